@@ -75,6 +75,50 @@ def job_list(
     return JobListRPC(flux_handle, "job-list.list", payload)
 
 
+def job_list_stream(
+    flux_handle,
+    max_entries=0,
+    attrs=[],
+    userid=os.getuid(),
+    states=0,
+    results=0,
+    chunk_size=0,
+    cursor=None,
+):
+    """Generator yielding jobs from a streaming job-list.list request
+
+    Jobs are returned by job-list in chunks of ``chunk_size`` (0 for the
+    job-list default), so large listings need not be held in memory all
+    at once.  A listing may be resumed after the last job yielded by
+    passing ``cursor={"id": job["id"], "state": job["state"]}``.
+    """
+    payload = {
+        "max_entries": int(max_entries),
+        "attrs": attrs,
+        "userid": int(userid),
+        "states": states,
+        "results": results,
+        "chunk_size": int(chunk_size),
+    }
+    if cursor is not None:
+        payload["cursor"] = cursor
+    rpc = JobListRPC(
+        flux_handle,
+        "job-list.list",
+        payload,
+        flags=flux.constants.FLUX_RPC_STREAMING,
+    )
+    while True:
+        try:
+            jobs = rpc.get_jobs()
+        except OSError as exc:
+            if exc.errno == errno.ENODATA:
+                return
+            raise
+        yield from jobs
+        rpc.reset()
+
+
 def job_list_inactive(flux_handle, since=0.0, max_entries=1000, attrs=[], name=None):
     payload = {"since": float(since), "max_entries": int(max_entries), "attrs": attrs}
     if name:
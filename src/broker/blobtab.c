@@ -0,0 +1,327 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "src/common/libccan/ccan/list/list.h"
+
+#include "blobtab.h"
+
+/* Slabs are allocated on a slab_size boundary so that the slab containing
+ * an item can be found by masking the item's address.
+ */
+static const size_t slab_size = 65536;
+
+static const size_t index_initial_size = 1024; // must be a power of 2
+
+#define ROUNDUP8(n) (((n) + 7) & ~(size_t)7)
+
+struct slab {
+    struct list_node list;          // on bt->partial if it has free slots
+    void *free;                     // list of freed slots
+    int used;                       // count of allocated slots
+    int carved;                     // count of slots ever allocated
+};
+
+struct blobtab {
+    int keysize;
+    size_t keyspace;                // keysize rounded up for alignment
+    size_t slotsize;                // keyspace + itemsize, rounded up
+    int slab_slots;                 // number of slots per slab
+    blobtab_destructor_f destructor;
+
+    struct list_head partial;       // slabs with free slots
+    int slab_count;
+
+    void **index;
+    size_t index_size;
+    int count;
+};
+
+static inline size_t slab_header_size (void)
+{
+    return ROUNDUP8 (sizeof (struct slab));
+}
+
+static inline struct slab *slab_from_slot (void *slot)
+{
+    return (struct slab *)((uintptr_t)slot & ~(uintptr_t)(slab_size - 1));
+}
+
+static void *slot_alloc (struct blobtab *bt)
+{
+    struct slab *s;
+    void *slot;
+
+    if (!(s = list_top (&bt->partial, struct slab, list))) {
+        if (posix_memalign ((void **)&s, slab_size, slab_size) != 0) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        s->free = NULL;
+        s->used = 0;
+        s->carved = 0;
+        list_add (&bt->partial, &s->list);
+        bt->slab_count++;
+    }
+    if (s->free) {
+        slot = s->free;
+        s->free = *(void **)slot;
+    }
+    else
+        slot = (char *)s + slab_header_size () + s->carved++ * bt->slotsize;
+    if (++s->used == bt->slab_slots)
+        list_del_from (&bt->partial, &s->list);
+    memset (slot, 0, bt->slotsize);
+    return slot;
+}
+
+/* Return 'slot' to its slab.  A slab that becomes empty is released
+ * unless it is the only one with free slots.
+ */
+static void slot_free (struct blobtab *bt, void *slot)
+{
+    struct slab *s = slab_from_slot (slot);
+
+    if (s->used-- == bt->slab_slots)
+        list_add (&bt->partial, &s->list);
+    if (s->used == 0 && list_top (&bt->partial, struct slab, list) != s) {
+        list_del_from (&bt->partial, &s->list);
+        bt->slab_count--;
+        free (s);
+        return;
+    }
+    *(void **)slot = s->free;
+    s->free = slot;
+}
+
+static inline void *slot_item (struct blobtab *bt, void *slot)
+{
+    return (char *)slot + bt->keyspace;
+}
+
+static inline void *item_slot (struct blobtab *bt, const void *item)
+{
+    return (char *)item - bt->keyspace;
+}
+
+const void *blobtab_key (struct blobtab *bt, const void *item)
+{
+    return item_slot (bt, item);
+}
+
+/* Digests are uniformly distributed, so use the leading bytes as the hash.
+ */
+static inline size_t key_hash (struct blobtab *bt, const void *key)
+{
+    size_t hash = 0;
+
+    memcpy (&hash, key, bt->keysize < sizeof (hash) ? bt->keysize
+                                                     : sizeof (hash));
+    return hash;
+}
+
+static inline size_t item_home (struct blobtab *bt, const void *item)
+{
+    return key_hash (bt, blobtab_key (bt, item)) & (bt->index_size - 1);
+}
+
+/* Return the index position of 'key', or of the empty position where
+ * it would be inserted.
+ */
+static size_t index_find (struct blobtab *bt, const void *key)
+{
+    size_t mask = bt->index_size - 1;
+    size_t i = key_hash (bt, key) & mask;
+
+    while (bt->index[i]) {
+        if (!memcmp (blobtab_key (bt, bt->index[i]), key, bt->keysize))
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int index_grow (struct blobtab *bt)
+{
+    size_t old_size = bt->index_size;
+    void **old_index = bt->index;
+    size_t new_size = old_size ? old_size * 2 : index_initial_size;
+
+    if (!(bt->index = calloc (new_size, sizeof (bt->index[0])))) {
+        bt->index = old_index;
+        return -1;
+    }
+    bt->index_size = new_size;
+    for (size_t i = 0; i < old_size; i++) {
+        if (old_index[i]) {
+            size_t j = item_home (bt, old_index[i]);
+            while (bt->index[j])
+                j = (j + 1) & (new_size - 1);
+            bt->index[j] = old_index[i];
+        }
+    }
+    free (old_index);
+    return 0;
+}
+
+void *blobtab_insert (struct blobtab *bt, const void *key)
+{
+    size_t i;
+    void *slot;
+
+    if (!bt || !key) {
+        errno = EINVAL;
+        return NULL;
+    }
+    /* Keep the load factor at or below 3/4.
+     */
+    if ((bt->count + 1) * 4 > bt->index_size * 3) {
+        if (index_grow (bt) < 0)
+            return NULL;
+    }
+    i = index_find (bt, key);
+    if (bt->index[i]) {
+        errno = EEXIST;
+        return NULL;
+    }
+    if (!(slot = slot_alloc (bt)))
+        return NULL;
+    memcpy (slot, key, bt->keysize);
+    bt->index[i] = slot_item (bt, slot);
+    bt->count++;
+    return bt->index[i];
+}
+
+void *blobtab_lookup (struct blobtab *bt, const void *key)
+{
+    if (!bt || !key || bt->count == 0)
+        return NULL;
+    return bt->index[index_find (bt, key)];
+}
+
+/* Delete the item at index position 'i', then shift back any following
+ * items in the probe sequence that would no longer be reachable.
+ */
+static void index_delete (struct blobtab *bt, size_t i)
+{
+    size_t mask = bt->index_size - 1;
+    size_t j = i;
+
+    for (;;) {
+        size_t home;
+
+        j = (j + 1) & mask;
+        if (!bt->index[j])
+            break;
+        home = item_home (bt, bt->index[j]);
+        /* Move index[j] to the hole at i unless its home lies
+         * cyclically in (i, j].
+         */
+        if ((i < j) ? (home <= i || home > j) : (home <= i && home > j)) {
+            bt->index[i] = bt->index[j];
+            i = j;
+        }
+    }
+    bt->index[i] = NULL;
+}
+
+void blobtab_remove (struct blobtab *bt, void *item)
+{
+    size_t i;
+
+    if (!bt || !item || bt->count == 0)
+        return;
+    i = index_find (bt, blobtab_key (bt, item));
+    if (bt->index[i] != item)
+        return;
+    index_delete (bt, i);
+    bt->count--;
+    if (bt->destructor)
+        bt->destructor (item);
+    slot_free (bt, item_slot (bt, item));
+}
+
+int blobtab_count (struct blobtab *bt)
+{
+    return bt ? bt->count : 0;
+}
+
+size_t blobtab_memory (struct blobtab *bt)
+{
+    if (!bt)
+        return 0;
+    return bt->slab_count * slab_size
+        + bt->index_size * sizeof (bt->index[0]);
+}
+
+void blobtab_destroy (struct blobtab *bt)
+{
+    if (bt) {
+        int saved_errno = errno;
+        struct slab *s;
+
+        /* Full slabs are not on the partial list, so find them via
+         * their items and add them to it before freeing.
+         */
+        for (size_t i = 0; i < bt->index_size; i++) {
+            if (bt->index[i]) {
+                if (bt->destructor)
+                    bt->destructor (bt->index[i]);
+                s = slab_from_slot (item_slot (bt, bt->index[i]));
+                if (s->used == bt->slab_slots) {
+                    s->used = 0;
+                    list_add (&bt->partial, &s->list);
+                }
+            }
+        }
+        free (bt->index);
+        while ((s = list_pop (&bt->partial, struct slab, list)))
+            free (s);
+        free (bt);
+        errno = saved_errno;
+    }
+}
+
+struct blobtab *blobtab_create (int keysize,
+                                size_t itemsize,
+                                blobtab_destructor_f destructor)
+{
+    struct blobtab *bt;
+
+    if (keysize <= 0 || itemsize == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bt = calloc (1, sizeof (*bt))))
+        return NULL;
+    bt->keysize = keysize;
+    bt->keyspace = ROUNDUP8 (keysize);
+    bt->slotsize = ROUNDUP8 (bt->keyspace + itemsize);
+    bt->slab_slots = (slab_size - slab_header_size ()) / bt->slotsize;
+    bt->destructor = destructor;
+    list_head_init (&bt->partial);
+    if (bt->slab_slots < 1) {
+        free (bt);
+        errno = EINVAL;
+        return NULL;
+    }
+    return bt;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
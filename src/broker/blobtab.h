@@ -0,0 +1,65 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef HAVE_BROKER_BLOBTAB_H
+#define HAVE_BROKER_BLOBTAB_H 1
+
+#include <stddef.h>
+
+/* A table of fixed size items keyed by binary blob digest.
+ *
+ * Items are allocated from slabs owned by the table, and each item's
+ * digest is stored just ahead of it in the same slab slot.  Since digests
+ * are uniformly distributed, their leading bytes are used directly as the
+ * hash value.  The index is an open addressing table of item pointers with
+ * linear probing and backward shift deletion.
+ */
+
+typedef void (*blobtab_destructor_f)(void *item);
+
+/* Create a table for digests of 'keysize' bytes and items of 'itemsize'
+ * bytes.  If 'destructor' is non-NULL, it is called on items removed from
+ * the table, including those remaining when the table is destroyed.
+ */
+struct blobtab *blobtab_create (int keysize,
+                                size_t itemsize,
+                                blobtab_destructor_f destructor);
+void blobtab_destroy (struct blobtab *bt);
+
+/* Allocate a zeroed item, keyed by 'key', and add it to the table.
+ * Returns item on success, NULL with errno set on failure (EEXIST if
+ * 'key' is already present).
+ */
+void *blobtab_insert (struct blobtab *bt, const void *key);
+
+/* Find item by 'key'.  Returns NULL if not found.
+ */
+void *blobtab_lookup (struct blobtab *bt, const void *key);
+
+/* Remove 'item' from the table, call the destructor on it, and
+ * return its memory to the slab.
+ */
+void blobtab_remove (struct blobtab *bt, void *item);
+
+/* Get the digest of 'item'.
+ */
+const void *blobtab_key (struct blobtab *bt, const void *item);
+
+int blobtab_count (struct blobtab *bt);
+
+/* Get the total memory allocated to slabs and the index, in bytes.
+ */
+size_t blobtab_memory (struct blobtab *bt);
+
+#endif /* !HAVE_BROKER_BLOBTAB_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
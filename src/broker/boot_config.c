@@ -22,12 +22,12 @@
 #include <flux/hostlist.h>
 
 #include "src/common/libutil/log.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libpmi/clique.h"
 
 #include "attr.h"
 #include "overlay.h"
+#include "topology.h"
 #include "boot_config.h"
 
 
@@ -439,12 +439,16 @@ int boot_config_geturibyrank (json_t *hosts,
     return 0;
 }
 
-int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
+int boot_config (flux_t *h,
+                 struct overlay *overlay,
+                 attr_t *attrs,
+                 const char *topo_uri)
 {
     struct boot_conf conf;
     uint32_t rank;
     uint32_t size;
     json_t *hosts = NULL;
+    struct topology *topo = NULL;
 
     /* Ingest the [bootstrap] stanza.
      */
@@ -476,10 +480,14 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         rank = 0;
     }
 
-    /* Tell overlay network this broker's rank, size, and branching factor.
+    /* Tell overlay network this broker's rank and the topology.
      * If a curve certificate was provided, load it.
      */
-    if (overlay_set_geometry (overlay, size, rank, tbon_k) < 0)
+    if (!(topo = topology_create (topo_uri, size))) {
+        log_err ("error creating '%s' topology", topo_uri);
+        goto error;
+    }
+    if (overlay_set_topology (overlay, topo, rank) < 0)
         goto error;
     if (conf.curve_cert) {
         if (overlay_cert_load (overlay, conf.curve_cert) < 0)
@@ -491,7 +499,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
      * attribute to the URI peers will connect to.  If broker has no
      * downstream peers, set tbon.endpoint to NULL.
      */
-    if (kary_childof (tbon_k, size, rank, 0) != KARY_NONE) {
+    if (topology_get_child_ranks (topo, rank, NULL) > 0) {
         char bind_uri[MAX_URI + 1];
         char my_uri[MAX_URI + 1];
 
@@ -543,7 +551,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         char parent_uri[MAX_URI + 1];
         if (boot_config_geturibyrank (hosts,
                                       &conf,
-                                      kary_parentof (tbon_k, rank),
+                                      topology_get_parent (topo, rank),
                                       parent_uri,
                                       sizeof (parent_uri)) < 0)
             goto error;
@@ -567,9 +575,11 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         log_err ("setattr instance-level 0");
         goto error;
     }
+    topology_decref (topo);
     json_decref (hosts);
     return 0;
 error:
+    topology_decref (topo);
     ERRNO_SAFE_WRAP (json_decref, hosts);
     return -1;
 }
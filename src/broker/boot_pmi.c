@@ -18,13 +18,13 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/ipaddr.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libpmi/pmi.h"
 #include "src/common/libpmi/pmi_strerror.h"
 #include "src/common/libpmi/clique.h"
 
 #include "attr.h"
 #include "overlay.h"
+#include "topology.h"
 #include "boot_pmi.h"
 #include "pmiutil.h"
 
@@ -148,7 +148,7 @@ overflow:
     return -1;
 }
 
-int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
+int boot_pmi (struct overlay *overlay, attr_t *attrs, const char *topo_uri)
 {
     int rank;
     char key[64];
@@ -157,6 +157,9 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
     struct pmi_params pmi_params;
     int result;
     const char *uri;
+    struct topology *topo = NULL;
+    const uint32_t *child_ranks;
+    int child_count;
     int i;
 
     memset (&pmi_params, 0, sizeof (pmi_params));
@@ -182,10 +185,15 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
         log_err ("error setting broker.mapping attribute");
         goto error;
     }
-    if (overlay_set_geometry (overlay,
-                              pmi_params.size,
-                              pmi_params.rank,
-                              tbon_k) < 0)
+    if (!(topo = topology_create (topo_uri, pmi_params.size))) {
+        log_err ("error creating '%s' topology", topo_uri);
+        goto error;
+    }
+    if (overlay_set_topology (overlay, topo, pmi_params.rank) < 0)
+        goto error;
+    if ((child_count = topology_get_child_ranks (topo,
+                                                 pmi_params.rank,
+                                                 &child_ranks)) < 0)
         goto error;
 
     /* A size=1 instance has no peers, so skip the PMI exchange.
@@ -195,13 +203,8 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
 
     /* If there are to be downstream peers, then bind to socket and extract
      * the concretized URI for sharing with other ranks.
-     * N.B. there are no downstream peers if the 0th child of this rank
-     * in k-ary tree does not exist.
      */
-    if (kary_childof (tbon_k,
-                      pmi_params.size,
-                      pmi_params.rank,
-                      0) != KARY_NONE) {
+    if (child_count > 0) {
         char buf[1024];
 
         if (format_bind_uri (buf, sizeof (buf), attrs, pmi_params.rank) < 0)
@@ -259,7 +262,7 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
     if (pmi_params.rank > 0) {
         char *cp;
 
-        rank = kary_parentof (tbon_k, pmi_params.rank);
+        rank = topology_get_parent (topo, pmi_params.rank);
         if (snprintf (key, sizeof (key), "%d", rank) >= sizeof (key)) {
             log_msg ("pmi key string overflow");
             goto error;
@@ -288,12 +291,10 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
 
     /* Fetch the business card of children and inform overlay of public keys.
      */
-    for (i = 0; i < tbon_k; i++) {
+    for (i = 0; i < child_count; i++) {
         char *cp;
 
-        rank = kary_childof (tbon_k, pmi_params.size, pmi_params.rank, i);
-        if (rank == KARY_NONE)
-            break;
+        rank = child_ranks[i];
         if (snprintf (key, sizeof (key), "%d", rank) >= sizeof (key)) {
             log_msg ("pmi key string overflow");
             goto error;
@@ -329,9 +330,11 @@ done:
         goto error;
     }
 
+    topology_decref (topo);
     broker_pmi_destroy (pmi);
     return 0;
 error:
+    topology_decref (topo);
     broker_pmi_destroy (pmi);
     return -1;
 }
@@ -236,6 +236,8 @@ int main (int argc, char *argv[])
     const flux_conf_t *conf;
     double boot_elapsed_sec;
     struct timespec boot_start_time;
+    char kary_uri[32];
+    const char *topo_uri;
 
     memset (&ctx, 0, sizeof (ctx));
     log_init (argv[0]);
@@ -350,19 +352,27 @@ int main (int argc, char *argv[])
     if (create_rundir (ctx.attrs) < 0)
         goto cleanup;
 
+    /* The TBON topology is selected by the tbon.topo attribute if set,
+     * otherwise it is a k-ary tree with the --k-ary branching factor.
+     */
+    if (attr_get (ctx.attrs, "tbon.topo", &topo_uri, NULL) < 0 || !topo_uri) {
+        snprintf (kary_uri, sizeof (kary_uri), "kary:%d", ctx.tbon_k);
+        topo_uri = kary_uri;
+    }
+
     /* Execute broker network bootstrap.
      * Default method is pmi.
      * If [bootstrap] is defined in configuration, use static configuration.
      */
     monotime (&boot_start_time);
     if (flux_conf_unpack (conf, NULL, "{s:{}}", "bootstrap") == 0) {
-        if (boot_config (ctx.h, ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
+        if (boot_config (ctx.h, ctx.overlay, ctx.attrs, topo_uri) < 0) {
             log_msg ("bootstrap failed");
             goto cleanup;
         }
     }
     else { // PMI
-        if (boot_pmi (ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
+        if (boot_pmi (ctx.overlay, ctx.attrs, topo_uri) < 0) {
             log_msg ("bootstrap failed");
             goto cleanup;
         }
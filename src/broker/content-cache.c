@@ -17,14 +17,15 @@
 #include <assert.h>
 #include <flux/core.h>
 
-#include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libccan/ccan/list/list.h"
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/iterators.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libcontent/content-batch.h"
 
 #include "attr.h"
+#include "blobtab.h"
 #include "content-cache.h"
 
 /* A periodic callback purges the cache of least recently used entries.
@@ -47,22 +48,57 @@ static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
 
+/* Maximum number of blobs in a load-batch or store-batch request sent
+ * upstream or to the backing store.
+ */
+#define BATCH_MAX_COUNT 256
+
 struct msgstack {
     const flux_msg_t *msg;
     struct msgstack *next;
 };
 
+/* A load-batch or store-batch request, answered with one response
+ * once all of its items have been resolved.
+ */
+struct batch_result {
+    void *data;
+    int len;
+    int errnum;
+};
+
+struct batch_request {
+    const flux_msg_t *msg;
+    const char *type;
+    int count;
+    int pending;
+    struct batch_result *results;
+};
+
+/* An item of a batch request waiting on a cache entry.
+ */
+struct batchwait {
+    struct batch_request *br;
+    int index;
+    struct batchwait *next;
+};
+
+/* Entries are allocated from cache->entries and keyed by blob digest.
+ * The blobref string is regenerated from the digest when needed.
+ */
 struct cache_entry {
     void *data;
     int len;
-    char *blobref;
     uint8_t valid:1;                /* entry contains valid data */
     uint8_t dirty:1;                /* entry needs to be stored upstream */
                                     /*   or to backing store (rank 0) */
     uint8_t load_pending:1;
     uint8_t store_pending:1;
+    uint8_t store_queued:1;         /* on cache->flush list */
     struct msgstack *load_requests;
     struct msgstack *store_requests;
+    struct batchwait *load_batch_waiters;
+    struct batchwait *store_batch_waiters;
     double lastused;
 
     struct list_node list;
@@ -74,10 +110,12 @@ struct content_cache {
     flux_msg_handler_t **handlers;
     flux_future_t *f_sync;
     uint32_t rank;
-    zhashx_t *entries;
+    struct blobtab *entries;
     uint8_t backing:1;              /* 'content.backing' service available */
+    uint8_t backing_nobatch:1;      /* backing store lacks batch methods */
     char *backing_name;
     const char *hash_name;
+    int hash_len;                   /* digest size of hash_name */
     struct msgstack *flush_requests;
 
     struct list_head lru;           /* LRU is for valid, clean entries only */
@@ -164,49 +202,193 @@ static void request_list_respond_error (struct msgstack **l,
     }
 }
 
-/* Destroy a cache entry
+static void batch_request_destroy (struct batch_request *br)
+{
+    if (br) {
+        int saved_errno = errno;
+        flux_msg_decref (br->msg);
+        if (br->results) {
+            for (int i = 0; i < br->count; i++)
+                free (br->results[i].data);
+            free (br->results);
+        }
+        free (br);
+        errno = saved_errno;
+    }
+}
+
+/* Create a batch request for 'msg' with 'count' items.
+ * The request holds one extra pending reference for the caller,
+ * dropped with batch_request_release().
+ */
+static struct batch_request *batch_request_create (const flux_msg_t *msg,
+                                                   int count,
+                                                   const char *type)
+{
+    struct batch_request *br;
+
+    if (!(br = calloc (1, sizeof (*br))))
+        return NULL;
+    if (count > 0 && !(br->results = calloc (count, sizeof (br->results[0]))))
+        goto error;
+    br->msg = flux_msg_incref (msg);
+    br->type = type;
+    br->count = count;
+    br->pending = count + 1;
+    return br;
+error:
+    batch_request_destroy (br);
+    return NULL;
+}
+
+static void batch_request_respond (flux_t *h, struct batch_request *br)
+{
+    struct content_batch *b;
+    const void *buf;
+    int len;
+
+    if (!(b = content_batch_create ()))
+        goto error;
+    for (int i = 0; i < br->count; i++) {
+        struct batch_result *r = &br->results[i];
+        if (r->errnum) {
+            if (content_batch_append_error (b, r->errnum) < 0)
+                goto error;
+        }
+        else if (content_batch_append (b, r->data, r->len) < 0)
+            goto error;
+    }
+    content_batch_encode (b, &buf, &len);
+    if (flux_respond_raw (h, br->msg, buf, len) < 0)
+        flux_log_error (h, "content %s-batch: flux_respond_raw", br->type);
+    content_batch_destroy (b);
+    return;
+error:
+    if (flux_respond_error (h, br->msg, errno, NULL) < 0)
+        flux_log_error (h, "content %s-batch: flux_respond_error", br->type);
+    content_batch_destroy (b);
+}
+
+/* Drop a pending reference on 'br'.  When none remain, respond and
+ * destroy the request.
+ */
+static void batch_request_release (flux_t *h, struct batch_request *br)
+{
+    if (--br->pending == 0) {
+        batch_request_respond (h, br);
+        batch_request_destroy (br);
+    }
+}
+
+/* Resolve item 'index' of 'br' with a copy of 'data', or with 'errnum'
+ * if nonzero.
+ */
+static void batch_request_set (flux_t *h,
+                               struct batch_request *br,
+                               int index,
+                               const void *data,
+                               int len,
+                               int errnum)
+{
+    struct batch_result *r = &br->results[index];
+
+    if (errnum == 0 && len > 0) {
+        if (!(r->data = malloc (len)))
+            errnum = errno;
+        else {
+            memcpy (r->data, data, len);
+            r->len = len;
+        }
+    }
+    r->errnum = errnum;
+    batch_request_release (h, br);
+}
+
+static int batchwait_push (struct batchwait **bwp,
+                           struct batch_request *br,
+                           int index)
+{
+    struct batchwait *bw;
+    if (!(bw = malloc (sizeof (*bw))))
+        return -1;
+    bw->br = br;
+    bw->index = index;
+    bw->next = *bwp;
+    *bwp = bw;
+    return 0;
+}
+
+/* Resolve all batch request items waiting on an entry.
+ * The list is always run to completion.
+ */
+static void batchwait_notify (struct batchwait **bwp,
+                              flux_t *h,
+                              const void *data,
+                              int len,
+                              int errnum)
+{
+    struct batchwait *bw;
+    while ((bw = *bwp)) {
+        *bwp = bw->next;
+        batch_request_set (h, bw->br, bw->index, data, len, errnum);
+        free (bw);
+    }
+}
+
+/* Release resources held by a cache entry.  The entry itself belongs
+ * to cache->entries.  This is the blobtab destructor.
  */
-static void cache_entry_destroy (struct cache_entry *e)
+static void cache_entry_destroy (void *item)
 {
+    struct cache_entry *e = item;
     if (e) {
         int saved_errno = errno;
         assert (e->load_requests == 0);
         assert (e->store_requests == 0);
+        assert (e->load_batch_waiters == NULL);
+        assert (e->store_batch_waiters == NULL);
         free (e->data);
         msgstack_destroy (&e->load_requests);
         msgstack_destroy (&e->store_requests);
-        free (e);
         errno = saved_errno;
     }
 }
 
-/* zhashx_destructor_fn footprint
+/* Convert 'blobref' to the digest used as a cache key.  A blobref of
+ * some other hash type cannot refer to a blob in this instance, so
+ * fail with ENOENT, like a missing blob.
+ * Returns 0 on success, -1 on failure with errno set.
  */
-static void cache_entry_destructor (void **item)
+static int cache_blobref_key (struct content_cache *cache,
+                              const char *blobref,
+                              uint8_t key[BLOBREF_MAX_DIGEST_SIZE])
 {
-    if (item) {
-        cache_entry_destroy (*item);
-        *item = NULL;
+    int n = strlen (cache->hash_name);
+
+    if (strncmp (blobref, cache->hash_name, n) != 0
+        || blobref[n] != '-'
+        || blobref_strtohash (blobref,
+                              key,
+                              BLOBREF_MAX_DIGEST_SIZE) != cache->hash_len) {
+        errno = ENOENT;
+        return -1;
     }
+    return 0;
 }
 
-/* Create a cache entry.
- * Entries are created with a blobref, but no data (e.g. "invalid").
- * The blobref is copied to the space following the entry struct so the entry
- * and the blobref can be co-located in memory, and allocated with one malloc.
- * Returns entry on success, NULL with errno set on failure.
+/* Format the blobref of 'e' into 'buf' and return it.
  */
-static struct cache_entry *cache_entry_create (const char *blobref)
+static const char *cache_entry_blobref (struct content_cache *cache,
+                                        struct cache_entry *e,
+                                        char buf[BLOBREF_MAX_STRING_SIZE])
 {
-    struct cache_entry *e;
-    int bloblen = strlen (blobref) + 1;
-
-    if (!(e = calloc (1, sizeof (*e) + bloblen)))
-        return NULL;
-    e->blobref = (char *)(e + 1);
-    memcpy (e->blobref, blobref, bloblen);
-    list_node_init (&e->list);
-    return e;
+    if (blobref_hashtostr (cache->hash_name,
+                           blobtab_key (cache->entries, e),
+                           cache->hash_len,
+                           buf,
+                           BLOBREF_MAX_STRING_SIZE) < 0)
+        buf[0] = '\0';
+    return buf;
 }
 
 /* Make an invalid cache entry valid, filling in its data.
@@ -248,6 +430,11 @@ static int cache_entry_fill (struct content_cache *cache,
                                   e->data,
                                   e->len,
                                   "load");
+        batchwait_notify (&e->load_batch_waiters,
+                          cache->h,
+                          e->data,
+                          e->len,
+                          0);
     }
     return 0;
 }
@@ -256,6 +443,9 @@ static void cache_entry_dirty_clear (struct content_cache *cache,
                                      struct cache_entry *e)
 {
     if (e->dirty) {
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+
+        cache_entry_blobref (cache, e, blobref);
         cache->acct_dirty--;
         e->dirty = 0;
 
@@ -265,40 +455,42 @@ static void cache_entry_dirty_clear (struct content_cache *cache,
 
         request_list_respond_raw (&e->store_requests,
                                   cache->h,
-                                  e->blobref,
-                                  strlen (e->blobref) + 1,
+                                  blobref,
+                                  strlen (blobref) + 1,
                                   "store");
+        batchwait_notify (&e->store_batch_waiters,
+                          cache->h,
+                          blobref,
+                          strlen (blobref) + 1,
+                          0);
     }
 }
 
 
-/* Create and insert a cache entry, using 'blobref' as the hash key.
- * Returns 0 on success, -1 on failure with errno set.
+/* Create and insert a cache entry, using digest 'key' as the hash key.
+ * Entries are created with no data (e.g. "invalid").
+ * Returns entry on success, NULL on failure with errno set.
  */
 static struct cache_entry *cache_entry_insert (struct content_cache *cache,
-                                               const char *blobref)
+                                               const uint8_t *key)
 {
     struct cache_entry *e;
-    if (!(e = cache_entry_create (blobref)))
+    if (!(e = blobtab_insert (cache->entries, key)))
         return NULL;
-    if (zhashx_insert (cache->entries, e->blobref, e) < 0) {
-        errno = EEXIST;
-        cache_entry_destroy (e);
-        return NULL;
-    }
+    list_node_init (&e->list);
     return e;
 }
 
-/* Look up a cache entry, by blobref.
+/* Look up a cache entry, by digest.
  * Move to front of LRU because it was looked up.
  * Returns entry on success, NULL on failure.
  * N.B. errno is not set
  */
 static struct cache_entry *cache_entry_lookup (struct content_cache *cache,
-                                               const char *blobref)
+                                               const uint8_t *key)
 {
     struct cache_entry *e;
-    if (!(e = zhashx_lookup (cache->entries, blobref)))
+    if (!(e = blobtab_lookup (cache->entries, key)))
         return NULL;
 
     if (e->valid && !e->dirty) {
@@ -317,6 +509,8 @@ static void cache_entry_remove (struct content_cache *cache,
 {
     assert (e->load_requests == NULL);
     assert (e->store_requests == NULL);
+    assert (e->load_batch_waiters == NULL);
+    assert (e->store_batch_waiters == NULL);
     list_del (&e->list);
     if (e->valid) {
         cache->acct_size -= e->len;
@@ -324,7 +518,7 @@ static void cache_entry_remove (struct content_cache *cache,
     }
     if (e->dirty)
         cache->acct_dirty--;
-    zhashx_delete (cache->entries, e->blobref);
+    blobtab_remove (cache->entries, e);
 }
 
 /* Load operation
@@ -338,34 +532,61 @@ static void cache_entry_remove (struct content_cache *cache,
  * an error such as ENOENT.
  */
 
-static void cache_load_continuation (flux_future_t *f, void *arg)
+/* Fail all requests waiting for 'e' to be loaded, then remove it.
+ */
+static void cache_load_error (struct content_cache *cache,
+                              struct cache_entry *e,
+                              int errnum)
 {
-    struct content_cache *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const void *data = NULL;
-    int len = 0;
+    e->load_pending = 0;
+    request_list_respond_error (&e->load_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "load");
+    batchwait_notify (&e->load_batch_waiters, cache->h, NULL, 0, errnum);
+    cache_entry_remove (cache, e);
+}
 
+/* Handle the result of loading 'e' from upstream or the backing store.
+ */
+static void cache_load_result (struct content_cache *cache,
+                               struct cache_entry *e,
+                               const void *data,
+                               int len,
+                               int errnum)
+{
     e->load_pending = 0;
-    if (flux_content_load_get (f, &data, &len) < 0) {
-        if (errno == ENOSYS && cache->rank == 0)
-            errno = ENOENT;
-        if (errno != ENOENT)
+    if (errnum) {
+        if (errnum == ENOSYS && cache->rank == 0)
+            errnum = ENOENT;
+        if (errnum != ENOENT) {
+            errno = errnum;
             flux_log_error (cache->h, "content load");
+        }
         goto error;
     }
     if (cache_entry_fill (cache, e, data, len, false) < 0) {
+        errnum = errno;
         flux_log_error (cache->h, "content load");
         goto error;
     }
-    flux_future_destroy (f);
     return;
 error:
-    request_list_respond_error (&e->load_requests,
-                                cache->h,
-                                errno,
-                                NULL,
-                                "load");
-    cache_entry_remove (cache, e);
+    cache_load_error (cache, e, errnum);
+}
+
+static void cache_load_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const void *data = NULL;
+    int len = 0;
+
+    if (flux_content_load_get (f, &data, &len) < 0)
+        cache_load_result (cache, e, NULL, 0, errno);
+    else
+        cache_load_result (cache, e, data, len, 0);
     flux_future_destroy (f);
 }
 
@@ -373,12 +594,14 @@ static int cache_load (struct content_cache *cache, struct cache_entry *e)
 {
     flux_future_t *f;
     int flags = CONTENT_FLAG_UPSTREAM;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
 
     if (e->load_pending)
         return 0;
     if (cache->rank == 0)
         flags = CONTENT_FLAG_CACHE_BYPASS;
-    if (!(f = flux_content_load (cache->h, e->blobref, flags))
+    cache_entry_blobref (cache, e, blobref);
+    if (!(f = flux_content_load (cache->h, blobref, flags))
         || flux_future_aux_set (f, "entry", e, NULL) < 0
         || flux_future_then (f, -1., cache_load_continuation, cache) < 0) {
         flux_log_error (cache->h, "content load");
@@ -389,12 +612,135 @@ static int cache_load (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
+/* The entries vector of a batch load or store, stored in the future aux.
+ */
+struct entryvec {
+    int count;
+    struct cache_entry *entries[];
+};
+
+static struct entryvec *entryvec_create (struct cache_entry **entries,
+                                         int count)
+{
+    struct entryvec *ev;
+
+    if (!(ev = malloc (sizeof (*ev) + count * sizeof (entries[0]))))
+        return NULL;
+    memcpy (ev->entries, entries, count * sizeof (entries[0]));
+    ev->count = count;
+    return ev;
+}
+
+static void cache_load_batch_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct entryvec *ev = flux_future_aux_get (f, "entries");
+    const struct content_batch *b;
+    int errnum = 0;
+
+    if (content_batch_rpc_get (f, &b) < 0) {
+        errnum = errno;
+        /* Fall back to single loads if the backing store does not
+         * implement load-batch.
+         */
+        if (errnum == ENOSYS && cache->rank == 0 && cache->backing) {
+            cache->backing_nobatch = 1;
+            for (int i = 0; i < ev->count; i++) {
+                ev->entries[i]->load_pending = 0;
+                if (cache_load (cache, ev->entries[i]) < 0)
+                    cache_load_error (cache, ev->entries[i], errno);
+            }
+            goto done;
+        }
+    }
+    else if (content_batch_count (b) != ev->count) {
+        flux_log (cache->h, LOG_ERR, "content load-batch: wrong item count");
+        errnum = EPROTO;
+    }
+    for (int i = 0; i < ev->count; i++) {
+        const void *data = NULL;
+        int len = 0;
+
+        if (errnum)
+            cache_load_result (cache, ev->entries[i], NULL, 0, errnum);
+        else if (content_batch_get (b, i, &data, &len) < 0)
+            cache_load_result (cache, ev->entries[i], NULL, 0, errno);
+        else
+            cache_load_result (cache, ev->entries[i], data, len, 0);
+    }
+done:
+    flux_future_destroy (f);
+}
+
+/* Load 'count' entries with load_pending already set, sending at most
+ * BATCH_MAX_COUNT blobrefs per load-batch request.
+ * On failure, the entries are failed with cache_load_error().
+ */
+static void cache_load_batch (struct content_cache *cache,
+                              struct cache_entry **entries,
+                              int count)
+{
+    int flags = CONTENT_FLAG_UPSTREAM;
+
+    if (cache->rank == 0) {
+        if (cache->backing_nobatch) {
+            for (int i = 0; i < count; i++) {
+                entries[i]->load_pending = 0;
+                if (cache_load (cache, entries[i]) < 0)
+                    cache_load_error (cache, entries[i], errno);
+            }
+            return;
+        }
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    }
+    while (count > 0) {
+        int n = count < BATCH_MAX_COUNT ? count : BATCH_MAX_COUNT;
+        struct content_batch *b = NULL;
+        struct entryvec *ev = NULL;
+        flux_future_t *f = NULL;
+        int errnum;
+
+        if (!(b = content_batch_create ()))
+            goto error;
+        for (int i = 0; i < n; i++) {
+            char blobref[BLOBREF_MAX_STRING_SIZE];
+
+            cache_entry_blobref (cache, entries[i], blobref);
+            if (content_batch_append_string (b, blobref) < 0)
+                goto error;
+        }
+        if (!(ev = entryvec_create (entries, n))
+            || !(f = content_load_batch (cache->h, b, flags))
+            || flux_future_aux_set (f, "entries", ev, free) < 0
+            || flux_future_then (f,
+                                 -1.,
+                                 cache_load_batch_continuation,
+                                 cache) < 0)
+            goto error;
+        content_batch_destroy (b);
+        entries += n;
+        count -= n;
+        continue;
+error:
+        errnum = errno;
+        flux_log_error (cache->h, "content load-batch");
+        if (!f || !flux_future_aux_get (f, "entries"))
+            free (ev);
+        flux_future_destroy (f);
+        content_batch_destroy (b);
+        for (int i = 0; i < count; i++)
+            cache_load_error (cache, entries[i], errnum);
+        return;
+    }
+}
+
 void content_load_request (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct content_cache *cache = arg;
     const char *blobref;
     int blobref_size;
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
     void *data = NULL;
     int len = 0;
     struct cache_entry *e;
@@ -406,12 +752,14 @@ void content_load_request (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
-    if (!(e = cache_entry_lookup (cache, blobref))) {
+    if (cache_blobref_key (cache, blobref, key) < 0)
+        goto error;
+    if (!(e = cache_entry_lookup (cache, key))) {
         if (cache->rank == 0 && !cache->backing) {
             errno = ENOENT;
             goto error;
         }
-        if (!(e = cache_entry_insert (cache, blobref))) {
+        if (!(e = cache_entry_insert (cache, key))) {
             flux_log_error (h, "content load");
             goto error;
         }
@@ -435,6 +783,87 @@ error:
         flux_log_error (h, "content load: flux_respond_error");
 }
 
+/* Load-batch operation
+ *
+ * Like load, but for a list of blobrefs.  Missing entries are requested
+ * with a single load-batch request to the next level of the TBON or to
+ * the backing store, and one response is sent when all items are resolved.
+ */
+static void content_load_batch_request (flux_t *h,
+                                        flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg,
+                                        void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *buf;
+    int len;
+    struct content_batch *b = NULL;
+    struct batch_request *br = NULL;
+    struct cache_entry **missing = NULL;
+    int nmissing = 0;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(b = content_batch_decode (buf, len)))
+        goto error;
+    count = content_batch_count (b);
+    for (int i = 0; i < count; i++) {
+        if (content_batch_get_string (b, i, NULL) < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+    }
+    if (!(br = batch_request_create (msg, count, "load"))
+        || (count > 0 && !(missing = calloc (count, sizeof (missing[0])))))
+        goto error;
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+        uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+        struct cache_entry *e;
+
+        (void)content_batch_get_string (b, i, &blobref);
+        if (cache_blobref_key (cache, blobref, key) < 0) {
+            batch_request_set (h, br, i, NULL, 0, errno);
+            continue;
+        }
+        if (!(e = cache_entry_lookup (cache, key))) {
+            if (cache->rank == 0 && !cache->backing) {
+                batch_request_set (h, br, i, NULL, 0, ENOENT);
+                continue;
+            }
+            if (!(e = cache_entry_insert (cache, key))) {
+                flux_log_error (h, "content load-batch");
+                batch_request_set (h, br, i, NULL, 0, errno);
+                continue;
+            }
+        }
+        if (e->valid) {
+            batch_request_set (h, br, i, e->data, e->len, 0);
+            continue;
+        }
+        if (batchwait_push (&e->load_batch_waiters, br, i) < 0) {
+            flux_log_error (h, "content load-batch");
+            batch_request_set (h, br, i, NULL, 0, errno);
+            continue;
+        }
+        if (!e->load_pending) {
+            e->load_pending = 1;
+            missing[nmissing++] = e;
+        }
+    }
+    cache_load_batch (cache, missing, nmissing);
+    free (missing);
+    content_batch_destroy (b);
+    batch_request_release (h, br);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+    batch_request_destroy (br);
+    free (missing);
+    content_batch_destroy (b);
+}
+
 /* Store operation
  *
  * If a cache entry is already valid and not dirty, response is immediate.
@@ -466,38 +895,64 @@ static void cache_resume_flush (struct content_cache *cache)
         (void)cache_flush (cache); /* resume flushing, subject to limits */
 }
 
-static void cache_store_continuation (flux_future_t *f, void *arg)
+/* Fail all requests waiting for 'e' to be stored.
+ */
+static void cache_store_error (struct content_cache *cache,
+                               struct cache_entry *e,
+                               int errnum)
 {
-    struct content_cache *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const char *blobref;
+    e->store_pending = 0;
+    request_list_respond_error (&e->store_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "store");
+    batchwait_notify (&e->store_batch_waiters, cache->h, NULL, 0, errnum);
+}
+
+/* Handle the result of storing 'e' upstream or to the backing store.
+ */
+static void cache_store_result (struct content_cache *cache,
+                                struct cache_entry *e,
+                                const char *blobref,
+                                int errnum)
+{
+    char expected[BLOBREF_MAX_STRING_SIZE];
 
     e->store_pending = 0;
-    assert (cache->flush_batch_count > 0);
-    cache->flush_batch_count--;
-    if (flux_content_store_get (f, &blobref) < 0) {
-        if (cache->rank == 0 && errno == ENOSYS)
+    if (errnum) {
+        if (cache->rank == 0 && errnum == ENOSYS)
             flux_log (cache->h, LOG_DEBUG, "content store: %s",
                       "backing store service unavailable");
-        else
+        else {
+            errno = errnum;
             flux_log_error (cache->h, "content store");
+        }
         goto error;
     }
-    if (strcmp (blobref, e->blobref)) {
+    if (strcmp (blobref, cache_entry_blobref (cache, e, expected))) {
         flux_log (cache->h, LOG_ERR, "content store: wrong blobref");
-        errno = EIO;
+        errnum = EIO;
         goto error;
     }
     cache_entry_dirty_clear (cache, e);
-    flux_future_destroy (f);
-    cache_resume_flush (cache);
     return;
 error:
-    request_list_respond_error (&e->store_requests,
-                                cache->h,
-                                errno,
-                                NULL,
-                                "store");
+    cache_store_error (cache, e, errnum);
+}
+
+static void cache_store_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const char *blobref;
+
+    assert (cache->flush_batch_count > 0);
+    cache->flush_batch_count--;
+    if (flux_content_store_get (f, &blobref) < 0)
+        cache_store_result (cache, e, NULL, errno);
+    else
+        cache_store_result (cache, e, blobref, 0);
     flux_future_destroy (f);
     cache_resume_flush (cache);
 }
@@ -509,11 +964,12 @@ static int cache_store (struct content_cache *cache, struct cache_entry *e)
 
     assert (e->valid);
 
-    if (e->store_pending)
+    if (e->store_pending || e->store_queued)
         return 0;
     if (cache->rank == 0) {
         if (cache->flush_batch_count >= cache->flush_batch_limit) {
             list_add_tail (&cache->flush, &e->list);
+            e->store_queued = 1;
             return 0;
         }
         flags = CONTENT_FLAG_CACHE_BYPASS;
@@ -530,6 +986,143 @@ static int cache_store (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
+static void cache_store_batch_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct entryvec *ev = flux_future_aux_get (f, "entries");
+    const struct content_batch *b;
+    int errnum = 0;
+
+    assert (cache->flush_batch_count >= ev->count);
+    cache->flush_batch_count -= ev->count;
+    if (content_batch_rpc_get (f, &b) < 0) {
+        errnum = errno;
+        /* Fall back to single stores if the backing store does not
+         * implement store-batch.
+         */
+        if (errnum == ENOSYS && cache->rank == 0 && cache->backing) {
+            cache->backing_nobatch = 1;
+            for (int i = 0; i < ev->count; i++) {
+                ev->entries[i]->store_pending = 0;
+                if (cache_store (cache, ev->entries[i]) < 0)
+                    cache_store_error (cache, ev->entries[i], errno);
+            }
+            goto done;
+        }
+    }
+    else if (content_batch_count (b) != ev->count) {
+        flux_log (cache->h, LOG_ERR, "content store-batch: wrong item count");
+        errnum = EPROTO;
+    }
+    for (int i = 0; i < ev->count; i++) {
+        const char *blobref;
+
+        if (errnum)
+            cache_store_result (cache, ev->entries[i], NULL, errnum);
+        else if (content_batch_get_string (b, i, &blobref) < 0)
+            cache_store_result (cache, ev->entries[i], NULL, errno);
+        else
+            cache_store_result (cache, ev->entries[i], blobref, 0);
+    }
+done:
+    flux_future_destroy (f);
+    cache_resume_flush (cache);
+}
+
+/* Store 'count' entries with store_pending already set, sending at most
+ * BATCH_MAX_COUNT blobs per store-batch request.
+ * On failure, the entries are failed with cache_store_error(), and -1 is
+ * returned with errno set.
+ */
+static int cache_store_batch (struct content_cache *cache,
+                              struct cache_entry **entries,
+                              int count)
+{
+    int flags = CONTENT_FLAG_UPSTREAM;
+
+    if (cache->rank == 0) {
+        if (cache->backing_nobatch) {
+            int last_errno = 0;
+            int rc = 0;
+
+            for (int i = 0; i < count; i++) {
+                entries[i]->store_pending = 0;
+                if (cache_store (cache, entries[i]) < 0) {
+                    last_errno = errno;
+                    cache_store_error (cache, entries[i], errno);
+                    rc = -1;
+                }
+            }
+            if (rc < 0)
+                errno = last_errno;
+            return rc;
+        }
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    }
+    while (count > 0) {
+        int n = count < BATCH_MAX_COUNT ? count : BATCH_MAX_COUNT;
+        struct content_batch *b = NULL;
+        struct entryvec *ev = NULL;
+        flux_future_t *f = NULL;
+        int errnum;
+
+        if (!(b = content_batch_create ()))
+            goto error;
+        for (int i = 0; i < n; i++) {
+            if (content_batch_append (b, entries[i]->data, entries[i]->len) < 0)
+                goto error;
+        }
+        if (!(ev = entryvec_create (entries, n))
+            || !(f = content_store_batch (cache->h, b, flags))
+            || flux_future_aux_set (f, "entries", ev, free) < 0
+            || flux_future_then (f,
+                                 -1.,
+                                 cache_store_batch_continuation,
+                                 cache) < 0)
+            goto error;
+        content_batch_destroy (b);
+        cache->flush_batch_count += n;
+        entries += n;
+        count -= n;
+        continue;
+error:
+        errnum = errno;
+        flux_log_error (cache->h, "content store-batch");
+        if (!f || !flux_future_aux_get (f, "entries"))
+            free (ev);
+        flux_future_destroy (f);
+        content_batch_destroy (b);
+        for (int i = 0; i < count; i++)
+            cache_store_error (cache, entries[i], errnum);
+        errno = errnum;
+        return -1;
+    }
+    return 0;
+}
+
+/* Add dirty entry 'e' to 'entries' for cache_store_batch(), unless a
+ * store is already pending.  On rank 0, queue it on the flush list
+ * instead if the flush batch limit would be exceeded.
+ */
+static void cache_store_collect (struct content_cache *cache,
+                                 struct cache_entry *e,
+                                 struct cache_entry **entries,
+                                 int *count)
+{
+    assert (e->valid);
+
+    if (e->store_pending || e->store_queued)
+        return;
+    if (cache->rank == 0
+        && cache->flush_batch_count + *count >= cache->flush_batch_limit) {
+        list_add_tail (&cache->flush, &e->list);
+        e->store_queued = 1;
+        return;
+    }
+    e->store_pending = 1;
+    entries[(*count)++] = e;
+}
+
 static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
@@ -538,6 +1131,7 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
     int len;
     struct cache_entry *e = NULL;
     char blobref[BLOBREF_MAX_STRING_SIZE];
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
 
     if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
         goto error;
@@ -546,11 +1140,12 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     if (blobref_hash (cache->hash_name, (uint8_t *)data, len, blobref,
-                      sizeof (blobref)) < 0)
+                      sizeof (blobref)) < 0
+        || cache_blobref_key (cache, blobref, key) < 0)
         goto error;
 
-    if (!(e = cache_entry_lookup (cache, blobref))) {
-        if (!(e = cache_entry_insert (cache, blobref)))
+    if (!(e = cache_entry_lookup (cache, key))) {
+        if (!(e = cache_entry_insert (cache, key)))
             goto error;
     }
     if (cache_entry_fill (cache, e, data, len, true) < 0)
@@ -574,6 +1169,94 @@ error:
         flux_log_error (h, "content store: flux_respond_error");
 }
 
+/* Store-batch operation
+ *
+ * Like store, but for a list of blobs.  Dirty entries are stored with
+ * a single store-batch request to the next level of the TBON (write-through)
+ * or to the backing store (write-back on rank 0), and one response is sent
+ * when all items are resolved.
+ */
+static void content_store_batch_request (flux_t *h,
+                                         flux_msg_handler_t *mh,
+                                         const flux_msg_t *msg,
+                                         void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *buf;
+    int len;
+    struct content_batch *b = NULL;
+    struct batch_request *br = NULL;
+    struct cache_entry **dirty = NULL;
+    int ndirty = 0;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(b = content_batch_decode (buf, len)))
+        goto error;
+    count = content_batch_count (b);
+    for (int i = 0; i < count; i++) {
+        if (content_batch_get (b, i, NULL, NULL) < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+    }
+    if (!(br = batch_request_create (msg, count, "store"))
+        || (count > 0 && !(dirty = calloc (count, sizeof (dirty[0])))))
+        goto error;
+    for (int i = 0; i < count; i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+        struct cache_entry *e;
+
+        (void)content_batch_get (b, i, &data, &size);
+        if (size > cache->blob_size_limit) {
+            batch_request_set (h, br, i, NULL, 0, EFBIG);
+            continue;
+        }
+        if (blobref_hash (cache->hash_name,
+                          (uint8_t *)data,
+                          size,
+                          blobref,
+                          sizeof (blobref)) < 0
+            || cache_blobref_key (cache, blobref, key) < 0) {
+            batch_request_set (h, br, i, NULL, 0, errno);
+            continue;
+        }
+        if (!(e = cache_entry_lookup (cache, key))) {
+            if (!(e = cache_entry_insert (cache, key))) {
+                batch_request_set (h, br, i, NULL, 0, errno);
+                continue;
+            }
+        }
+        if (cache_entry_fill (cache, e, data, size, true) < 0) {
+            batch_request_set (h, br, i, NULL, 0, errno);
+            continue;
+        }
+        if (e->dirty && (cache->rank > 0 || cache->backing)) {
+            cache_store_collect (cache, e, dirty, &ndirty);
+            if (cache->rank > 0) { /* write-through */
+                if (batchwait_push (&e->store_batch_waiters, br, i) < 0)
+                    batch_request_set (h, br, i, NULL, 0, errno);
+                continue;
+            }
+        }
+        batch_request_set (h, br, i, blobref, strlen (blobref) + 1, 0);
+    }
+    (void)cache_store_batch (cache, dirty, ndirty); // errors go to waiters
+    free (dirty);
+    content_batch_destroy (b);
+    batch_request_release (h, br);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content store-batch: flux_respond_error");
+    batch_request_destroy (br);
+    free (dirty);
+    content_batch_destroy (b);
+}
+
 /* Backing store is enabled/disabled by modules that provide the
  * 'content.backing' service.  At module load time, the backing module
  * informs the content service of its availability, and entries are
@@ -583,19 +1266,30 @@ error:
 
 static int cache_flush (struct content_cache *cache)
 {
+    struct cache_entry *entries[BATCH_MAX_COUNT];
     struct cache_entry *e;
     int last_errno = 0;
     int count = 0;
     int rc = 0;
 
-    while (cache->flush_batch_count < cache->flush_batch_limit) {
+    while (cache->flush_batch_count + count < cache->flush_batch_limit) {
         if (!(e = list_pop (&cache->flush, struct cache_entry, list)))
             break;
-        if (cache_store (cache, e) < 0) { // incr flush_batch_count
-            last_errno = errno;           //   and continuation will decr
-            rc = -1;
+        e->store_queued = 0;
+        e->store_pending = 1;
+        entries[count++] = e;
+        if (count == BATCH_MAX_COUNT) {
+            // incr flush_batch_count and continuation will decr
+            if (cache_store_batch (cache, entries, count) < 0) {
+                last_errno = errno;
+                rc = -1;
+            }
+            count = 0;
         }
-        count++;
+    }
+    if (cache_store_batch (cache, entries, count) < 0) {
+        last_errno = errno;
+        rc = -1;
     }
     if (rc < 0)
         errno = last_errno;
@@ -638,6 +1332,7 @@ static void content_register_backing_request (flux_t *h,
         goto error;
     }
     cache->backing = 1;
+    cache->backing_nobatch = 0;
     flux_log (h, LOG_DEBUG, "content backing store: enabled %s", name);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "error responding to register-backing request");
@@ -686,32 +1381,57 @@ static void content_dropcache_request (flux_t *h, flux_msg_handler_t *mh,
     struct cache_entry *e = NULL;
     struct cache_entry *next;
 
-    orig_size = zhashx_size (cache->entries);
+    orig_size = blobtab_count (cache->entries);
 
     list_for_each_safe (&cache->lru, e, next, list) {
         cache_entry_remove (cache, e);
     }
 
     flux_log (h, LOG_DEBUG, "content dropcache %d/%d",
-              orig_size - (int)zhashx_size (cache->entries), orig_size);
+              orig_size - blobtab_count (cache->entries), orig_size);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "content dropcache");
 }
 
+/* Estimate the per-entry overhead of the former zhashx table keyed by
+ * blobref strings: the entry plus a blobref pointer and string in one
+ * allocation, and a five word zhashx item plus its bucket pointer in
+ * another, with a word of malloc overhead for each allocation.
+ */
+static int legacy_entry_size (struct content_cache *cache)
+{
+    int bloblen = strlen (cache->hash_name) + 1 + cache->hash_len * 2 + 1;
+
+    return sizeof (struct cache_entry) + sizeof (char *) + bloblen
+        + 6 * sizeof (void *)
+        + 2 * sizeof (size_t);
+}
+
 /* Return stats about the cache.
+ * 'entry-size' is the memory used by cache->entries per entry, excluding
+ * data, and 'entry-size-saved' is its difference from legacy_entry_size().
  */
 
 static void content_stats_request (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
     struct content_cache *cache = arg;
+    int count = blobtab_count (cache->entries);
+    int entry_size = 0;
+    int entry_size_saved = 0;
 
-    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:i s:i}",
-                           "count", zhashx_size (cache->entries),
+    if (count > 0) {
+        entry_size = blobtab_memory (cache->entries) / count;
+        entry_size_saved = legacy_entry_size (cache) - entry_size;
+    }
+    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:i s:i s:i s:i}",
+                           "count", count,
                            "valid", cache->acct_valid,
                            "dirty", cache->acct_dirty,
                            "size", cache->acct_size,
-                           "flush-batch-count", cache->flush_batch_count) < 0)
+                           "flush-batch-count", cache->flush_batch_count,
+                           "entry-size", entry_size,
+                           "entry-size-saved", entry_size_saved) < 0)
         flux_log_error (h, "content stats");
 }
 
@@ -806,6 +1526,18 @@ static const struct flux_msg_handler_spec htab[] = {
         content_store_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.load-batch",
+        content_load_batch_request,
+        FLUX_ROLE_USER
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.store-batch",
+        content_store_batch_request,
+        FLUX_ROLE_USER
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.unregister-backing",
@@ -850,6 +1582,18 @@ static int content_cache_getattr (const char *name, const char **val, void *arg)
     return 0;
 }
 
+/* Get the digest size of hash type 'name'.
+ */
+static int hash_size (const char *name)
+{
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+
+    if (blobref_hash (name, NULL, 0, blobref, sizeof (blobref)) < 0)
+        return -1;
+    return blobref_strtohash (blobref, hash, sizeof (hash));
+}
+
 static int register_attrs (struct content_cache *cache, attr_t *attr)
 {
     const char *s;
@@ -913,7 +1657,7 @@ void content_cache_destroy (struct content_cache *cache)
         flux_future_destroy (cache->f_sync);
         flux_msg_handler_delvec (cache->handlers);
         free (cache->backing_name);
-        zhashx_destroy (&cache->entries);
+        blobtab_destroy (cache->entries);
         msgstack_destroy (&cache->flush_requests);
         free (cache);
         errno = saved_errno;
@@ -926,11 +1670,6 @@ struct content_cache *content_cache_create (flux_t *h, attr_t *attrs)
 
     if (!(cache = calloc (1, sizeof (*cache))))
         return NULL;
-    if (!(cache->entries = zhashx_new ()))
-        goto nomem;
-    zhashx_set_destructor (cache->entries, cache_entry_destructor);
-    zhashx_set_key_destructor (cache->entries, NULL); // key is part of entry
-    zhashx_set_key_duplicator (cache->entries, NULL); // key is part of entry
 
     cache->rank = FLUX_NODEID_ANY;
     cache->blob_size_limit = default_blob_size_limit;
@@ -945,6 +1684,11 @@ struct content_cache *content_cache_create (flux_t *h, attr_t *attrs)
 
     if (register_attrs (cache, attrs) < 0)
         goto error;
+    if ((cache->hash_len = hash_size (cache->hash_name)) < 0
+        || !(cache->entries = blobtab_create (cache->hash_len,
+                                              sizeof (struct cache_entry),
+                                              cache_entry_destroy)))
+        goto error;
 
     if (flux_msg_handler_addvec (h, htab, cache, &cache->handlers) < 0)
         goto error;
@@ -954,8 +1698,6 @@ struct content_cache *content_cache_create (flux_t *h, attr_t *attrs)
         || flux_future_then (cache->f_sync, sync_max, sync_cb, cache) < 0)
         goto error;
     return cache;
-nomem:
-    errno = ENOMEM;
 error:
     content_cache_destroy (cache);
     return NULL;
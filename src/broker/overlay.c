@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <stdarg.h>
+#include <arpa/inet.h>
 #include <czmq.h>
 #include <zmq.h>
 #include <flux/core.h>
@@ -21,13 +22,14 @@
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/log.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
 
 #include "overlay.h"
 #include "attr.h"
+#include "topology.h"
 
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
@@ -39,6 +41,35 @@
 enum {
     KEEPALIVE_STATUS_NORMAL = 0,
     KEEPALIVE_STATUS_DISCONNECT = 1,
+    KEEPALIVE_STATUS_BATCH = 2,
+};
+
+/* Optionally, small messages bound for the same peer are queued and sent
+ * together as the payload of one keepalive message with status
+ * KEEPALIVE_STATUS_BATCH.  Each message is encoded with flux_msg_encode(),
+ * preceded by its size as a 4 byte integer in network byte order.
+ * A batch is sent once 'tbon.batch-size' bytes are queued, or
+ * 'tbon.batch-timeout' after the first message was queued.
+ */
+struct batch {
+    char *buf;
+    size_t len;
+    size_t alloc;
+    int count;
+    struct timespec t0;     // when first message was queued
+};
+
+/* Batch size (messages) and latency (microseconds) are counted in
+ * power of two buckets, e.g. bucket 3 counts values in [8,16).
+ */
+#define BATCH_HIST_BUCKETS 16
+
+struct batch_stats {
+    int64_t count;
+    int64_t messages;
+    int64_t bytes;
+    int size[BATCH_HIST_BUCKETS];
+    int latency[BATCH_HIST_BUCKETS];
 };
 
 struct child {
@@ -47,6 +78,7 @@ struct child {
     char uuid[UUID_STR_LEN];
     bool connected;
     bool idle;
+    struct batch batch;
 };
 
 struct parent {
@@ -59,6 +91,7 @@ struct parent {
     char uuid[UUID_STR_LEN];
     bool hello_error;
     bool hello_responded;
+    struct batch batch;
 };
 
 /* Wake up periodically (between 'sync_min' and 'sync_max' seconds) and:
@@ -84,7 +117,7 @@ struct overlay {
 
     uint32_t size;
     uint32_t rank;
-    int tbon_k;
+    struct topology *topo;
     char uuid[UUID_STR_LEN];
     int version;
 
@@ -102,13 +135,34 @@ struct overlay {
 
     overlay_recv_f recv_cb;
     void *recv_arg;
+
+    uint32_t batch_size;        // 0 disables batching
+    double batch_timeout;
+    char batch_timeout_fsd[64];
+    flux_watcher_t *batch_w;
+    bool batch_armed;
+    int batch_pending;          // number of peers with queued messages
+    struct batch_stats batch_stats;
 };
 
 static void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg);
 static int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg);
+static int overlay_sendmsg_child_route (struct overlay *ov,
+                                        const flux_msg_t *msg,
+                                        const char **routes,
+                                        int nroutes);
 static int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg);
 static void hello_response_handler (struct overlay *ov, const flux_msg_t *msg);
 static void hello_request_handler (struct overlay *ov, const flux_msg_t *msg);
+static bool batch_enabled (struct overlay *ov,
+                           const flux_msg_t *msg,
+                           size_t *sizep);
+static int batch_append (struct overlay *ov,
+                         struct batch *batch,
+                         const flux_msg_t *msg,
+                         size_t size);
+static int batch_flush_parent (struct overlay *ov);
+static int batch_flush_child (struct overlay *ov, struct child *child);
 
 /* Convenience iterator for ov->children
  */
@@ -123,23 +177,23 @@ static void overlay_monitor_notify (struct overlay *ov)
         ov->child_monitor_cb (ov, ov->child_monitor_arg);
 }
 
-static int child_count (uint32_t rank, uint32_t size, int k)
+int overlay_set_topology (struct overlay *ov,
+                          struct topology *topo,
+                          uint32_t rank)
 {
+    const uint32_t *ranks;
     int count;
-    for (count = 0; kary_childof (k, size, rank, count) != KARY_NONE; count++)
-        ;
-    return count;
-}
 
-int overlay_set_geometry (struct overlay *ov,
-                          uint32_t size,
-                          uint32_t rank,
-                          int tbon_k)
-{
-    ov->size = size;
+    if (!topo
+        || ov->topo
+        || (count = topology_get_child_ranks (topo, rank, &ranks)) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    ov->topo = topology_incref (topo);
+    ov->size = topology_get_size (topo);
     ov->rank = rank;
-    ov->tbon_k = tbon_k;
-    ov->child_count = child_count (rank, size, tbon_k);
+    ov->child_count = count;
     if (ov->child_count > 0) {
         int i;
 
@@ -151,16 +205,38 @@ int overlay_set_geometry (struct overlay *ov,
         zhashx_set_key_destructor (ov->child_hash, NULL);
         for (i = 0; i < ov->child_count; i++) {
             struct child *child = &ov->children[i];
-            child->rank = kary_childof (tbon_k, size, rank, i);
+            child->rank = ranks[i];
         }
     }
     if (rank > 0) {
-        ov->parent.rank = kary_parentof (tbon_k, rank);
+        ov->parent.rank = topology_get_parent (topo, rank);
     }
 
     return 0;
 }
 
+int overlay_set_geometry (struct overlay *ov,
+                          uint32_t size,
+                          uint32_t rank,
+                          int tbon_k)
+{
+    struct topology *topo;
+    char uri[32];
+    int rc;
+
+    snprintf (uri, sizeof (uri), "kary:%d", tbon_k);
+    if (!(topo = topology_create (uri, size)))
+        return -1;
+    rc = overlay_set_topology (ov, topo, rank);
+    topology_decref (topo);
+    return rc;
+}
+
+struct topology *overlay_get_topology (struct overlay *ov)
+{
+    return ov->topo;
+}
+
 uint32_t overlay_get_rank (struct overlay *ov)
 {
     return ov->rank;
@@ -252,21 +328,32 @@ static struct child *child_lookup (struct overlay *ov, const char *id)
     return ov->child_hash ?  zhashx_lookup (ov->child_hash, id) : NULL;
 }
 
+static int child_rank_cmp (const void *key, const void *item)
+{
+    uint32_t rank = *(const uint32_t *)key;
+    const struct child *child = item;
+
+    if (rank < child->rank)
+        return -1;
+    if (rank > child->rank)
+        return 1;
+    return 0;
+}
+
 /* Given a rank, find a (direct) child peer.
- * Since child ranks are numerically contiguous, perform a range check
- * and index into the child array directly.
+ * Child ranks are sorted but not necessarily contiguous (e.g. binomial),
+ * so perform a binary search of the child array.
  * Returns NULL on lookup failure.
  */
 static struct child *child_lookup_byrank (struct overlay *ov, uint32_t rank)
 {
-    uint32_t first;
-    int i;
-
-    if ((first = kary_childof (ov->tbon_k, ov->size, ov->rank, 0)) == KARY_NONE
-        || (i = rank - first) < 0
-        || i >= ov->child_count)
+    if (ov->child_count == 0)
         return NULL;
-    return &ov->children[i];
+    return bsearch (&rank,
+                    ov->children,
+                    ov->child_count,
+                    sizeof (ov->children[0]),
+                    child_rank_cmp);
 }
 
 /* Look up child that provides route to 'rank' (NULL if none).
@@ -275,8 +362,10 @@ static struct child *child_lookup_route (struct overlay *ov, uint32_t rank)
 {
     uint32_t child_rank;
 
-    child_rank = kary_child_route (ov->tbon_k, ov->size, ov->rank, rank);
-    if (child_rank == KARY_NONE)
+    if (!ov->topo)
+        return NULL;
+    child_rank = topology_get_child_route (ov->topo, ov->rank, rank);
+    if (child_rank == TOPOLOGY_NONE)
         return NULL;
     return child_lookup_byrank (ov, child_rank);
 }
@@ -323,6 +412,8 @@ static int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
         errno = EHOSTUNREACH;
         goto done;
     }
+    if (ov->parent.batch.count > 0 && batch_flush_parent (ov) < 0)
+        goto done;
     rc = flux_msg_sendzsock (ov->parent.zsock, msg);
     if (rc == 0)
         ov->parent.lastsent = flux_reactor_now (ov->reactor);
@@ -330,6 +421,31 @@ done:
     return rc;
 }
 
+/* Queue 'msg' of encoded 'size' to be sent to the parent in a batch.
+ */
+static int overlay_queue_parent (struct overlay *ov,
+                                 const flux_msg_t *msg,
+                                 size_t size)
+{
+    if (batch_append (ov, &ov->parent.batch, msg, size) < 0)
+        return -1;
+    if (ov->parent.batch.len >= ov->batch_size)
+        return batch_flush_parent (ov);
+    return 0;
+}
+
+/* Send 'msg' to the parent, or queue it to be sent in a batch.
+ */
+static int overlay_sendmsg_parent_batch (struct overlay *ov,
+                                         const flux_msg_t *msg)
+{
+    size_t size;
+
+    if (ov->parent.zsock && batch_enabled (ov, msg, &size))
+        return overlay_queue_parent (ov, msg, size);
+    return overlay_sendmsg_parent (ov, msg);
+}
+
 static int overlay_keepalive_parent (struct overlay *ov, int status)
 {
     flux_msg_t *msg = NULL;
@@ -356,9 +472,10 @@ int overlay_sendmsg (struct overlay *ov,
     int type;
     uint8_t flags;
     flux_msg_t *cpy = NULL;
-    char *uuid = NULL;
+    const char *routes[2];
     uint32_t nodeid;
     struct child *child;
+    size_t size;
     int rc;
 
     if (flux_msg_get_type (msg, &type) < 0
@@ -367,9 +484,11 @@ int overlay_sendmsg (struct overlay *ov,
     switch (type) {
         case FLUX_MSGTYPE_REQUEST:
             /* If message is being routed downstream to reach 'nodeid',
-             * push the local uuid, then the next hop onto the messages's
-             * route stack so that the ROUTER socket can pop off next hop to
-             * select the peer, and our uuid remains as part of the source addr.
+             * send it with the local uuid, then the next hop pushed onto the
+             * messages's route stack so that the ROUTER socket can pop off
+             * next hop to select the peer, and our uuid remains as part of
+             * the source addr.  The routes are added as the message is sent
+             * rather than to a copy of it.
              */
             if (where == OVERLAY_ANY) {
                 if (flux_msg_get_nodeid (msg, &nodeid) < 0)
@@ -382,21 +501,22 @@ int overlay_sendmsg (struct overlay *ov,
                             errno = EHOSTUNREACH;
                             goto error;
                         }
-                        if (!(cpy = flux_msg_copy (msg, true)))
-                            goto error;
-                        if (flux_msg_push_route (cpy, ov->uuid) < 0)
+                        if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+                            errno = EPROTO;
                             goto error;
-                        if (flux_msg_push_route (cpy, child->uuid) < 0)
+                        }
+                        routes[0] = ov->uuid;
+                        routes[1] = child->uuid;
+                        if (overlay_sendmsg_child_route (ov, msg, routes, 2) < 0)
                             goto error;
-                        msg = cpy;
-                        where = OVERLAY_DOWNSTREAM;
+                        break;
                     }
                     else
                         where = OVERLAY_UPSTREAM;
                 }
             }
             if (where == OVERLAY_UPSTREAM)
-                rc = overlay_sendmsg_parent (ov, msg);
+                rc = overlay_sendmsg_parent_batch (ov, msg);
             else
                 rc = overlay_sendmsg_child (ov, msg);
             if (rc < 0)
@@ -409,15 +529,13 @@ int overlay_sendmsg (struct overlay *ov,
              */
             if (where == OVERLAY_ANY) {
                 if (ov->rank > 0
-                    && flux_msg_get_route_last (msg, &uuid) == 0
-                    && uuid != NULL
-                    && !strcmp (uuid, ov->parent.uuid))
+                    && flux_msg_cmp_route_last (msg, ov->parent.uuid))
                     where = OVERLAY_UPSTREAM;
                 else
                     where = OVERLAY_DOWNSTREAM;
             }
             if (where == OVERLAY_UPSTREAM)
-                rc = overlay_sendmsg_parent (ov, msg);
+                rc = overlay_sendmsg_parent_batch (ov, msg);
             else
                 rc = overlay_sendmsg_child (ov, msg);
             if (rc < 0)
@@ -426,6 +544,13 @@ int overlay_sendmsg (struct overlay *ov,
         case FLUX_MSGTYPE_EVENT:
             if (where == OVERLAY_DOWNSTREAM || where == OVERLAY_ANY)
                 overlay_mcast_child (ov, msg);
+            else if (ov->parent.zsock && batch_enabled (ov, msg, &size)) {
+                /* N.B. the route delimiter is added by the receiver
+                 * for messages sent in a batch.
+                 */
+                if (overlay_queue_parent (ov, msg, size) < 0)
+                    goto error;
+            }
             else {
                 /* N.B. add route delimiter if needed to pass unpublished
                  * event message upstream through router socket.
@@ -444,13 +569,11 @@ int overlay_sendmsg (struct overlay *ov,
         default:
             goto inval;
     }
-    free (uuid);
     flux_msg_decref (cpy);
     return 0;
 inval:
     errno = EINVAL;
 error:
-    ERRNO_SAFE_WRAP (free, uuid);
     flux_msg_decref (cpy);
     return -1;
 }
@@ -480,40 +603,77 @@ static int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
         errno = EHOSTUNREACH;
         goto done;
     }
+    /* Send any messages queued for this child first to preserve ordering.
+     */
+    if (ov->batch_pending > 0) {
+        struct child *child;
+        foreach_overlay_child (ov, child) {
+            if (child->batch.count > 0
+                && flux_msg_cmp_route_last (msg, child->uuid)) {
+                if (batch_flush_child (ov, child) < 0)
+                    goto done;
+                break;
+            }
+        }
+    }
     rc = flux_msg_sendzsock_ex (ov->bind_zsock, msg, true);
 done:
     return rc;
 }
 
+/* Send 'msg' as though 'routes' were pushed onto a copy of it.
+ */
+static int overlay_sendmsg_child_route (struct overlay *ov,
+                                        const flux_msg_t *msg,
+                                        const char **routes,
+                                        int nroutes)
+{
+    struct child *child;
+
+    if (!ov->bind_zsock) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    if (ov->batch_pending > 0
+        && nroutes > 0
+        && (child = child_lookup (ov, routes[nroutes - 1]))
+        && child->batch.count > 0
+        && batch_flush_child (ov, child) < 0)
+        return -1;
+    return flux_msg_sendzsock_route (ov->bind_zsock, msg, routes, nroutes, true);
+}
+
+/* Send 'msg' to 'child', or if 'size' is nonzero, queue it to be sent
+ * in a batch.
+ */
 static int overlay_mcast_child_one (struct overlay *ov,
                                     const flux_msg_t *msg,
+                                    size_t size,
                                     struct child *child)
 {
-    flux_msg_t *cpy;
-    int rc = -1;
+    const char *routes[] = { child->uuid };
 
-    if (!(cpy = flux_msg_copy (msg, true)))
-        return -1;
-    if (flux_msg_enable_route (cpy) < 0)
-        goto done;
-    if (flux_msg_push_route (cpy, child->uuid) < 0)
-        goto done;
-    if (overlay_sendmsg_child (ov, cpy) < 0)
-        goto done;
-    rc = 0;
-done:
-    flux_msg_destroy (cpy);
-    return rc;
+    if (size > 0) {
+        if (batch_append (ov, &child->batch, msg, size) < 0)
+            return -1;
+        if (child->batch.len >= ov->batch_size)
+            return batch_flush_child (ov, child);
+        return 0;
+    }
+    return overlay_sendmsg_child_route (ov, msg, routes, 1);
 }
 
 static void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
 {
     struct child *child;
     int disconnects = 0;
+    size_t size;
 
+    if (!batch_enabled (ov, msg, &size))
+        size = 0;
     foreach_overlay_child (ov, child) {
         if (child->connected) {
-            if (overlay_mcast_child_one (ov, msg, child) < 0) {
+            if (overlay_mcast_child_one (ov, msg, size, child) < 0) {
                 if (errno == EHOSTUNREACH) {
                     child->connected = false;
                     zhashx_delete (ov->child_hash, child->uuid);
@@ -530,6 +690,243 @@ static void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
         overlay_monitor_notify (ov);
 }
 
+/* Return true if 'msg' may be sent in a batch, and set '*sizep' to its
+ * encoded size for batch_append().
+ */
+static bool batch_enabled (struct overlay *ov,
+                           const flux_msg_t *msg,
+                           size_t *sizep)
+{
+    if (ov->batch_size == 0)
+        return false;
+    *sizep = flux_msg_encode_size (msg);
+    return *sizep + 4 < ov->batch_size;
+}
+
+/* Place 'val' in a power of two histogram bucket.
+ */
+static int batch_hist_bucket (double val)
+{
+    int i = 0;
+
+    while (val >= 2 && i < BATCH_HIST_BUCKETS - 1) {
+        val /= 2;
+        i++;
+    }
+    return i;
+}
+
+static int batch_append (struct overlay *ov,
+                         struct batch *batch,
+                         const flux_msg_t *msg,
+                         size_t size)
+{
+    uint32_t n = htonl (size);
+
+    if (batch->len + 4 + size > batch->alloc) {
+        size_t alloc = batch->alloc > 0 ? batch->alloc : ov->batch_size;
+        char *buf;
+
+        while (alloc < batch->len + 4 + size)
+            alloc *= 2;
+        if (!(buf = realloc (batch->buf, alloc)))
+            return -1;
+        batch->buf = buf;
+        batch->alloc = alloc;
+    }
+    if (flux_msg_encode (msg, batch->buf + batch->len + 4, size) < 0)
+        return -1;
+    memcpy (batch->buf + batch->len, &n, 4);
+    batch->len += 4 + size;
+    if (batch->count++ == 0) {
+        monotime (&batch->t0);
+        ov->batch_pending++;
+        if (!ov->batch_armed) {
+            flux_timer_watcher_reset (ov->batch_w, ov->batch_timeout, 0.);
+            flux_watcher_start (ov->batch_w);
+            ov->batch_armed = true;
+        }
+    }
+    return 0;
+}
+
+/* Encode the queued messages as a batch message and empty the queue.
+ * If the message cannot be created, the queued messages are dropped.
+ */
+static flux_msg_t *batch_encode (struct overlay *ov, struct batch *batch)
+{
+    struct batch_stats *stats = &ov->batch_stats;
+    flux_msg_t *msg;
+
+    if (!(msg = flux_keepalive_encode (0, KEEPALIVE_STATUS_BATCH))
+        || flux_msg_set_payload (msg, batch->buf, batch->len) < 0
+        || flux_msg_enable_route (msg) < 0) {
+        flux_msg_decref (msg);
+        msg = NULL;
+    }
+    stats->count++;
+    stats->messages += batch->count;
+    stats->bytes += batch->len;
+    stats->size[batch_hist_bucket (batch->count)]++;
+    stats->latency[batch_hist_bucket (monotime_since (batch->t0) * 1E3)]++;
+    batch->len = 0;
+    batch->count = 0;
+    ov->batch_pending--;
+    return msg;
+}
+
+static int batch_flush_parent (struct overlay *ov)
+{
+    flux_msg_t *msg;
+    int rc;
+
+    if (ov->parent.batch.count == 0)
+        return 0;
+    if (!(msg = batch_encode (ov, &ov->parent.batch)))
+        return -1;
+    rc = overlay_sendmsg_parent (ov, msg);
+    ERRNO_SAFE_WRAP (flux_msg_decref, msg);
+    return rc;
+}
+
+static int batch_flush_child (struct overlay *ov, struct child *child)
+{
+    const char *routes[] = { child->uuid };
+    flux_msg_t *msg;
+    int rc;
+
+    if (child->batch.count == 0)
+        return 0;
+    if (!(msg = batch_encode (ov, &child->batch)))
+        return -1;
+    rc = overlay_sendmsg_child_route (ov, msg, routes, 1);
+    ERRNO_SAFE_WRAP (flux_msg_decref, msg);
+    return rc;
+}
+
+static void batch_flush_all (struct overlay *ov)
+{
+    struct child *child;
+    int disconnects = 0;
+
+    if (batch_flush_parent (ov) < 0)
+        flux_log_error (ov->h, "error sending batch to parent");
+    foreach_overlay_child (ov, child) {
+        if (ov->batch_pending == 0)
+            break;
+        if (batch_flush_child (ov, child) < 0) {
+            if (errno == EHOSTUNREACH && child->connected) {
+                child->connected = false;
+                zhashx_delete (ov->child_hash, child->uuid);
+                disconnects++;
+            }
+            else
+                flux_log_error (ov->h,
+                                "error sending batch to child rank %lu",
+                                (unsigned long)child->rank);
+        }
+    }
+    if (disconnects)
+        overlay_monitor_notify (ov);
+}
+
+static void batch_timer_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct overlay *ov = arg;
+
+    ov->batch_armed = false;
+    batch_flush_all (ov);
+}
+
+/* Handle a message from a connected TBON child, received directly
+ * or in a batch.
+ */
+static void child_recv (struct overlay *ov, flux_msg_t *msg, int type)
+{
+    if (type == FLUX_MSGTYPE_RESPONSE) {
+        /* Response message traveling upstream requires special handling:
+         * ROUTER socket will have pushed peer id onto message as if it
+         * were a request, but the effect we want for responses is to have
+         * a route popped off at each router hop.
+         */
+        (void)flux_msg_pop_route (msg, NULL); // child id from ROUTER
+        (void)flux_msg_pop_route (msg, NULL); // my id
+    }
+    ov->recv_cb (msg, OVERLAY_DOWNSTREAM, ov->recv_arg);
+}
+
+/* Handle a message from the TBON parent, received directly or in a batch.
+ */
+static int parent_recv (struct overlay *ov, flux_msg_t *msg, int type)
+{
+    if (type == FLUX_MSGTYPE_EVENT) {
+        if (flux_msg_clear_route (msg) < 0)
+            return -1;
+    }
+    ov->recv_cb (msg, OVERLAY_UPSTREAM, ov->recv_arg);
+    return 0;
+}
+
+/* Unpack a batch message received from 'child' (NULL if from the parent)
+ * and handle each message in it.  Messages from a child are given the
+ * route that the ROUTER socket would have pushed had they been sent
+ * individually.
+ */
+static void batch_recv (struct overlay *ov,
+                        const flux_msg_t *msg,
+                        struct child *child)
+{
+    const void *buf;
+    int size;
+    int offset = 0;
+
+    if (flux_msg_get_payload (msg, &buf, &size) < 0)
+        goto error;
+    while (offset < size) {
+        flux_msg_t *inner;
+        uint32_t n;
+        int type;
+
+        if (size - offset < 4)
+            goto error;
+        memcpy (&n, (char *)buf + offset, 4);
+        n = ntohl (n);
+        offset += 4;
+        if (n > (uint32_t)(size - offset)
+            || !(inner = flux_msg_decode ((char *)buf + offset, n)))
+            goto error;
+        offset += n;
+        if (flux_msg_get_type (inner, &type) < 0
+            || type == FLUX_MSGTYPE_KEEPALIVE) {
+            flux_msg_decref (inner);
+            goto error;
+        }
+        if (child) {
+            if (flux_msg_enable_route (inner) < 0
+                || flux_msg_push_route (inner, child->uuid) < 0) {
+                flux_msg_decref (inner);
+                goto error;
+            }
+            child_recv (ov, inner, type);
+        }
+        else if (parent_recv (ov, inner, type) < 0) {
+            flux_msg_decref (inner);
+            goto error;
+        }
+        flux_msg_decref (inner);
+    }
+    return;
+error:
+    flux_log (ov->h,
+              LOG_ERR,
+              "DROP %s batch from %s",
+              child ? "downstream" : "upstream",
+              child ? child->uuid : ov->parent.uuid);
+}
+
 /* Handle a message received from TBON child (downstream).
  */
 static void child_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -559,29 +956,23 @@ static void child_cb (flux_reactor_t *r, flux_watcher_t *w,
     child->lastseen = flux_reactor_now (ov->reactor);
     switch (type) {
         case FLUX_MSGTYPE_KEEPALIVE:
-            if (flux_keepalive_decode (msg, NULL, &status) == 0
-                && status == KEEPALIVE_STATUS_DISCONNECT
+            if (flux_keepalive_decode (msg, NULL, &status) < 0)
+                goto handled;
+            if (status == KEEPALIVE_STATUS_DISCONNECT
                 && child->connected == true) {
                 child->connected = false;
                 zhashx_delete (ov->child_hash, child->uuid);
                 overlay_monitor_notify (ov);
             }
+            else if (status == KEEPALIVE_STATUS_BATCH)
+                batch_recv (ov, msg, child);
             goto handled;
         case FLUX_MSGTYPE_REQUEST:
-            break;
         case FLUX_MSGTYPE_RESPONSE:
-            /* Response message traveling upstream requires special handling:
-             * ROUTER socket will have pushed peer id onto message as if it
-             * were a request, but the effect we want for responses is to have
-             * a route popped off at each router hop.
-             */
-            (void)flux_msg_pop_route (msg, NULL); // child id from ROUTER
-            (void)flux_msg_pop_route (msg, NULL); // my id
-            break;
         case FLUX_MSGTYPE_EVENT:
             break;
     }
-    ov->recv_cb (msg, OVERLAY_DOWNSTREAM, ov->recv_arg);
+    child_recv (ov, msg, type);
 handled:
     free (sender);
     flux_msg_decref (msg);
@@ -619,12 +1010,16 @@ static void parent_cb (flux_reactor_t *r, flux_watcher_t *w,
         hello_response_handler (ov, msg);
         goto handled;
     }
-    if (type == FLUX_MSGTYPE_EVENT) {
-        if (flux_msg_clear_route (msg) < 0) {
-            goto drop;
+    if (type == FLUX_MSGTYPE_KEEPALIVE) {
+        int status;
+        if (flux_keepalive_decode (msg, NULL, &status) == 0
+            && status == KEEPALIVE_STATUS_BATCH) {
+            batch_recv (ov, msg, NULL);
+            goto handled;
         }
     }
-    ov->recv_cb (msg, OVERLAY_UPSTREAM, ov->recv_arg);
+    if (parent_recv (ov, msg, type) < 0)
+        goto drop;
 handled:
     flux_msg_destroy (msg);
     return;
@@ -988,6 +1383,13 @@ static int overlay_attr_get_cb (const char *name, const char **val, void *arg)
 
     if (!strcmp (name, "tbon.parent-endpoint"))
         *val = overlay_get_parent_uri (overlay);
+    else if (!strcmp (name, "tbon.batch-timeout")) {
+        if (fsd_format_duration (overlay->batch_timeout_fsd,
+                                 sizeof (overlay->batch_timeout_fsd),
+                                 overlay->batch_timeout) < 0)
+            goto done;
+        *val = overlay->batch_timeout_fsd;
+    }
     else {
         errno = ENOENT;
         goto done;
@@ -997,14 +1399,35 @@ done:
     return rc;
 }
 
-int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
+static int overlay_attr_set_cb (const char *name, const char *val, void *arg)
 {
-    int tbon_level = kary_levelof (overlay->tbon_k, overlay->rank);
-    int tbon_maxlevel = kary_levelof (overlay->tbon_k, overlay->size - 1);
-    int tbon_descendants = kary_sum_descendants (overlay->tbon_k,
-                                                 overlay->size,
-                                                 overlay->rank);
+    struct overlay *overlay = arg;
+    double timeout;
 
+    if (!strcmp (name, "tbon.batch-timeout")) {
+        if (fsd_parse_duration (val, &timeout) < 0)
+            return -1;
+        overlay->batch_timeout = timeout;
+        return 0;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
+{
+    struct topology *topo = overlay->topo;
+    int tbon_level = 0;
+    int tbon_maxlevel = 0;
+    int tbon_descendants = 0;
+    int tbon_arity = 0;
+
+    if (topo) {
+        tbon_level = topology_get_level (topo, overlay->rank);
+        tbon_maxlevel = topology_get_maxlevel (topo);
+        tbon_descendants = topology_get_descendant_count (topo, overlay->rank);
+        tbon_arity = topology_get_arity (topo);
+    }
     if (attr_add_active (attrs, "tbon.parent-endpoint",
                          FLUX_ATTRFLAG_READONLY,
                          overlay_attr_get_cb, NULL, overlay) < 0)
@@ -1015,9 +1438,21 @@ int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
     if (attr_add_uint32 (attrs, "size", overlay->size,
                          FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.arity", overlay->tbon_k,
+    if (attr_add_int (attrs, "tbon.arity", tbon_arity,
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
+    /* tbon.topo may have been set on the command line to select the
+     * topology at boot.  Either way it becomes immutable now.
+     */
+    if (attr_get (attrs, "tbon.topo", NULL, NULL) == 0) {
+        if (attr_set_flags (attrs, "tbon.topo", FLUX_ATTRFLAG_IMMUTABLE) < 0)
+            return -1;
+    }
+    else if (attr_add (attrs,
+                       "tbon.topo",
+                       topo ? topology_get_uri (topo) : NULL,
+                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
+        return -1;
     if (attr_add_int (attrs, "tbon.level", tbon_level,
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
@@ -1027,6 +1462,14 @@ int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
     if (attr_add_int (attrs, "tbon.descendants", tbon_descendants,
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
+    if (attr_add_active_uint32 (attrs, "tbon.batch-size",
+                                &overlay->batch_size, 0) < 0)
+        return -1;
+    if (attr_add_active (attrs, "tbon.batch-timeout", 0,
+                         overlay_attr_get_cb,
+                         overlay_attr_set_cb,
+                         overlay) < 0)
+        return -1;
 
     return 0;
 }
@@ -1039,24 +1482,61 @@ void overlay_set_monitor_cb (struct overlay *ov,
     ov->child_monitor_arg = arg;
 }
 
+static json_t *batch_hist_tojson (const int *hist)
+{
+    json_t *a;
+    json_t *o;
+
+    if (!(a = json_array ()))
+        goto nomem;
+    for (int i = 0; i < BATCH_HIST_BUCKETS; i++) {
+        if (!(o = json_integer (hist[i]))
+            || json_array_append_new (a, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    return a;
+nomem:
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
 static void overlay_stats_get_cb (flux_t *h,
                                   flux_msg_handler_t *mh,
                                   const flux_msg_t *msg,
                                   void *arg)
 {
     struct overlay *ov = arg;
+    struct batch_stats *stats = &ov->batch_stats;
+    json_t *size = NULL;
+    json_t *latency = NULL;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
+    if (!(size = batch_hist_tojson (stats->size))
+        || !(latency = batch_hist_tojson (stats->latency)))
+        goto error;
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:i s:i}",
+                           "{s:i s:i s:i s:{s:I s:I s:I s:O s:O}}",
                            "child-count", ov->child_count,
                            "child-connected", overlay_get_child_peer_count (ov),
-                           "parent-count", ov->rank > 0 ? 1 : 0) < 0)
+                           "parent-count", ov->rank > 0 ? 1 : 0,
+                           "batch",
+                             "count", (json_int_t)stats->count,
+                             "messages", (json_int_t)stats->messages,
+                             "bytes", (json_int_t)stats->bytes,
+                             "size", size,
+                             "latency", latency) < 0)
         flux_log_error (h, "error responding to overlay.stats.get");
+    json_decref (size);
+    json_decref (latency);
     return;
 error:
+    json_decref (size);
+    json_decref (latency);
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "error responding to overlay.stats.get");
 }
@@ -1130,6 +1610,8 @@ void overlay_destroy (struct overlay *ov)
 
         flux_future_destroy (ov->f_sync);
         flux_msg_handler_delvec (ov->handlers);
+        batch_flush_all (ov);
+        flux_watcher_destroy (ov->batch_w);
         overlay_keepalive_parent (ov, KEEPALIVE_STATUS_DISCONNECT);
 
         zsock_destroy (&ov->parent.zsock);
@@ -1142,7 +1624,14 @@ void overlay_destroy (struct overlay *ov)
         flux_watcher_destroy (ov->bind_w);
 
         zhashx_destroy (&ov->child_hash);
-        free (ov->children);
+        if (ov->children) {
+            struct child *child;
+            foreach_overlay_child (ov, child)
+                free (child->batch.buf);
+            free (ov->children);
+        }
+        free (ov->parent.batch.buf);
+        topology_decref (ov->topo);
         free (ov);
         errno = saved_errno;
     }
@@ -1172,6 +1661,7 @@ struct overlay *overlay_create (flux_t *h, overlay_recv_f cb, void *arg)
     ov->recv_cb = cb;
     ov->recv_arg = arg;
     ov->version = FLUX_CORE_VERSION_HEX;
+    ov->batch_timeout = 0.001;
     uuid_generate (uuid);
     uuid_unparse (uuid, ov->uuid);
     if (flux_msg_handler_addvec (h, htab, ov, &ov->handlers) < 0)
@@ -1179,6 +1669,12 @@ struct overlay *overlay_create (flux_t *h, overlay_recv_f cb, void *arg)
     if (!(ov->f_sync = flux_sync_create (h, sync_min))
         || flux_future_then (ov->f_sync, sync_max, sync_cb, ov) < 0)
         goto error;
+    if (!(ov->batch_w = flux_timer_watcher_create (ov->reactor,
+                                                   0.,
+                                                   0.,
+                                                   batch_timer_cb,
+                                                   ov)))
+        goto error;
     if (!(ov->cert = zcert_new ()))
         goto nomem;
     if (!(ov->certstore = zcertstore_new (NULL)))
@@ -12,6 +12,7 @@
 #define _BROKER_OVERLAY_H
 
 #include "attr.h"
+#include "topology.h"
 
 typedef enum {
     OVERLAY_ANY = 0,
@@ -32,7 +33,16 @@ typedef void (*overlay_recv_f)(const flux_msg_t *msg,
 struct overlay *overlay_create (flux_t *h, overlay_recv_f cb, void *arg);
 void overlay_destroy (struct overlay *ov);
 
-/* Set the overlay network size, rank, and TBON branching factor.
+/* Set the overlay network topology and the rank of this broker in it.
+ * The overlay takes a reference on 'topo'.  This may be called only once.
+ */
+int overlay_set_topology (struct overlay *ov,
+                          struct topology *topo,
+                          uint32_t rank);
+struct topology *overlay_get_topology (struct overlay *ov);
+
+/* Set the overlay network size, rank, and TBON branching factor,
+ * using a k-ary topology.
  */
 int overlay_set_geometry (struct overlay *ov,
                           uint32_t size,
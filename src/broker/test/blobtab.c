@@ -0,0 +1,206 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobref.h"
+
+#include "blobtab.h"
+
+#define KEYSIZE 20
+
+struct item {
+    int id;
+    char pad[100];
+};
+
+static int destroyed;
+
+static void item_destructor (void *arg)
+{
+    destroyed++;
+}
+
+static void make_key (int id, uint8_t key[KEYSIZE])
+{
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+
+    if (blobref_hash ("sha1", &id, sizeof (id), blobref, sizeof (blobref)) < 0
+        || blobref_strtohash (blobref, key, KEYSIZE) != KEYSIZE)
+        BAIL_OUT ("could not create key");
+}
+
+/* Keys that share a hash value (leading bytes), to exercise probing.
+ */
+static void make_colliding_key (int id, uint8_t key[KEYSIZE])
+{
+    memset (key, 0, KEYSIZE);
+    memcpy (key + KEYSIZE - sizeof (id), &id, sizeof (id));
+}
+
+void test_basic (void)
+{
+    struct blobtab *bt;
+    uint8_t key[KEYSIZE];
+    struct item *item;
+
+    ok (blobtab_create (0, sizeof (struct item), NULL) == NULL
+        && errno == EINVAL,
+        "blobtab_create keysize=0 fails with EINVAL");
+    ok (blobtab_create (KEYSIZE, 1024*1024, NULL) == NULL
+        && errno == EINVAL,
+        "blobtab_create with oversized item fails with EINVAL");
+
+    bt = blobtab_create (KEYSIZE, sizeof (struct item), item_destructor);
+    ok (bt != NULL,
+        "blobtab_create works");
+    ok (blobtab_count (bt) == 0,
+        "blobtab_count returns 0");
+    make_key (1, key);
+    ok (blobtab_lookup (bt, key) == NULL,
+        "blobtab_lookup on empty table returns NULL");
+    item = blobtab_insert (bt, key);
+    ok (item != NULL && item->id == 0,
+        "blobtab_insert returns zeroed item");
+    item->id = 1;
+    ok (blobtab_count (bt) == 1,
+        "blobtab_count returns 1");
+    ok (memcmp (blobtab_key (bt, item), key, KEYSIZE) == 0,
+        "blobtab_key returns the item's key");
+    ok (blobtab_lookup (bt, key) == item,
+        "blobtab_lookup finds item");
+    errno = 0;
+    ok (blobtab_insert (bt, key) == NULL && errno == EEXIST,
+        "blobtab_insert of duplicate key fails with EEXIST");
+    ok (blobtab_memory (bt) > 0,
+        "blobtab_memory is nonzero");
+    destroyed = 0;
+    blobtab_remove (bt, item);
+    ok (destroyed == 1,
+        "blobtab_remove called destructor");
+    ok (blobtab_count (bt) == 0 && blobtab_lookup (bt, key) == NULL,
+        "blobtab_remove removed item");
+
+    item = blobtab_insert (bt, key);
+    ok (item != NULL,
+        "blobtab_insert works after remove");
+    destroyed = 0;
+    blobtab_destroy (bt);
+    ok (destroyed == 1,
+        "blobtab_destroy called destructor on remaining item");
+
+    lives_ok ({blobtab_destroy (NULL);},
+              "blobtab_destroy NULL doesn't crash");
+    ok (blobtab_lookup (NULL, key) == NULL,
+        "blobtab_lookup bt=NULL returns NULL");
+    errno = 0;
+    ok (blobtab_insert (NULL, key) == NULL && errno == EINVAL,
+        "blobtab_insert bt=NULL fails with EINVAL");
+}
+
+/* Insert, look up and remove enough items to span several slabs
+ * and index resizes.
+ */
+void test_load (void (*make)(int id, uint8_t key[KEYSIZE]),
+                int count,
+                const char *name)
+{
+    struct blobtab *bt;
+    uint8_t key[KEYSIZE];
+    struct item *item;
+    int errors;
+    size_t mem_full;
+
+    if (!(bt = blobtab_create (KEYSIZE, sizeof (struct item), NULL)))
+        BAIL_OUT ("blobtab_create failed");
+
+    errors = 0;
+    for (int i = 0; i < count; i++) {
+        make (i, key);
+        if (!(item = blobtab_insert (bt, key)))
+            errors++;
+        else
+            item->id = i;
+    }
+    ok (errors == 0 && blobtab_count (bt) == count,
+        "%s: inserted %d items", name, count);
+    mem_full = blobtab_memory (bt);
+
+    errors = 0;
+    for (int i = 0; i < count; i++) {
+        make (i, key);
+        if (!(item = blobtab_lookup (bt, key)) || item->id != i)
+            errors++;
+    }
+    ok (errors == 0,
+        "%s: found all items", name);
+
+    /* Remove even items, then verify odd ones can still be found
+     * after backward shift deletion.
+     */
+    errors = 0;
+    for (int i = 0; i < count; i += 2) {
+        make (i, key);
+        if (!(item = blobtab_lookup (bt, key)))
+            errors++;
+        else
+            blobtab_remove (bt, item);
+    }
+    ok (errors == 0 && blobtab_count (bt) == count / 2,
+        "%s: removed even items", name);
+    errors = 0;
+    for (int i = 0; i < count; i++) {
+        make (i, key);
+        item = blobtab_lookup (bt, key);
+        if ((i % 2 == 0 && item != NULL)
+            || (i % 2 == 1 && (!item || item->id != i)))
+            errors++;
+    }
+    ok (errors == 0,
+        "%s: only odd items remain", name);
+
+    errors = 0;
+    for (int i = 1; i < count; i += 2) {
+        make (i, key);
+        if (!(item = blobtab_lookup (bt, key)))
+            errors++;
+        else
+            blobtab_remove (bt, item);
+    }
+    ok (errors == 0 && blobtab_count (bt) == 0,
+        "%s: removed odd items", name);
+    ok (blobtab_memory (bt) < mem_full,
+        "%s: empty slabs were released", name);
+
+    blobtab_destroy (bt);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_load (make_key, 100000, "digest keys");
+    test_load (make_colliding_key, 5000, "colliding keys");
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,227 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/kary.h"
+
+#include "topology.h"
+
+/* Check that the kary topology agrees with libutil/kary for all ranks.
+ */
+static void test_kary (int k, uint32_t size)
+{
+    struct topology *topo;
+    char uri[32];
+    int errors = 0;
+
+    snprintf (uri, sizeof (uri), "kary:%d", k);
+    if (!(topo = topology_create (uri, size)))
+        BAIL_OUT ("topology_create kary:%d size=%u failed", k, size);
+    ok (topology_get_arity (topo) == k,
+        "kary:%d size=%u: arity is %d", k, size, k);
+    ok (topology_get_maxlevel (topo) == kary_levelof (k, size - 1),
+        "kary:%d size=%u: maxlevel is correct", k, size);
+    for (uint32_t rank = 0; rank < size; rank++) {
+        const uint32_t *children;
+        int count;
+
+        if (topology_get_parent (topo, rank) != kary_parentof (k, rank)
+            || topology_get_level (topo, rank) != kary_levelof (k, rank)
+            || topology_get_descendant_count (topo, rank)
+                != kary_sum_descendants (k, size, rank))
+            errors++;
+        count = topology_get_child_ranks (topo, rank, &children);
+        for (int i = 0; i < count; i++) {
+            if (children[i] != kary_childof (k, size, rank, i))
+                errors++;
+        }
+        if (kary_childof (k, size, rank, count) != KARY_NONE)
+            errors++;
+        for (uint32_t dst = 0; dst < size; dst += 7) {
+            if (topology_get_child_route (topo, rank, dst)
+                != kary_child_route (k, size, rank, dst))
+                errors++;
+        }
+    }
+    ok (errors == 0,
+        "kary:%d size=%u: all ranks agree with libutil/kary", k, size);
+    topology_decref (topo);
+}
+
+static void test_binomial (void)
+{
+    struct topology *topo;
+    const uint32_t *children;
+
+    if (!(topo = topology_create ("binomial", 16)))
+        BAIL_OUT ("topology_create binomial failed");
+    ok (topology_get_child_ranks (topo, 0, &children) == 4
+        && children[0] == 1
+        && children[1] == 2
+        && children[2] == 4
+        && children[3] == 8,
+        "binomial: rank 0 has children 1,2,4,8");
+    ok (topology_get_child_ranks (topo, 8, &children) == 3
+        && children[0] == 9
+        && children[1] == 10
+        && children[2] == 12,
+        "binomial: rank 8 has children 9,10,12");
+    ok (topology_get_parent (topo, 15) == 14
+        && topology_get_parent (topo, 14) == 12
+        && topology_get_parent (topo, 12) == 8
+        && topology_get_parent (topo, 8) == 0,
+        "binomial: rank 15 has ancestors 14,12,8,0");
+    ok (topology_get_level (topo, 15) == 4
+        && topology_get_maxlevel (topo) == 4,
+        "binomial: rank 15 is at the maximum level 4");
+    ok (topology_get_descendant_count (topo, 0) == 15
+        && topology_get_descendant_count (topo, 8) == 7
+        && topology_get_descendant_count (topo, 15) == 0,
+        "binomial: descendant counts are correct");
+    ok (topology_get_arity (topo) == 4,
+        "binomial: arity is the root's child count");
+    ok (topology_get_child_route (topo, 0, 13) == 8
+        && topology_get_child_route (topo, 8, 13) == 12
+        && topology_get_child_route (topo, 12, 13) == 13
+        && topology_get_child_route (topo, 4, 13) == TOPOLOGY_NONE
+        && topology_get_child_route (topo, 13, 13) == TOPOLOGY_NONE,
+        "binomial: child routes are correct");
+    topology_decref (topo);
+}
+
+static void test_flatroot (void)
+{
+    struct topology *topo;
+    const uint32_t *children;
+
+    if (!(topo = topology_create ("flatroot:4:2", 16)))
+        BAIL_OUT ("topology_create flatroot:4:2 failed");
+    ok (topology_get_child_ranks (topo, 0, &children) == 4
+        && children[0] == 1
+        && children[3] == 4,
+        "flatroot:4:2: rank 0 has children 1-4");
+    ok (topology_get_child_ranks (topo, 1, &children) == 2
+        && children[0] == 5
+        && children[1] == 6,
+        "flatroot:4:2: rank 1 has children 5,6");
+    ok (topology_get_child_ranks (topo, 5, &children) == 2
+        && children[0] == 13
+        && children[1] == 14,
+        "flatroot:4:2: rank 5 has children 13,14");
+    ok (topology_get_maxlevel (topo) == 3
+        && topology_get_level (topo, 15) == 3,
+        "flatroot:4:2: maxlevel is 3");
+    ok (topology_get_child_route (topo, 0, 15) == 1
+        && topology_get_child_route (topo, 1, 15) == 6
+        && topology_get_child_route (topo, 2, 15) == TOPOLOGY_NONE,
+        "flatroot:4:2: child routes are correct");
+    ok (topology_get_arity (topo) == 4,
+        "flatroot:4:2: arity is the root's child count");
+    topology_decref (topo);
+
+    if (!(topo = topology_create ("flatroot:1000", 16)))
+        BAIL_OUT ("topology_create flatroot:1000 failed");
+    ok (topology_get_child_ranks (topo, 0, NULL) == 15
+        && topology_get_maxlevel (topo) == 1
+        && topology_get_arity (topo) == 15,
+        "flatroot:1000: all ranks are children of the root");
+    topology_decref (topo);
+}
+
+static void test_size1 (void)
+{
+    const char *uris[] = { "kary:2", "binomial", "flatroot:8" };
+
+    for (int i = 0; i < sizeof (uris) / sizeof (uris[0]); i++) {
+        struct topology *topo;
+
+        if (!(topo = topology_create (uris[i], 1)))
+            BAIL_OUT ("topology_create %s size=1 failed", uris[i]);
+        ok (topology_get_parent (topo, 0) == TOPOLOGY_NONE
+            && topology_get_child_ranks (topo, 0, NULL) == 0
+            && topology_get_maxlevel (topo) == 0
+            && topology_get_descendant_count (topo, 0) == 0,
+            "%s size=1: rank 0 has no parent or children", uris[i]);
+        topology_decref (topo);
+    }
+}
+
+static void test_inval (void)
+{
+    const char *uris[] = {
+        "", "kary", "kary:", "kary:0", "kary:-1", "kary:2x", "kary:2:3",
+        "binomial:2", "flatroot", "flatroot:0", "flatroot:2:", "flatroot:2:0",
+        "foo", "foo:1",
+    };
+    struct topology *topo;
+
+    for (int i = 0; i < sizeof (uris) / sizeof (uris[0]); i++) {
+        errno = 0;
+        ok (topology_create (uris[i], 4) == NULL && errno == EINVAL,
+            "topology_create '%s' fails with EINVAL", uris[i]);
+    }
+    errno = 0;
+    ok (topology_create (NULL, 4) == NULL && errno == EINVAL,
+        "topology_create uri=NULL fails with EINVAL");
+    errno = 0;
+    ok (topology_create ("kary:2", 0) == NULL && errno == EINVAL,
+        "topology_create size=0 fails with EINVAL");
+
+    if (!(topo = topology_create ("kary:2", 4)))
+        BAIL_OUT ("topology_create kary:2 failed");
+    ok (topology_get_parent (topo, 4) == TOPOLOGY_NONE,
+        "topology_get_parent rank=size returns TOPOLOGY_NONE");
+    errno = 0;
+    ok (topology_get_child_ranks (topo, 4, NULL) < 0 && errno == EINVAL,
+        "topology_get_child_ranks rank=size fails with EINVAL");
+    errno = 0;
+    ok (topology_get_level (topo, 4) < 0 && errno == EINVAL,
+        "topology_get_level rank=size fails with EINVAL");
+    errno = 0;
+    ok (topology_get_descendant_count (topo, 4) < 0 && errno == EINVAL,
+        "topology_get_descendant_count rank=size fails with EINVAL");
+    ok (topology_get_child_route (topo, 0, 42) == TOPOLOGY_NONE,
+        "topology_get_child_route dst=42 returns TOPOLOGY_NONE");
+    ok (topology_incref (topo) == topo,
+        "topology_incref returns its argument");
+    topology_decref (topo);
+    ok (topology_get_size (topo) == 4,
+        "topology is still valid after one decref");
+    topology_decref (topo);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_kary (2, 1);
+    test_kary (2, 1000);
+    test_kary (3, 1024);
+    test_kary (16, 10000);
+    test_binomial ();
+    test_flatroot ();
+    test_size1 ();
+    test_inval ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
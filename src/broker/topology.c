@@ -0,0 +1,310 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topology.c - TBON topologies
+ *
+ * Each topology type is a plugin that fills in the parent of every
+ * non-root rank.  The generic code then derives children, levels, and
+ * descendant counts for all ranks in one pass each, so that queries made
+ * while routing messages are O(1), or O(depth) for child routes.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "topology.h"
+
+struct topology {
+    int refcount;
+    char *uri;
+    uint32_t size;
+    int arity;
+    int maxlevel;
+    uint32_t *parent;       // parent[rank]
+    uint32_t *child_index;  // children of rank: child_index[rank..rank+1]
+    uint32_t *children;
+    int *level;
+    int *descendants;
+};
+
+struct topology_plugin {
+    const char *name;
+    int (*init)(struct topology *topo, const char *args);
+};
+
+/* Parse a positive integer argument from the front of 's', returning a
+ * pointer past it in '*endptr'.
+ */
+static int parse_arg (const char *s, int *value, const char **endptr)
+{
+    char *end;
+    unsigned long n;
+
+    if (!s || *s < '0' || *s > '9')
+        return -1;
+    errno = 0;
+    n = strtoul (s, &end, 10);
+    if (errno != 0 || n < 1 || n > INT32_MAX)
+        return -1;
+    *value = n;
+    *endptr = end;
+    return 0;
+}
+
+/* kary:K
+ */
+static int kary_init (struct topology *topo, const char *args)
+{
+    const char *end;
+    int k;
+
+    if (parse_arg (args, &k, &end) < 0 || *end != '\0')
+        return -1;
+    for (uint32_t rank = 1; rank < topo->size; rank++)
+        topo->parent[rank] = (rank - 1) / k;
+    topo->arity = k;
+    return 0;
+}
+
+/* binomial
+ */
+static int binomial_init (struct topology *topo, const char *args)
+{
+    if (args)
+        return -1;
+    topo->arity = 0;
+    for (uint32_t rank = 1; rank < topo->size; rank++) {
+        topo->parent[rank] = rank & (rank - 1);
+        if (topo->parent[rank] == 0)
+            topo->arity++;
+    }
+    return 0;
+}
+
+/* flatroot:N[:K]
+ */
+static int flatroot_init (struct topology *topo, const char *args)
+{
+    const char *end;
+    int n;
+    int k = 2;
+
+    if (parse_arg (args, &n, &end) < 0)
+        return -1;
+    if (*end == ':') {
+        if (parse_arg (end + 1, &k, &end) < 0)
+            return -1;
+    }
+    if (*end != '\0')
+        return -1;
+    for (uint32_t rank = 1; rank < topo->size; rank++) {
+        if (rank <= (uint32_t)n)
+            topo->parent[rank] = 0;
+        else
+            topo->parent[rank] = 1 + (rank - 1 - n) / k;
+    }
+    topo->arity = topo->size - 1 < (uint32_t)n ? topo->size - 1 : n;
+    return 0;
+}
+
+static const struct topology_plugin plugins[] = {
+    { "kary", kary_init },
+    { "binomial", binomial_init },
+    { "flatroot", flatroot_init },
+};
+
+static const struct topology_plugin *plugin_lookup (const char *name)
+{
+    for (int i = 0; i < sizeof (plugins) / sizeof (plugins[0]); i++) {
+        if (!strcmp (plugins[i].name, name))
+            return &plugins[i];
+    }
+    return NULL;
+}
+
+/* Derive children, levels, and descendant counts from topo->parent.
+ * Since every parent's rank is lower than its children's ranks, levels
+ * can be computed in rank order and descendant counts in reverse rank
+ * order, and the children of each rank come out sorted.
+ */
+static int topology_build (struct topology *topo)
+{
+    uint32_t size = topo->size;
+
+    topo->level[0] = 0;
+    topo->maxlevel = 0;
+    for (uint32_t rank = 1; rank < size; rank++) {
+        uint32_t parent = topo->parent[rank];
+        if (parent >= rank)
+            return -1;
+        topo->level[rank] = topo->level[parent] + 1;
+        if (topo->maxlevel < topo->level[rank])
+            topo->maxlevel = topo->level[rank];
+        topo->child_index[parent + 1]++;
+    }
+    for (uint32_t rank = 0; rank < size; rank++)
+        topo->child_index[rank + 1] += topo->child_index[rank];
+    for (uint32_t rank = 1; rank < size; rank++) {
+        uint32_t parent = topo->parent[rank];
+        uint32_t i = topo->child_index[parent] + topo->descendants[parent]++;
+        topo->children[i] = rank;
+    }
+    memset (topo->descendants, 0, sizeof (topo->descendants[0]) * size);
+    for (uint32_t rank = size - 1; rank > 0; rank--)
+        topo->descendants[topo->parent[rank]] += topo->descendants[rank] + 1;
+    return 0;
+}
+
+struct topology *topology_create (const char *uri, uint32_t size)
+{
+    struct topology *topo;
+    const struct topology_plugin *plugin;
+    char *name = NULL;
+    char *args;
+
+    if (!uri || size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(topo = calloc (1, sizeof (*topo))))
+        return NULL;
+    topo->refcount = 1;
+    topo->size = size;
+    if (!(topo->uri = strdup (uri))
+        || !(name = strdup (uri))
+        || !(topo->parent = calloc (size, sizeof (topo->parent[0])))
+        || !(topo->child_index = calloc ((size_t)size + 1,
+                                         sizeof (topo->child_index[0])))
+        || !(topo->children = calloc (size, sizeof (topo->children[0])))
+        || !(topo->level = calloc (size, sizeof (topo->level[0])))
+        || !(topo->descendants = calloc (size,
+                                         sizeof (topo->descendants[0]))))
+        goto error;
+    if ((args = strchr (name, ':')))
+        *args++ = '\0';
+    topo->parent[0] = TOPOLOGY_NONE;
+    if (!(plugin = plugin_lookup (name))
+        || plugin->init (topo, args) < 0
+        || topology_build (topo) < 0) {
+        errno = EINVAL;
+        goto error;
+    }
+    free (name);
+    return topo;
+error:
+    free (name);
+    topology_decref (topo);
+    return NULL;
+}
+
+struct topology *topology_incref (struct topology *topo)
+{
+    if (topo)
+        topo->refcount++;
+    return topo;
+}
+
+void topology_decref (struct topology *topo)
+{
+    if (topo && --topo->refcount == 0) {
+        int saved_errno = errno;
+        free (topo->uri);
+        free (topo->parent);
+        free (topo->child_index);
+        free (topo->children);
+        free (topo->level);
+        free (topo->descendants);
+        free (topo);
+        errno = saved_errno;
+    }
+}
+
+const char *topology_get_uri (struct topology *topo)
+{
+    return topo->uri;
+}
+
+uint32_t topology_get_size (struct topology *topo)
+{
+    return topo->size;
+}
+
+int topology_get_arity (struct topology *topo)
+{
+    return topo->arity;
+}
+
+uint32_t topology_get_parent (struct topology *topo, uint32_t rank)
+{
+    if (rank >= topo->size)
+        return TOPOLOGY_NONE;
+    return topo->parent[rank];
+}
+
+int topology_get_child_ranks (struct topology *topo,
+                              uint32_t rank,
+                              const uint32_t **ranks)
+{
+    if (rank >= topo->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (ranks)
+        *ranks = &topo->children[topo->child_index[rank]];
+    return topo->child_index[rank + 1] - topo->child_index[rank];
+}
+
+int topology_get_level (struct topology *topo, uint32_t rank)
+{
+    if (rank >= topo->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return topo->level[rank];
+}
+
+int topology_get_maxlevel (struct topology *topo)
+{
+    return topo->maxlevel;
+}
+
+int topology_get_descendant_count (struct topology *topo, uint32_t rank)
+{
+    if (rank >= topo->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return topo->descendants[rank];
+}
+
+/* Walk up from 'dst' until reaching a child of 'src'.  Ancestors have
+ * lower ranks than their descendants, so stop once the walk passes 'src'.
+ */
+uint32_t topology_get_child_route (struct topology *topo,
+                                   uint32_t src,
+                                   uint32_t dst)
+{
+    if (src >= topo->size || dst >= topo->size)
+        return TOPOLOGY_NONE;
+    while (dst > src) {
+        if (topo->parent[dst] == src)
+            return dst;
+        dst = topo->parent[dst];
+    }
+    return TOPOLOGY_NONE;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
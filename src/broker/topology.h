@@ -0,0 +1,84 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_TOPOLOGY_H
+#define _BROKER_TOPOLOGY_H
+
+#include <stdint.h>
+
+/* TBON topology
+ *
+ * A topology is a tree of 'size' ranks rooted at rank 0, selected by a
+ * URI-like specification string:
+ *
+ *   kary:K       complete K-ary tree (the default, with K=2)
+ *   binomial     binomial tree: the parent of r is r with its lowest set
+ *                bit cleared, so the root has log2(size) children
+ *   flatroot:N[:K]
+ *                ranks 1..N are children of the root, and the remaining
+ *                ranks form complete K-ary trees below them (default K=2)
+ *
+ * In every topology a parent's rank is lower than its children's ranks.
+ */
+
+#define TOPOLOGY_NONE   (~(uint32_t)0)
+
+/* Create a topology of 'size' ranks from 'uri'.
+ * Returns NULL with errno set on failure (EINVAL if 'uri' is invalid).
+ */
+struct topology *topology_create (const char *uri, uint32_t size);
+struct topology *topology_incref (struct topology *topo);
+void topology_decref (struct topology *topo);
+
+/* Return the specification string the topology was created with.
+ */
+const char *topology_get_uri (struct topology *topo);
+
+uint32_t topology_get_size (struct topology *topo);
+
+/* Return the nominal branching factor of the topology, e.g. K for kary:K.
+ * For topologies without one, such as binomial and flatroot, this is the
+ * root's child count.
+ */
+int topology_get_arity (struct topology *topo);
+
+/* Return the parent of 'rank', or TOPOLOGY_NONE for the root or an
+ * out of range rank.
+ */
+uint32_t topology_get_parent (struct topology *topo, uint32_t rank);
+
+/* Set '*ranks' to the children of 'rank', in ascending order, and
+ * return the number of children.  Returns -1 with errno set to EINVAL
+ * if 'rank' is out of range.
+ */
+int topology_get_child_ranks (struct topology *topo,
+                              uint32_t rank,
+                              const uint32_t **ranks);
+
+/* Return the level of 'rank' (root is level 0), or the maximum level
+ * of any rank, or the number of descendants of 'rank'.
+ * Returns -1 with errno set to EINVAL if 'rank' is out of range.
+ */
+int topology_get_level (struct topology *topo, uint32_t rank);
+int topology_get_maxlevel (struct topology *topo);
+int topology_get_descendant_count (struct topology *topo, uint32_t rank);
+
+/* Return the child of 'src' that 'dst' is a descendant of (or is),
+ * or TOPOLOGY_NONE if 'dst' is not a descendant of 'src'.
+ */
+uint32_t topology_get_child_route (struct topology *topo,
+                                   uint32_t src,
+                                   uint32_t dst);
+
+#endif /* !_BROKER_TOPOLOGY_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
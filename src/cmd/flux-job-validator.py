@@ -46,6 +46,41 @@ class HelpAction(argparse.Action):
         parser.exit()
 
 
+def read_batches(fd, size=65536):
+    """Yield lists of input lines, one list per read from fd
+
+    The job-ingest module writes several jobs at once when the validator
+    is busy, so reading everything available and answering with a single
+    write amortizes per-job system call overhead.
+    """
+    buf = b""
+    while True:
+        data = os.read(fd, size)
+        if not data:
+            break
+        buf += data
+        lines = buf.split(b"\n")
+        buf = lines.pop()
+        if lines:
+            yield [x.decode("utf-8", errors="surrogateescape") for x in lines]
+    if buf:
+        yield [buf.decode("utf-8", errors="surrogateescape")]
+
+
+def validate_line(validator, line):
+    if validator.args.jobspec_only:
+        jobspec = json.loads(line)
+        return validator.validate(
+            {
+                "jobspec": jobspec,
+                "userid": os.getuid(),
+                "flags": None,
+                "urgency": 16,
+            }
+        )
+    return validator.validate(line)
+
+
 @flux.util.CLIMain(LOGGER)
 def main():
 
@@ -86,23 +121,11 @@ def main():
         LOGGER.critical(exc)
         sys.exit(1)
 
-    # Ensure stdin is line buffered, with proper encoding
-    for line in os.fdopen(
-        sys.stdin.fileno(), "r", buffering=1, encoding="utf-8", errors="surrogateescape"
-    ):
-        if validator.args.jobspec_only:
-            jobspec = json.loads(line)
-            result = validator.validate(
-                {
-                    "jobspec": jobspec,
-                    "userid": os.getuid(),
-                    "flags": None,
-                    "urgency": 16,
-                }
-            )
-        else:
-            result = validator.validate(line)
-        print(result, flush=True)
+    # Answer each batch of input lines with one batch of result lines
+    for batch in read_batches(sys.stdin.fileno()):
+        results = [str(validate_line(validator, line)) for line in batch]
+        sys.stdout.write("\n".join(results) + "\n")
+        sys.stdout.flush()
 
 
 if __name__ == "__main__":
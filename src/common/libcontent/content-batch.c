@@ -0,0 +1,309 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <flux/core.h>
+
+#include "content-batch.h"
+
+struct content_item {
+    size_t offset;          // offset of data in buf
+    int len;
+    int errnum;
+};
+
+struct content_batch {
+    char *buf;
+    size_t size;
+    size_t alloc;           // zero if buf is not owned by the batch
+    struct content_item *items;
+    int count;
+    int items_alloc;
+};
+
+void content_batch_destroy (struct content_batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        if (b->alloc > 0)
+            free (b->buf);
+        free (b->items);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+struct content_batch *content_batch_create (void)
+{
+    return calloc (1, sizeof (struct content_batch));
+}
+
+static int grow_items (struct content_batch *b)
+{
+    if (b->count == b->items_alloc) {
+        int n = b->items_alloc ? b->items_alloc * 2 : 16;
+        struct content_item *items;
+
+        if (!(items = realloc (b->items, n * sizeof (items[0]))))
+            return -1;
+        b->items = items;
+        b->items_alloc = n;
+    }
+    return 0;
+}
+
+/* Make room for 'len' more bytes in buf, taking ownership of it
+ * if the batch was decoded from a caller's buffer.
+ */
+static int grow_buf (struct content_batch *b, size_t len)
+{
+    if (b->size + len > b->alloc) {
+        size_t n = b->alloc ? b->alloc : 4096;
+        char *buf;
+
+        while (n < b->size + len)
+            n *= 2;
+        if (b->alloc == 0) {
+            if (!(buf = malloc (n)))
+                return -1;
+            if (b->size > 0)
+                memcpy (buf, b->buf, b->size);
+        }
+        else if (!(buf = realloc (b->buf, n)))
+            return -1;
+        b->buf = buf;
+        b->alloc = n;
+    }
+    return 0;
+}
+
+static int append_item (struct content_batch *b,
+                        const void *data,
+                        int len,
+                        int errnum)
+{
+    int32_t hdr = htonl (errnum ? -errnum : len);
+
+    if (grow_items (b) < 0 || grow_buf (b, sizeof (hdr) + len) < 0)
+        return -1;
+    memcpy (b->buf + b->size, &hdr, sizeof (hdr));
+    b->size += sizeof (hdr);
+    b->items[b->count].offset = b->size;
+    b->items[b->count].len = len;
+    b->items[b->count].errnum = errnum;
+    b->count++;
+    if (len > 0) {
+        memcpy (b->buf + b->size, data, len);
+        b->size += len;
+    }
+    return 0;
+}
+
+int content_batch_append (struct content_batch *b, const void *data, int len)
+{
+    if (!b || len < 0 || (len > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_item (b, data, len, 0);
+}
+
+int content_batch_append_string (struct content_batch *b, const char *s)
+{
+    if (!b || !s) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_item (b, s, strlen (s) + 1, 0);
+}
+
+int content_batch_append_error (struct content_batch *b, int errnum)
+{
+    if (!b || errnum <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_item (b, NULL, 0, errnum);
+}
+
+int content_batch_count (const struct content_batch *b)
+{
+    return b ? b->count : 0;
+}
+
+int content_batch_get (const struct content_batch *b,
+                       int index,
+                       const void **data,
+                       int *len)
+{
+    if (!b || index < 0 || index >= b->count) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (b->items[index].errnum) {
+        errno = b->items[index].errnum;
+        return -1;
+    }
+    if (data)
+        *data = b->items[index].len > 0 ? b->buf + b->items[index].offset
+                                        : NULL;
+    if (len)
+        *len = b->items[index].len;
+    return 0;
+}
+
+int content_batch_get_string (const struct content_batch *b,
+                              int index,
+                              const char **s)
+{
+    const char *data;
+    int len;
+
+    if (content_batch_get (b, index, (const void **)&data, &len) < 0)
+        return -1;
+    if (len == 0 || data[len - 1] != '\0') {
+        errno = EPROTO;
+        return -1;
+    }
+    if (s)
+        *s = data;
+    return 0;
+}
+
+void content_batch_encode (const struct content_batch *b,
+                           const void **buf,
+                           int *len)
+{
+    if (buf)
+        *buf = b ? b->buf : NULL;
+    if (len)
+        *len = b ? b->size : 0;
+}
+
+struct content_batch *content_batch_decode (const void *buf, int len)
+{
+    struct content_batch *b;
+    size_t offset = 0;
+
+    if (len < 0 || (len > 0 && !buf)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(b = content_batch_create ()))
+        return NULL;
+    b->buf = (char *)buf;
+    b->size = len;
+    while (offset < len) {
+        int32_t hdr;
+        int n;
+
+        if (len - offset < sizeof (hdr))
+            goto eproto;
+        memcpy (&hdr, b->buf + offset, sizeof (hdr));
+        offset += sizeof (hdr);
+        n = ntohl (hdr);
+        if (n == INT32_MIN || (n > 0 && len - offset < n))
+            goto eproto;
+        if (grow_items (b) < 0)
+            goto error;
+        b->items[b->count].offset = offset;
+        b->items[b->count].len = n > 0 ? n : 0;
+        b->items[b->count].errnum = n < 0 ? -n : 0;
+        b->count++;
+        if (n > 0)
+            offset += n;
+    }
+    return b;
+eproto:
+    errno = EPROTO;
+error:
+    content_batch_destroy (b);
+    return NULL;
+}
+
+static flux_future_t *batch_rpc (flux_t *h,
+                                 const char *method,
+                                 const struct content_batch *b,
+                                 int flags)
+{
+    char topic[64];
+    uint32_t rank = FLUX_NODEID_ANY;
+    const char *service = "content";
+    const void *buf;
+    int len;
+
+    if (!h || !b) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    if ((flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        service = "content-backing";
+        rank = 0;
+    }
+    (void)snprintf (topic, sizeof (topic), "%s.%s", service, method);
+    content_batch_encode (b, &buf, &len);
+    return flux_rpc_raw (h, topic, buf, len, rank, 0);
+}
+
+flux_future_t *content_load_batch (flux_t *h,
+                                   const struct content_batch *blobrefs,
+                                   int flags)
+{
+    return batch_rpc (h, "load-batch", blobrefs, flags);
+}
+
+flux_future_t *content_store_batch (flux_t *h,
+                                    const struct content_batch *blobs,
+                                    int flags)
+{
+    return batch_rpc (h, "store-batch", blobs, flags);
+}
+
+static void batch_destructor (void *arg)
+{
+    content_batch_destroy (arg);
+}
+
+int content_batch_rpc_get (flux_future_t *f, const struct content_batch **bp)
+{
+    const char *auxkey = "flux::content_batch";
+    struct content_batch *b;
+
+    if (!(b = flux_future_aux_get (f, auxkey))) {
+        const void *buf;
+        int len;
+
+        if (flux_rpc_get_raw (f, &buf, &len) < 0)
+            return -1;
+        if (!(b = content_batch_decode (buf, len)))
+            return -1;
+        if (flux_future_aux_set (f, auxkey, b, batch_destructor) < 0) {
+            content_batch_destroy (b);
+            return -1;
+        }
+    }
+    if (bp)
+        *bp = b;
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
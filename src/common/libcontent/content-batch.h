@@ -0,0 +1,96 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CONTENT_BATCH_H
+#define _FLUX_CONTENT_BATCH_H
+
+#include <flux/core.h>
+
+/* A content batch is an ordered list of items, each of which is either
+ * a buffer or an error number.  It is the payload of the load-batch and
+ * store-batch methods of the content and content-backing services:
+ *
+ * load-batch request:      blobrefs (including NUL terminator)
+ * load-batch response:     blobs, or errors, in request order
+ * store-batch request:     blobs
+ * store-batch response:    blobrefs, or errors, in request order
+ *
+ * Each item is encoded as a 4 byte signed length in network byte order,
+ * followed by that many bytes of data.  A negative length is a negated
+ * error number with no data.
+ */
+
+struct content_batch;
+
+struct content_batch *content_batch_create (void);
+void content_batch_destroy (struct content_batch *b);
+
+/* Append a copy of 'data' of length 'len' to the batch.
+ */
+int content_batch_append (struct content_batch *b, const void *data, int len);
+
+/* Append a copy of string 's', including NUL terminator, to the batch.
+ */
+int content_batch_append_string (struct content_batch *b, const char *s);
+
+/* Append an error item to the batch.
+ */
+int content_batch_append_error (struct content_batch *b, int errnum);
+
+int content_batch_count (const struct content_batch *b);
+
+/* Get the item at 'index'.  Storage for 'data' belongs to the batch.
+ * If the item is an error, -1 is returned with errno set to its value.
+ */
+int content_batch_get (const struct content_batch *b,
+                       int index,
+                       const void **data,
+                       int *len);
+
+/* Get the item at 'index' as a string.  Fail with EPROTO if it is not
+ * NUL terminated.
+ */
+int content_batch_get_string (const struct content_batch *b,
+                              int index,
+                              const char **s);
+
+/* Get the encoded batch.  'buf' is valid until the batch is modified
+ * or destroyed.
+ */
+void content_batch_encode (const struct content_batch *b,
+                           const void **buf,
+                           int *len);
+
+/* Decode 'buf' of length 'len'.  The batch refers to 'buf' without
+ * copying it, so 'buf' must remain valid until the batch is destroyed.
+ * Returns batch on success, or NULL with errno set (EPROTO if malformed).
+ */
+struct content_batch *content_batch_decode (const void *buf, int len);
+
+/* Send a load-batch or store-batch request.  'flags' are as described
+ * in flux_content_load(3).
+ */
+flux_future_t *content_load_batch (flux_t *h,
+                                   const struct content_batch *blobrefs,
+                                   int flags);
+flux_future_t *content_store_batch (flux_t *h,
+                                    const struct content_batch *blobs,
+                                    int flags);
+
+/* Get the response batch.  It belongs to 'f' and is valid until 'f' is
+ * destroyed.
+ */
+int content_batch_rpc_get (flux_future_t *f, const struct content_batch **bp);
+
+#endif /* !_FLUX_CONTENT_BATCH_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
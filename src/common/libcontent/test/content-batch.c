@@ -0,0 +1,158 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libcontent/content-batch.h"
+
+void test_badargs (void)
+{
+    struct content_batch *b;
+    const void *data;
+    const char *s;
+    int len;
+
+    if (!(b = content_batch_create ()))
+        BAIL_OUT ("content_batch_create failed");
+
+    errno = 0;
+    ok (content_batch_append (NULL, "a", 1) < 0 && errno == EINVAL,
+        "content_batch_append b=NULL fails with EINVAL");
+    errno = 0;
+    ok (content_batch_append (b, NULL, 1) < 0 && errno == EINVAL,
+        "content_batch_append data=NULL len=1 fails with EINVAL");
+    errno = 0;
+    ok (content_batch_append (b, "a", -1) < 0 && errno == EINVAL,
+        "content_batch_append len=-1 fails with EINVAL");
+    errno = 0;
+    ok (content_batch_append_string (b, NULL) < 0 && errno == EINVAL,
+        "content_batch_append_string s=NULL fails with EINVAL");
+    errno = 0;
+    ok (content_batch_append_error (b, 0) < 0 && errno == EINVAL,
+        "content_batch_append_error errnum=0 fails with EINVAL");
+    errno = 0;
+    ok (content_batch_get (b, 0, &data, &len) < 0 && errno == EINVAL,
+        "content_batch_get index=0 on empty batch fails with EINVAL");
+    errno = 0;
+    ok (content_batch_get (NULL, 0, &data, &len) < 0 && errno == EINVAL,
+        "content_batch_get b=NULL fails with EINVAL");
+    ok (content_batch_count (NULL) == 0,
+        "content_batch_count b=NULL returns 0");
+
+    ok (content_batch_append (b, "abc", 3) == 0,
+        "content_batch_append abc (no NUL) works");
+    errno = 0;
+    ok (content_batch_get_string (b, 0, &s) < 0 && errno == EPROTO,
+        "content_batch_get_string on unterminated item fails with EPROTO");
+
+    errno = 0;
+    ok (content_batch_decode (NULL, 1) == NULL && errno == EINVAL,
+        "content_batch_decode buf=NULL len=1 fails with EINVAL");
+
+    content_batch_destroy (b);
+}
+
+void test_encode_decode (void)
+{
+    struct content_batch *b;
+    struct content_batch *b2;
+    const void *buf;
+    int buflen;
+    const void *data;
+    const char *s;
+    int len;
+    char big[10000];
+
+    memset (big, 'b', sizeof (big));
+
+    if (!(b = content_batch_create ()))
+        BAIL_OUT ("content_batch_create failed");
+    ok (content_batch_append_string (b, "sha1-1234") == 0
+        && content_batch_append_error (b, ENOENT) == 0
+        && content_batch_append (b, NULL, 0) == 0
+        && content_batch_append (b, big, sizeof (big)) == 0,
+        "appended string, error, empty, and large items");
+    ok (content_batch_count (b) == 4,
+        "content_batch_count returns 4");
+    content_batch_encode (b, &buf, &buflen);
+    ok (buf != NULL && buflen == 4 * 4 + 10 + sizeof (big),
+        "content_batch_encode returned expected size");
+
+    b2 = content_batch_decode (buf, buflen);
+    ok (b2 != NULL,
+        "content_batch_decode works");
+    ok (content_batch_count (b2) == 4,
+        "decoded batch has 4 items");
+    ok (content_batch_get_string (b2, 0, &s) == 0 && !strcmp (s, "sha1-1234"),
+        "item 0 is the expected string");
+    errno = 0;
+    ok (content_batch_get (b2, 1, &data, &len) < 0 && errno == ENOENT,
+        "item 1 is ENOENT");
+    ok (content_batch_get (b2, 2, &data, &len) == 0 && len == 0,
+        "item 2 is empty");
+    ok (content_batch_get (b2, 3, &data, &len) == 0
+        && len == sizeof (big)
+        && !memcmp (data, big, len),
+        "item 3 is the large buffer");
+
+    ok (content_batch_append_string (b2, "more") == 0,
+        "content_batch_append to decoded batch works");
+    ok (content_batch_count (b2) == 5
+        && content_batch_get_string (b2, 4, &s) == 0
+        && !strcmp (s, "more"),
+        "appended item can be retrieved");
+    ok (content_batch_get_string (b2, 0, &s) == 0 && !strcmp (s, "sha1-1234"),
+        "earlier item is still intact");
+    content_batch_destroy (b2);
+
+    errno = 0;
+    ok (content_batch_decode (buf, buflen - 1) == NULL && errno == EPROTO,
+        "content_batch_decode truncated buffer fails with EPROTO");
+    errno = 0;
+    ok (content_batch_decode (buf, 2) == NULL && errno == EPROTO,
+        "content_batch_decode truncated header fails with EPROTO");
+
+    b2 = content_batch_decode (NULL, 0);
+    ok (b2 != NULL && content_batch_count (b2) == 0,
+        "content_batch_decode empty buffer returns empty batch");
+    content_batch_destroy (b2);
+
+    content_batch_destroy (b);
+}
+
+void test_malformed (void)
+{
+    int32_t hdr = htonl (INT32_MIN);
+
+    errno = 0;
+    ok (content_batch_decode (&hdr, sizeof (hdr)) == NULL && errno == EPROTO,
+        "content_batch_decode with INT32_MIN length fails with EPROTO");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_badargs ();
+    test_encode_decode ();
+    test_malformed ();
+
+    done_testing ();
+    return (0);
+}
+
+// vi: ts=4 sw=4 expandtab
@@ -341,6 +341,24 @@ zlistx_find (zlistx_t *self, void *item)
 }
 
 
+//  --------------------------------------------------------------------------
+//  Set the cursor to the item with the given list handle, so that iteration
+//  with zlistx_next () or zlistx_prev () continues from there without
+//  scanning the list. The handle must belong to this list. Returns the item.
+
+void *
+zlistx_seek (zlistx_t *self, void *handle)
+{
+    assert (self);
+    assert (handle);
+
+    node_t *node = (node_t *) handle;
+    assert (node->tag == NODE_TAG);
+    self->cursor = node;
+    return node->item;
+}
+
+
 //  --------------------------------------------------------------------------
 //  Detach an item from the list, using its handle. The item is not modified,
 //  and the caller is responsible for destroying it if necessary. If handle is
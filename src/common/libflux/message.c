@@ -21,6 +21,13 @@
  * PROTO frame
  *
  * See also: RFC 3
+ *
+ * In memory, the frames are not kept as a list.  The PROTO frame is
+ * decoded into struct fields, the route stack is an array with the
+ * most recently pushed route at the end so push and pop are O(1), and
+ * the payload is a reference on an immutable, reference counted buffer
+ * that is shared by copies of the message.  Frames are only produced
+ * when the message is encoded or sent.
  */
 
 #if HAVE_CONFIG_H
@@ -41,14 +48,45 @@
 
 #include "message.h"
 
+struct msg_proto {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t userid;
+    uint32_t rolemask;
+    uint32_t aux1;
+    uint32_t aux2;
+};
+
+/* Payload storage.  The data is either held in 'data' or, for a payload
+ * received with flux_msg_recvzsock(), in the zeromq message it arrived in.
+ */
+struct msg_buf {
+    int refcount;
+    bool zmsg_valid;
+    zmq_msg_t zmsg;
+    char data[];
+};
+
 struct flux_msg {
-    zmsg_t *zmsg;
+    struct msg_proto proto;
+    char **routes;          // routes[0] is route_first, last is route_last
+    int route_count;
+    int route_alloc;
+    char *topic;
+    struct msg_buf *payload_buf;
+    const void *payload;
+    size_t payload_size;
     json_t *json;
     char *lasterr;
     struct aux_item *aux;
     int refcount;
 };
 
+/* Route stack slots reserved when routing is first enabled.
+ * Messages rarely travel more hops than this.
+ */
+static const int route_headroom = 4;
+
 /* Begin manual codec
  * PROTO consists of 4 byte prelude followed by a fixed length
  * array of u32's in network byte order.
@@ -70,116 +108,114 @@ struct flux_msg {
 #define PROTO_U32_COUNT     4
 #define PROTO_SIZE          4 + (PROTO_U32_COUNT * 4)
 
-/* Helpful aliases */
-#define PROTO_IND_NODEID    PROTO_IND_AUX1 // request
-#define PROTO_IND_MATCHTAG  PROTO_IND_AUX2 // request, response
-#define PROTO_IND_SEQUENCE  PROTO_IND_AUX1 // event
-#define PROTO_IND_ERRNUM    PROTO_IND_AUX1 // response, keepalive
-#define PROTO_IND_STATUS    PROTO_IND_AUX2 // keepalive
+static void proto_put_u32 (uint8_t *data, int index, uint32_t val)
+{
+    uint32_t x = htonl (val);
+    memcpy (&data[PROTO_OFF_U32_ARRAY + index * 4], &x, sizeof (x));
+}
 
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val);
+static uint32_t proto_get_u32 (const uint8_t *data, int index)
+{
+    uint32_t x;
+    memcpy (&x, &data[PROTO_OFF_U32_ARRAY + index * 4], sizeof (x));
+    return ntohl (x);
+}
 
-static int proto_set_type (uint8_t *data, int len, int type)
+static void proto_encode (const struct msg_proto *proto,
+                          uint8_t data[PROTO_SIZE])
+{
+    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
+    data[PROTO_OFF_VERSION] = PROTO_VERSION;
+    data[PROTO_OFF_TYPE] = proto->type;
+    data[PROTO_OFF_FLAGS] = proto->flags;
+    proto_put_u32 (data, PROTO_IND_USERID, proto->userid);
+    proto_put_u32 (data, PROTO_IND_ROLEMASK, proto->rolemask);
+    proto_put_u32 (data, PROTO_IND_AUX1, proto->aux1);
+    proto_put_u32 (data, PROTO_IND_AUX2, proto->aux2);
+}
+
+static int proto_decode (struct msg_proto *proto,
+                         const uint8_t *data,
+                         size_t len)
 {
     if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
                          || data[PROTO_OFF_VERSION] != PROTO_VERSION)
         return -1;
+    proto->type = data[PROTO_OFF_TYPE];
+    proto->flags = data[PROTO_OFF_FLAGS];
+    proto->userid = proto_get_u32 (data, PROTO_IND_USERID);
+    proto->rolemask = proto_get_u32 (data, PROTO_IND_ROLEMASK);
+    proto->aux1 = proto_get_u32 (data, PROTO_IND_AUX1);
+    proto->aux2 = proto_get_u32 (data, PROTO_IND_AUX2);
+    return 0;
+}
+/* End manual codec
+ */
+
+/* aux1 and aux2 hold different fields depending on message type:
+ *   request:   aux1=nodeid    aux2=matchtag
+ *   response:  aux1=errnum    aux2=matchtag
+ *   event:     aux1=sequence  aux2=unused
+ *   keepalive: aux1=errnum    aux2=status
+ */
+
+static int proto_set_type (struct msg_proto *proto, int type)
+{
     switch (type) {
         case FLUX_MSGTYPE_REQUEST:
-            if (proto_set_u32 (data, len, PROTO_IND_NODEID,
-                               FLUX_NODEID_ANY) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_MATCHTAG,
-                               FLUX_MATCHTAG_NONE) < 0)
-                return -1;
+            proto->aux1 = FLUX_NODEID_ANY;
+            proto->aux2 = FLUX_MATCHTAG_NONE;
             break;
         case FLUX_MSGTYPE_RESPONSE:
             /* N.B. don't clobber matchtag from request on set_type */
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            proto->aux1 = 0;
             break;
         case FLUX_MSGTYPE_EVENT:
-            if (proto_set_u32 (data, len, PROTO_IND_SEQUENCE, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_AUX2, 0) < 0)
-                return -1;
+            proto->aux1 = 0;
+            proto->aux2 = 0;
             break;
         case FLUX_MSGTYPE_KEEPALIVE:
-            if (proto_set_u32 (data, len, PROTO_IND_STATUS, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            proto->aux2 = 0;
+            proto->aux1 = 0;
             break;
         default:
             return -1;
     }
-    data[PROTO_OFF_TYPE] = type;
-    return 0;
-}
-static int proto_get_type (uint8_t *data, int len, int *type)
-{
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *type = data[PROTO_OFF_TYPE];
+    proto->type = type;
     return 0;
 }
-static int proto_set_flags (uint8_t *data, int len, uint8_t flags)
-{
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    data[PROTO_OFF_FLAGS] = flags;
-    return 0;
-}
-static int proto_get_flags (uint8_t *data, int len, uint8_t *val)
-{
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *val = data[PROTO_OFF_FLAGS];
-    return 0;
-}
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val)
+
+static struct msg_buf *msg_buf_create (const void *data, size_t size)
 {
-    uint32_t x = htonl (val);
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    struct msg_buf *mbuf;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&data[offset], &x, sizeof (x));
-    return 0;
+    if (!(mbuf = malloc (sizeof (*mbuf) + size))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    mbuf->refcount = 1;
+    mbuf->zmsg_valid = false;
+    memcpy (mbuf->data, data, size);
+    return mbuf;
 }
-static int proto_get_u32 (uint8_t *data, int len, int index, uint32_t *val)
-{
-    uint32_t x;
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&x, &data[offset], sizeof (x));
-    *val = ntohl (x);
-    return 0;
+static struct msg_buf *msg_buf_incref (struct msg_buf *mbuf)
+{
+    if (mbuf)
+        mbuf->refcount++;
+    return mbuf;
 }
-static void proto_init (uint8_t *data, int len, uint8_t flags)
+
+static void msg_buf_decref (struct msg_buf *mbuf)
 {
-    int n;
-    assert (len >= PROTO_SIZE);
-    memset (data, 0, len);
-    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
-    data[PROTO_OFF_VERSION] = PROTO_VERSION;
-    data[PROTO_OFF_FLAGS] = flags;
-    n = proto_set_u32 (data, len, PROTO_IND_USERID, FLUX_USERID_UNKNOWN);
-    assert (n == 0);
-    n = proto_set_u32 (data, len, PROTO_IND_ROLEMASK, FLUX_ROLE_NONE);
-    assert (n == 0);
+    if (mbuf && --mbuf->refcount == 0) {
+        int saved_errno = errno;
+        if (mbuf->zmsg_valid)
+            zmq_msg_close (&mbuf->zmsg);
+        free (mbuf);
+        errno = saved_errno;
+    }
 }
-/* End manual codec
- */
 
 static flux_msg_t *flux_msg_create_common (void)
 {
@@ -193,34 +229,38 @@ static flux_msg_t *flux_msg_create_common (void)
 
 flux_msg_t *flux_msg_create (int type)
 {
-    uint8_t proto[PROTO_SIZE];
     flux_msg_t *msg;
 
     if (!(msg = flux_msg_create_common ()))
         return NULL;
-    proto_init (proto, PROTO_SIZE, 0);
-    if (proto_set_type (proto, PROTO_SIZE, type) < 0) {
+    msg->proto.userid = FLUX_USERID_UNKNOWN;
+    msg->proto.rolemask = FLUX_ROLE_NONE;
+    if (proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         goto error;
     }
-    if (!(msg->zmsg = zmsg_new ())) {
-        errno = ENOMEM;
-        goto error;
-    }
-    if (zmsg_addmem (msg->zmsg, proto, PROTO_SIZE) < 0)
-        goto error;
     return msg;
 error:
     flux_msg_destroy (msg);
     return NULL;
 }
 
+static void msg_routes_clear (flux_msg_t *msg)
+{
+    for (int i = 0; i < msg->route_count; i++)
+        free (msg->routes[i]);
+    msg->route_count = 0;
+}
+
 void flux_msg_destroy (flux_msg_t *msg)
 {
     if (msg && --msg->refcount == 0) {
         int saved_errno = errno;
         json_decref (msg->json);
-        zmsg_destroy (&msg->zmsg);
+        msg_routes_clear (msg);
+        free (msg->routes);
+        free (msg->topic);
+        msg_buf_decref (msg->payload_buf);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
         free (msg);
@@ -275,20 +315,210 @@ void *flux_msg_aux_get (const flux_msg_t *msg, const char *name)
     return aux_get (msg->aux, name);
 }
 
+/* Make room for at least one more route on the route stack.
+ */
+static int msg_routes_reserve (flux_msg_t *msg)
+{
+    if (msg->route_count == msg->route_alloc) {
+        int new_alloc = msg->route_alloc ? msg->route_alloc * 2
+                                         : route_headroom;
+        char **new_routes;
+
+        if (!(new_routes = realloc (msg->routes,
+                                    new_alloc * sizeof (msg->routes[0])))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        msg->routes = new_routes;
+        msg->route_alloc = new_alloc;
+    }
+    return 0;
+}
+
+/* A frame of the message, as it appears on the wire.
+ */
+struct msg_frame {
+    const void *data;
+    size_t size;
+};
+
+/* Iterate over the frames of a message in wire order.  Optionally,
+ * 'routes' are sent as though routing were enabled and they were pushed
+ * onto the message, without modifying it.
+ */
+struct frame_iter {
+    const flux_msg_t *msg;
+    const char **routes;
+    int nroutes;
+    uint8_t flags;
+    int index;      // frame index in wire order
+    int nframes;
+    uint8_t proto[PROTO_SIZE];
+};
+
+static void frame_iter_init_route (struct frame_iter *it,
+                                   const flux_msg_t *msg,
+                                   const char **routes,
+                                   int nroutes)
+{
+    struct msg_proto proto = msg->proto;
+
+    it->msg = msg;
+    it->routes = routes;
+    it->nroutes = nroutes;
+    it->index = 0;
+    it->nframes = flux_msg_frames (msg);
+    if (routes) {
+        if (!(proto.flags & FLUX_MSGFLAG_ROUTE)) {
+            proto.flags |= FLUX_MSGFLAG_ROUTE;
+            it->nframes++;
+        }
+        it->nframes += nroutes;
+    }
+    it->flags = proto.flags;
+    proto_encode (&proto, it->proto);
+}
+
+static void frame_iter_init (struct frame_iter *it, const flux_msg_t *msg)
+{
+    frame_iter_init_route (it, msg, NULL, 0);
+}
+
+/* Get the next frame, returning false when there are no more.
+ */
+static bool frame_iter_next (struct frame_iter *it, struct msg_frame *frame)
+{
+    const flux_msg_t *msg = it->msg;
+    int i = it->index;
+
+    if (i >= it->nframes)
+        return false;
+    it->index++;
+    if ((it->flags & FLUX_MSGFLAG_ROUTE)) {
+        int route_count = it->nroutes + msg->route_count;
+        if (i < route_count) {
+            const char *route;
+            if (i < it->nroutes)
+                route = it->routes[it->nroutes - 1 - i];
+            else
+                route = msg->routes[route_count - 1 - i];
+            frame->data = route;
+            frame->size = strlen (route);
+            return true;
+        }
+        if (i == route_count) {
+            frame->data = NULL;
+            frame->size = 0;
+            return true;
+        }
+        i -= route_count + 1;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        if (i == 0) {
+            frame->data = msg->topic;
+            frame->size = strlen (msg->topic) + 1;
+            return true;
+        }
+        i--;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (i == 0) {
+            frame->data = msg->payload;
+            frame->size = msg->payload_size;
+            return true;
+        }
+        i--;
+    }
+    frame->data = it->proto;
+    frame->size = PROTO_SIZE;
+    return true;
+}
+
+/* Build a message from frames in wire order.  If 'mbuf' is non-NULL,
+ * it contains the payload frame, which is referenced instead of copied.
+ */
+static flux_msg_t *msg_from_frames (const struct msg_frame *frames,
+                                    int count,
+                                    struct msg_buf *mbuf)
+{
+    flux_msg_t *msg;
+    int routes = 0;
+    int i = 0;
+
+    if (!(msg = flux_msg_create_common ()))
+        return NULL;
+    if (count < 1
+        || proto_decode (&msg->proto,
+                         frames[count - 1].data,
+                         frames[count - 1].size) < 0)
+        goto eproto;
+    count--;
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        while (routes < count && frames[routes].size > 0)
+            routes++;
+        if (routes == count)
+            goto eproto;
+        if (routes > 0) {
+            msg->route_alloc = routes;
+            if (!(msg->routes = calloc (routes, sizeof (msg->routes[0]))))
+                goto nomem;
+        }
+        while (msg->route_count < routes) {
+            const struct msg_frame *f = &frames[routes - 1 - msg->route_count];
+            if (!(msg->routes[msg->route_count] = strndup (f->data, f->size)))
+                goto nomem;
+            msg->route_count++;
+        }
+        i = routes + 1;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        const char *s = frames[i].data;
+        if (i == count
+            || frames[i].size == 0
+            || s[frames[i].size - 1] != '\0')
+            goto eproto;
+        if (!(msg->topic = strdup (s)))
+            goto nomem;
+        i++;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (i == count)
+            goto eproto;
+        if (mbuf)
+            msg->payload_buf = msg_buf_incref (mbuf);
+        else if (!(msg->payload_buf = msg_buf_create (frames[i].data,
+                                                      frames[i].size)))
+            goto error;
+        msg->payload = mbuf ? frames[i].data : msg->payload_buf->data;
+        msg->payload_size = frames[i].size;
+        i++;
+    }
+    if (i != count)
+        goto eproto;
+    return msg;
+eproto:
+    errno = EPROTO;
+    goto error;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_msg_destroy (msg);
+    return NULL;
+}
+
 size_t flux_msg_encode_size (const flux_msg_t *msg)
 {
-    zframe_t *zf;
+    struct frame_iter it;
+    struct msg_frame f;
     size_t size = 0;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 255)
+    frame_iter_init (&it, msg);
+    while (frame_iter_next (&it, &f)) {
+        if (f.size < 255)
             size += 1;
         else
             size += 1 + 4;
-        size += n;
-        zf = zmsg_next (msg->zmsg);
+        size += f.size;
     }
     return size;
 }
@@ -297,25 +527,27 @@ size_t flux_msg_encode_size (const flux_msg_t *msg)
 int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size)
 {
     uint8_t *p = buf;
-    zframe_t *zf;
+    struct frame_iter it;
+    struct msg_frame f;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
+    frame_iter_init (&it, msg);
+    while (frame_iter_next (&it, &f)) {
+        size_t n = f.size;
         if (n < 0xff) {
             if (size - (p - (uint8_t *)buf) < n + 1)
                 goto nospace;
             *p++ = (uint8_t)n;
         } else {
+            uint32_t x = htonl (n);
             if (size - (p - (uint8_t *)buf) < n + 1 + 4)
                 goto nospace;
             *p++ = 0xff;
-            *(uint32_t *)p = htonl (n);
+            memcpy (p, &x, sizeof (x));
             p += 4;
         }
-        memcpy (p, zframe_data (zf), n);
+        if (n > 0)
+            memcpy (p, f.data, n);
         p += n;
-        zf = zmsg_next (msg->zmsg);
     }
     return 0;
 nospace:
@@ -323,48 +555,67 @@ nospace:
     return -1;
 }
 
-flux_msg_t *flux_msg_decode (const void *buf, size_t size)
+/* Walk the encoded frames in 'buf', storing up to 'max' of them in
+ * 'frames'.  Return the total number of frames, or -1 if 'buf' is
+ * truncated.
+ */
+static int decode_frames (const void *buf,
+                          size_t size,
+                          struct msg_frame *frames,
+                          int max)
 {
-    flux_msg_t *msg;
     uint8_t const *p = buf;
-    zframe_t *zf;
+    int count = 0;
 
-    if (!(msg = flux_msg_create_common ()))
-        return NULL;
-    if (!(msg->zmsg = zmsg_new ()))
-        goto nomem;
     while (p - (uint8_t *)buf < size) {
         size_t n = *p++;
         if (n == 0xff) {
-            if (size - (p - (uint8_t *)buf) < 4) {
-                errno = EINVAL;
-                goto error;
-            }
-            n = ntohl (*(uint32_t *)p);
+            uint32_t x;
+            if (size - (p - (uint8_t *)buf) < 4)
+                return -1;
+            memcpy (&x, p, sizeof (x));
+            n = ntohl (x);
             p += 4;
         }
-        if (size - (p - (uint8_t *)buf) < n) {
-            errno = EINVAL;
-            goto error;
+        if (size - (p - (uint8_t *)buf) < n)
+            return -1;
+        if (count < max) {
+            frames[count].data = p;
+            frames[count].size = n;
         }
-        if (!(zf = zframe_new (p, n)))
-            goto nomem;
-        if (zmsg_append (msg->zmsg, &zf) < 0)
-            goto nomem;
+        count++;
         p += n;
     }
+    return count;
+}
+
+flux_msg_t *flux_msg_decode (const void *buf, size_t size)
+{
+    struct msg_frame frames_static[8];
+    struct msg_frame *frames = frames_static;
+    flux_msg_t *msg;
+    int count;
+
+    if ((count = decode_frames (buf, size, frames, 8)) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (count > 8) {
+        if (!(frames = calloc (count, sizeof (frames[0])))) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        (void)decode_frames (buf, size, frames, count);
+    }
+    msg = msg_from_frames (frames, count, NULL);
+    if (frames != frames_static)
+        ERRNO_SAFE_WRAP (free, frames);
     return msg;
-nomem:
-    errno = ENOMEM;
-error:
-    flux_msg_destroy (msg);
-    return NULL;
 }
 
 int flux_msg_set_type (flux_msg_t *msg, int type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_type (zframe_data (zf), zframe_size (zf), type) < 0) {
+    if (!msg || proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         return -1;
     }
@@ -373,11 +624,11 @@ int flux_msg_set_type (flux_msg_t *msg, int type)
 
 int flux_msg_get_type (const flux_msg_t *msg, int *type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), type) < 0) {
-        errno = EPROTO;
+    if (!msg || !type) {
+        errno = EINVAL;
         return -1;
     }
+    *type = msg->proto.type;
     return 0;
 }
 
@@ -387,17 +638,22 @@ int flux_msg_set_flags (flux_msg_t *msg, uint8_t fl)
                               | FLUX_MSGFLAG_ROUTE | FLUX_MSGFLAG_UPSTREAM
                               | FLUX_MSGFLAG_PRIVATE | FLUX_MSGFLAG_STREAMING
                               | FLUX_MSGFLAG_NORESPONSE;
+    const uint8_t frame_flags = FLUX_MSGFLAG_TOPIC | FLUX_MSGFLAG_PAYLOAD
+                              | FLUX_MSGFLAG_ROUTE;
 
     if (!msg || fl & ~valid_flags || ((fl & FLUX_MSGFLAG_STREAMING)
                                    && (fl & FLUX_MSGFLAG_NORESPONSE)) != 0) {
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
+    /* Flags that indicate the presence of frames may only be changed by
+     * adding or removing the frame.
+     */
+    if ((fl & frame_flags) != (msg->proto.flags & frame_flags)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.flags = fl;
     return 0;
 }
 
@@ -407,11 +663,7 @@ int flux_msg_get_flags (const flux_msg_t *msg, uint8_t *fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *fl = msg->proto.flags;
     return 0;
 }
 
@@ -473,77 +725,41 @@ bool flux_msg_is_noresponse (const flux_msg_t *msg)
 
 int flux_msg_set_userid (flux_msg_t *msg, uint32_t userid)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.userid = userid;
     return 0;
 }
 
 int flux_msg_get_userid (const flux_msg_t *msg, uint32_t *userid)
 {
-    zframe_t *zf;
-
     if (!msg || !userid) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *userid = msg->proto.userid;
     return 0;
 }
 
 int flux_msg_set_rolemask (flux_msg_t *msg, uint32_t rolemask)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.rolemask = rolemask;
     return 0;
 }
 
 int flux_msg_get_rolemask (const flux_msg_t *msg, uint32_t *rolemask)
 {
-    zframe_t *zf;
-
     if (!msg || !rolemask) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *rolemask = msg->proto.rolemask;
     return 0;
 }
 
@@ -597,22 +813,13 @@ int flux_msg_authorize (const flux_msg_t *msg, uint32_t userid)
 
 int flux_msg_set_nodeid (flux_msg_t *msg, uint32_t nodeid)
 {
-    zframe_t *zf;
-    int type;
-
     if (!msg)
         goto error;
     if (nodeid == FLUX_NODEID_UPSTREAM) /* should have been resolved earlier */
         goto error;
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, nodeid) < 0)
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST)
         goto error;
+    msg->proto.aux1 = nodeid;
     return 0;
 error:
     errno = EINVAL;
@@ -621,24 +828,13 @@ error:
 
 int flux_msg_get_nodeid (const flux_msg_t *msg, uint32_t *nodeidp)
 {
-    zframe_t *zf;
-    int type;
-    uint32_t nodeid;
-
     if (!msg || !nodeidp) {
         errno = EINVAL;
         return -1;
     }
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, &nodeid) < 0)
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST)
         goto error;
-    *nodeidp = nodeid;
+    *nodeidp = msg->proto.aux1;
     return 0;
 error:
     return EPROTO;
@@ -647,125 +843,85 @@ error:
 
 int flux_msg_set_errnum (flux_msg_t *msg, int e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, e) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = e;
     return 0;
 }
 
 int flux_msg_get_errnum (const flux_msg_t *msg, int *e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t xe;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, &xe) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EPROTO;
         return -1;
     }
-    *e = xe;
+    *e = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_seq (flux_msg_t *msg, uint32_t seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = seq;
     return 0;
 }
 
 int flux_msg_get_seq (const flux_msg_t *msg, uint32_t *seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EPROTO;
         return -1;
     }
+    *seq = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_matchtag (flux_msg_t *msg, uint32_t t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux2 = t;
     return 0;
 }
 
 int flux_msg_get_matchtag (const flux_msg_t *msg, uint32_t *t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EPROTO;
         return -1;
     }
+    *t = msg->proto.aux2;
     return 0;
 }
 
 int flux_msg_set_status (flux_msg_t *msg, int s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, s) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux2 = s;
     return 0;
 }
 
 int flux_msg_get_status (const flux_msg_t *msg, int *s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t u;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, &u) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EPROTO;
         return -1;
     }
-    *s = u;
+    *s = msg->proto.aux2;
     return 0;
 }
 
@@ -828,100 +984,88 @@ bool flux_msg_cmp (const flux_msg_t *msg, struct flux_match match)
 
 int flux_msg_enable_route (flux_msg_t *msg)
 {
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if ((flags & FLUX_MSGFLAG_ROUTE))
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE))
         return 0;
-    if (zmsg_pushmem (msg->zmsg, NULL, 0) < 0) {
-        errno = ENOMEM;
+    if (msg_routes_reserve (msg) < 0)
         return -1;
-    }
-    flags |= FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    msg->proto.flags |= FLUX_MSGFLAG_ROUTE;
+    return 0;
 }
 
 int flux_msg_clear_route (flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int size;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE))
-        return 0;
-    while ((zf = zmsg_pop (msg->zmsg))) {
-        size = zframe_size (zf);
-        zframe_destroy (&zf);
-        if (size == 0)
-            break;
     }
-    flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    msg_routes_clear (msg);
+    msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
+    return 0;
 }
 
 int flux_msg_push_route (flux_msg_t *msg, const char *id)
 {
-    uint8_t flags;
+    char *s;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg || !id) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zmsg_pushstr (msg->zmsg, id) < 0) {
+    if (msg_routes_reserve (msg) < 0)
+        return -1;
+    if (!(s = strdup (id))) {
         errno = ENOMEM;
         return -1;
     }
+    msg->routes[msg->route_count++] = s;
     return 0;
 }
 
 int flux_msg_pop_route (flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
+    char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zframe_size (zf) > 0 && (zf = zmsg_pop (msg->zmsg))) {
-        if (id) {
-            char *s = zframe_strdup (zf);
-            if (!s) {
-                zframe_destroy (&zf);
-                errno = ENOMEM;
-                return -1;
-            }
-            *id = s;
-        }
-        zframe_destroy (&zf);
-    } else {
-        if (id)
-            *id = NULL;
-    }
+    if (msg->route_count > 0)
+        s = msg->routes[--msg->route_count];
+    if (id)
+        *id = s;
+    else
+        free (s);
     return 0;
 }
 
-/* replaces flux_msg_nexthop */
-int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+/* Duplicate route at 'index' from the start of the stack, or set *id
+ * to NULL if there are no routes.
+ */
+static int get_route_dup (const flux_msg_t *msg, int index, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
     char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
+    if (msg->route_count > 0 && !(s = strdup (msg->routes[index]))) {
         errno = ENOMEM;
         return -1;
     }
@@ -929,114 +1073,54 @@ int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
     return 0;
 }
 
-static zframe_t *find_route_first (const flux_msg_t *msg)
+/* replaces flux_msg_nexthop */
+int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf, *zf_next;
-
-    if (!msg
-        || flux_msg_get_flags (msg, &flags) < 0
-        || !(flags & FLUX_MSGFLAG_ROUTE)) {
-        return NULL;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf_next = zmsg_next (msg->zmsg);
-        if (zf_next && zframe_size (zf_next) == 0)
-            break;
-        zf = zf_next;
-    }
-    return zf;
+    return get_route_dup (msg, msg ? msg->route_count - 1 : 0, id);
 }
 
 /* replaces flux_msg_sender */
 int flux_msg_get_route_first (const flux_msg_t *msg, char **id)
 {
-    zframe_t *zf;
-    char *s = NULL;
-
-    if (!(zf = find_route_first (msg))) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
-        errno = ENOMEM;
-        return -1;
-    }
-    *id = s;
-    return 0;
+    return get_route_dup (msg, 0, id);
 }
 
 int flux_msg_get_route_count (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    return count;
+    return msg->route_count;
 }
 
 /* Get sum of size in bytes of route frames
  */
 static int flux_msg_get_route_size (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
     int size = 0;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        size += zframe_size (zf);
-        zf = zmsg_next (msg->zmsg);
-    }
+    for (int i = 0; i < msg->route_count; i++)
+        size += strlen (msg->routes[i]);
     return size;
 }
 
-static zframe_t *flux_msg_get_route_nth (const flux_msg_t *msg, int n)
-{
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return NULL;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return NULL;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        if (count == n)
-            return zf;
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    errno = ENOENT;
-    return NULL;
-}
-
 char *flux_msg_get_route_string (const flux_msg_t *msg)
 {
     int hops, len;
     int n;
-    zframe_t *zf;
     char *buf, *cp;
 
     if (msg == NULL) {
@@ -1049,95 +1133,64 @@ char *flux_msg_get_route_string (const flux_msg_t *msg)
     }
     if (!(cp = buf = malloc (len + hops + 1)))
         return NULL;
-    for (n = hops - 1; n >= 0; n--) {
+    for (n = 0; n < hops; n++) {
         if (cp > buf)
             *cp++ = '!';
-        if (!(zf = flux_msg_get_route_nth (msg, n))) {
-            ERRNO_SAFE_WRAP (free, buf);
-            return NULL;
-        }
-        int cpylen = zframe_size (zf);
+        int cpylen = strlen (msg->routes[n]);
         if (cpylen > 8) /* abbreviate long UUID */
             cpylen = 8;
         assert (cp - buf + cpylen < len + hops);
-        memcpy (cp, zframe_data (zf), cpylen);
+        memcpy (cp, msg->routes[n], cpylen);
         cp += cpylen;
     }
     *cp = '\0';
     return buf;
 }
 
-static bool payload_overlap (const void *b, zframe_t *zf)
+static bool payload_overlap (const flux_msg_t *msg, const void *b)
 {
-    return ((char *)b >= (char *)zframe_data (zf)
-         && (char *)b <  (char *)zframe_data (zf) + zframe_size (zf));
+    return ((char *)b >= (char *)msg->payload
+         && (char *)b <  (char *)msg->payload + msg->payload_size);
 }
 
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-    int rc = -1;
+    struct msg_buf *mbuf;
 
     if (!msg) {
         errno = EINVAL;
-        goto done;
+        return -1;
     }
     json_decref (msg->json);            /* invalidate cached json object */
     msg->json = NULL;
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        rc = 0;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);      /* skip route frame */
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip route delim */
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip topic frame */
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    /* Case #1: replace existing payload.
+    /* Case #1: remove payload (if any).
      */
-    if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        if (zframe_data (zf) != buf || zframe_size (zf) != size) {
-            if (payload_overlap (buf, zf)) {
-                errno = EINVAL;
-                goto done;
-            }
-            zframe_reset (zf, buf, size);
-        }
-    /* Case #2: add payload.
+    if (buf == NULL || size == 0) {
+        msg_buf_decref (msg->payload_buf);
+        msg->payload_buf = NULL;
+        msg->payload = NULL;
+        msg->payload_size = 0;
+        msg->proto.flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
+        return 0;
+    }
+    /* Case #2: add or replace payload.
      */
-    } else if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        if (zmsg_addmem (msg->zmsg, buf, size) < 0
-                                        || zmsg_append (msg->zmsg, &zf) < 0) {
-            errno = ENOMEM;
-            goto done;
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (msg->payload == buf && msg->payload_size == size)
+            return 0;
+        if (payload_overlap (msg, buf)) {
+            errno = EINVAL;
+            return -1;
         }
-        flags |= FLUX_MSGFLAG_PAYLOAD;
-    /* Case #3: remove payload.
-     */
-    } else if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
     }
-    if (flux_msg_set_flags (msg, flags) < 0)
-        goto done;
-    rc = 0;
-done:
-    return rc;
+    if (!(mbuf = msg_buf_create (buf, size)))
+        return -1;
+    msg_buf_decref (msg->payload_buf);
+    msg->payload_buf = mbuf;
+    msg->payload = mbuf->data;
+    msg->payload_size = size;
+    msg->proto.flags |= FLUX_MSGFLAG_PAYLOAD;
+    return 0;
 }
 
 static inline void msg_lasterr_reset (flux_msg_t *msg)
@@ -1214,34 +1267,18 @@ int flux_msg_pack (flux_msg_t *msg, const char *fmt, ...)
 
 int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD)) {
-        errno = EPROTO;
+    if (!msg) {
+        errno = EINVAL;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {
+    if (!(msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
         errno = EPROTO;
         return -1;
     }
     if (buf)
-        *buf = zframe_data (zf);
+        *buf = msg->payload;
     if (size)
-        *size = zframe_size (zf);
+        *size = msg->payload_size;
     return 0;
 }
 
@@ -1359,140 +1396,76 @@ const char *flux_msg_last_error (const flux_msg_t *msg)
 
 int flux_msg_set_topic (flux_msg_t *msg, const char *topic)
 {
-    zframe_t *zf, *zf2 = NULL;
-    uint8_t flags;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {   /* skip over routing frames, if any */
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC) && topic) {        /* case 1: repl topic */
-        zframe_reset (zf, topic, strlen (topic) + 1);
-    } else if (!(flags & FLUX_MSGFLAG_TOPIC) && topic) {/* case 2: add topic */
-        zmsg_remove (msg->zmsg, zf);
-        if ((flags & FLUX_MSGFLAG_PAYLOAD) && (zf2 = zmsg_next (msg->zmsg)))
-            zmsg_remove (msg->zmsg, zf2);
-        if (zmsg_addmem (msg->zmsg, topic, strlen (topic) + 1) < 0
-                                    || zmsg_append (msg->zmsg, &zf) < 0
-                                    || (zf2 && zmsg_append (msg->zmsg, &zf2) < 0)) {
-            errno = ENOMEM;
-            goto done;
-        }
-        flags |= FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    } else if ((flags & FLUX_MSGFLAG_TOPIC) && !topic) { /* case 3: del topic */
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    }
-    rc = 0;
-done:
-    return rc;
-}
-
-static int zf_topic (const flux_msg_t *msg, zframe_t **zfp)
-{
-    uint8_t flags;
-    zframe_t *zf = NULL;
-    int rc = -1;
+    char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_TOPIC)) {
-        errno = EPROTO;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
     }
-    if (!zf) {
-        errno = EPROTO;
-        goto done;
+    if (topic && !(s = strdup (topic))) {
+        errno = ENOMEM;
+        return -1;
     }
-    *zfp = zf;
-    rc = 0;
-done:
-    return rc;
+    free (msg->topic);
+    msg->topic = s;
+    if (s)
+        msg->proto.flags |= FLUX_MSGFLAG_TOPIC;
+    else
+        msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
+    return 0;
 }
 
 int flux_msg_get_topic (const flux_msg_t *msg, const char **topic)
 {
-    zframe_t *zf;
-    const char *s;
-    int rc = -1;
-
-    if (zf_topic (msg, &zf) < 0)
-        goto done;
-    s = (const char *)zframe_data (zf);
-    if (s[zframe_size (zf) - 1] != '\0') {
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
         errno = EPROTO;
-        goto done;
+        return -1;
     }
-    *topic = s;
-    rc = 0;
-done:
-    return rc;
+    *topic = msg->topic;
+    return 0;
 }
 
+/* N.B. The payload is immutable once set, so the copy shares it
+ * with the original rather than duplicating it.
+ */
 flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
 {
     flux_msg_t *cpy = NULL;
-    zframe_t *zf;
-    int count;
-    uint8_t flags;
-    bool skip_payload = false;
 
-    /* Set skip_payload = true if caller set 'payload' flag false
-     * AND message contains a payload frame.
-     */
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return NULL;
-    if (!payload && (flags & FLUX_MSGFLAG_PAYLOAD)) {
-        flags &= ~(FLUX_MSGFLAG_PAYLOAD);
-        skip_payload = true;
     }
     if (!(cpy = flux_msg_create_common ()))
         return NULL;
-    if (!(cpy->zmsg = zmsg_new ()))
-        goto nomem;
-
-    /* Copy frames from 'msg' to 'cpy'.
-     * 'count' indexes frames from 0 to zmsg_size (msg) - 1.
-     * The payload frame (if it exists) will be in the second to last position.
-     */
-    count = 0;
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        if (!skip_payload || count != zmsg_size (msg->zmsg) - 2) {
-            if (zmsg_addmem (cpy->zmsg, zframe_data (zf), zframe_size (zf)) < 0)
+    cpy->proto = msg->proto;
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        cpy->route_alloc = msg->route_count + route_headroom;
+        if (!(cpy->routes = calloc (cpy->route_alloc, sizeof (cpy->routes[0]))))
+            goto nomem;
+        while (cpy->route_count < msg->route_count) {
+            int i = cpy->route_count;
+            if (!(cpy->routes[i] = strdup (msg->routes[i])))
                 goto nomem;
+            cpy->route_count++;
         }
-        zf = zmsg_next (msg->zmsg);
-        count++;
     }
-    if (flux_msg_set_flags (cpy, flags) < 0)
-        goto error;
+    if (msg->topic && !(cpy->topic = strdup (msg->topic)))
+        goto nomem;
+    if (payload) {
+        cpy->payload_buf = msg_buf_incref (msg->payload_buf);
+        cpy->payload = msg->payload;
+        cpy->payload_size = msg->payload_size;
+    }
+    else
+        cpy->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_PAYLOAD;
     return cpy;
 nomem:
     errno = ENOMEM;
-error:
     flux_msg_destroy (cpy);
     return NULL;
 }
@@ -1535,7 +1508,7 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
 {
     int hops;
     int type = 0;
-    zframe_t *proto;
+    uint8_t proto[PROTO_SIZE];
     const char *prefix, *topic = NULL;
 
     fprintf (f, "--------------------------------------\n");
@@ -1543,8 +1516,7 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
         fprintf (f, "NULL");
         return;
     }
-    if (flux_msg_get_type (msg, &type) < 0
-            || (!(proto = zmsg_last (msg->zmsg)))) {
+    if (flux_msg_get_type (msg, &type) < 0) {
         fprintf (f, "malformed message");
         return;
     }
@@ -1579,36 +1551,66 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
     }
     /* Proto block
      */
-    zframe_fprint (proto, prefix, f);
+    proto_encode (&msg->proto, proto);
+    fprintf (f, "%s[%03d] ", prefix, PROTO_SIZE);
+    for (int i = 0; i < PROTO_SIZE; i++)
+        fprintf (f, "%02X", proto[i]);
+    fprintf (f, "\n");
 }
 
-int flux_msg_sendzsock_ex (void *sock, const flux_msg_t *msg, bool nonblock)
+static int sendzsock (void *sock,
+                      const flux_msg_t *msg,
+                      const char **routes,
+                      int nroutes,
+                      bool nonblock)
 {
-    int rc = -1;
+    struct frame_iter it;
+    struct msg_frame f;
+    void *handle;
+    int flags = 0;
 
-    if (!sock || !msg || !zmsg_is (msg->zmsg)) {
+    if (!sock || !msg) {
         errno = EINVAL;
-        goto done;
+        return -1;
+    }
+    if (!(handle = zsock_resolve (sock))) {
+        errno = EINVAL;
+        return -1;
     }
+    if (nonblock)
+        flags |= ZMQ_DONTWAIT;
 
-    void *handle = zsock_resolve (sock);
-    int flags = ZFRAME_REUSE | ZFRAME_MORE;
-    zframe_t *zf = zmsg_first (msg->zmsg);
-    size_t count = 0;
+    frame_iter_init_route (&it, msg, routes, nroutes);
+    while (frame_iter_next (&it, &f)) {
+        int more = it.index < it.nframes ? ZMQ_SNDMORE : 0;
+        if (zmq_send (handle, f.data, f.size, flags | more) < 0)
+            return -1;
+    }
+    return 0;
+}
 
-    if (nonblock)
-        flags |= ZFRAME_DONTWAIT;
+int flux_msg_sendzsock_ex (void *sock, const flux_msg_t *msg, bool nonblock)
+{
+    return sendzsock (sock, msg, NULL, 0, nonblock);
+}
 
-    while (zf) {
-        if (++count == zmsg_size (msg->zmsg))
-            flags &= ~ZFRAME_MORE;
-        if (zframe_send (&zf, handle, flags) < 0)
-            goto done;
-        zf = zmsg_next (msg->zmsg);
+int flux_msg_sendzsock_route (void *sock,
+                              const flux_msg_t *msg,
+                              const char **routes,
+                              int nroutes,
+                              bool nonblock)
+{
+    static const char *noroutes[] = { NULL };
+
+    if (nroutes < 0 || (nroutes > 0 && !routes)) {
+        errno = EINVAL;
+        return -1;
     }
-    rc = 0;
-done:
-    return rc;
+    /* A non-NULL 'routes' enables routing, even if 'nroutes' is zero.
+     */
+    if (!routes)
+        routes = noroutes;
+    return sendzsock (sock, msg, routes, nroutes, nonblock);
 }
 
 int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
@@ -1616,25 +1618,92 @@ int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
     return flux_msg_sendzsock_ex (sock, msg, false);
 }
 
+/* Receive all parts of one zeromq message.  The payload part, if any,
+ * is moved into a msg_buf so the message can reference it without a copy.
+ */
 flux_msg_t *flux_msg_recvzsock (void *sock)
 {
-    zmsg_t *zmsg;
-    flux_msg_t *msg;
+    void *handle;
+    zmq_msg_t *parts = NULL;
+    struct msg_frame *frames = NULL;
+    struct msg_buf *mbuf = NULL;
+    struct msg_proto proto;
+    flux_msg_t *msg = NULL;
+    int count = 0;
+    int alloc = 0;
+    int more;
 
-    if (!(zmsg = zmsg_recv (sock)))
+    if (!sock || !(handle = zsock_resolve (sock))) {
+        errno = EINVAL;
         return NULL;
-    if (!(msg = flux_msg_create_common ())) {
-        zmsg_destroy (&zmsg);
+    }
+    do {
+        size_t more_size = sizeof (more);
+        if (count == alloc) {
+            int new_alloc = alloc ? alloc * 2 : 8;
+            zmq_msg_t *new_parts;
+            if (!(new_parts = realloc (parts, new_alloc * sizeof (parts[0])))) {
+                errno = ENOMEM;
+                goto done;
+            }
+            parts = new_parts;
+            alloc = new_alloc;
+        }
+        if (zmq_msg_init (&parts[count]) < 0)
+            goto done;
+        if (zmq_msg_recv (&parts[count], handle, 0) < 0) {
+            ERRNO_SAFE_WRAP (zmq_msg_close, &parts[count]);
+            goto done;
+        }
+        count++;
+        if (zmq_getsockopt (handle, ZMQ_RCVMORE, &more, &more_size) < 0)
+            goto done;
+    } while (more);
+
+    if (!(frames = calloc (count, sizeof (frames[0])))) {
         errno = ENOMEM;
-        return NULL;
+        goto done;
+    }
+    for (int i = 0; i < count; i++) {
+        frames[i].data = zmq_msg_data (&parts[i]);
+        frames[i].size = zmq_msg_size (&parts[i]);
     }
-    msg->zmsg = zmsg;
+    if (proto_decode (&proto,
+                      frames[count - 1].data,
+                      frames[count - 1].size) == 0
+        && (proto.flags & FLUX_MSGFLAG_PAYLOAD)
+        && count >= 2) {
+        if (!(mbuf = malloc (sizeof (*mbuf)))) {
+            errno = ENOMEM;
+            goto done;
+        }
+        mbuf->refcount = 1;
+        mbuf->zmsg_valid = true;
+        zmq_msg_init (&mbuf->zmsg);
+        zmq_msg_move (&mbuf->zmsg, &parts[count - 2]);
+        frames[count - 2].data = zmq_msg_data (&mbuf->zmsg);
+    }
+    msg = msg_from_frames (frames, count, mbuf);
+done:
+    for (int i = 0; i < count; i++)
+        ERRNO_SAFE_WRAP (zmq_msg_close, &parts[i]);
+    msg_buf_decref (mbuf);
+    ERRNO_SAFE_WRAP (free, frames);
+    ERRNO_SAFE_WRAP (free, parts);
     return msg;
 }
 
 int flux_msg_frames (const flux_msg_t *msg)
 {
-    return zmsg_size (msg->zmsg);
+    int n = 1;
+
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE))
+        n += msg->route_count + 1;
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC))
+        n++;
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD))
+        n++;
+    return n;
 }
 
 struct flux_match flux_match_init (int typemask,
@@ -1661,16 +1730,27 @@ int flux_match_asprintf (struct flux_match *m, const char *topic_glob_fmt, ...)
     return res;
 }
 
-bool flux_msg_match_route_first (const flux_msg_t *msg1, const flux_msg_t *msg2)
+bool flux_msg_cmp_route_last (const flux_msg_t *msg, const char *id)
 {
-    zframe_t *zf1 = find_route_first (msg1);
-    zframe_t *zf2 = find_route_first (msg2);
-    int len;
+    if (!msg
+        || !id
+        || !(msg->proto.flags & FLUX_MSGFLAG_ROUTE)
+        || msg->route_count == 0)
+        return false;
+    if (strcmp (msg->routes[msg->route_count - 1], id) != 0)
+        return false;
+    return true;
+}
 
-    if (!zf1 || !zf2)
+bool flux_msg_match_route_first (const flux_msg_t *msg1, const flux_msg_t *msg2)
+{
+    if (!msg1 || !msg2
+        || !(msg1->proto.flags & FLUX_MSGFLAG_ROUTE)
+        || !(msg2->proto.flags & FLUX_MSGFLAG_ROUTE))
         return false;
-    if ((len = zframe_size (zf1)) != zframe_size (zf2)
-        || memcmp (zframe_data (zf1), zframe_data (zf2), len) != 0)
+    if (msg1->route_count == 0 || msg2->route_count == 0)
+        return msg1->route_count == msg2->route_count;
+    if (strcmp (msg1->routes[0], msg2->routes[0]) != 0)
         return false;
     return true;
 }
@@ -1678,4 +1758,3 @@ bool flux_msg_match_route_first (const flux_msg_t *msg1, const flux_msg_t *msg2)
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
-
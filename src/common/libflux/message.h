@@ -134,6 +134,17 @@ flux_msg_t *flux_msg_decode (const void *buf, size_t size);
 int flux_msg_sendzsock (void *dest, const flux_msg_t *msg);
 int flux_msg_sendzsock_ex (void *dest, const flux_msg_t *msg, bool nonblock);
 
+/* Send message to zeromq socket as though routing were enabled and
+ * 'routes' (in order) were pushed onto a copy of it.  The message itself
+ * is not modified.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int flux_msg_sendzsock_route (void *dest,
+                              const flux_msg_t *msg,
+                              const char **routes,
+                              int nroutes,
+                              bool nonblock);
+
 /* Receive a message from zeromq socket.
  * Returns message on success, NULL on failure with errno set.
  */
@@ -185,7 +196,10 @@ bool flux_msg_has_payload (const flux_msg_t *msg);
 /* Get/set flags
  * Users should avoid using flux_msg_set_flags(), and instead use the
  * higher level functions that manipulate message flags.  It is exposed
- * mainly for testing.
+ * mainly for testing.  flux_msg_set_flags() fails with EINVAL if 'flags'
+ * would change FLUX_MSGFLAG_TOPIC, FLUX_MSGFLAG_PAYLOAD, or
+ * FLUX_MSGFLAG_ROUTE, since those follow the presence of the topic,
+ * payload, and route frames.
  */
 int flux_msg_get_flags (const flux_msg_t *msg, uint8_t *flags);
 int flux_msg_set_flags (flux_msg_t *msg, uint8_t flags);
@@ -364,6 +378,11 @@ char *flux_msg_get_route_string (const flux_msg_t *msg);
 bool flux_msg_match_route_first (const flux_msg_t *msg1,
                                  const flux_msg_t *msg2);
 
+/* Return true if the last routing frame of 'msg' (for responses, the
+ * next hop) is equal to 'id'.  This does not allocate memory.
+ */
+bool flux_msg_cmp_route_last (const flux_msg_t *msg, const char *id);
+
 #ifdef __cplusplus
 }
 #endif
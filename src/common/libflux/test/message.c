@@ -41,6 +41,8 @@ void check_routes (void)
         "flux_msg_get_route_last returns -1 errno EPROTO on msg w/o delim");
     ok ((flux_msg_pop_route (msg, &s) == -1 && errno == EPROTO),
         "flux_msg_pop_route returns -1 errno EPROTO on msg w/o delim");
+    ok (flux_msg_cmp_route_last (msg, "sender") == false,
+        "flux_msg_cmp_route_last returns false on msg w/o delim");
 
     ok (flux_msg_clear_route (msg) == 0 && flux_msg_frames (msg) == 1,
         "flux_msg_clear_route works, is no-op on msg w/o delim");
@@ -88,6 +90,12 @@ void check_routes (void)
     like (s, "router",
         "flux_msg_get_route_last returns id2 on message with delim+id1+id2");
     free (s);
+    ok (flux_msg_cmp_route_last (msg, "router") == true,
+        "flux_msg_cmp_route_last returns true for last id");
+    ok (flux_msg_cmp_route_last (msg, "sender") == false,
+        "flux_msg_cmp_route_last returns false for first id");
+    ok (flux_msg_cmp_route_last (msg, NULL) == false,
+        "flux_msg_cmp_route_last returns false for NULL id");
 
     s = NULL;
     ok (flux_msg_pop_route (msg, &s) == 0 && s != NULL,
@@ -728,6 +736,59 @@ void check_sendzsock (void)
             && flux_msg_has_payload (msg2) == false,
         "try2: decoded message looks like what was sent");
     flux_msg_destroy (msg2);
+
+    /* Send it with routes added in flight.
+     */
+    const char *routes[] = { "sender", "router" };
+    char *s;
+    ok (flux_msg_sendzsock_route (zsock[1], msg, routes, 2, false) == 0,
+        "flux_msg_sendzsock_route works");
+    ok ((msg2 = flux_msg_recvzsock (zsock[0])) != NULL,
+        "flux_msg_recvzsock works");
+    ok (flux_msg_get_route_count (msg2) == 2
+            && flux_msg_cmp_route_last (msg2, "router")
+            && flux_msg_get_route_first (msg2, &s) == 0
+            && s != NULL && !strcmp (s, "sender"),
+        "decoded message has routes pushed in order");
+    free (s);
+    ok (flux_msg_get_topic (msg2, &topic) == 0
+            && !strcmp (topic, "foo.bar")
+            && flux_msg_frames (msg2) == flux_msg_frames (msg) + 3,
+        "decoded message otherwise looks like what was sent");
+    errno = 0;
+    ok (flux_msg_get_route_count (msg) < 0 && errno == EPROTO,
+        "original message was not modified");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_sendzsock_route (zsock[1], msg, NULL, 0, false) == 0,
+        "flux_msg_sendzsock_route works with no routes");
+    ok ((msg2 = flux_msg_recvzsock (zsock[0])) != NULL,
+        "flux_msg_recvzsock works");
+    ok (flux_msg_get_route_count (msg2) == 0,
+        "decoded message has routing enabled and no routes");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_enable_route (msg) == 0
+            && flux_msg_push_route (msg, "origin") == 0,
+        "pushed a route onto test message");
+    ok (flux_msg_sendzsock_route (zsock[1], msg, routes, 1, false) == 0,
+        "flux_msg_sendzsock_route works on message with routes");
+    ok ((msg2 = flux_msg_recvzsock (zsock[0])) != NULL,
+        "flux_msg_recvzsock works");
+    ok (flux_msg_get_route_count (msg2) == 2
+            && flux_msg_cmp_route_last (msg2, "sender")
+            && flux_msg_get_route_first (msg2, &s) == 0
+            && s != NULL && !strcmp (s, "origin"),
+        "decoded message has new route after existing one");
+    free (s);
+    ok (flux_msg_get_route_count (msg) == 1,
+        "original message was not modified");
+    flux_msg_destroy (msg2);
+
+    errno = 0;
+    ok (flux_msg_sendzsock_route (zsock[1], msg, NULL, 1, false) < 0
+            && errno == EINVAL,
+        "flux_msg_sendzsock_route routes=NULL nroutes=1 fails with EINVAL");
     flux_msg_destroy (msg);
 
     zsock_destroy (&zsock[0]);
@@ -885,7 +946,7 @@ void check_params (void)
 void check_flags (void)
 {
     flux_msg_t *msg;
-    uint8_t flags;
+    uint8_t flags, flags2;
 
     if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)))
         BAIL_OUT ("flux_msg_create failed");
@@ -945,6 +1006,48 @@ void check_flags (void)
         && (flags & FLUX_MSGFLAG_ROUTE),
         "flux_msg_enable_route sets FLUX_MSGFLAG_ROUTE");
 
+    /* flags that indicate the presence of frames cannot be changed */
+
+    if (flux_msg_get_flags (msg, &flags) < 0)
+        BAIL_OUT ("flux_msg_get_flags failed");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, flags & ~FLUX_MSGFLAG_TOPIC) < 0
+        && errno == EINVAL,
+        "flux_msg_set_flags clearing FLUX_MSGFLAG_TOPIC fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, flags & ~FLUX_MSGFLAG_PAYLOAD) < 0
+        && errno == EINVAL,
+        "flux_msg_set_flags clearing FLUX_MSGFLAG_PAYLOAD fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, flags & ~FLUX_MSGFLAG_ROUTE) < 0
+        && errno == EINVAL,
+        "flux_msg_set_flags clearing FLUX_MSGFLAG_ROUTE fails with EINVAL");
+    ok (flux_msg_get_flags (msg, &flags2) == 0 && flags2 == flags,
+        "flags are unchanged after failed flux_msg_set_flags");
+    ok (flux_msg_set_flags (msg, (flags & ~FLUX_MSGFLAG_STREAMING)
+                                 | FLUX_MSGFLAG_PRIVATE) == 0
+        && flux_msg_get_flags (msg, &flags2) == 0
+        && flags2 == ((flags & ~FLUX_MSGFLAG_STREAMING)
+                      | FLUX_MSGFLAG_PRIVATE),
+        "flux_msg_set_flags changing other flags works");
+
+    flux_msg_destroy (msg);
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)))
+        BAIL_OUT ("flux_msg_create failed");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, FLUX_MSGFLAG_TOPIC) < 0 && errno == EINVAL,
+        "flux_msg_set_flags setting FLUX_MSGFLAG_TOPIC fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, FLUX_MSGFLAG_PAYLOAD) < 0 && errno == EINVAL,
+        "flux_msg_set_flags setting FLUX_MSGFLAG_PAYLOAD fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_flags (msg, FLUX_MSGFLAG_ROUTE) < 0 && errno == EINVAL,
+        "flux_msg_set_flags setting FLUX_MSGFLAG_ROUTE fails with EINVAL");
+    ok (flux_msg_set_flags (msg, FLUX_MSGFLAG_UPSTREAM) == 0
+        && flux_msg_get_flags (msg, &flags) == 0
+        && flags == FLUX_MSGFLAG_UPSTREAM,
+        "flux_msg_set_flags FLUX_MSGFLAG_UPSTREAM works");
     flux_msg_destroy (msg);
 
     /* invalid params checks */
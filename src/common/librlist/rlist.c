@@ -54,6 +54,138 @@ sprintfcat (char **s, size_t *sz, size_t *lenp, const char *fmt, ...)
     return (n);
 }
 
+/*  Index of rlist nodes used by the allocator. Up nodes are bucketed
+ *   by available core count, so candidate nodes can be visited in
+ *   worst-fit, best-fit, or rank order without sorting the node list,
+ *   and moving a node between buckets after an alloc or free costs
+ *   O(log N) (idsets are van Emde Boas trees).
+ */
+struct rlist_index {
+    unsigned int nranks;    /* size of rnodes[] and bucket[] (max rank + 1) */
+    struct rnode **rnodes;  /* rank -> rnode */
+    int *bucket;            /* rank -> current avail bucket, -1 if not up */
+
+    int nbuckets;           /* max cores per node + 1 */
+    struct idset **avail;   /* avail[i]: ranks of up nodes with i avail cores */
+    int *nsize;             /* nsize[i]: number of nodes with i total cores */
+    unsigned int *cursor;   /* per-bucket scratch for rank order iteration */
+};
+
+static void rlist_index_destroy (struct rlist_index *idx)
+{
+    if (idx) {
+        int saved_errno = errno;
+        if (idx->avail) {
+            for (int i = 0; i < idx->nbuckets; i++)
+                idset_destroy (idx->avail[i]);
+            free (idx->avail);
+        }
+        free (idx->rnodes);
+        free (idx->bucket);
+        free (idx->nsize);
+        free (idx->cursor);
+        free (idx);
+        errno = saved_errno;
+    }
+}
+
+/*  Move rnode 'n' to the bucket matching its current availability.
+ */
+static int rlist_index_set (struct rlist_index *idx, struct rnode *n)
+{
+    int b = n->up ? (int) rnode_avail (n) : -1;
+    int prev = idx->bucket[n->rank];
+
+    if (b == prev)
+        return 0;
+    if (b >= idx->nbuckets) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (b >= 0 && idset_set (idx->avail[b], n->rank) < 0)
+        return -1;
+    if (prev >= 0)
+        idset_clear (idx->avail[prev], n->rank);
+    idx->bucket[n->rank] = b;
+    return 0;
+}
+
+static struct rlist_index *rlist_index_create (const struct rlist *rl)
+{
+    struct rlist_index *idx;
+    struct rnode *n;
+
+    if (!(idx = calloc (1, sizeof (*idx))))
+        return NULL;
+    idx->nranks = 1;
+    idx->nbuckets = 1;
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        if (n->rank >= idx->nranks)
+            idx->nranks = n->rank + 1;
+        if (rnode_count (n) >= idx->nbuckets)
+            idx->nbuckets = rnode_count (n) + 1;
+        n = zlistx_next (rl->nodes);
+    }
+    if (!(idx->rnodes = calloc (idx->nranks, sizeof (*idx->rnodes)))
+        || !(idx->bucket = calloc (idx->nranks, sizeof (*idx->bucket)))
+        || !(idx->avail = calloc (idx->nbuckets, sizeof (*idx->avail)))
+        || !(idx->nsize = calloc (idx->nbuckets, sizeof (*idx->nsize)))
+        || !(idx->cursor = calloc (idx->nbuckets, sizeof (*idx->cursor))))
+        goto error;
+    for (unsigned int i = 0; i < idx->nranks; i++)
+        idx->bucket[i] = -1;
+    /*  Create all buckets up front so that rlist_index_set() does not
+     *   need to allocate memory.
+     */
+    for (int i = 0; i < idx->nbuckets; i++) {
+        if (!(idx->avail[i] = idset_create (idx->nranks, 0)))
+            goto error;
+    }
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        idx->rnodes[n->rank] = n;
+        idx->nsize[rnode_count (n)]++;
+        if (rlist_index_set (idx, n) < 0)
+            goto error;
+        n = zlistx_next (rl->nodes);
+    }
+    return idx;
+error:
+    rlist_index_destroy (idx);
+    return NULL;
+}
+
+static struct rlist_index *rlist_get_index (struct rlist *rl)
+{
+    if (!rl->index)
+        rl->index = rlist_index_create (rl);
+    return rl->index;
+}
+
+/*  Drop the allocator index, e.g. after a change to the set of nodes
+ *   or ranks in 'rl'. It will be rebuilt on next use.
+ */
+static void rlist_index_invalidate (struct rlist *rl)
+{
+    rlist_index_destroy (rl->index);
+    rl->index = NULL;
+}
+
+/*  Update rnode 'n' in the index of 'rl' (if any) after a change to
+ *   its available cores or up/down state.
+ */
+static void rlist_index_update (struct rlist *rl, struct rnode *n)
+{
+    struct rlist_index *idx = rl->index;
+    if (idx) {
+        if (n->rank >= idx->nranks
+            || idx->rnodes[n->rank] != n
+            || rlist_index_set (idx, n) < 0)
+            rlist_index_invalidate (rl);
+    }
+}
+
 void rlist_destroy (struct rlist *rl)
 {
     if (rl) {
@@ -61,6 +193,7 @@ void rlist_destroy (struct rlist *rl)
         zlistx_destroy (&rl->nodes);
         zhashx_destroy (&rl->noremap);
         json_decref (rl->scheduling);
+        rlist_index_destroy (rl->index);
         free (rl);
         errno = saved_errno;
     }
@@ -128,6 +261,18 @@ static struct rnode *rlist_find_rank (const struct rlist *rl, uint32_t rank)
     return NULL;
 }
 
+/*  Like rlist_find_rank(), but use the allocator index if possible
+ *   for O(1) lookup. Note: unlike rlist_find_rank() this does not leave
+ *   the rl->nodes cursor on the returned node.
+ */
+static struct rnode *rlist_lookup_rank (struct rlist *rl, uint32_t rank)
+{
+    struct rlist_index *idx = rlist_get_index (rl);
+    if (idx)
+        return rank < idx->nranks ? idx->rnodes[rank] : NULL;
+    return rlist_find_rank (rl, rank);
+}
+
 static void rlist_update_totals (struct rlist *rl, struct rnode *n)
 {
     rl->total += rnode_count (n);
@@ -139,6 +284,7 @@ static int rlist_add_rnode_new (struct rlist *rl, struct rnode *n)
 {
     if (!zlistx_add_end (rl->nodes, n))
         return -1;
+    rlist_index_invalidate (rl);
     rlist_update_totals (rl, n);
     return 0;
 }
@@ -153,6 +299,7 @@ static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
     if (found) {
         if (rnode_add (found, n) < 0)
             return -1;
+        rlist_index_invalidate (rl);
         rlist_update_totals (rl, n);
         rnode_destroy (n);
     }
@@ -295,6 +442,8 @@ int rlist_remove_ranks (struct rlist *rl, struct idset *ranks)
         }
         i = idset_next (ranks, i);
     }
+    if (count > 0)
+        rlist_index_invalidate (rl);
     return count;
 }
 
@@ -303,6 +452,8 @@ int rlist_remap (struct rlist *rl)
     uint32_t rank = 0;
     struct rnode *n;
 
+    rlist_index_invalidate (rl);
+
     /*   Sort list by ascending rank, then rerank starting at 0
      */
     zlistx_set_comparator (rl->nodes, by_rank);
@@ -334,6 +485,8 @@ static int rlist_rerank_hostlist (struct rlist *rl, struct hostlist *hl)
 {
     uint32_t rank = 0;
     const char *host = hostlist_first (hl);
+
+    rlist_index_invalidate (rl);
     while (host) {
         struct rnode *n = rlist_find_host (rl, host);
         if (!n)
@@ -384,8 +537,10 @@ done:
 static struct rnode *rlist_detach_rank (struct rlist *rl, uint32_t rank)
 {
     struct rnode *n = rlist_find_rank (rl, rank);
-    if (n)
+    if (n) {
         zlistx_detach_cur (rl->nodes);
+        rlist_index_invalidate (rl);
+    }
     return n;
 }
 
@@ -750,6 +905,7 @@ int rlist_rank_add_child (struct rlist *rl,
     }
     if (rnode_add_child (n, name, ids) == NULL)
         return -1;
+    rlist_index_invalidate (rl);
     return 0;
 }
 
@@ -1322,16 +1478,6 @@ static int by_rank (const void *item1, const void *item2)
     return (x->rank - y->rank);
 }
 
-static int by_avail (const void *item1, const void *item2)
-{
-    int n;
-    const struct rnode *x = item1;
-    const struct rnode *y = item2;
-    if ((n = rnode_avail (x) - rnode_avail (y)) == 0)
-        n = by_rank (x, y);
-    return n;
-}
-
 static int by_used (const void *item1, const void *item2)
 {
     int n;
@@ -1348,47 +1494,136 @@ static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
     if (!n || rnode_alloc (n, count, idsetp) < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
+    rlist_index_update (rl, n);
     return 0;
 }
 
-#if 0
-static uint32_t rlist_rnode_rank (struct rlist *rl)
+/*  Order in which candidate nodes are considered for allocation
+ */
+enum alloc_order {
+    ORDER_RANK,         /* ascending rank ("first-fit") */
+    ORDER_AVAIL_ASC,    /* fewest available cores first ("best-fit") */
+    ORDER_AVAIL_DESC,   /* most available cores first ("worst-fit") */
+};
+
+static int alloc_order_from_mode (const char *mode)
 {
-    struct rnode *n = zlistx_item (rl->nodes);
-    if (n)
-        return n->rank;
-    else
-        return (uint32_t)-1;
+    if (mode == NULL || strcmp (mode, "worst-fit") == 0)
+        return ORDER_AVAIL_DESC;
+    else if (strcmp (mode, "best-fit") == 0)
+        return ORDER_AVAIL_ASC;
+    else if (strcmp (mode, "first-fit") == 0)
+        return ORDER_RANK;
+    errno = EINVAL;
+    return -1;
 }
-#endif
 
-static struct rnode *rlist_first (struct rlist *rl)
+/*  Iterator over up nodes with at least 'min' cores available, in
+ *   'order', with ties in available cores broken by rank.
+ *
+ *  The current node may be moved to another bucket while iterating
+ *   (e.g. by allocating from it) as long as it lands in a bucket < min.
+ */
+struct candidates {
+    struct rlist *rl;
+    int order;
+    int min;
+    int b;              /* current bucket */
+    unsigned int rank;  /* last rank returned */
+};
+
+static struct rnode *candidates_next (struct candidates *c)
 {
-    return zlistx_first (rl->nodes);
+    struct rlist_index *idx = c->rl->index;
+    unsigned int r;
+
+    /*  Index was dropped (e.g. on error), end iteration */
+    if (!idx)
+        return NULL;
+
+    if (c->order == ORDER_RANK) {
+        /*  Merge buckets >= min by rank. Advance only the cursor of
+         *   the bucket from which the last node was returned.
+         */
+        if (c->b >= 0)
+            idx->cursor[c->b] = idset_next (idx->avail[c->b], c->rank);
+        c->b = -1;
+        for (int i = c->min; i < idx->nbuckets; i++) {
+            if (idx->cursor[i] != IDSET_INVALID_ID
+                && (c->b < 0 || idx->cursor[i] < idx->cursor[c->b]))
+                c->b = i;
+        }
+        if (c->b < 0)
+            return NULL;
+        c->rank = idx->cursor[c->b];
+        return idx->rnodes[c->rank];
+    }
+    while (c->b >= c->min && c->b < idx->nbuckets) {
+        if (c->rank == IDSET_INVALID_ID)
+            r = idset_first (idx->avail[c->b]);
+        else
+            r = idset_next (idx->avail[c->b], c->rank);
+        if (r != IDSET_INVALID_ID) {
+            c->rank = r;
+            return idx->rnodes[r];
+        }
+        c->rank = IDSET_INVALID_ID;
+        c->b += (c->order == ORDER_AVAIL_ASC) ? 1 : -1;
+    }
+    return NULL;
 }
 
-static struct rnode *rlist_next (struct rlist *rl)
+static struct rnode *candidates_first (struct candidates *c,
+                                       struct rlist *rl,
+                                       int order,
+                                       int min)
 {
-    return zlistx_next (rl->nodes);
+    struct rlist_index *idx = rlist_get_index (rl);
+
+    if (!idx)
+        return NULL;
+    c->rl = rl;
+    c->order = order;
+    c->min = min;
+    c->rank = IDSET_INVALID_ID;
+    if (order == ORDER_RANK) {
+        for (int i = min; i < idx->nbuckets; i++)
+            idx->cursor[i] = idset_first (idx->avail[i]);
+        c->b = -1;
+    }
+    else if (order == ORDER_AVAIL_ASC)
+        c->b = min;
+    else
+        c->b = idx->nbuckets - 1;
+    return candidates_next (c);
 }
 
 /*
  *  Allocate the first available N slots of size cores_per_slot from
- *   resource list rl after sorting the nodes with the current sort strategy.
+ *   resource list rl, visiting nodes in the given order:
+ *
+ *   ORDER_AVAIL_ASC:  "best fit" (minimize nodes used)
+ *   ORDER_AVAIL_DESC: "worst fit" (spread jobs across nodes)
+ *   ORDER_RANK:       "first fit"
  */
-static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
-                                             int cores_per_slot,
-                                             int slots)
+static struct rlist * rlist_alloc_ordered (struct rlist *rl,
+                                           int order,
+                                           int cores_per_slot,
+                                           int slots)
 {
     int rc;
     struct idset *ids = NULL;
     struct rnode *n = NULL;
     struct rlist *result = NULL;
+    struct candidates c;
 
-    zlistx_sort (rl->nodes);
-
-    if (!(n = rlist_first (rl)))
+    /* 1. get first node that could fit a slot
+     */
+    if (!(n = candidates_first (&c, rl, order, cores_per_slot))) {
+        if (rl->index)
+            errno = ENOSPC;
         return NULL;
+    }
 
     if (!(result = rlist_create ()))
         return NULL;
@@ -1402,7 +1637,7 @@ static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
         if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0) {
             if (errno != ENOSPC)
                 goto unwind;
-            n = rlist_next (rl);
+            n = candidates_next (&c);
             continue;
         }
         /*  Append the allocated cores to the result set and continue
@@ -1424,51 +1659,25 @@ unwind:
     return result;
 }
 
-/*
- *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
- *   we get something like "best fit". (minimize nodes used)
+/*  Return a list of the `nnodes` least utilized up nodes in `rl`.
  */
-static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
-                                            int cores_per_slot,
-                                            int slots)
-{
-    zlistx_set_comparator (rl->nodes, by_avail);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
-}
-
-/*
- *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
- *   we get something like "worst fit". (Spread jobs across nodes)
- */
-static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
-                                             int cores_per_slot,
-                                             int slots)
-{
-    zlistx_set_comparator (rl->nodes, by_used);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
-}
-
-
 static zlistx_t *rlist_get_nnodes (struct rlist *rl, int nnodes)
 {
     struct rnode *n;
+    struct candidates c;
     zlistx_t *l = zlistx_new ();
     if (!l)
         return NULL;
-    n = zlistx_first (rl->nodes);
+    n = candidates_first (&c, rl, ORDER_AVAIL_DESC, 0);
     while (nnodes > 0) {
         if (n == NULL) {
             errno = ENOSPC;
             goto err;
         }
-        if (n->up) {
-            if (!zlistx_add_end (l, n))
-                goto err;
-            nnodes--;
-        }
-        n = zlistx_next (rl->nodes);
+        if (!zlistx_add_end (l, n))
+            goto err;
+        nnodes--;
+        n = candidates_next (&c);
     }
     return (l);
 err:
@@ -1498,12 +1707,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 1. sort rank list by used cores ascending:
-     */
-    zlistx_set_comparator (rl->nodes, by_used);
-    zlistx_sort (rl->nodes);
-
-    /* 2. get a list of the first up n nodes
+    /* 1. get a list of the first n up nodes by used cores ascending
      */
     if (!(cl = rlist_get_nnodes (rl, nnodes)))
         goto unwind;
@@ -1514,7 +1718,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     zlistx_set_comparator (cl, by_used);
 
     /*
-     * 3. divide slots across all nodes, placing each slot
+     * 2. divide slots across all nodes, placing each slot
      *    on most empty node first
      */
     while (slots > 0) {
@@ -1558,36 +1762,58 @@ static struct rlist *rlist_try_alloc (struct rlist *rl, const char *mode,
                                       int nnodes, int slots, int cores_per_slot)
 {
     struct rlist *result = NULL;
+    int order;
 
     if (!rl) {
         errno = EINVAL;
         return NULL;
     }
 
-    /*  Reset default sort to order nodes by "rank" */
-    zlistx_set_comparator (rl->nodes, by_rank);
-
     if (nnodes > 0)
         result = rlist_alloc_nnodes (rl, nnodes, cores_per_slot, slots);
-    else if (mode == NULL || strcmp (mode, "worst-fit") == 0)
-        result = rlist_alloc_worst_fit (rl, cores_per_slot, slots);
-    else if (mode && strcmp (mode, "best-fit") == 0)
-        result = rlist_alloc_best_fit (rl, cores_per_slot, slots);
-    else if (mode && strcmp (mode, "first-fit") == 0)
-        result = rlist_alloc_first_fit (rl, cores_per_slot, slots);
-    else
-        errno = EINVAL;
+    else if ((order = alloc_order_from_mode (mode)) >= 0)
+        result = rlist_alloc_ordered (rl, order, cores_per_slot, slots);
     return result;
 }
 
-/*  Determine if allocation request is feasible for rlist `rl`.
+/*  Determine if allocation request is feasible for rlist `rl`, i.e.
+ *   if it could be satisfied by an empty copy of `rl` with all nodes up.
+ *
+ *  On an empty node, any of the allocation strategies can place
+ *   count/slotsz slots, so use the node size histogram from the index
+ *   (largest nodes first when nnodes > 0) instead of allocating from
+ *   a copy of `rl`.
  */
-static bool rlist_alloc_feasible (const struct rlist *rl, const char *mode,
+static bool rlist_alloc_feasible (struct rlist *rl, const char *mode,
                                   int nnodes, int slots, int slotsz)
 {
     bool rc = false;
     struct rlist *result = NULL;
-    struct rlist *all = rlist_copy_empty (rl);
+    struct rlist *all;
+    struct rlist_index *idx;
+
+    if ((idx = rlist_get_index (rl))) {
+        int64_t capacity = 0;
+        int used = 0;
+
+        if (nnodes == 0 && alloc_order_from_mode (mode) < 0)
+            return false;
+        if (nnodes > 0 && slots < nnodes)
+            return false;
+        for (int i = idx->nbuckets - 1; i > 0; i--) {
+            int count = idx->nsize[i];
+            if (nnodes > 0) {
+                if (count > nnodes - used)
+                    count = nnodes - used;
+                used += count;
+            }
+            capacity += (int64_t) count * (i / slotsz);
+        }
+        if (used < nnodes)
+            return false;
+        return capacity >= slots;
+    }
+    all = rlist_copy_empty (rl);
     if (all && (result = rlist_try_alloc (all, mode, nnodes, slots, slotsz)))
         rc = true;
     rlist_destroy (all);
@@ -1634,7 +1860,7 @@ struct rlist *rlist_alloc (struct rlist *rl, const char *mode,
 
 static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
 {
-    struct rnode *rnode = rlist_find_rank (rl, n->rank);
+    struct rnode *rnode = rlist_lookup_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
@@ -1643,12 +1869,13 @@ static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->cores->ids);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
 static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
 {
-    struct rnode *rnode = rlist_find_rank (rl, n->rank);
+    struct rnode *rnode = rlist_lookup_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
@@ -1656,6 +1883,7 @@ static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
     if (rnode_alloc_idset (rnode, n->cores->avail) < 0)
         return -1;
     rl->avail -= idset_count (n->cores->avail);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -1740,6 +1968,7 @@ static int rlist_mark_all (struct rlist *rl, bool up)
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -1754,10 +1983,11 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
         return -1;
     i = idset_first (idset);
     while (i != IDSET_INVALID_ID) {
-        struct rnode *n = rlist_find_rank (rl, i);
+        struct rnode *n = rlist_lookup_rank (rl, i);
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
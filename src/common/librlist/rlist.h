@@ -25,6 +25,8 @@ typedef struct {
     char text[128];
 } rlist_error_t;
 
+struct rlist_index;
+
 /* A list of resource nodes */
 struct rlist {
     int total;
@@ -41,6 +43,11 @@ struct rlist {
 
     /*  Opaque Rv1.scheduling key */
     json_t *scheduling;
+
+    /*  Allocator index of nodes by rank and available cores.
+     *   Built on demand, and dropped when the set of nodes changes.
+     */
+    struct rlist_index *index;
 };
 
 /*  Create an empty rlist object */
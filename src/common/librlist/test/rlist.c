@@ -735,6 +735,64 @@ static void test_updown ()
     rlist_destroy (rl2);
 }
 
+static void test_alloc_down_modes ()
+{
+    const char *modes[] = { "worst-fit", "best-fit", "first-fit", NULL };
+    char *R = R_create ("0-3", "0-3", NULL, "host[0-3]");
+    struct rlist *rl = rlist_from_R (R);
+    if (rl == NULL)
+        BAIL_OUT ("rlist_from_R failed");
+    free (R);
+
+    /*  rank0 down, rank1 has 1 core free, rank2 2 cores, rank3 3 cores
+     */
+    ok (rlist_mark_down (rl, "0") == 0,
+        "rlist_mark_down 0");
+    for (int i = 1; i < 4; i++) {
+        char ids[16];
+        struct rlist *a;
+        snprintf (ids, sizeof (ids), "0-%d", 3 - i);
+        if (!(a = rlist_create ())
+            || rlist_append_rank_cores (a, "host", i, ids) < 0
+            || rlist_set_allocated (rl, a) < 0)
+            BAIL_OUT ("failed to allocate %s on rank %d", ids, i);
+        rlist_destroy (a);
+    }
+    ok (rl->avail == 6,
+        "rl avail == 6");
+
+    for (int i = 0; modes[i] != NULL; i++) {
+        struct rlist *a;
+        char *s;
+        const char *expected[] = {
+            "rank3/core1",  /* worst-fit */
+            "rank1/core3",  /* best-fit */
+            "rank1/core3",  /* first-fit */
+        };
+        ok ((a = rlist_alloc (rl, modes[i], 0, 1, 1)) != NULL,
+            "%s: rlist_alloc with rank0 down works", modes[i]);
+        if (!a)
+            continue;
+        s = rlist_dumps (a);
+        is (s, expected[i],
+            "%s: allocated %s", modes[i], s);
+        free (s);
+        ok (rlist_free (rl, a) == 0 && rl->avail == 6,
+            "%s: rlist_free works", modes[i]);
+        rlist_destroy (a);
+    }
+
+    ok (rlist_alloc (rl, "best-fit", 0, 1, 4) == NULL && errno == ENOSPC,
+        "best-fit: 4 core slot with rank0 down fails with ENOSPC");
+    ok (rlist_mark_up (rl, "0") == 0,
+        "rlist_mark_up 0");
+    ok (rlist_alloc (rl, "best-fit", 0, 2, 4) == NULL && errno == ENOSPC,
+        "best-fit: 2 slots of 4 cores with 1 free node fails with ENOSPC");
+    ok (rlist_alloc (rl, "best-fit", 0, 1, 5) == NULL && errno == EOVERFLOW,
+        "best-fit: 1 slot of 5 cores fails with EOVERFLOW");
+    rlist_destroy (rl);
+}
+
 struct append_test {
     const char *ranksa;
     const char *coresa;
@@ -1550,6 +1608,7 @@ int main (int ac, char *av[])
     test_issue2202 ();
     test_issue2473 ();
     test_updown ();
+    test_alloc_down_modes ();
     test_append ();
     test_diff ();
     test_union ();
@@ -29,6 +29,7 @@ struct router_entry {
     struct router *rtr;
     struct subhash *subscriptions;  // client's subscriber hash
     struct disconnect *dcon;
+    unsigned int event_seq;         // last event sent, see event_cb()
 };
 
 struct router {
@@ -36,6 +37,8 @@ struct router {
     zhashx_t *routes;               // uuid => 'struct router_entry'
     void *arg;
     struct subhash *subscriptions;  // router's subscriber hash
+    zhashx_t *subscribers;          // topic => (uuid => 'struct router_entry')
+    unsigned int event_seq;
     struct servhash *services;
     flux_msg_handler_t **handlers;
     bool mute;
@@ -226,14 +229,41 @@ static int broker_unsubscribe (const char *topic, void *arg)
     return 0;
 }
 
+// zhashx_destructor_fn footprint
+static void subscribers_destructor (void **item)
+{
+    if (item) {
+        zhashx_t *hash = *item;
+        zhashx_destroy (&hash);
+        *item = NULL;
+    }
+}
+
 /* A client asks the router to subscribe.
  * This might generate a broker_subscribe() or just usecount++.
+ * The client's own subhash calls this only on its first subscription
+ * to 'topic', so each client appears at most once in the topic's list
+ * of subscribers.
  */
 static int router_subscribe (const char *topic, void *arg)
 {
-    struct router *rtr = arg;
+    struct router_entry *entry = arg;
+    struct router *rtr = entry->rtr;
+    zhashx_t *subscribers;
 
-    return subhash_subscribe (rtr->subscriptions, topic);
+    if (subhash_subscribe (rtr->subscriptions, topic) < 0)
+        return -1;
+    if (!(subscribers = zhashx_lookup (rtr->subscribers, topic))) {
+        if (!(subscribers = zhashx_new ()))
+            goto nomem;
+        (void)zhashx_insert (rtr->subscribers, topic, subscribers);
+    }
+    (void)zhashx_insert (subscribers, entry->uuid, entry);
+    return 0;
+nomem:
+    (void)subhash_unsubscribe (rtr->subscriptions, topic);
+    errno = ENOMEM;
+    return -1;
 }
 
 /* A client asks the router to unsubscribe.
@@ -241,9 +271,18 @@ static int router_subscribe (const char *topic, void *arg)
  */
 static int router_unsubscribe (const char *topic, void *arg)
 {
-    struct router *rtr = arg;
+    struct router_entry *entry = arg;
+    struct router *rtr = entry->rtr;
+    zhashx_t *subscribers;
 
-    return subhash_unsubscribe (rtr->subscriptions, topic);
+    if (subhash_unsubscribe (rtr->subscriptions, topic) < 0)
+        return -1;
+    if ((subscribers = zhashx_lookup (rtr->subscribers, topic))) {
+        zhashx_delete (subscribers, entry->uuid);
+        if (zhashx_size (subscribers) == 0)
+            zhashx_delete (rtr->subscribers, topic);
+    }
+    return 0;
 }
 
 static void disconnect_cb (const flux_msg_t *msg, void *arg)
@@ -319,15 +358,15 @@ struct router_entry *router_entry_add (struct router *rtr,
     if (!(entry = router_entry_create (uuid, cb, arg)))
         return NULL;
 
-    subhash_set_subscribe (entry->subscriptions, router_subscribe, rtr);
-    subhash_set_unsubscribe (entry->subscriptions, router_unsubscribe, rtr);
-
     if (zhashx_insert (rtr->routes, uuid, entry) < 0) {
         router_entry_destroy (entry);
         errno = EEXIST;
         return NULL;
     }
     entry->rtr = rtr;
+
+    subhash_set_subscribe (entry->subscriptions, router_subscribe, entry);
+    subhash_set_unsubscribe (entry->subscriptions, router_unsubscribe, entry);
     return entry;
 }
 
@@ -401,8 +440,43 @@ error:
     flux_msg_destroy (cpy);
 }
 
+struct event_dist {
+    struct router *rtr;
+    const flux_msg_t *msg;
+};
+
+/* subhash_match_f footprint
+ * Send event to each subscriber of 'sub_topic' that has not already
+ * been sent this event via another matching subscription.
+ */
+static void event_dist_cb (const char *sub_topic, void *arg)
+{
+    struct event_dist *dist = arg;
+    struct router *rtr = dist->rtr;
+    struct router_entry *entry;
+    zhashx_t *subscribers;
+
+    if (!(subscribers = zhashx_lookup (rtr->subscribers, sub_topic)))
+        return;
+    entry = zhashx_first (subscribers);
+    while (entry) {
+        if (entry->event_seq != rtr->event_seq) {
+            entry->event_seq = rtr->event_seq;
+            if (entry->send (dist->msg, entry->arg) < 0) {
+                flux_log_error (rtr->h,
+                                "router: event > client=%.5s",
+                                entry->uuid);
+            }
+        }
+        entry = zhashx_next (subscribers);
+    }
+}
+
 /* Receive event from broker.
  * Distribute to all router entries with matching subscriptions.
+ * The router's subhash holds the union of all client subscriptions,
+ * so walk the subscriptions that match 'topic' and send to their
+ * subscribers, rather than testing every client.
  */
 static void event_cb (flux_t *h,
                       flux_msg_handler_t *mh,
@@ -410,22 +484,21 @@ static void event_cb (flux_t *h,
                       void *arg)
 {
     struct router *rtr = arg;
-    struct router_entry *entry;
+    struct event_dist dist = { .rtr = rtr, .msg = msg };
     const char *topic;
 
     if (flux_msg_get_topic (msg, &topic) < 0) {
         flux_log_error (h, "router: event > client");
         return;
     }
-
-    entry = zhashx_first (rtr->routes);
-    while ((entry)) {
-        if (subhash_topic_match (entry->subscriptions, topic)) {
-            if (entry->send (msg, entry->arg) < 0)
-                flux_log_error (h, "router: event > client=%.5s", entry->uuid);
-        }
-        entry = zhashx_next (rtr->routes);
-    }
+    /* N.B. entries start with event_seq 0, so skip 0 on wraparound */
+    if (++rtr->event_seq == 0)
+        rtr->event_seq++;
+    if (subhash_topic_match_each (rtr->subscriptions,
+                                  topic,
+                                  event_dist_cb,
+                                  &dist) < 0)
+        flux_log_error (h, "router: event > client");
 }
 
 static const struct flux_msg_handler_spec htab[] = {
@@ -451,6 +524,10 @@ struct router *router_create (flux_t *h)
         goto error;
     zhashx_set_destructor (rtr->routes, router_entry_destructor);
 
+    if (!(rtr->subscribers = zhashx_new ()))
+        goto error;
+    zhashx_set_destructor (rtr->subscribers, subscribers_destructor);
+
     if (!(rtr->subscriptions = subhash_create ()))
         goto error;
     subhash_set_subscribe (rtr->subscriptions, broker_subscribe, rtr);
@@ -472,9 +549,13 @@ void router_destroy (struct router *rtr)
 {
     if (rtr) {
         flux_msg_handler_delvec (rtr->handlers);
+        /* N.B. destroy routes first, since router entries unsubscribe
+         * from rtr->subscriptions as they are destroyed.
+         */
+        ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->routes);
         subhash_destroy (rtr->subscriptions);
+        ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->subscribers);
         servhash_destroy (rtr->services);
-        ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->routes);
         ERRNO_SAFE_WRAP (free, rtr);
     }
 }
@@ -42,6 +42,12 @@
  * - sendfd/recvfd do not encrypt messages, therefore this transport
  *   is only appropriate for use on AF_LOCAL sockets or on file descriptors
  *   tunneled through a secure channel.
+ *
+ * - the msgbuf functions use the same encoding, but buffer multiple
+ *   messages so that a burst of messages may be sent with one write(2),
+ *   and a single read(2) may return several messages.  A msgbuf grows to
+ *   hold a message larger than its usual size, and shrinks back to
+ *   nothing once it is drained.
  */
 
 #if HAVE_CONFIG_H
@@ -51,10 +57,17 @@
 #include <unistd.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/errno_safe.h"
+
 #include "sendfd.h"
 
 #define IOBUF_MAGIC 0xffee0012
 
+/* Minimum msgbuf allocation, and the most msgbuf_read() will try to
+ * read at once unless a larger message is being assembled.
+ */
+static const size_t msgbuf_chunk = 16384;
+
 void iobuf_init (struct iobuf *iobuf)
 {
     memset (iobuf, 0, sizeof (*iobuf));
@@ -175,6 +188,171 @@ done:
     return msg;
 }
 
+void msgbuf_init (struct msgbuf *mb)
+{
+    memset (mb, 0, sizeof (*mb));
+}
+
+void msgbuf_clean (struct msgbuf *mb)
+{
+    free (mb->buf);
+    memset (mb, 0, sizeof (*mb));
+}
+
+/* Reset an empty msgbuf, releasing memory if it grew beyond
+ * its usual size.
+ */
+static void msgbuf_reset (struct msgbuf *mb)
+{
+    if (mb->size > msgbuf_chunk)
+        msgbuf_clean (mb);
+    else
+        mb->start = mb->end = 0;
+}
+
+/* Ensure there is room for 'len' more bytes at the end of msgbuf.
+ */
+static int msgbuf_reserve (struct msgbuf *mb, size_t len)
+{
+    size_t size;
+    uint8_t *buf;
+
+    if (mb->end + len <= mb->size)
+        return 0;
+    if (mb->start > 0) {
+        memmove (mb->buf, mb->buf + mb->start, mb->end - mb->start);
+        mb->end -= mb->start;
+        mb->start = 0;
+        if (mb->end + len <= mb->size)
+            return 0;
+    }
+    size = mb->end + len;
+    if (size < msgbuf_chunk)
+        size = msgbuf_chunk;
+    if (!(buf = realloc (mb->buf, size)))
+        return -1;
+    mb->buf = buf;
+    mb->size = size;
+    return 0;
+}
+
+int msgbuf_append (struct msgbuf *mb, const flux_msg_t *msg)
+{
+    size_t len;
+    uint32_t hdr[2];
+    uint8_t *p;
+
+    if (!mb || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    len = flux_msg_encode_size (msg);
+    if (msgbuf_reserve (mb, len + 8) < 0)
+        return -1;
+    /* N.B. messages are packed back to back in the buffer, so the
+     * header may not be aligned.
+     */
+    p = mb->buf + mb->end;
+    hdr[0] = IOBUF_MAGIC;
+    hdr[1] = htonl (len);
+    memcpy (p, hdr, sizeof (hdr));
+    if (flux_msg_encode (msg, &p[8], len) < 0)
+        return -1;
+    mb->end += len + 8;
+    return 0;
+}
+
+size_t msgbuf_pending (struct msgbuf *mb)
+{
+    return mb ? mb->end - mb->start : 0;
+}
+
+int msgbuf_write (int fd, struct msgbuf *mb)
+{
+    if (fd < 0 || !mb) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (mb->start < mb->end) {
+        ssize_t n;
+        if ((n = write (fd, mb->buf + mb->start, mb->end - mb->start)) < 0)
+            return -1;
+        mb->start += n;
+    }
+    msgbuf_reset (mb);
+    return 0;
+}
+
+/* Check for a complete message at the start of msgbuf.
+ * Returns 1 if found, 0 if not, or -1 with errno set if the data is
+ * not in the expected format.  Set *lenp to the length of the message
+ * including the header, or if that is not yet known, the header length.
+ */
+static int msgbuf_frame (struct msgbuf *mb, size_t *lenp)
+{
+    size_t avail = mb->end - mb->start;
+    uint32_t hdr[2];
+    size_t len;
+
+    if (avail < 8) {
+        *lenp = 8;
+        return 0;
+    }
+    memcpy (hdr, mb->buf + mb->start, sizeof (hdr));
+    if (hdr[0] != IOBUF_MAGIC) {
+        errno = EPROTO;
+        return -1;
+    }
+    len = ntohl (hdr[1]) + 8;
+    *lenp = len;
+    return avail >= len ? 1 : 0;
+}
+
+bool msgbuf_ready (struct msgbuf *mb)
+{
+    size_t len;
+    int saved_errno = errno;
+    bool ready = mb && msgbuf_frame (mb, &len) != 0;
+
+    errno = saved_errno;
+    return ready;
+}
+
+flux_msg_t *msgbuf_read (int fd, struct msgbuf *mb)
+{
+    flux_msg_t *msg;
+    size_t len;
+    int rc;
+
+    if (fd < 0 || !mb) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while ((rc = msgbuf_frame (mb, &len)) == 0) {
+        ssize_t n;
+
+        /* Make room for the rest of this message, then read as much
+         * as will fit, which may include subsequent messages.
+         */
+        if (msgbuf_reserve (mb, len - (mb->end - mb->start)) < 0)
+            return NULL;
+        if ((n = read (fd, mb->buf + mb->end, mb->size - mb->end)) < 0)
+            return NULL;
+        if (n == 0) {
+            errno = ECONNRESET;
+            return NULL;
+        }
+        mb->end += n;
+    }
+    if (rc < 0)
+        return NULL;
+    msg = flux_msg_decode (mb->buf + mb->start + 8, len - 8);
+    mb->start += len;
+    if (mb->start == mb->end)
+        ERRNO_SAFE_WRAP (msgbuf_reset, mb);
+    return msg;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
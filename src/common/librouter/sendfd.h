@@ -11,6 +11,7 @@
 #ifndef _ROUTER_SENDFD_H
 #define _ROUTER_SENDFD_H
 
+#include <stdbool.h>
 #include <flux/core.h>
 
 struct iobuf {
@@ -41,6 +42,52 @@ void iobuf_init (struct iobuf *iobuf);
  */
 void iobuf_clean (struct iobuf *iobuf);
 
+/* A msgbuf holds any number of messages in the sendfd() encoding, so
+ * that several may be sent or received with one system call.  A msgbuf
+ * is used for either sending or receiving, not both.
+ */
+struct msgbuf {
+    uint8_t *buf;
+    size_t size;    // allocated size of buf
+    size_t start;   // offset of first byte not yet written or consumed
+    size_t end;     // offset of end of data
+};
+
+/* Initialize msgbuf members.
+ */
+void msgbuf_init (struct msgbuf *mb);
+
+/* Discard any buffered data and free internal memory.
+ */
+void msgbuf_clean (struct msgbuf *mb);
+
+/* Encode message and append it to msgbuf for msgbuf_write().
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int msgbuf_append (struct msgbuf *mb, const flux_msg_t *msg);
+
+/* Write buffered messages to file descriptor.
+ * Returns 0 once the msgbuf is empty, or -1 with errno set.
+ * As with sendfd(), EAGAIN/EWOULDBLOCK is restartable.
+ */
+int msgbuf_write (int fd, struct msgbuf *mb);
+
+/* Return the number of bytes buffered for msgbuf_write().
+ */
+size_t msgbuf_pending (struct msgbuf *mb);
+
+/* Return the next message from msgbuf, or if no complete message is
+ * buffered, read as much as is available from file descriptor first.
+ * Returns message on success, NULL on failure with errno set.
+ * As with recvfd(), EAGAIN/EWOULDBLOCK is restartable.
+ */
+flux_msg_t *msgbuf_read (int fd, struct msgbuf *mb);
+
+/* Return true if msgbuf_read() can return a message (or an error)
+ * without reading from the file descriptor.
+ */
+bool msgbuf_ready (struct msgbuf *mb);
+
 #endif /* !_ROUTER_SENDFD_H */
 
 /*
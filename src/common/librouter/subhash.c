@@ -30,6 +30,10 @@
  *
  * subhash_topic_match() can be used to test if a message topic matches any
  * subscription topics for a given subhash, as an aid to event distribution.
+ * Since a subscription matches any topic it is a prefix of, subscriptions
+ * are also indexed in a trie keyed by topic characters, so that matching
+ * costs time proportional to the length of the message topic rather than
+ * the number of subscriptions.
  */
 
 #if HAVE_CONFIG_H
@@ -49,8 +53,20 @@ struct subhash_entry {
     struct subhash *sh;
 };
 
+/* Trie node.  The path from the root to a node spells a topic prefix.
+ * Children are kept in a sibling list, which is short in practice since
+ * topics are drawn from a small alphabet of service names.
+ */
+struct trie_node {
+    struct subhash_entry *entry;    // subscription ending here, if any
+    struct trie_node *child;        // first child
+    struct trie_node *sibling;      // next sibling
+    unsigned char c;                // edge label from parent
+};
+
 struct subhash {
     zhashx_t *subs;
+    struct trie_node root;          // root.entry is the "" subscription
     subscribe_f unsub;
     void *unsub_arg;
     subscribe_f sub;
@@ -94,28 +110,119 @@ error:
     return NULL;
 }
 
+static struct trie_node *trie_child (struct trie_node *node, unsigned char c)
+{
+    struct trie_node *child = node->child;
+
+    while (child && child->c != c)
+        child = child->sibling;
+    return child;
+}
+
+static void trie_destroy (struct trie_node *node)
+{
+    while (node) {
+        struct trie_node *sibling = node->sibling;
+        trie_destroy (node->child);
+        free (node);
+        node = sibling;
+    }
+}
+
+/* Remove the subscription under 'topic' from the subtrie rooted at
+ * 'node', pruning nodes that no longer lead to a subscription.
+ * Return true if 'node' itself is now empty.
+ */
+static bool trie_remove (struct trie_node *node, const char *topic)
+{
+    if (*topic == '\0')
+        node->entry = NULL;
+    else {
+        struct trie_node **prev = &node->child;
+        struct trie_node *child;
+
+        while ((child = *prev) && child->c != (unsigned char)*topic)
+            prev = &child->sibling;
+        if (child && trie_remove (child, topic + 1)) {
+            *prev = child->sibling;
+            free (child);
+        }
+    }
+    return (node->entry == NULL && node->child == NULL);
+}
+
+/* Add 'entry' to the trie under entry->topic.
+ */
+static int trie_insert (struct trie_node *root, struct subhash_entry *entry)
+{
+    struct trie_node *node = root;
+    const unsigned char *cp;
+
+    for (cp = (const unsigned char *)entry->topic; *cp != '\0'; cp++) {
+        struct trie_node *child;
+
+        if (!(child = trie_child (node, *cp))) {
+            if (!(child = calloc (1, sizeof (*child))))
+                goto error;
+            child->c = *cp;
+            child->sibling = node->child;
+            node->child = child;
+        }
+        node = child;
+    }
+    node->entry = entry;
+    return 0;
+error:
+    /* prune any empty nodes created above */
+    (void)trie_remove (root, entry->topic);
+    errno = ENOMEM;
+    return -1;
+}
+
 /* sub="" matches all
  * sub="foo" matches "foo", "foobar", "foo.bar"
+ * Walk the trie along 'topic', visiting each subscription that is a prefix.
  */
-static bool match_event (const char *sub_topic, const char *msg_topic)
+int subhash_topic_match_each (struct subhash *sh,
+                              const char *topic,
+                              subhash_match_f cb,
+                              void *arg)
 {
-    int len = strlen (sub_topic);
+    struct trie_node *node;
+    const unsigned char *cp;
+    int count = 0;
 
-    if (!strncmp (sub_topic, msg_topic, len))
-        return true;
-    return false;
+    if (!sh || !topic) {
+        errno = EINVAL;
+        return -1;
+    }
+    node = &sh->root;
+    cp = (const unsigned char *)topic;
+    for (;;) {
+        if (node->entry) {
+            if (cb)
+                cb (node->entry->topic, arg);
+            count++;
+        }
+        if (*cp == '\0' || !(node = trie_child (node, *cp++)))
+            break;
+    }
+    return count;
 }
 
 bool subhash_topic_match (struct subhash *sh, const char *topic)
 {
-    struct subhash_entry *entry;
+    struct trie_node *node;
+    const unsigned char *cp;
 
     if (sh && topic) {
-        entry = zhashx_first (sh->subs);
-        while (entry) {
-            if (match_event  (entry->topic, topic))
+        node = &sh->root;
+        cp = (const unsigned char *)topic;
+        for (;;) {
+            if (node->entry)
                 return true;
-            entry = zhashx_next (sh->subs);
+            if (*cp == '\0' || !(node = trie_child (node, *cp++)))
+                break;
         }
     }
     return false;
@@ -135,8 +242,13 @@ int subhash_subscribe (struct subhash *sh, const char *topic)
     else {
         if (!(entry = subhash_entry_create (topic)))
             return -1;
+        if (trie_insert (&sh->root, entry) < 0) {
+            subhash_entry_destroy (entry);
+            return -1;
+        }
         if (sh->sub) {
             if (sh->sub (topic, sh->sub_arg) < 0) {
+                (void)trie_remove (&sh->root, topic);
                 subhash_entry_destroy (entry);
                 return -1;
             }
@@ -162,8 +274,10 @@ int subhash_unsubscribe (struct subhash *sh, const char *topic)
                 return -1;
             entry->sh = NULL; // prevent destructor from calling unsub()
         }
-        if (--entry->refcount == 0)
+        if (--entry->refcount == 0) {
+            (void)trie_remove (&sh->root, topic);
             zhashx_delete (sh->subs, topic);
+        }
     }
     else {
         errno = ENOENT;
@@ -193,6 +307,7 @@ void subhash_destroy (struct subhash *sh)
 {
     if (sh) {
         ERRNO_SAFE_WRAP (zhashx_destroy, &sh->subs);
+        ERRNO_SAFE_WRAP (trie_destroy, sh->root.child);
         ERRNO_SAFE_WRAP (free, sh);
     }
 }
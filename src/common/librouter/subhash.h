@@ -22,6 +22,16 @@ void subhash_set_unsubscribe (struct subhash *sub, subscribe_f cb, void *arg);
 
 bool subhash_topic_match (struct subhash *sh, const char *topic);
 
+/* Call 'cb' (if non-NULL) with each subscription topic that matches
+ * 'topic', that is, each subscription that is a prefix of 'topic'.
+ * Returns the number of matches, or -1 on error.
+ */
+typedef void (*subhash_match_f)(const char *sub_topic, void *arg);
+int subhash_topic_match_each (struct subhash *sh,
+                              const char *topic,
+                              subhash_match_f cb,
+                              void *arg);
+
 int subhash_subscribe (struct subhash *sh, const char *topic);
 int subhash_unsubscribe (struct subhash *sh, const char *topic);
 
@@ -292,6 +292,180 @@ next:
     free (buf);
 }
 
+/* Check that 'msg' is a request with topic "foo.bar" and a payload of
+ * 'size' bytes of 'c'.
+ */
+static bool check_msg (const flux_msg_t *msg, int size, char c)
+{
+    const char *topic;
+    const void *buf;
+    int len;
+
+    if (flux_request_decode_raw (msg, &topic, &buf, &len) < 0
+        || strcmp (topic, "foo.bar") != 0
+        || len != size)
+        return false;
+    for (int i = 0; i < len; i++) {
+        if (((const char *)buf)[i] != c)
+            return false;
+    }
+    return true;
+}
+
+static flux_msg_t *create_msg (int size, char c)
+{
+    flux_msg_t *msg;
+    char *buf;
+
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("malloc failed");
+    memset (buf, c, size);
+    if (!(msg = flux_request_encode_raw ("foo.bar", buf, size)))
+        BAIL_OUT ("flux_request_encode_raw failed");
+    free (buf);
+    return msg;
+}
+
+/* Send several small messages with one write over a blocking pipe,
+ * and receive them all with one read.
+ */
+void test_msgbuf (void)
+{
+    int pfd[2];
+    struct msgbuf out;
+    struct msgbuf in;
+    flux_msg_t *msg;
+    int count = 16;
+    int errors;
+    int i;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    msgbuf_init (&out);
+    msgbuf_init (&in);
+
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        msg = create_msg (i, 'a' + i);
+        if (msgbuf_append (&out, msg) < 0)
+            errors++;
+        flux_msg_destroy (msg);
+    }
+    ok (errors == 0 && msgbuf_pending (&out) > 0,
+        "msgbuf_append works");
+    ok (msgbuf_write (pfd[1], &out) == 0 && msgbuf_pending (&out) == 0,
+        "msgbuf_write works");
+
+    ok (msgbuf_ready (&in) == false,
+        "msgbuf_ready returns false on empty msgbuf");
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        if (!(msg = msgbuf_read (pfd[0], &in)) || !check_msg (msg, i, 'a' + i))
+            errors++;
+        flux_msg_destroy (msg);
+        if (i == 0)
+            ok (msgbuf_ready (&in) == true,
+                "msgbuf_ready returns true after first of several messages");
+    }
+    ok (errors == 0,
+        "msgbuf_read received all messages intact");
+    ok (msgbuf_ready (&in) == false,
+        "msgbuf_ready returns false once all messages are consumed");
+
+    msgbuf_clean (&out);
+    msgbuf_clean (&in);
+    close (pfd[1]);
+    close (pfd[0]);
+}
+
+/* The msgbuf and sendfd/recvfd encodings are interchangeable.
+ */
+void test_msgbuf_compat (void)
+{
+    int pfd[2];
+    struct msgbuf mb;
+    flux_msg_t *msg, *msg2;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    msgbuf_init (&mb);
+
+    msg = create_msg (8192, 'x');
+    ok (sendfd (pfd[1], msg, NULL) == 0
+        && (msg2 = msgbuf_read (pfd[0], &mb)) != NULL
+        && check_msg (msg2, 8192, 'x'),
+        "msgbuf_read can receive message sent with sendfd");
+    flux_msg_destroy (msg2);
+
+    ok (msgbuf_append (&mb, msg) == 0
+        && msgbuf_write (pfd[1], &mb) == 0
+        && (msg2 = recvfd (pfd[0], NULL)) != NULL
+        && check_msg (msg2, 8192, 'x'),
+        "recvfd can receive message sent with msgbuf_write");
+    flux_msg_destroy (msg2);
+    flux_msg_destroy (msg);
+
+    close (pfd[1]);
+    errno = 0;
+    ok (msgbuf_read (pfd[0], &mb) == NULL && errno == ECONNRESET,
+        "msgbuf_read fails with ECONNRESET when sender closes pipe");
+
+    msgbuf_clean (&mb);
+    close (pfd[0]);
+}
+
+/* Alternate between writing and reading on a nonblocking pipe so that
+ * messages, including ones larger than the pipe buffer, arrive in
+ * pieces.
+ */
+void test_msgbuf_nonblock (int size, int count)
+{
+    int pfd[2];
+    struct msgbuf out;
+    struct msgbuf in;
+    flux_msg_t *msg;
+    int sent = 0;
+    int received = 0;
+    int errors = 0;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    if (fd_set_nonblocking (pfd[0]) < 0 || fd_set_nonblocking (pfd[1]) < 0)
+        BAIL_OUT ("fd_set_nonblocking failed");
+    msgbuf_init (&out);
+    msgbuf_init (&in);
+
+    while (received < count) {
+        while (sent < count && msgbuf_pending (&out) < 65536) {
+            msg = create_msg (size, 'a' + sent % 26);
+            if (msgbuf_append (&out, msg) < 0)
+                BAIL_OUT ("msgbuf_append failed");
+            flux_msg_destroy (msg);
+            sent++;
+        }
+        if (msgbuf_write (pfd[1], &out) < 0
+            && errno != EWOULDBLOCK && errno != EAGAIN)
+            BAIL_OUT ("msgbuf_write failed: %s", strerror (errno));
+        while ((msg = msgbuf_read (pfd[0], &in))) {
+            if (!check_msg (msg, size, 'a' + received % 26))
+                errors++;
+            flux_msg_destroy (msg);
+            received++;
+        }
+        if (errno != EWOULDBLOCK && errno != EAGAIN)
+            BAIL_OUT ("msgbuf_read failed: %s", strerror (errno));
+    }
+    ok (received == count && errors == 0,
+        "msgbuf nonblock %d,%d: received messages are intact",
+        count,
+        size);
+
+    msgbuf_clean (&out);
+    msgbuf_clean (&in);
+    close (pfd[1]);
+    close (pfd[0]);
+}
+
 void test_inval (void)
 {
     flux_msg_t *msg;
@@ -310,6 +484,16 @@ void test_inval (void)
     ok (sendfd (0, NULL, NULL) < 0 && errno == EINVAL,
         "senfd msg=NULL fails with EINVAL");
 
+    errno = 0;
+    ok (msgbuf_read (-1, NULL) == NULL && errno == EINVAL,
+        "msgbuf_read fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (msgbuf_write (-1, NULL) < 0 && errno == EINVAL,
+        "msgbuf_write fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (msgbuf_append (NULL, msg) < 0 && errno == EINVAL,
+        "msgbuf_append mb=NULL fails with EINVAL");
+
     flux_msg_destroy (msg);
 }
 
@@ -324,6 +508,11 @@ int main (int argc, char *argv[])
     test_nonblock (4096, 256);
     test_nonblock (16384, 64);
     test_nonblock (1048586, 1);
+    test_msgbuf ();
+    test_msgbuf_compat ();
+    test_msgbuf_nonblock (64, 4096);
+    test_msgbuf_nonblock (20000, 64);
+    test_msgbuf_nonblock (1048586, 2);
     test_inval ();
 
     done_testing();
@@ -11,6 +11,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <string.h>
 #include <flux/core.h>
 
 #include "src/common/libtap/tap.h"
@@ -58,6 +59,90 @@ void test_topic_match (void)
     subhash_destroy (sub);
 }
 
+void match_cb (const char *sub_topic, void *arg)
+{
+    char *buf = arg;
+
+    strcat (buf, "[");
+    strcat (buf, sub_topic);
+    strcat (buf, "]");
+}
+
+void test_prefix_match (void)
+{
+    struct subhash *sub;
+    char buf[256];
+
+    if (!(sub = subhash_create ()))
+        BAIL_OUT ("subhash_create failed");
+
+    ok (subhash_subscribe (sub, "job-state") == 0
+        && subhash_subscribe (sub, "job") == 0
+        && subhash_subscribe (sub, "job-exception") == 0
+        && subhash_subscribe (sub, "kvs.namespace-primary") == 0,
+        "subscribed to overlapping topics");
+
+    ok (subhash_topic_match (sub, "job-state") == true,
+        "subhash_topic_match job-state returns true");
+    ok (subhash_topic_match (sub, "jo") == false,
+        "subhash_topic_match jo returns false");
+    ok (subhash_topic_match (sub, "kvs.namespace-prim") == false,
+        "subhash_topic_match kvs.namespace-prim returns false");
+    ok (subhash_topic_match (sub, "kvs.namespace-primary-setroot") == true,
+        "subhash_topic_match kvs.namespace-primary-setroot returns true");
+
+    buf[0] = '\0';
+    ok (subhash_topic_match_each (sub, "job-state.x", match_cb, buf) == 2
+        && !strcmp (buf, "[job][job-state]"),
+        "subhash_topic_match_each job-state.x visits job, job-state in order");
+    ok (subhash_topic_match_each (sub, "jobtap", NULL, NULL) == 1,
+        "subhash_topic_match_each jobtap matches 1 with cb=NULL");
+    ok (subhash_topic_match_each (sub, "heartbeat", NULL, NULL) == 0,
+        "subhash_topic_match_each heartbeat matches 0");
+
+    /* unsubscribing a prefix leaves longer subscriptions intact */
+    ok (subhash_unsubscribe (sub, "job") == 0,
+        "subhash_unsubscribe job");
+    ok (subhash_topic_match (sub, "jobtap") == false,
+        "subhash_topic_match jobtap returns false");
+    ok (subhash_topic_match (sub, "job-exception") == true,
+        "subhash_topic_match job-exception returns true");
+
+    /* unsubscribing a longer topic leaves its prefix intact */
+    ok (subhash_subscribe (sub, "job") == 0,
+        "subhash_subscribe job");
+    ok (subhash_unsubscribe (sub, "job-state") == 0
+        && subhash_unsubscribe (sub, "job-exception") == 0,
+        "subhash_unsubscribe job-state, job-exception");
+    buf[0] = '\0';
+    ok (subhash_topic_match_each (sub, "job-state", match_cb, buf) == 1
+        && !strcmp (buf, "[job]"),
+        "subhash_topic_match_each job-state visits only job");
+
+    /* empty topic subscription matches all */
+    ok (subhash_subscribe (sub, "") == 0,
+        "subhash_subscribe \"\"");
+    ok (subhash_topic_match (sub, "heartbeat") == true,
+        "subhash_topic_match heartbeat returns true");
+    ok (subhash_topic_match_each (sub, "job", NULL, NULL) == 2,
+        "subhash_topic_match_each job matches 2");
+    ok (subhash_unsubscribe (sub, "") == 0,
+        "subhash_unsubscribe \"\"");
+    ok (subhash_topic_match (sub, "heartbeat") == false,
+        "subhash_topic_match heartbeat returns false");
+
+    errno = 0;
+    ok (subhash_topic_match_each (NULL, "foo", NULL, NULL) < 0
+        && errno == EINVAL,
+        "subhash_topic_match_each sub=NULL fails with EINVAL");
+    errno = 0;
+    ok (subhash_topic_match_each (sub, NULL, NULL, NULL) < 0
+        && errno == EINVAL,
+        "subhash_topic_match_each topic=NULL fails with EINVAL");
+
+    subhash_destroy (sub);
+}
+
 int counter_cb (const char *topic, void *arg)
 {
     int *count = arg;
@@ -190,6 +275,7 @@ int main (int argc, char *argv[])
     plan (NO_PLAN);
 
     test_topic_match ();
+    test_prefix_match ();
     test_callbacks ();
     test_callbacks_rc ();
     test_errors ();
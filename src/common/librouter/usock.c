@@ -71,10 +71,15 @@ struct usock_server {
     void *arg;
 };
 
+/* Encode at most this many bytes of queued messages (but always at
+ * least one message) for one write(2) to a client.
+ */
+static const size_t conn_write_batch = 65536;
+
 struct usock_io {
     int fd;
     flux_watcher_t *w;
-    struct iobuf iobuf;
+    struct msgbuf buf;
 };
 
 struct usock_conn {
@@ -100,11 +105,12 @@ struct usock_conn {
     int refcount;
 
     unsigned char enable_close_on_destroy:1;
+    unsigned char destroy_pending:1;
 };
 
 struct usock_client {
     int fd;
-    struct iobuf in_iobuf;
+    struct msgbuf in_buf;
     struct iobuf out_iobuf;
 };
 
@@ -195,6 +201,33 @@ int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg)
     return 0;
 }
 
+/* Read from the connection and deliver each complete message.
+ * One read(2) may return several messages, so continue until no
+ * complete message remains buffered.
+ */
+static void conn_read_messages (struct usock_conn *conn)
+{
+    flux_msg_t *msg;
+
+    do {
+        if (!(msg = msgbuf_read (conn->in.fd, &conn->in.buf))) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                conn_io_error (conn, errno);
+            return;
+        }
+        /* Update message credentials based on connected creds.
+         */
+        if (auth_init_message (msg, &conn->cred) < 0) {
+            ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
+            conn_io_error (conn, errno);
+            return;
+        }
+        if (conn->recv_cb)
+            conn->recv_cb (conn, msg, conn->recv_arg);
+        flux_msg_destroy (msg);
+    } while (!conn->destroy_pending && msgbuf_ready (&conn->in.buf));
+}
+
 static void conn_read_cb (flux_reactor_t *r,
                           flux_watcher_t *w,
                           int revents,
@@ -207,22 +240,13 @@ static void conn_read_cb (flux_reactor_t *r,
         goto error;
     }
     if ((revents & FLUX_POLLIN)) {
-        flux_msg_t *msg;
-
-        if (!(msg = recvfd (conn->in.fd, &conn->in.iobuf))) {
-            if (errno != EWOULDBLOCK && errno != EAGAIN)
-                goto error;
-        }
-        else {
-            /* Update message credentials based on connected creds.
-             */
-            if (auth_init_message (msg, &conn->cred) < 0)
-                goto error;
-
-            if (conn->recv_cb)
-                conn->recv_cb (conn, msg, conn->recv_arg);
-            flux_msg_destroy (msg);
-        }
+        /* Callbacks may destroy the connection.  Defer that until
+         * all buffered messages have been handled.
+         */
+        conn->refcount++;
+        conn_read_messages (conn);
+        if (--conn->refcount == 0 && conn->destroy_pending)
+            usock_conn_destroy (conn);
     }
     return;
 error:
@@ -251,30 +275,37 @@ static void conn_write_cb (flux_reactor_t *r,
     }
 
     if ((revents & FLUX_POLLOUT)) {
-        const flux_msg_t *msg = zlist_head (conn->outqueue);
-        if (msg) {
-            if (sendfd (conn->out.fd, msg, &conn->out.iobuf) < 0) {
-                if (errno == EPIPE) {
-                    /* Remote peer has closed connection.
-                     * However, there may still be pending messages sent
-                     * by peer, so do not destroy connection here. Instead,
-                     * drop all pending messsages in the output queue, and
-                     * let connection be closed after EOF/ECONNRESET from
-                     * *read* side of connection.
-                     */
-                    while (conn_outqueue_drop (conn))
-                        ;
-                    flux_watcher_stop (conn->out.w);
-                }
-                else if (errno != EWOULDBLOCK && errno != EAGAIN)
-                    goto error;
-            }
-            else {
-                (void) conn_outqueue_drop (conn);
-                if (zlist_size (conn->outqueue) == 0)
-                    flux_watcher_stop (conn->out.w);
+        const flux_msg_t *msg;
+
+        /* Move queued messages to the output buffer so that a burst
+         * of messages may be sent with one write(2).
+         */
+        while (msgbuf_pending (&conn->out.buf) < conn_write_batch
+               && (msg = zlist_pop (conn->outqueue))) {
+            int rc = msgbuf_append (&conn->out.buf, msg);
+            flux_msg_decref (msg);
+            if (rc < 0)
+                goto error;
+        }
+        if (msgbuf_write (conn->out.fd, &conn->out.buf) < 0) {
+            if (errno == EPIPE) {
+                /* Remote peer has closed connection.
+                 * However, there may still be pending messages sent
+                 * by peer, so do not destroy connection here. Instead,
+                 * drop all pending messsages in the output queue, and
+                 * let connection be closed after EOF/ECONNRESET from
+                 * *read* side of connection.
+                 */
+                msgbuf_clean (&conn->out.buf);
+                while (conn_outqueue_drop (conn))
+                    ;
+                flux_watcher_stop (conn->out.w);
             }
+            else if (errno != EWOULDBLOCK && errno != EAGAIN)
+                goto error;
         }
+        else if (zlist_size (conn->outqueue) == 0)
+            flux_watcher_stop (conn->out.w);
     }
     return;
 error:
@@ -326,11 +357,15 @@ void usock_conn_destroy (struct usock_conn *conn)
 {
     if (conn) {
         int saved_errno = errno;
+        if (conn->refcount > 0) { // see conn_read_cb()
+            conn->destroy_pending = 1;
+            return;
+        }
         if (conn->close_cb)
             (*conn->close_cb) (conn, conn->close_arg);
         aux_destroy (&conn->aux);
         flux_watcher_destroy (conn->in.w);
-        iobuf_clean (&conn->in.iobuf);
+        msgbuf_clean (&conn->in.buf);
         if (conn->outqueue) {
             const flux_msg_t *msg;
             while ((msg = zlist_pop (conn->outqueue)))
@@ -338,7 +373,7 @@ void usock_conn_destroy (struct usock_conn *conn)
             zlist_destroy (&conn->outqueue);
         }
         flux_watcher_destroy (conn->out.w);
-        iobuf_clean (&conn->out.iobuf);
+        msgbuf_clean (&conn->out.buf);
         if (conn->server)
             zlist_remove (conn->server->connections, conn);
         if (conn->enable_close_on_destroy) {
@@ -428,7 +463,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
                                                conn_read_cb,
                                                conn)))
         goto error;
-    iobuf_init (&conn->in.iobuf);
+    msgbuf_init (&conn->in.buf);
 
     if (!(conn->out.w = flux_fd_watcher_create (r,
                                                 conn->out.fd,
@@ -436,7 +471,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
                                                 conn_write_cb,
                                                 conn)))
         goto error;
-    iobuf_init (&conn->out.iobuf);
+    msgbuf_init (&conn->out.buf);
     uuid_generate (conn->uuid);
     uuid_unparse (conn->uuid, conn->uuid_str);
 
@@ -588,7 +623,9 @@ int usock_client_pollevents (struct usock_client *client)
 
     if (poll (&pfd, 1, 0) < 0)
         return FLUX_POLLERR;
-    if ((pfd.revents & POLLIN))
+    /* A message may already be buffered from an earlier read(2).
+     */
+    if ((pfd.revents & POLLIN) || msgbuf_ready (&client->in_buf))
         flux_revents |= FLUX_POLLIN;
     if ((pfd.revents & POLLOUT))
         flux_revents |= FLUX_POLLOUT;
@@ -647,14 +684,14 @@ int usock_client_send (struct usock_client *client,
 }
 
 /* Try to recv message.  If flags does not include FLUX_O_NONBLOCK,
- * and recvfd fails with EWOULDBLOCK/EAGAIN, then poll(POLLIN) and
+ * and msgbuf_read fails with EWOULDBLOCK/EAGAIN, then poll(POLLIN) and
  * keep trying until the full message is received
  */
 flux_msg_t *usock_client_recv (struct usock_client *client, int flags)
 {
     flux_msg_t *msg;
 
-    while (!(msg = recvfd (client->fd, &client->in_iobuf))) {
+    while (!(msg = msgbuf_read (client->fd, &client->in_buf))) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return NULL;
         if ((flags & FLUX_O_NONBLOCK))
@@ -741,7 +778,7 @@ struct usock_client *usock_client_create (int fd)
         return NULL;
 
     client->fd = fd;
-    iobuf_init (&client->in_iobuf);
+    msgbuf_init (&client->in_buf);
     iobuf_init (&client->out_iobuf);
 
     if (usock_client_read_zero (client->fd) < 0)
@@ -757,7 +794,7 @@ error:
 void usock_client_destroy (struct usock_client *client)
 {
     if (client) {
-        iobuf_clean (&client->in_iobuf);
+        msgbuf_clean (&client->in_buf);
         iobuf_clean (&client->out_iobuf);
         ERRNO_SAFE_WRAP (free, client);
     }
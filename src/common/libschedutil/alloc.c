@@ -18,16 +18,47 @@
 #include "init.h"
 #include "alloc.h"
 
-static int schedutil_alloc_respond (flux_t *h, const flux_msg_t *msg,
+/* A response to a request split from a batch is queued and sent
+ * with other responses to the batch.
+ */
+static int schedutil_alloc_respond_batch (schedutil_t *util,
+                                          flux_jobid_t id,
+                                          int type,
+                                          const char *note,
+                                          json_t *annotations)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:I s:i}", "id", id, "type", type)))
+        goto nomem;
+    if (annotations) {
+        if (json_object_set (o, "annotations", annotations) < 0)
+            goto nomem;
+    }
+    else if (note) {
+        if (json_object_set_new (o, "note", json_string (note)) < 0)
+            goto nomem;
+    }
+    return schedutil_batch_alloc_respond (util, o);
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return -1;
+}
+
+static int schedutil_alloc_respond (schedutil_t *util, const flux_msg_t *msg,
                                     int type, const char *note,
                                     json_t *annotations)
 {
+    flux_t *h = util->h;
     flux_jobid_t id;
     int rc;
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
-    if (annotations)
+    if (schedutil_batch_member (msg))
+        rc = schedutil_alloc_respond_batch (util, id, type, note, annotations);
+    else if (annotations)
         rc = flux_respond_pack (h, msg, "{s:I s:i s:O}",
                                         "id", id,
                                         "type", type,
@@ -57,7 +88,7 @@ int schedutil_alloc_respond_annotate_pack (schedutil_t *util,
         errno = EINVAL;
         goto error;
     }
-    rc = schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_ANNOTATE,
+    rc = schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_ANNOTATE,
                                   NULL, o);
 error:
     va_end (ap);
@@ -68,13 +99,13 @@ error:
 int schedutil_alloc_respond_deny (schedutil_t *util, const flux_msg_t *msg,
                                   const char *note)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_DENY,
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_DENY,
                                     note, NULL);
 }
 
 int schedutil_alloc_respond_cancel (schedutil_t *util, const flux_msg_t *msg)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_CANCEL,
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_CANCEL,
                                     NULL, NULL);
 }
 
@@ -137,7 +168,7 @@ static void alloc_continuation (flux_future_t *f, void *arg)
         goto error;
     }
     schedutil_remove_outstanding_future (util, f);
-    if (schedutil_alloc_respond (h, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
+    if (schedutil_alloc_respond (util, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
                                  NULL, ctx->annotations) < 0) {
         flux_log_error (h, "alloc response");
         goto error;
@@ -0,0 +1,167 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* batch.c - batched alloc and free requests
+ *
+ * If the scheduler sets SCHEDUTIL_BATCH, the job-manager may send
+ * sched.alloc-batch and sched.free-batch requests, each carrying many
+ * jobs.  These are split into one request message per job so that the
+ * scheduler's alloc and free callbacks need not change.  The per-job
+ * messages carry the batch request's route, so a response sent directly
+ * to one with flux_respond() still reaches the job-manager.
+ *
+ * Responses sent with schedutil_alloc_respond_*() or
+ * schedutil_free_respond() are instead collected and sent as one
+ * sched.alloc-batch or sched.free-batch response just before the
+ * reactor next blocks.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "schedutil_private.h"
+#include "init.h"
+
+static const char *batch_auxkey = "schedutil::batch";
+
+flux_msg_t *schedutil_batch_split (schedutil_t *util,
+                                   const flux_msg_t *msg,
+                                   const char *topic,
+                                   json_t *payload)
+{
+    flux_msg_t *cpy;
+
+    if (!(cpy = flux_msg_copy (msg, false))
+        || flux_msg_set_topic (cpy, topic) < 0
+        || flux_msg_pack (cpy, "O", payload) < 0
+        || flux_msg_aux_set (cpy, batch_auxkey, util, NULL) < 0)
+        goto error;
+    if (util->batch_msg != msg) {
+        flux_msg_decref (util->batch_msg);
+        util->batch_msg = flux_msg_incref (msg);
+    }
+    return cpy;
+error:
+    ERRNO_SAFE_WRAP (flux_msg_destroy, cpy);
+    return NULL;
+}
+
+bool schedutil_batch_member (const flux_msg_t *msg)
+{
+    return flux_msg_aux_get (msg, batch_auxkey) ? true : false;
+}
+
+static int batch_append (schedutil_t *util, json_t **array, json_t *o)
+{
+    if (!o)
+        goto nomem;
+    if (!*array && !(*array = json_array ()))
+        goto nomem;
+    if (json_array_append_new (*array, o) < 0)
+        goto nomem;
+    flux_watcher_start (util->batch_prep);
+    return 0;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return -1;
+}
+
+int schedutil_batch_alloc_respond (schedutil_t *util, json_t *response)
+{
+    return batch_append (util, &util->alloc_responses, response);
+}
+
+int schedutil_batch_free_respond (schedutil_t *util, flux_jobid_t id)
+{
+    return batch_append (util, &util->free_responses, json_integer (id));
+}
+
+static int batch_send (schedutil_t *util,
+                       const char *topic,
+                       const char *key,
+                       json_t *array)
+{
+    flux_msg_t *msg;
+
+    if (json_array_size (array) == 0)
+        return 0;
+    if (!(msg = flux_response_derive (util->batch_msg, 0))
+        || flux_msg_set_topic (msg, topic) < 0
+        || flux_msg_pack (msg, "{s:O}", key, array) < 0
+        || flux_send (util->h, msg, 0) < 0) {
+        flux_log_error (util->h, "error sending %s response", topic);
+        flux_msg_destroy (msg);
+        return -1;
+    }
+    flux_msg_destroy (msg);
+    json_array_clear (array);
+    return 0;
+}
+
+int schedutil_batch_flush (schedutil_t *util)
+{
+    int rc = 0;
+
+    if (!util->batch_msg)
+        return 0;
+    if (batch_send (util,
+                    "sched.alloc-batch",
+                    "responses",
+                    util->alloc_responses) < 0)
+        rc = -1;
+    if (batch_send (util,
+                    "sched.free-batch",
+                    "ids",
+                    util->free_responses) < 0)
+        rc = -1;
+    return rc;
+}
+
+static void batch_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    schedutil_t *util = arg;
+
+    (void)schedutil_batch_flush (util);
+    flux_watcher_stop (w);
+}
+
+int schedutil_batch_init (schedutil_t *util)
+{
+    if (!(util->batch_prep = flux_prepare_watcher_create (
+                                            flux_get_reactor (util->h),
+                                            batch_prep_cb,
+                                            util)))
+        return -1;
+    return 0;
+}
+
+void schedutil_batch_cleanup (schedutil_t *util)
+{
+    int saved_errno = errno;
+    (void)schedutil_batch_flush (util);
+    flux_watcher_destroy (util->batch_prep);
+    json_decref (util->alloc_responses);
+    json_decref (util->free_responses);
+    flux_msg_decref (util->batch_msg);
+    errno = saved_errno;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -23,6 +23,8 @@ int schedutil_free_respond (schedutil_t *util, const flux_msg_t *msg)
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
+    if (schedutil_batch_member (msg))
+        return schedutil_batch_free_respond (util, id);
     return flux_respond_pack (util->h, msg, "{s:I}", "id", id);
 }
 
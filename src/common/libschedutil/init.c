@@ -56,6 +56,8 @@ schedutil_t *schedutil_create (flux_t *h,
     if (!(util->outstanding_futures = zlistx_new ()))
         goto error;
     zlistx_set_destructor (util->outstanding_futures, future_destructor);
+    if (schedutil_batch_init (util) < 0)
+        goto error;
     if (schedutil_ops_register (util) < 0)
         goto error;
 
@@ -70,6 +72,7 @@ void schedutil_destroy (schedutil_t *util)
 {
     if (util) {
         int saved_errno = errno;
+        schedutil_batch_cleanup (util);
         zlistx_destroy (&util->outstanding_futures);
         schedutil_ops_unregister (util);
         free (util);
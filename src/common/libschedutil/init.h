@@ -23,6 +23,7 @@ typedef struct schedutil_ctx schedutil_t;
 
 enum schedutil_flags {
     SCHEDUTIL_FREE_NOLOOKUP = 1, // ops->free() will be called with R=NULL
+    SCHEDUTIL_BATCH = 2,         // accept batched alloc and free requests
 };
 
 /* Create a handle for the schedutil convenience library.
@@ -64,16 +64,13 @@ error:
     flux_future_destroy (f);
 }
 
-static void free_cb (flux_t *h, flux_msg_handler_t *mh,
-                     const flux_msg_t *msg, void *arg)
+static void free_request (schedutil_t *util, const flux_msg_t *msg)
 {
-    schedutil_t *util = arg;
+    flux_t *h = util->h;
     flux_jobid_t id;
     flux_future_t *f;
     char key[64];
 
-    assert (util);
-
     if (util->flags & SCHEDUTIL_FREE_NOLOOKUP) {
         util->ops->free (h, msg, NULL, util->cb_arg);
         return;
@@ -108,6 +105,82 @@ error:
         flux_log_error (h, "sched.free respond_error");
 }
 
+static void free_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    schedutil_t *util = arg;
+
+    assert (util);
+
+    free_request (util, msg);
+}
+
+/* A batched alloc request is {"jobs":[o,...]}, where each 'o' is the
+ * payload of a sched.alloc request.
+ */
+static void alloc_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    schedutil_t *util = arg;
+    json_t *jobs;
+    size_t index;
+    json_t *o;
+
+    assert (util);
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "jobs", &jobs) < 0
+        || !json_is_array (jobs)) {
+        flux_log (h, LOG_ERR, "malformed sched.alloc-batch request");
+        return;
+    }
+    json_array_foreach (jobs, index, o) {
+        flux_msg_t *job_msg;
+
+        if (!(job_msg = schedutil_batch_split (util, msg, "sched.alloc", o))) {
+            flux_log_error (h, "sched.alloc-batch");
+            return;
+        }
+        util->ops->alloc (h, job_msg, util->cb_arg);
+        flux_msg_decref (job_msg);
+    }
+}
+
+/* A batched free request is {"ids":[id,...]}.
+ */
+static void free_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                           const flux_msg_t *msg, void *arg)
+{
+    schedutil_t *util = arg;
+    json_t *ids;
+    size_t index;
+    json_t *id;
+
+    assert (util);
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "ids", &ids) < 0
+        || !json_is_array (ids)) {
+        flux_log (h, LOG_ERR, "malformed sched.free-batch request");
+        return;
+    }
+    json_array_foreach (ids, index, id) {
+        flux_msg_t *job_msg;
+        json_t *o;
+
+        if (!(o = json_pack ("{s:O}", "id", id))
+            || !(job_msg = schedutil_batch_split (util,
+                                                  msg,
+                                                  "sched.free",
+                                                  o))) {
+            flux_log_error (h, "sched.free-batch");
+            json_decref (o);
+            return;
+        }
+        json_decref (o);
+        free_request (util, job_msg);
+        flux_msg_decref (job_msg);
+    }
+}
+
 static void prioritize_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
@@ -123,6 +196,8 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "sched.alloc", alloc_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "sched.cancel", cancel_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "sched.free", free_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "sched.alloc-batch", alloc_batch_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "sched.free-batch", free_batch_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "sched.prioritize", prioritize_cb, 0},
     FLUX_MSGHANDLER_TABLE_END,
 };
@@ -42,20 +42,16 @@ int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth)
         errno = EINVAL;
         return -1;
     }
-    if (limit) {
-        if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
-                                 FLUX_NODEID_ANY, 0,
-                                 "{s:s s:i}",
-                                 "mode", mode,
-                                 "limit", limit)))
-            return -1;
-    }
-    else {
-        if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
-                                 FLUX_NODEID_ANY, 0,
-                                 "{s:s}", "mode", mode)))
-            return -1;
-    }
+    /* N.B. a job-manager that doesn't support batching ignores "batch"
+     * and continues to send individual alloc and free requests.
+     */
+    if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
+                             FLUX_NODEID_ANY, 0,
+                             "{s:s s:i s:b}",
+                             "mode", mode,
+                             "limit", limit,
+                             "batch", util->flags & SCHEDUTIL_BATCH ? 1 : 0)))
+        return -1;
     if (flux_rpc_get_unpack (f, "{s:i}", "count", &count) < 0)
         goto error;
     if (queue_depth)
@@ -11,7 +11,9 @@
 #ifndef HAVE_SCHEDUTIL_PRIVATE_H
 #define HAVE_SCHEDUTIL_PRIVATE_H 1
 
+#include <stdbool.h>
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
@@ -25,6 +27,12 @@ struct schedutil_ctx {
     int flags;
     void *cb_arg;
     zlistx_t *outstanding_futures;
+
+    /* batched responses, see batch.c */
+    const flux_msg_t *batch_msg;
+    json_t *alloc_responses;
+    json_t *free_responses;
+    flux_watcher_t *batch_prep;
 };
 
 /* Track futures that need to be destroyed on scheduler unload.
@@ -34,6 +42,33 @@ int schedutil_add_outstanding_future (schedutil_t *util, flux_future_t *fut);
 int schedutil_remove_outstanding_future (schedutil_t *util,
                                          flux_future_t *fut);
 
+/* Create a request message for one job of a batched request 'msg',
+ * with 'topic' and 'payload'.  The caller must destroy it.
+ */
+flux_msg_t *schedutil_batch_split (schedutil_t *util,
+                                   const flux_msg_t *msg,
+                                   const char *topic,
+                                   json_t *payload);
+
+/* Return true if 'msg' was created by schedutil_batch_split().
+ */
+bool schedutil_batch_member (const flux_msg_t *msg);
+
+/* Queue responses to requests from schedutil_batch_split(), to be sent
+ * by schedutil_batch_flush().  schedutil_batch_alloc_respond() steals
+ * the reference to 'response'.
+ */
+int schedutil_batch_alloc_respond (schedutil_t *util, json_t *response);
+int schedutil_batch_free_respond (schedutil_t *util, flux_jobid_t id);
+
+/* Send queued batch responses.  This is called automatically just
+ * before the reactor next blocks.
+ */
+int schedutil_batch_flush (schedutil_t *util);
+
+int schedutil_batch_init (schedutil_t *util);
+void schedutil_batch_cleanup (schedutil_t *util);
+
 /* (Un-)register callbacks for alloc, free, cancel.
  */
 int schedutil_ops_register (schedutil_t *util);
@@ -15,7 +15,7 @@
  * As such, it is hungry for inodes and may run the file system out of them
  * if used in anger!
  *
- * There are four main operations (RPC handlers):
+ * There are six main operations (RPC handlers):
  *
  * content-backing.load:
  * Given a blobref, lookup blob and return it or a "not found" error.
@@ -23,6 +23,9 @@
  * content-backing.store:
  * Given a blob, store it and return its blobref
  *
+ * content-backing.load-batch, content-backing.store-batch:
+ * Like load and store, but for a list of blobrefs or blobs.
+ *
  * kvs-checkpoint.get:
  * Given a string key, lookup string value and return it or a "not found" error.
  *
@@ -57,6 +60,7 @@
 #include "src/common/libutil/log.h"
 
 #include "src/common/libcontent/content-util.h"
+#include "src/common/libcontent/content-batch.h"
 
 #include "filedb.h"
 
@@ -141,6 +145,120 @@ error:
         flux_log_error (h, "error responding to store request");
 }
 
+static void respond_batch (flux_t *h,
+                           const flux_msg_t *msg,
+                           const struct content_batch *b)
+{
+    const void *buf;
+    int len;
+
+    content_batch_encode (b, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to batch request");
+}
+
+/* Handle a content-backing.load-batch request.  The request and response
+ * payloads are lists of blobrefs and blobs, as described in content-batch.h.
+ * Per-item errors are returned in the response list.
+ */
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *buf;
+    int len;
+    struct content_batch *refs = NULL;
+    struct content_batch *blobs = NULL;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(refs = content_batch_decode (buf, len))
+        || !(blobs = content_batch_create ()))
+        goto error;
+    count = content_batch_count (refs);
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+        void *data;
+        size_t size;
+        int rc;
+
+        if (content_batch_get_string (refs, i, &blobref) < 0
+            || blobref_validate (blobref) < 0)
+            rc = content_batch_append_error (blobs, EPROTO);
+        else if (filedb_get (ctx->dbpath, blobref, &data, &size, NULL) < 0)
+            rc = content_batch_append_error (blobs, errno);
+        else {
+            rc = content_batch_append (blobs, data, size);
+            free (data);
+        }
+        if (rc < 0)
+            goto error;
+    }
+    respond_batch (h, msg, blobs);
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+}
+
+/* Handle a content-backing.store-batch request.  The request and response
+ * payloads are lists of blobs and blobrefs, as described in content-batch.h.
+ * Per-item errors are returned in the response list.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *buf;
+    int len;
+    struct content_batch *blobs = NULL;
+    struct content_batch *refs = NULL;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(blobs = content_batch_decode (buf, len))
+        || !(refs = content_batch_create ()))
+        goto error;
+    count = content_batch_count (blobs);
+    for (int i = 0; i < count; i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (content_batch_get (blobs, i, &data, &size) < 0)
+            rc = content_batch_append_error (refs, EPROTO);
+        else if (blobref_hash (ctx->hashfun,
+                               (uint8_t *)data,
+                               size,
+                               blobref,
+                               sizeof (blobref)) < 0
+                 || filedb_put (ctx->dbpath, blobref, data, size, NULL) < 0)
+            rc = content_batch_append_error (refs, errno);
+        else
+            rc = content_batch_append_string (refs, blobref);
+        if (rc < 0)
+            goto error;
+    }
+    respond_batch (h, msg, refs);
+    content_batch_destroy (refs);
+    content_batch_destroy (blobs);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    content_batch_destroy (refs);
+    content_batch_destroy (blobs);
+}
+
 /* Handle a kvs-checkpoint.get request from the rank 0 kvs module.
  * The KVS stores its last root reference here for restart purposes.
  *
@@ -227,6 +345,8 @@ static void content_files_destroy (struct content_files *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
@@ -0,0 +1,712 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* content-mmap.c - content addressable storage with mmapdb back end
+ *
+ * Blobs are appended to segment files and located with a memory mapped
+ * hash index (see mmapdb.c).  Blobs >= compression_threshold are LZ4
+ * compressed like content-sqlite.  Uncompressed blobs are loaded directly
+ * from the segment mapping without copying.
+ *
+ * Store responses are deferred to the end of the reactor loop iteration,
+ * then the database is flushed once for the whole batch and the responses
+ * are sent (group commit).  Store-batch requests join the same group.
+ * With the "sync" module option, the flush waits for data to reach stable
+ * storage.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <lz4.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "src/common/libcontent/content-util.h"
+#include "src/common/libcontent/content-batch.h"
+
+#include "mmapdb.h"
+
+const size_t lzo_buf_chunksize = 1024*1024;
+const size_t compression_threshold = 256; /* compress blobs >= this size */
+const size_t segment_size = 64*1024*1024;
+
+struct store_pending {
+    const flux_msg_t *msg;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    struct content_batch *refs; // store-batch response, if non-NULL
+};
+
+struct content_mmap {
+    flux_msg_handler_t **handlers;
+    flux_watcher_t *prep_w;
+    flux_watcher_t *check_w;
+    flux_watcher_t *idle_w;
+    zlistx_t *pending;          // store requests awaiting flush
+    char *dbpath;
+    struct mmapdb *db;
+    flux_t *h;
+    const char *hashfun;
+    bool sync;
+    size_t lzo_bufsize;
+    void *lzo_buf;
+    int flushes;                // for content-mmap.stats.get
+};
+
+static int grow_lzo_buf (struct content_mmap *ctx, size_t size)
+{
+    size_t newsize = ctx->lzo_bufsize;
+    void *newbuf;
+    while (newsize < size)
+        newsize += lzo_buf_chunksize;
+    if (!(newbuf = realloc (ctx->lzo_buf, newsize))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    ctx->lzo_bufsize = newsize;
+    ctx->lzo_buf = newbuf;
+    return 0;
+}
+
+/* Load blob from mmapdb, uncompressing if necessary.
+ * Returned data points into the segment mapping or ctx->lzo_buf, and is
+ * valid until the next load.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int content_mmap_load (struct content_mmap *ctx,
+                              const char *blobref,
+                              const void **datap,
+                              int *sizep)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_len;
+    const void *data;
+    int size;
+    int uncompressed_size;
+
+    if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0) {
+        errno = ENOENT;
+        flux_log_error (ctx->h, "load: unexpected foreign blobref");
+        return -1;
+    }
+    if (mmapdb_get (ctx->db,
+                    hash,
+                    hash_len,
+                    &data,
+                    &size,
+                    &uncompressed_size) < 0) {
+        if (errno != ENOENT)
+            flux_log_error (ctx->h, "load: %s", blobref);
+        return -1;
+    }
+    if (uncompressed_size != -1) {
+        if (ctx->lzo_bufsize < uncompressed_size
+                                && grow_lzo_buf (ctx, uncompressed_size) < 0)
+            return -1;
+        int r = LZ4_decompress_safe (data,
+                                     ctx->lzo_buf,
+                                     size,
+                                     uncompressed_size);
+        if (r < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (r != uncompressed_size) {
+            flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
+            errno = EINVAL;
+            return -1;
+        }
+        data = ctx->lzo_buf;
+        size = uncompressed_size;
+    }
+    *datap = data;
+    *sizep = size;
+    return 0;
+}
+
+/* Store blob to mmapdb, compressing if necessary.
+ * Blobref resulting from hash over 'data' is stored to 'blobref'.
+ * The blob may not be committed until mmapdb_flush() is called.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int content_mmap_store (struct content_mmap *ctx,
+                               const void *data,
+                               int size,
+                               char *blobref,
+                               int blobrefsz)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_len;
+    int uncompressed_size = -1;
+
+    if (blobref_hash (ctx->hashfun,
+                      (uint8_t *)data,
+                      size,
+                      blobref,
+                      blobrefsz) < 0)
+        return -1;
+    if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0)
+        return -1;
+    if (size >= compression_threshold) {
+        int r;
+        int out_len = LZ4_compressBound(size);
+        if (ctx->lzo_bufsize < out_len && grow_lzo_buf (ctx, out_len) < 0)
+            return -1;
+        r = LZ4_compress_default (data, ctx->lzo_buf, size, out_len);
+        if (r == 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        uncompressed_size = size;
+        size = r;
+        data = ctx->lzo_buf;
+    }
+    if (mmapdb_put (ctx->db,
+                    hash,
+                    hash_len,
+                    data,
+                    size,
+                    uncompressed_size) < 0) {
+        flux_log_error (ctx->h, "store: %s", blobref);
+        return -1;
+    }
+    return 0;
+}
+
+static void load_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_mmap *ctx = arg;
+    const char *blobref;
+    int blobref_size;
+    const void *data;
+    int size;
+
+    if (flux_request_decode_raw (msg,
+                                 NULL,
+                                 (const void **)&blobref,
+                                 &blobref_size) < 0) {
+        flux_log_error (h, "load: request decode failed");
+        goto error;
+    }
+    if (!blobref || blobref[blobref_size - 1] != '\0') {
+        errno = EPROTO;
+        flux_log_error (h, "load: malformed blobref");
+        goto error;
+    }
+    if (content_mmap_load (ctx, blobref, &data, &size) < 0)
+        goto error;
+    if (flux_respond_raw (h, msg, data, size) < 0)
+        flux_log_error (h, "load: flux_respond_raw");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "load: flux_respond_error");
+}
+
+static void store_pending_destroy (struct store_pending *sp)
+{
+    if (sp) {
+        int saved_errno = errno;
+        flux_msg_decref (sp->msg);
+        content_batch_destroy (sp->refs);
+        free (sp);
+        errno = saved_errno;
+    }
+}
+
+// zlistx_destructor_fn footprint
+static void store_pending_destructor (void **item)
+{
+    if (item) {
+        store_pending_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct store_pending *store_pending_create (const flux_msg_t *msg)
+{
+    struct store_pending *sp;
+
+    if (!(sp = calloc (1, sizeof (*sp))))
+        return NULL;
+    sp->msg = flux_msg_incref (msg);
+    return sp;
+}
+
+void store_cb (flux_t *h,
+               flux_msg_handler_t *mh,
+               const flux_msg_t *msg,
+               void *arg)
+{
+    struct content_mmap *ctx = arg;
+    struct store_pending *sp = NULL;
+    const void *data;
+    int size;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
+        flux_log_error (h, "store: request decode failed");
+        goto error;
+    }
+    if (!(sp = store_pending_create (msg)))
+        goto error;
+    if (content_mmap_store (ctx,
+                            data,
+                            size,
+                            sp->blobref,
+                            sizeof (sp->blobref)) < 0)
+        goto error;
+    if (!zlistx_add_end (ctx->pending, sp)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store: flux_respond_error");
+    store_pending_destroy (sp);
+}
+
+/* Store a batch of blobs.  As with store, the response is deferred
+ * until the database is flushed.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_mmap *ctx = arg;
+    struct store_pending *sp = NULL;
+    struct content_batch *blobs = NULL;
+    const void *buf;
+    int len;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(blobs = content_batch_decode (buf, len))) {
+        flux_log_error (h, "store-batch: request decode failed");
+        goto error;
+    }
+    if (!(sp = store_pending_create (msg))
+        || !(sp->refs = content_batch_create ()))
+        goto error;
+    count = content_batch_count (blobs);
+    for (int i = 0; i < count; i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (content_batch_get (blobs, i, &data, &size) < 0)
+            rc = content_batch_append_error (sp->refs, EPROTO);
+        else if (content_mmap_store (ctx,
+                                     data,
+                                     size,
+                                     blobref,
+                                     sizeof (blobref)) < 0)
+            rc = content_batch_append_error (sp->refs, errno);
+        else
+            rc = content_batch_append_string (sp->refs, blobref);
+        if (rc < 0)
+            goto error;
+    }
+    if (!zlistx_add_end (ctx->pending, sp)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    content_batch_destroy (blobs);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store-batch: flux_respond_error");
+    store_pending_destroy (sp);
+    content_batch_destroy (blobs);
+}
+
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_mmap *ctx = arg;
+    struct content_batch *refs = NULL;
+    struct content_batch *blobs = NULL;
+    const void *buf;
+    int len;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(refs = content_batch_decode (buf, len))) {
+        flux_log_error (h, "load-batch: request decode failed");
+        goto error;
+    }
+    if (!(blobs = content_batch_create ()))
+        goto error;
+    count = content_batch_count (refs);
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+        const void *data;
+        int size;
+        int rc;
+
+        if (content_batch_get_string (refs, i, &blobref) < 0)
+            rc = content_batch_append_error (blobs, EPROTO);
+        else if (content_mmap_load (ctx, blobref, &data, &size) < 0)
+            rc = content_batch_append_error (blobs, errno);
+        else
+            rc = content_batch_append (blobs, data, size);
+        if (rc < 0)
+            goto error;
+    }
+    content_batch_encode (blobs, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "load-batch: flux_respond_raw");
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "load-batch: flux_respond_error");
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+}
+
+/* Flush the database and respond to all pending store requests.
+ */
+static void flush_pending (struct content_mmap *ctx)
+{
+    struct store_pending *sp;
+    int errnum = 0;
+
+    if (mmapdb_flush (ctx->db, ctx->sync) < 0) {
+        errnum = errno;
+        flux_log_error (ctx->h, "store: flush");
+    }
+    ctx->flushes++;
+    while ((sp = zlistx_detach (ctx->pending, NULL))) {
+        if (errnum == 0 && sp->refs) {
+            const void *buf;
+            int len;
+
+            content_batch_encode (sp->refs, &buf, &len);
+            if (flux_respond_raw (ctx->h, sp->msg, buf, len) < 0)
+                flux_log_error (ctx->h, "store-batch: flux_respond_raw");
+        }
+        else if (errnum == 0) {
+            if (flux_respond_raw (ctx->h,
+                                  sp->msg,
+                                  sp->blobref,
+                                  strlen (sp->blobref) + 1) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_raw");
+        }
+        else {
+            if (flux_respond_error (ctx->h, sp->msg, errnum, NULL) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_error");
+        }
+        store_pending_destroy (sp);
+    }
+}
+
+/* If store responses are pending, keep the reactor from blocking
+ * so they are flushed in the check callback of this loop iteration.
+ */
+static void prep_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct content_mmap *ctx = arg;
+
+    if (zlistx_size (ctx->pending) > 0)
+        flux_watcher_start (ctx->idle_w);
+}
+
+static void check_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+    struct content_mmap *ctx = arg;
+
+    flux_watcher_stop (ctx->idle_w);
+    if (zlistx_size (ctx->pending) > 0)
+        flush_pending (ctx);
+}
+
+void checkpoint_get_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+    struct content_mmap *ctx = arg;
+    const char *key;
+    char *value = NULL;
+    const char *errstr = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:s}", "key", &key) < 0)
+        goto error;
+    if (mmapdb_checkpoint_get (ctx->db, key, &value, &errstr) < 0)
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:s}", "value", value) < 0)
+        flux_log_error (h, "flux_respond_pack");
+    free (value);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "flux_respond_error");
+}
+
+void checkpoint_put_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+    struct content_mmap *ctx = arg;
+    const char *key;
+    const char *value;
+    const char *errstr = NULL;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:s s:s}",
+                             "key",
+                             &key,
+                             "value",
+                             &value) < 0)
+        goto error;
+    /* The checkpoint must not become durable before the blobs it refers
+     * to, so answer pending stores now.  mmapdb_checkpoint_put() syncs.
+     */
+    if (zlistx_size (ctx->pending) > 0)
+        flush_pending (ctx);
+    if (mmapdb_checkpoint_put (ctx->db, key, value, &errstr) < 0)
+        goto error;
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "flux_respond");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "flux_respond_error");
+}
+
+static void stats_get_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct content_mmap *ctx = arg;
+    struct mmapdb_stats stats;
+
+    mmapdb_get_stats (ctx->db, &stats);
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:I s:I s:I s:i s:b}",
+                           "segments", stats.segments,
+                           "objects", (json_int_t)stats.objects,
+                           "bytes", (json_int_t)stats.bytes,
+                           "index-slots", (json_int_t)stats.index_slots,
+                           "flushes", ctx->flushes,
+                           "sync", ctx->sync) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+}
+
+static void content_mmap_closedb (struct content_mmap *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        if (ctx->pending && zlistx_size (ctx->pending) > 0)
+            flush_pending (ctx);
+        mmapdb_close (ctx->db);
+        ctx->db = NULL;
+        errno = saved_errno;
+    }
+}
+
+static int content_mmap_opendb (struct content_mmap *ctx)
+{
+    const char *errstr = NULL;
+
+    if (!(ctx->db = mmapdb_open (ctx->dbpath, segment_size, &errstr))) {
+        flux_log_error (ctx->h,
+                        "opening %s%s%s",
+                        ctx->dbpath,
+                        errstr ? ": " : "",
+                        errstr ? errstr : "");
+        return -1;
+    }
+    return 0;
+}
+
+static void content_mmap_destroy (struct content_mmap *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->prep_w);
+        flux_watcher_destroy (ctx->check_w);
+        flux_watcher_destroy (ctx->idle_w);
+        zlistx_destroy (&ctx->pending);
+        free (ctx->dbpath);
+        free (ctx->lzo_buf);
+        free (ctx);
+        errno = saved_errno;
+    }
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-mmap.stats.get", stats_get_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static struct content_mmap *content_mmap_create (flux_t *h, bool sync)
+{
+    struct content_mmap *ctx;
+    flux_reactor_t *r = flux_get_reactor (h);
+    const char *backing_path;
+
+    if (!(ctx = calloc (1, sizeof (*ctx))))
+        return NULL;
+    if (!(ctx->lzo_buf = calloc (1, lzo_buf_chunksize)))
+        goto error;
+    ctx->lzo_bufsize = lzo_buf_chunksize;
+    ctx->h = h;
+    ctx->sync = sync;
+    if (!(ctx->pending = zlistx_new ()))
+        goto nomem;
+    zlistx_set_destructor (ctx->pending, store_pending_destructor);
+    if (!(ctx->prep_w = flux_prepare_watcher_create (r, prep_cb, ctx))
+        || !(ctx->check_w = flux_check_watcher_create (r, check_cb, ctx))
+        || !(ctx->idle_w = flux_idle_watcher_create (r, NULL, NULL)))
+        goto error;
+    flux_watcher_start (ctx->prep_w);
+    flux_watcher_start (ctx->check_w);
+
+    /* Some tunables:
+     * - the hash function, e.g. sha1, sha256
+     * - path to db directory
+     */
+    if (!(ctx->hashfun = flux_attr_get (h, "content.hash"))) {
+        flux_log_error (h, "content.hash");
+        goto error;
+    }
+
+    /* If 'content.backing-path' attribute is already set, then:
+     * - value is the db directory
+     * - if it exists, preserve existing content; else create empty
+     * Otherwise:
+     * - ${rundir}/content.mmap is the backing path
+     * - set 'content.backing-path' to this name
+     * - ${rundir} is cleaned up recursively by broker atexit(3) handler
+     */
+    backing_path = flux_attr_get (h, "content.backing-path");
+    if (backing_path) {
+        if (!(ctx->dbpath = strdup (backing_path)))
+            goto error;
+    }
+    else {
+        const char *rundir = flux_attr_get (h, "rundir");
+        if (!rundir) {
+            flux_log_error (h, "rundir");
+            goto error;
+        }
+        if (asprintf (&ctx->dbpath, "%s/content.mmap", rundir) < 0)
+            goto error;
+        if (flux_attr_set (h, "content.backing-path", ctx->dbpath) < 0)
+            goto error;
+    }
+    if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
+        goto error;
+    return ctx;
+nomem:
+    errno = ENOMEM;
+error:
+    content_mmap_destroy (ctx);
+    return NULL;
+}
+
+static int parse_args (flux_t *h,
+                       int argc,
+                       char **argv,
+                       bool *testing,
+                       bool *sync)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (!strcmp (argv[i], "testing"))
+            *testing = true;
+        else if (!strcmp (argv[i], "sync"))
+            *sync = true;
+        else {
+            errno = EINVAL;
+            flux_log_error (h, "%s", argv[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int mod_main (flux_t *h, int argc, char **argv)
+{
+    struct content_mmap *ctx;
+    bool testing = false;
+    bool sync = false;
+    int rc = -1;
+
+    if (parse_args (h, argc, argv, &testing, &sync) < 0)
+        return -1;
+    if (!(ctx = content_mmap_create (h, sync))) {
+        flux_log_error (h, "content_mmap_create failed");
+        return -1;
+    }
+    if (content_mmap_opendb (ctx) < 0)
+        goto done;
+    if (!testing) {
+        if (content_register_backing_store (h, "content-mmap") < 0)
+            goto done;
+    }
+    if (content_register_service (h, "content-backing") < 0)
+        goto done;
+    if (content_register_service (h, "kvs-checkpoint") < 0)
+        goto done;
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        goto done;
+    }
+    if (!testing) {
+        if (content_unregister_backing_store (h) < 0)
+            goto done;
+    }
+    rc = 0;
+done:
+    content_mmap_closedb (ctx);
+    content_mmap_destroy (ctx);
+    return rc;
+}
+
+MOD_NAME ("content-mmap");
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
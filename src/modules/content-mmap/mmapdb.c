@@ -0,0 +1,773 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* mmapdb.c - append-only segment files with a memory mapped hash index
+ *
+ * The database directory contains:
+ *
+ * segment.NNNNNN
+ *   Append-only files of records, each a fixed size header containing
+ *   the digest, followed by the blob data, padded to RECORD_ALIGN.
+ *   Segments are pre-sized with ftruncate(2) and mapped read-only, so
+ *   blobs are read directly from the mapping.  Records are appended with
+ *   pwritev(2) so that a full file system returns ENOSPC rather than
+ *   raising SIGBUS.  The end of a segment is the first record without
+ *   RECORD_MAGIC.
+ *
+ * index
+ *   An open addressing (linear probing) hash table of digest to record
+ *   location, mapped read-write.  The header records whether the index
+ *   was closed cleanly, and the current segment and offset.  If the index
+ *   is missing, invalid, or was not closed cleanly, it is rebuilt by
+ *   scanning the segments.  The table doubles when it is half full.
+ *
+ * checkpoint.KEY
+ *   KVS checkpoint values, replaced atomically with rename(2).
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "mmapdb.h"
+
+#define RECORD_MAGIC        0x626c6f62  // "blob"
+#define RECORD_ALIGN        8
+#define INDEX_MAGIC         0x6d696478  // "midx"
+#define INDEX_VERSION       1
+#define INDEX_MIN_SLOTS     4096
+
+struct record {
+    uint32_t magic;
+    uint32_t size;
+    int32_t aux;
+    uint8_t digest_len;
+    uint8_t pad[3];
+    uint8_t digest[MMAPDB_DIGEST_MAX];
+};
+
+struct index_slot {
+    uint8_t digest[MMAPDB_DIGEST_MAX];
+    uint8_t digest_len;         // 0 if slot is empty
+    uint8_t pad[3];
+    uint32_t segno;
+    uint64_t offset;
+};
+
+struct index_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t clean;             // index was closed cleanly
+    uint32_t segno;             // current segment
+    uint64_t offset;            // end of records in current segment
+    uint64_t nslots;            // power of 2
+    uint64_t count;             // number of occupied slots
+    uint64_t bytes;             // bytes used in all segments
+    uint8_t pad[16];
+};
+
+struct segment {
+    int fd;
+    void *base;
+    size_t size;
+};
+
+struct mmapdb {
+    char *dbpath;
+    size_t segment_size;
+    struct segment *segs;
+    int nsegs;
+    size_t offset;              // end of records in last segment
+    uint64_t bytes;
+    bool dirty;                 // records appended since last flush
+    int unsynced;               // first segment not yet synced, or -1
+    int index_fd;
+    struct index_header *index;
+    size_t index_size;
+};
+
+static size_t record_size (size_t size)
+{
+    size_t n = sizeof (struct record) + size;
+    return (n + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1);
+}
+
+static int valid_key (const char *key, const char **errstr)
+{
+    if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
+                          || !strcmp (key, ".")) {
+        errno = EINVAL;
+        if (errstr)
+            *errstr = "invalid key";
+        return -1;
+    }
+    return 0;
+}
+
+static int db_path (struct mmapdb *db,
+                    char *buf,
+                    size_t bufsz,
+                    const char *fmt,
+                    ...)
+{
+    va_list ap;
+    char name[256];
+    int n;
+
+    va_start (ap, fmt);
+    n = vsnprintf (name, sizeof (name), fmt, ap);
+    va_end (ap);
+    if (n >= sizeof (name)
+        || snprintf (buf, bufsz, "%s/%s", db->dbpath, name) >= bufsz) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return 0;
+}
+
+/* Segments
+ */
+
+static void segment_close (struct segment *seg)
+{
+    if (seg->base && seg->base != MAP_FAILED)
+        ERRNO_SAFE_WRAP (munmap, seg->base, seg->size);
+    if (seg->fd >= 0)
+        ERRNO_SAFE_WRAP (close, seg->fd);
+}
+
+/* Open segment 'segno'.  If 'create_size' is nonzero, create it with
+ * that size.
+ */
+static int segment_open (struct mmapdb *db, int segno, size_t create_size)
+{
+    char path[1024];
+    struct segment *seg;
+    struct segment *segs;
+    struct stat sb;
+    int flags = O_RDWR;
+
+    if (db_path (db, path, sizeof (path), "segment.%06d", segno) < 0)
+        return -1;
+    if (!(segs = realloc (db->segs, sizeof (segs[0]) * (segno + 1))))
+        return -1;
+    db->segs = segs;
+    seg = &db->segs[segno];
+    seg->base = NULL;
+    if (create_size > 0)
+        flags |= O_CREAT | O_EXCL;
+    if ((seg->fd = open (path, flags, 0600)) < 0)
+        return -1;
+    if (create_size > 0) {
+        if (ftruncate (seg->fd, create_size) < 0)
+            goto error;
+        seg->size = create_size;
+    }
+    else {
+        if (fstat (seg->fd, &sb) < 0)
+            goto error;
+        seg->size = sb.st_size;
+    }
+    if (seg->size > 0) {
+        seg->base = mmap (NULL, seg->size, PROT_READ, MAP_SHARED, seg->fd, 0);
+        if (seg->base == MAP_FAILED)
+            goto error;
+    }
+    db->nsegs = segno + 1;
+    return 0;
+error:
+    segment_close (seg);
+    if (create_size > 0)
+        (void)unlink (path);
+    return -1;
+}
+
+static const struct record *segment_record (struct segment *seg,
+                                            uint64_t offset)
+{
+    const struct record *rec;
+
+    if (offset + sizeof (*rec) > seg->size)
+        return NULL;
+    rec = (const struct record *)((char *)seg->base + offset);
+    if (rec->magic != RECORD_MAGIC
+        || rec->digest_len == 0
+        || rec->digest_len > MMAPDB_DIGEST_MAX
+        || offset + record_size (rec->size) > seg->size)
+        return NULL;
+    return rec;
+}
+
+/* Index
+ */
+
+static struct index_slot *index_slots (struct index_header *index)
+{
+    return (struct index_slot *)(index + 1);
+}
+
+static uint64_t digest_hash (const uint8_t *digest, int digest_len)
+{
+    uint64_t h = 0;
+
+    /* digests are uniformly distributed, so any 8 bytes will do */
+    memcpy (&h, digest, digest_len < sizeof (h) ? digest_len : sizeof (h));
+    return h;
+}
+
+/* Find the slot for 'digest', which is either the slot containing it,
+ * or the empty slot where it would be inserted.
+ */
+static struct index_slot *index_find (struct index_header *index,
+                                      const uint8_t *digest,
+                                      int digest_len)
+{
+    struct index_slot *slots = index_slots (index);
+    uint64_t mask = index->nslots - 1;
+    uint64_t i = digest_hash (digest, digest_len) & mask;
+
+    while (slots[i].digest_len != 0) {
+        if (slots[i].digest_len == digest_len
+            && !memcmp (slots[i].digest, digest, digest_len))
+            break;
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static void index_unmap (int fd, struct index_header *index, size_t size)
+{
+    if (index && index != MAP_FAILED)
+        ERRNO_SAFE_WRAP (munmap, index, size);
+    if (fd >= 0)
+        ERRNO_SAFE_WRAP (close, fd);
+}
+
+/* Create an empty index with 'nslots' slots at 'path'.
+ * Space is allocated up front, since running out of space while writing
+ * to a mapping raises SIGBUS.
+ */
+static struct index_header *index_create (const char *path,
+                                          uint64_t nslots,
+                                          int *fdp,
+                                          size_t *sizep)
+{
+    struct index_header *index = NULL;
+    size_t size = sizeof (*index) + nslots * sizeof (struct index_slot);
+    int fd;
+    int e;
+
+    if ((fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0600)) < 0)
+        return NULL;
+    if ((e = posix_fallocate (fd, 0, size)) != 0) {
+        errno = e;
+        goto error;
+    }
+    index = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (index == MAP_FAILED)
+        goto error;
+    memset (index, 0, size);
+    index->magic = INDEX_MAGIC;
+    index->version = INDEX_VERSION;
+    index->nslots = nslots;
+    *fdp = fd;
+    *sizep = size;
+    return index;
+error:
+    index_unmap (fd, index, size);
+    return NULL;
+}
+
+/* Map an existing index at 'path'.  Fail with EINVAL if it is invalid.
+ */
+static struct index_header *index_map (const char *path,
+                                       int *fdp,
+                                       size_t *sizep)
+{
+    struct index_header *index = NULL;
+    struct stat sb;
+    size_t size = 0;
+    int fd;
+
+    if ((fd = open (path, O_RDWR)) < 0)
+        return NULL;
+    if (fstat (fd, &sb) < 0)
+        goto error;
+    if (sb.st_size < sizeof (*index)) {
+        errno = EINVAL;
+        goto error;
+    }
+    size = sb.st_size;
+    index = mmap (NULL,
+                  size,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED,
+                  fd,
+                  0);
+    if (index == MAP_FAILED)
+        goto error;
+    if (index->magic != INDEX_MAGIC
+        || index->version != INDEX_VERSION
+        || index->nslots < INDEX_MIN_SLOTS
+        || (index->nslots & (index->nslots - 1)) != 0
+        || sizeof (*index) + index->nslots * sizeof (struct index_slot)
+           != size) {
+        errno = EINVAL;
+        goto error;
+    }
+    *fdp = fd;
+    *sizep = size;
+    return index;
+error:
+    index_unmap (fd, index, size);
+    return NULL;
+}
+
+static void index_set (struct index_slot *slot,
+                       const uint8_t *digest,
+                       int digest_len,
+                       uint32_t segno,
+                       uint64_t offset)
+{
+    memcpy (slot->digest, digest, digest_len);
+    slot->digest_len = digest_len;
+    slot->segno = segno;
+    slot->offset = offset;
+}
+
+/* Replace the index with one twice the size.
+ */
+static int index_grow (struct mmapdb *db)
+{
+    char path[1024];
+    char tmp[1024];
+    struct index_header *index;
+    struct index_slot *slots = index_slots (db->index);
+    size_t size;
+    int fd;
+
+    if (db_path (db, path, sizeof (path), "index") < 0
+        || db_path (db, tmp, sizeof (tmp), "index.tmp") < 0)
+        return -1;
+    if (!(index = index_create (tmp, db->index->nslots * 2, &fd, &size)))
+        return -1;
+    for (uint64_t i = 0; i < db->index->nslots; i++) {
+        if (slots[i].digest_len != 0) {
+            index_set (index_find (index, slots[i].digest, slots[i].digest_len),
+                       slots[i].digest,
+                       slots[i].digest_len,
+                       slots[i].segno,
+                       slots[i].offset);
+        }
+    }
+    index->count = db->index->count;
+    if (rename (tmp, path) < 0) {
+        index_unmap (fd, index, size);
+        (void)unlink (tmp);
+        return -1;
+    }
+    index_unmap (db->index_fd, db->index, db->index_size);
+    db->index = index;
+    db->index_fd = fd;
+    db->index_size = size;
+    return 0;
+}
+
+static int index_insert (struct mmapdb *db,
+                         const uint8_t *digest,
+                         int digest_len,
+                         uint32_t segno,
+                         uint64_t offset)
+{
+    struct index_slot *slot;
+
+    if ((db->index->count + 1) * 2 > db->index->nslots) {
+        if (index_grow (db) < 0)
+            return -1;
+    }
+    slot = index_find (db->index, digest, digest_len);
+    if (slot->digest_len == 0) {
+        index_set (slot, digest, digest_len, segno, offset);
+        db->index->count++;
+    }
+    return 0;
+}
+
+/* Rebuild the index by scanning all segments.
+ */
+static int index_rebuild (struct mmapdb *db)
+{
+    char path[1024];
+
+    if (db_path (db, path, sizeof (path), "index") < 0)
+        return -1;
+    if (!(db->index = index_create (path,
+                                    INDEX_MIN_SLOTS,
+                                    &db->index_fd,
+                                    &db->index_size)))
+        return -1;
+    db->bytes = 0;
+    for (int segno = 0; segno < db->nsegs; segno++) {
+        struct segment *seg = &db->segs[segno];
+        const struct record *rec;
+        uint64_t offset = 0;
+
+        while ((rec = segment_record (seg, offset))) {
+            if (index_insert (db,
+                              rec->digest,
+                              rec->digest_len,
+                              segno,
+                              offset) < 0)
+                return -1;
+            offset += record_size (rec->size);
+        }
+        db->offset = offset;
+        db->bytes += offset;
+    }
+    return 0;
+}
+
+/* Update the index header and mark it clean or dirty.
+ * If 'sync' is true, write the index to stable storage.
+ */
+static int index_commit (struct mmapdb *db, bool clean, bool sync)
+{
+    db->index->segno = db->nsegs - 1;
+    db->index->offset = db->offset;
+    db->index->bytes = db->bytes;
+    db->index->clean = clean ? 1 : 0;
+    if (sync && msync (db->index, db->index_size, MS_SYNC) < 0)
+        return -1;
+    return 0;
+}
+
+static int open_segments (struct mmapdb *db)
+{
+    char path[1024];
+    int segno = 0;
+
+    for (;;) {
+        if (db_path (db, path, sizeof (path), "segment.%06d", segno) < 0)
+            return -1;
+        if (access (path, F_OK) < 0)
+            break;
+        if (segment_open (db, segno, 0) < 0)
+            return -1;
+        segno++;
+    }
+    if (db->nsegs == 0) {
+        if (segment_open (db, 0, db->segment_size) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int open_index (struct mmapdb *db)
+{
+    char path[1024];
+
+    if (db_path (db, path, sizeof (path), "index") < 0)
+        return -1;
+    if ((db->index = index_map (path, &db->index_fd, &db->index_size))) {
+        if (db->index->clean
+            && db->index->segno == (uint32_t)(db->nsegs - 1)
+            && db->index->offset <= db->segs[db->nsegs - 1].size) {
+            db->offset = db->index->offset;
+            db->bytes = db->index->bytes;
+            goto done;
+        }
+        index_unmap (db->index_fd, db->index, db->index_size);
+        db->index = NULL;
+        db->index_fd = -1;
+    }
+    else if (errno != ENOENT && errno != EINVAL)
+        return -1;
+    if (index_rebuild (db) < 0)
+        return -1;
+done:
+    /* Mark the index dirty while open, so it is rebuilt after a crash.
+     */
+    return index_commit (db, false, true);
+}
+
+void mmapdb_close (struct mmapdb *db)
+{
+    if (db) {
+        int saved_errno = errno;
+        if (db->index) {
+            if (mmapdb_flush (db, true) == 0)
+                (void)index_commit (db, true, true);
+            index_unmap (db->index_fd, db->index, db->index_size);
+        }
+        for (int i = 0; i < db->nsegs; i++)
+            segment_close (&db->segs[i]);
+        free (db->segs);
+        free (db->dbpath);
+        free (db);
+        errno = saved_errno;
+    }
+}
+
+struct mmapdb *mmapdb_open (const char *dbpath,
+                            size_t segment_size,
+                            const char **errstr)
+{
+    struct mmapdb *db;
+
+    if (!dbpath || segment_size < sizeof (struct record)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(db = calloc (1, sizeof (*db))))
+        return NULL;
+    db->index_fd = -1;
+    db->unsynced = -1;
+    db->segment_size = segment_size;
+    if (!(db->dbpath = strdup (dbpath)))
+        goto error;
+    if (mkdir (db->dbpath, 0700) < 0 && errno != EEXIST)
+        goto error;
+    if (open_segments (db) < 0) {
+        if (errstr)
+            *errstr = "error opening segment files";
+        goto error;
+    }
+    if (open_index (db) < 0) {
+        if (errstr)
+            *errstr = "error opening index";
+        goto error;
+    }
+    return db;
+error:
+    /* don't mark a partially opened index clean */
+    if (db->index) {
+        index_unmap (db->index_fd, db->index, db->index_size);
+        db->index = NULL;
+    }
+    mmapdb_close (db);
+    return NULL;
+}
+
+int mmapdb_get (struct mmapdb *db,
+                const void *digest,
+                int digest_len,
+                const void **datap,
+                int *sizep,
+                int *auxp)
+{
+    struct index_slot *slot;
+    const struct record *rec;
+
+    if (!db || !digest || digest_len <= 0 || digest_len > MMAPDB_DIGEST_MAX
+        || !datap || !sizep) {
+        errno = EINVAL;
+        return -1;
+    }
+    slot = index_find (db->index, digest, digest_len);
+    if (slot->digest_len == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (slot->segno >= db->nsegs
+        || !(rec = segment_record (&db->segs[slot->segno], slot->offset))) {
+        errno = EIO;
+        return -1;
+    }
+    *datap = rec + 1;
+    *sizep = rec->size;
+    if (auxp)
+        *auxp = rec->aux;
+    return 0;
+}
+
+int mmapdb_put (struct mmapdb *db,
+                const void *digest,
+                int digest_len,
+                const void *data,
+                int size,
+                int aux)
+{
+    struct index_slot *slot;
+    struct record rec;
+    struct iovec iov[3];
+    static const char pad[RECORD_ALIGN];
+    size_t len;
+    ssize_t n;
+
+    if (!db || !digest || digest_len <= 0 || digest_len > MMAPDB_DIGEST_MAX
+        || size < 0 || (size > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    slot = index_find (db->index, digest, digest_len);
+    if (slot->digest_len != 0)
+        return 0;
+    len = record_size (size);
+    if (db->offset + len > db->segs[db->nsegs - 1].size) {
+        size_t create_size = db->segment_size;
+        if (create_size < len)
+            create_size = len;
+        if (segment_open (db, db->nsegs, create_size) < 0)
+            return -1;
+        db->offset = 0;
+    }
+    memset (&rec, 0, sizeof (rec));
+    rec.magic = RECORD_MAGIC;
+    rec.size = size;
+    rec.aux = aux;
+    rec.digest_len = digest_len;
+    memcpy (rec.digest, digest, digest_len);
+    iov[0].iov_base = &rec;
+    iov[0].iov_len = sizeof (rec);
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = size;
+    iov[2].iov_base = (void *)pad;
+    iov[2].iov_len = len - sizeof (rec) - size;
+    if ((n = pwritev (db->segs[db->nsegs - 1].fd, iov, 3, db->offset)) < 0)
+        return -1;
+    if (n < len) {
+        errno = EIO;
+        return -1;
+    }
+    if (index_insert (db, digest, digest_len, db->nsegs - 1, db->offset) < 0)
+        return -1;
+    db->offset += len;
+    db->bytes += len;
+    db->dirty = true;
+    if (db->unsynced < 0)
+        db->unsynced = db->nsegs - 1;
+    return 0;
+}
+
+int mmapdb_flush (struct mmapdb *db, bool sync)
+{
+    if (!db) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (db->dirty) {
+        (void)index_commit (db, false, false);
+        db->dirty = false;
+    }
+    if (sync && db->unsynced >= 0) {
+        for (int i = db->unsynced; i < db->nsegs; i++) {
+            if (fdatasync (db->segs[i].fd) < 0)
+                return -1;
+        }
+        if (msync (db->index, db->index_size, MS_SYNC) < 0)
+            return -1;
+        db->unsynced = -1;
+    }
+    return 0;
+}
+
+int mmapdb_checkpoint_get (struct mmapdb *db,
+                           const char *key,
+                           char **valuep,
+                           const char **errstr)
+{
+    char path[1024];
+    void *data;
+    int fd;
+
+    if (!db || !key || !valuep) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (valid_key (key, errstr) < 0)
+        return -1;
+    if (db_path (db, path, sizeof (path), "checkpoint.%s", key) < 0) {
+        if (errstr)
+            *errstr = "key name too long for internal buffer";
+        return -1;
+    }
+    if ((fd = open (path, O_RDONLY)) < 0)
+        return -1;
+    /* N.B. read_all() pads the buffer with a NULL */
+    if (read_all (fd, &data) < 0) {
+        ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    if (close (fd) < 0) {
+        ERRNO_SAFE_WRAP (free, data);
+        return -1;
+    }
+    *valuep = data;
+    return 0;
+}
+
+int mmapdb_checkpoint_put (struct mmapdb *db,
+                           const char *key,
+                           const char *value,
+                           const char **errstr)
+{
+    char path[1024];
+    char tmp[1024];
+    int fd;
+
+    if (!db || !key || !value) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (valid_key (key, errstr) < 0)
+        return -1;
+    if (db_path (db, path, sizeof (path), "checkpoint.%s", key) < 0
+        || db_path (db, tmp, sizeof (tmp), "tmp.checkpoint.%s", key) < 0) {
+        if (errstr)
+            *errstr = "key name too long for internal buffer";
+        return -1;
+    }
+    /* The checkpoint refers to blobs, so they must be durable first.
+     */
+    if (mmapdb_flush (db, true) < 0)
+        return -1;
+    if ((fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0)
+        return -1;
+    if (write_all (fd, value, strlen (value)) < 0 || fdatasync (fd) < 0) {
+        ERRNO_SAFE_WRAP (close, fd);
+        goto error;
+    }
+    if (close (fd) < 0)
+        goto error;
+    if (rename (tmp, path) < 0)
+        goto error;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (unlink, tmp);
+    return -1;
+}
+
+void mmapdb_get_stats (struct mmapdb *db, struct mmapdb_stats *stats)
+{
+    if (db && stats) {
+        stats->segments = db->nsegs;
+        stats->objects = db->index->count;
+        stats->bytes = db->bytes;
+        stats->index_slots = db->index->nslots;
+    }
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
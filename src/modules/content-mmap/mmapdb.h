@@ -0,0 +1,95 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONTENT_MMAP_MMAPDB_H
+#define _CONTENT_MMAP_MMAPDB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define MMAPDB_DIGEST_MAX 32
+
+struct mmapdb;
+
+struct mmapdb_stats {
+    int segments;               // number of segment files
+    uint64_t objects;           // number of stored blobs
+    uint64_t bytes;             // bytes used in segment files
+    uint64_t index_slots;       // capacity of hash index
+};
+
+/* Open the database in directory 'dbpath', creating it if it does not
+ * exist.  New segment files are created with 'segment_size' bytes
+ * (or larger if needed to hold one blob).
+ * If the index was not closed cleanly, it is rebuilt from the segments.
+ * On failure, NULL is returned with errno set.
+ * Pass '*errstr' in pre-set to NULL and if a human readable error message
+ * is appropriate, it is assigned on error (do not free).
+ */
+struct mmapdb *mmapdb_open (const char *dbpath,
+                            size_t segment_size,
+                            const char **errstr);
+
+/* Flush and close the database, marking the index clean.
+ */
+void mmapdb_close (struct mmapdb *db);
+
+/* Look up blob by 'digest'.  On success, 'datap' and 'sizep' are assigned
+ * the stored data, which points into the segment mapping and remains valid
+ * until mmapdb_close().  'auxp' (if non-NULL) is assigned the 'aux' value
+ * passed to mmapdb_put().  On failure, -1 is returned with errno set
+ * (ENOENT if not found).
+ */
+int mmapdb_get (struct mmapdb *db,
+                const void *digest,
+                int digest_len,
+                const void **datap,
+                int *sizep,
+                int *auxp);
+
+/* Append blob 'data' of length 'size' under 'digest', with an arbitrary
+ * integer 'aux' stored alongside it.  If 'digest' is already present,
+ * this is a no-op.  The blob is written to the segment file but may not
+ * be durable until mmapdb_flush().
+ * On failure, -1 is returned with errno set.
+ */
+int mmapdb_put (struct mmapdb *db,
+                const void *digest,
+                int digest_len,
+                const void *data,
+                int size,
+                int aux);
+
+/* Commit blobs appended since the last flush.  If 'sync' is true,
+ * do not return until the segment data and index are on stable storage.
+ */
+int mmapdb_flush (struct mmapdb *db, bool sync);
+
+/* Get/put string 'value' under 'key' for KVS checkpoints.
+ * The value returned by mmapdb_checkpoint_get() must be freed.
+ * A checkpoint put is durable on return.
+ */
+int mmapdb_checkpoint_get (struct mmapdb *db,
+                           const char *key,
+                           char **valuep,
+                           const char **errstr);
+int mmapdb_checkpoint_put (struct mmapdb *db,
+                           const char *key,
+                           const char *value,
+                           const char **errstr);
+
+void mmapdb_get_stats (struct mmapdb *db, struct mmapdb_stats *stats);
+
+#endif /* !_CONTENT_MMAP_MMAPDB_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
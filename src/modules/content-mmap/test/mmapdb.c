@@ -0,0 +1,318 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/content-mmap/mmapdb.h"
+#include "src/common/libutil/unlink_recursive.h"
+
+#define SEGMENT_SIZE 4096
+
+/* Generate a distinct digest for integer 'n'.
+ */
+static void make_digest (uint8_t *digest, int n)
+{
+    uint32_t h = n * 2654435761U;
+
+    for (int i = 0; i < MMAPDB_DIGEST_MAX; i++) {
+        digest[i] = h >> ((i % 4) * 8);
+        if (i % 4 == 3)
+            h = h * 2654435761U + i;
+    }
+}
+
+static bool check_blob (struct mmapdb *db,
+                        const uint8_t *digest,
+                        const void *expected,
+                        int expected_size,
+                        int expected_aux)
+{
+    const void *data;
+    int size;
+    int aux;
+
+    if (mmapdb_get (db, digest, MMAPDB_DIGEST_MAX, &data, &size, &aux) < 0)
+        return false;
+    if (size != expected_size || aux != expected_aux)
+        return false;
+    if (size > 0 && memcmp (data, expected, size) != 0)
+        return false;
+    return true;
+}
+
+void test_badargs (const char *dbpath)
+{
+    struct mmapdb *db;
+    uint8_t digest[MMAPDB_DIGEST_MAX];
+    const void *data;
+    int size;
+    char *value;
+    const char *errstr;
+
+    errno = 0;
+    ok (mmapdb_open (NULL, SEGMENT_SIZE, NULL) == NULL && errno == EINVAL,
+        "mmapdb_open dbpath=NULL fails with EINVAL");
+    errno = 0;
+    ok (mmapdb_open (dbpath, 1, NULL) == NULL && errno == EINVAL,
+        "mmapdb_open segment_size=1 fails with EINVAL");
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+    make_digest (digest, 0);
+
+    errno = 0;
+    ok (mmapdb_get (db, digest, 0, &data, &size, NULL) < 0 && errno == EINVAL,
+        "mmapdb_get digest_len=0 fails with EINVAL");
+    errno = 0;
+    ok (mmapdb_get (db, digest, MMAPDB_DIGEST_MAX + 1, &data, &size, NULL) < 0
+        && errno == EINVAL,
+        "mmapdb_get digest_len=MAX+1 fails with EINVAL");
+    errno = 0;
+    ok (mmapdb_get (db, digest, MMAPDB_DIGEST_MAX, &data, &size, NULL) < 0
+        && errno == ENOENT,
+        "mmapdb_get unknown digest fails with ENOENT");
+    errno = 0;
+    ok (mmapdb_put (db, digest, MMAPDB_DIGEST_MAX, NULL, 1, 0) < 0
+        && errno == EINVAL,
+        "mmapdb_put data=NULL size=1 fails with EINVAL");
+    errno = 0;
+    ok (mmapdb_put (db, digest, MMAPDB_DIGEST_MAX, "x", -1, 0) < 0
+        && errno == EINVAL,
+        "mmapdb_put size=-1 fails with EINVAL");
+    errno = 0;
+    ok (mmapdb_flush (NULL, false) < 0 && errno == EINVAL,
+        "mmapdb_flush db=NULL fails with EINVAL");
+
+    errno = 0;
+    errstr = NULL;
+    ok (mmapdb_checkpoint_put (db, "a/b", "x", &errstr) < 0 && errno == EINVAL,
+        "mmapdb_checkpoint_put key=\"a/b\" fails with EINVAL");
+    ok (errstr != NULL,
+        "and error string was set");
+    errno = 0;
+    errstr = NULL;
+    ok (mmapdb_checkpoint_get (db, "", &value, &errstr) < 0 && errno == EINVAL,
+        "mmapdb_checkpoint_get key=\"\" fails with EINVAL");
+    ok (errstr != NULL,
+        "and error string was set");
+    errno = 0;
+    ok (mmapdb_checkpoint_get (db, "noexist", &value, &errstr) < 0
+        && errno == ENOENT,
+        "mmapdb_checkpoint_get key=noexist fails with ENOENT");
+
+    mmapdb_close (db);
+}
+
+void test_simple (const char *dbpath)
+{
+    struct mmapdb *db;
+    struct mmapdb_stats stats;
+    uint8_t d1[MMAPDB_DIGEST_MAX];
+    uint8_t d2[MMAPDB_DIGEST_MAX];
+    uint8_t d3[MMAPDB_DIGEST_MAX];
+    char big[SEGMENT_SIZE * 3];
+    const char *val1 = "abcdefg";
+    char *value;
+
+    make_digest (d1, 1);
+    make_digest (d2, 2);
+    make_digest (d3, 3);
+    memset (big, 'z', sizeof (big));
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+
+    ok (mmapdb_put (db, d1, sizeof (d1), val1, strlen (val1), 42) == 0,
+        "mmapdb_put blob1 works");
+    ok (check_blob (db, d1, val1, strlen (val1), 42),
+        "mmapdb_get blob1 returns the data and aux value");
+    ok (mmapdb_put (db, d2, sizeof (d2), NULL, 0, -1) == 0,
+        "mmapdb_put empty blob2 works");
+    ok (check_blob (db, d2, NULL, 0, -1),
+        "mmapdb_get blob2 returns empty data");
+    ok (mmapdb_put (db, d3, sizeof (d3), big, sizeof (big), -1) == 0,
+        "mmapdb_put blob3 larger than segment size works");
+    ok (check_blob (db, d3, big, sizeof (big), -1),
+        "mmapdb_get blob3 returns the data");
+
+    mmapdb_get_stats (db, &stats);
+    ok (stats.objects == 3,
+        "stats reports 3 objects");
+    ok (stats.segments == 2,
+        "stats reports 2 segments");
+    ok (mmapdb_put (db, d1, sizeof (d1), val1, strlen (val1), 42) == 0,
+        "mmapdb_put blob1 again works");
+    mmapdb_get_stats (db, &stats);
+    ok (stats.objects == 3,
+        "stats still reports 3 objects");
+
+    ok (mmapdb_flush (db, true) == 0,
+        "mmapdb_flush sync=true works");
+    ok (mmapdb_checkpoint_put (db, "kvs-primary", "{\"a\":1}", NULL) == 0,
+        "mmapdb_checkpoint_put works");
+    ok (mmapdb_checkpoint_put (db, "kvs-primary", "{\"b\":2}", NULL) == 0,
+        "mmapdb_checkpoint_put overwrite works");
+    value = NULL;
+    ok (mmapdb_checkpoint_get (db, "kvs-primary", &value, NULL) == 0
+        && value != NULL
+        && !strcmp (value, "{\"b\":2}"),
+        "mmapdb_checkpoint_get returns updated value");
+    free (value);
+
+    mmapdb_close (db);
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+    ok (check_blob (db, d1, val1, strlen (val1), 42)
+        && check_blob (db, d2, NULL, 0, -1)
+        && check_blob (db, d3, big, sizeof (big), -1),
+        "blobs can be read after reopen");
+    value = NULL;
+    ok (mmapdb_checkpoint_get (db, "kvs-primary", &value, NULL) == 0
+        && value != NULL
+        && !strcmp (value, "{\"b\":2}"),
+        "checkpoint can be read after reopen");
+    free (value);
+    mmapdb_close (db);
+}
+
+/* Store enough blobs to grow the index and span many segments,
+ * then verify they survive reopen with and without the index file.
+ */
+void test_many (const char *dbpath)
+{
+    struct mmapdb *db;
+    struct mmapdb_stats stats;
+    uint8_t digest[MMAPDB_DIGEST_MAX];
+    char path[1024];
+    char data[64];
+    const int count = 10000;
+    int errors;
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+    errors = 0;
+    for (int i = 0; i < count; i++) {
+        int n = snprintf (data, sizeof (data), "blob-%d", i);
+        make_digest (digest, 1000 + i);
+        if (mmapdb_put (db, digest, sizeof (digest), data, n, i) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "mmapdb_put %d blobs works", count);
+    mmapdb_get_stats (db, &stats);
+    ok (stats.objects == count + 3,
+        "stats reports %d objects", count + 3);
+    ok (stats.index_slots >= stats.objects * 2,
+        "index grew to %ju slots", (uintmax_t)stats.index_slots);
+    mmapdb_close (db);
+
+    if (snprintf (path, sizeof (path), "%s/index", dbpath) >= sizeof (path))
+        BAIL_OUT ("internal buffer overflow");
+    ok (unlink (path) == 0,
+        "removed index file");
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+    mmapdb_get_stats (db, &stats);
+    ok (stats.objects == count + 3,
+        "index was rebuilt with %d objects", count + 3);
+    errors = 0;
+    for (int i = 0; i < count; i++) {
+        int n = snprintf (data, sizeof (data), "blob-%d", i);
+        make_digest (digest, 1000 + i);
+        if (!check_blob (db, digest, data, n, i))
+            errors++;
+    }
+    ok (errors == 0,
+        "all blobs can be read after index rebuild");
+
+    make_digest (digest, 1);
+    ok (mmapdb_put (db, digest, sizeof (digest), "new", 3, 0) == 0,
+        "mmapdb_put duplicate digest works");
+    ok (check_blob (db, digest, "abcdefg", 7, 42),
+        "duplicate put did not replace the original blob");
+    mmapdb_close (db);
+}
+
+/* Exit without closing, leaving the index marked dirty as after a crash.
+ */
+void test_crash (const char *dbpath)
+{
+    struct mmapdb *db;
+    uint8_t digest[MMAPDB_DIGEST_MAX];
+    pid_t pid;
+    int status;
+
+    make_digest (digest, 99999);
+    if ((pid = fork ()) < 0)
+        BAIL_OUT ("fork failed");
+    if (pid == 0) {
+        if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL))
+            || mmapdb_put (db, digest, sizeof (digest), "crash", 5, 7) < 0
+            || mmapdb_flush (db, false) < 0)
+            _exit (1);
+        _exit (0);
+    }
+    ok (waitpid (pid, &status, 0) == pid
+        && WIFEXITED (status)
+        && WEXITSTATUS (status) == 0,
+        "child stored a blob and exited without closing");
+
+    if (!(db = mmapdb_open (dbpath, SEGMENT_SIZE, NULL)))
+        BAIL_OUT ("mmapdb_open failed");
+    ok (check_blob (db, digest, "crash", 5, 7),
+        "blob stored before unclean exit can be read");
+    make_digest (digest, 1);
+    ok (check_blob (db, digest, "abcdefg", 7, 42),
+        "earlier blobs can be read");
+    mmapdb_close (db);
+}
+
+int main (int argc, char *argv[])
+{
+    char dir[1024];
+    char dbpath[1100];
+    const char *tmp = getenv ("TMPDIR");
+
+    plan (NO_PLAN);
+
+    if (!tmp)
+        tmp = "/tmp";
+    if (snprintf (dir, sizeof (dir), "%s/mmapdb.XXXXXX", tmp) >= sizeof (dir))
+        BAIL_OUT ("internal buffer overflow");
+    if (!mkdtemp (dir))
+        BAIL_OUT ("mkdtemp failed");
+    diag ("mkdir %s", dir);
+    snprintf (dbpath, sizeof (dbpath), "%s/db", dir);
+
+    test_badargs (dbpath);
+    test_simple (dbpath);
+    test_many (dbpath);
+    test_crash (dbpath);
+
+    if (unlink_recursive (dir) < 0)
+        BAIL_OUT ("unlink_recursive failed");
+
+    done_testing ();
+    return (0);
+}
+
+// vi: ts=4 sw=4 expandtab
@@ -22,6 +22,7 @@
 #include "src/common/libutil/errno_safe.h"
 
 #include "src/common/libcontent/content-util.h"
+#include "src/common/libcontent/content-batch.h"
 
 const size_t lzo_buf_chunksize = 1024*1024;
 const size_t compression_threshold = 256; /* compress blobs >= this size */
@@ -330,6 +331,144 @@ error:
         flux_log_error (h, "store: flux_respond_error");
 }
 
+static void respond_batch (flux_t *h,
+                           const flux_msg_t *msg,
+                           const struct content_batch *b,
+                           const char *name)
+{
+    const void *buf;
+    int len;
+
+    content_batch_encode (b, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "%s: flux_respond_raw", name);
+}
+
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *buf;
+    int len;
+    struct content_batch *refs = NULL;
+    struct content_batch *blobs = NULL;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(refs = content_batch_decode (buf, len))) {
+        flux_log_error (h, "load-batch: request decode failed");
+        goto error;
+    }
+    if (!(blobs = content_batch_create ()))
+        goto error;
+    count = content_batch_count (refs);
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+        const void *data;
+        int size;
+        int rc;
+
+        if (content_batch_get_string (refs, i, &blobref) < 0) {
+            rc = content_batch_append_error (blobs, EPROTO);
+        }
+        else if (content_sqlite_load (ctx, blobref, &data, &size) < 0) {
+            rc = content_batch_append_error (blobs, errno);
+        }
+        else {
+            rc = content_batch_append (blobs, data, size);
+            (void )sqlite3_reset (ctx->load_stmt);
+        }
+        if (rc < 0)
+            goto error;
+    }
+    respond_batch (h, msg, blobs, "load-batch");
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "load-batch: flux_respond_error");
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+}
+
+/* Store a batch of blobs in one sqlite transaction, so that the cost
+ * of updating the database is shared among them.  Blobs that cannot be
+ * stored get an error entry in the response.  If the response cannot be
+ * built or the transaction cannot be committed, it is rolled back and
+ * the whole batch fails, so no blobs are stored without the caller
+ * learning their blobrefs.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *buf;
+    int len;
+    struct content_batch *blobs = NULL;
+    struct content_batch *refs = NULL;
+    bool in_transaction = false;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(blobs = content_batch_decode (buf, len))) {
+        flux_log_error (h, "store-batch: request decode failed");
+        goto error;
+    }
+    if (!(refs = content_batch_create ()))
+        goto error;
+    if (sqlite3_exec (ctx->db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store-batch: begin transaction");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    in_transaction = true;
+    count = content_batch_count (blobs);
+    for (int i = 0; i < count; i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (content_batch_get (blobs, i, &data, &size) < 0)
+            rc = content_batch_append_error (refs, EPROTO);
+        else if (content_sqlite_store (ctx,
+                                       data,
+                                       size,
+                                       blobref,
+                                       sizeof (blobref)) < 0)
+            rc = content_batch_append_error (refs, errno);
+        else
+            rc = content_batch_append_string (refs, blobref);
+        if (rc < 0)
+            goto error;
+    }
+    if (sqlite3_exec (ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store-batch: commit transaction");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    respond_batch (h, msg, refs, "store-batch");
+    content_batch_destroy (refs);
+    content_batch_destroy (blobs);
+    return;
+error:
+    if (in_transaction) {
+        int saved_errno = errno;
+        if (sqlite3_exec (ctx->db, "ROLLBACK", NULL, NULL, NULL) != SQLITE_OK)
+            log_sqlite_error (ctx, "store-batch: rollback transaction");
+        errno = saved_errno;
+    }
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store-batch: flux_respond_error");
+    content_batch_destroy (refs);
+    content_batch_destroy (blobs);
+}
+
 void checkpoint_get_cb (flux_t *h,
                         flux_msg_handler_t *mh,
                         const flux_msg_t *msg,
@@ -553,6 +692,8 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <unistd.h>
+#include <limits.h>
 #include <jansson.h>
 #include <flux/core.h>
 #if HAVE_FLUX_SECURITY
@@ -884,6 +885,45 @@ static const struct flux_msg_handler_spec htab[] = {
     FLUX_MSGHANDLER_TABLE_END,
 };
 
+static int parse_count (flux_t *h, const char *arg, int *value)
+{
+    const char *s = strchr (arg, '=') + 1;
+    char *endptr;
+    long l;
+
+    errno = 0;
+    l = strtol (s, &endptr, 0);
+    if (errno != 0 || *endptr != '\0' || l <= 0 || l > INT_MAX) {
+        flux_log (h, LOG_ERR, "Invalid %s", arg);
+        errno = EINVAL;
+        return -1;
+    }
+    *value = l;
+    return 0;
+}
+
+/* Set '*value' from [ingest.validator] key 'name', if it was configured.
+ * The value must be a positive integer.
+ */
+static int config_count (flux_t *h, json_t *o, const char *name, int *value)
+{
+    json_int_t l;
+
+    if (!o)
+        return 0;
+    if (!json_is_integer (o)
+        || (l = json_integer_value (o)) <= 0
+        || l > INT_MAX) {
+        flux_log (h, LOG_ERR,
+                  "ingest.validator %s must be a positive integer",
+                  name);
+        errno = EINVAL;
+        return -1;
+    }
+    *value = l;
+    return 0;
+}
+
 int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
                          flux_t *h,
                          int argc,
@@ -892,14 +932,40 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
     flux_reactor_t *r = flux_get_reactor (h);
     const char *usage_message =
         "Usage: flux module load [OPTIONS] job-ingest"
-        " [validator-plugins=LIST] [validator-args=ARGS]";
+        " [validator-native=NAME]"
+        " [validator-plugins=LIST] [validator-args=ARGS]"
+        " [validator-max-workers=N] [validator-batch-size=N]";
+    const char *native = NULL;
     const char *plugins = NULL;
     const char *valargs = NULL;
+    int max_workers = 0;
+    int batch_size = 0;
+    json_t *max_workers_o = NULL;
+    json_t *batch_size_o = NULL;
     bool use_validator = true;
+    flux_conf_error_t err;
 
     memset (ctx, 0, sizeof (*ctx));
     ctx->h = h;
 
+    /*  Process [ingest] config.  Module args override config file.
+     */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?{s?{s?o s?o !}}}",
+                          "ingest",
+                            "validator",
+                              "max-workers", &max_workers_o,
+                              "batch-size", &batch_size_o) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading ingest config: %s",
+                  err.errbuf);
+        return -1;
+    }
+    if (config_count (h, max_workers_o, "max-workers", &max_workers) < 0
+        || config_count (h, batch_size_o, "batch-size", &batch_size) < 0)
+        return -1;
+
     /*  Process cmdline args */
     for (int i = 0; i < argc; i++) {
         if (!strncmp (argv[i], "validator-args=", 15)) {
@@ -908,6 +974,17 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
         else if (!strncmp (argv[i], "validator-plugins=", 18)) {
             plugins = argv[i] + 18;
         }
+        else if (!strncmp (argv[i], "validator-native=", 17)) {
+            native = argv[i] + 17;
+        }
+        else if (!strncmp (argv[i], "validator-max-workers=", 22)) {
+            if (parse_count (h, argv[i], &max_workers) < 0)
+                return -1;
+        }
+        else if (!strncmp (argv[i], "validator-batch-size=", 21)) {
+            if (parse_count (h, argv[i], &batch_size) < 0)
+                return -1;
+        }
         else if (!strncmp (argv[i], "batch-count=", 12)) {
             char *endptr;
             ctx->batch_count = strtol (argv[i]+12, &endptr, 0);
@@ -927,7 +1004,12 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
         }
     }
     if (use_validator &&
-        !(ctx->validate = validate_create (h, plugins, valargs))) {
+        !(ctx->validate = validate_create (h,
+                                           native,
+                                           plugins,
+                                           valargs,
+                                           max_workers,
+                                           batch_size))) {
         flux_log_error (h, "validate_create");
         return -1;
     }
@@ -0,0 +1,416 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec - in-process jobspec validation
+ *
+ * The default checks follow flux.job.validate_jobspec() in the Python
+ * bindings, and use the same error messages, so that users see the same
+ * result whether a job was validated here or by flux-job-validator(1).
+ * The JOBSPEC_REQUIRE_V1 checks follow schemas/jobspec_v1.jsonschema.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "jobspec.h"
+
+struct vctx {
+    int flags;
+    char *errbuf;
+    int errbufsz;
+};
+
+static int invalid (struct vctx *v, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (v->errbuf) {
+        va_start (ap, fmt);
+        (void)vsnprintf (v->errbuf, v->errbufsz, fmt, ap);
+        va_end (ap);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+static bool key_in (const char *key, const char **keys)
+{
+    for (int i = 0; keys[i] != NULL; i++) {
+        if (!strcmp (key, keys[i]))
+            return true;
+    }
+    return false;
+}
+
+/* Like _validate_keys() in the Python bindings: unless 'optional',
+ * all 'keys' must be present, and unless 'allow_additional', no other
+ * keys may be present.
+ */
+static int check_keys (struct vctx *v,
+                       json_t *o,
+                       const char **keys,
+                       bool optional,
+                       bool allow_additional)
+{
+    const char *key;
+    json_t *value;
+
+    if (!optional) {
+        for (int i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i]))
+                return invalid (v, "Missing key (%s)", keys[i]);
+        }
+    }
+    if (!allow_additional) {
+        json_object_foreach (o, key, value) {
+            if (!key_in (key, keys))
+                return invalid (v, "Extraneous key (%s)", key);
+        }
+    }
+    return 0;
+}
+
+static int check_range (struct vctx *v, json_t *count)
+{
+    static const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    static const char *intkeys[] = { "min", "max", "operand", NULL };
+    json_t *o;
+
+    if (!json_object_get (count, "min"))
+        return invalid (v, "min must be in range");
+    if (json_object_size (count) > 1
+        && check_keys (v, count, keys, false, false) < 0)
+        return -1;
+    for (int i = 0; intkeys[i] != NULL; i++) {
+        if (!(o = json_object_get (count, intkeys[i])))
+            continue;
+        if (!json_is_integer (o))
+            return invalid (v, "%s must be an int", intkeys[i]);
+        if (json_integer_value (o) < 1)
+            return invalid (v, "%s must be > 0", intkeys[i]);
+    }
+    if ((o = json_object_get (count, "operator"))) {
+        const char *op = json_string_value (o);
+        if (!op || (strcmp (op, "+") && strcmp (op, "*") && strcmp (op, "^")))
+            return invalid (v, "operator must be one of ['+', '*', '^']");
+    }
+    return 0;
+}
+
+/* Check resource vertex 'res' and its children.
+ */
+static int check_resource (struct vctx *v, json_t *res)
+{
+    static const char *strkeys[] = { "id", "unit", "label", NULL };
+    json_t *type;
+    json_t *count;
+    json_t *o;
+    size_t index;
+    json_t *child;
+
+    if (!json_is_object (res))
+        return invalid (v, "resource must be a mapping");
+    if (!(type = json_object_get (res, "type")))
+        return invalid (v, "type is a required key for resources");
+    if (!json_is_string (type))
+        return invalid (v, "type must be a string");
+    if (!(count = json_object_get (res, "count")))
+        return invalid (v, "count is a required key for resources");
+    if (json_is_object (count)) {
+        if (check_range (v, count) < 0)
+            return -1;
+    }
+    else if (!json_is_integer (count))
+        return invalid (v, "count must be an int or mapping");
+    else if (json_integer_value (count) < 1)
+        return invalid (v, "count must be > 0");
+    for (int i = 0; strkeys[i] != NULL; i++) {
+        if ((o = json_object_get (res, strkeys[i])) && !json_is_string (o))
+            return invalid (v, "%s must be a string", strkeys[i]);
+    }
+    if ((o = json_object_get (res, "exclusive")) && !json_is_boolean (o))
+        return invalid (v, "exclusive must be a boolean");
+    if (!strcmp (json_string_value (type), "slot")
+        && !json_object_get (res, "label"))
+        return invalid (v, "slots must have labels");
+    if ((o = json_object_get (res, "with"))) {
+        if (!json_is_array (o))
+            return invalid (v, "with must be a sequence");
+        json_array_foreach (o, index, child) {
+            if (check_resource (v, child) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int check_task (struct vctx *v, json_t *task)
+{
+    static const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *command;
+    json_t *o;
+    size_t index;
+    json_t *arg;
+
+    if (!json_is_object (task))
+        return invalid (v, "task must be a mapping");
+    if (check_keys (v, task, keys, false, true) < 0)
+        return -1;
+    if (!json_is_object (json_object_get (task, "count")))
+        return invalid (v, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return invalid (v, "slot must be a string");
+    if ((o = json_object_get (task, "attributes")) && !json_is_object (o))
+        return invalid (v, "attributes must be a mapping");
+    command = json_object_get (task, "command");
+    if (json_is_array (command) && json_array_size (command) == 0)
+        return invalid (v, "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return invalid (v, "command must be a list of strings");
+    json_array_foreach (command, index, arg) {
+        if (!json_is_string (arg))
+            return invalid (v, "command must be a list of strings");
+    }
+    return 0;
+}
+
+/* Version 1 requires attributes.system.duration.
+ */
+static int check_v1_attributes (struct vctx *v, json_t *attributes)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return invalid (v, "attributes.system is a required key");
+    if (!json_is_object (system))
+        return invalid (v, "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return invalid (v, "attributes.system.duration is a required key");
+    if (!json_is_number (duration))
+        return invalid (v, "attributes.system.duration must be a number");
+    return 0;
+}
+
+/* Check that 'o' is an integer >= 1, as required of counts in
+ * the version 1 schema.
+ */
+static int check_v1_count (struct vctx *v, json_t *o, const char *name)
+{
+    if (!json_is_integer (o) || json_integer_value (o) < 1)
+        return invalid (v, "%s must be an integer >= 1", name);
+    return 0;
+}
+
+/* Check the keys common to all version 1 resource vertices.
+ */
+static int check_v1_vertex (struct vctx *v,
+                            json_t *res,
+                            const char **keys,
+                            const char *type)
+{
+    json_t *o;
+
+    if (!json_is_object (res))
+        return invalid (v, "resource must be a mapping");
+    if (check_keys (v, res, keys, true, false) < 0)
+        return -1;
+    if (!json_object_get (res, "type") || !json_object_get (res, "count"))
+        return invalid (v, "%s requires type and count", type);
+    if (check_v1_count (v, json_object_get (res, "count"), "count") < 0)
+        return -1;
+    if ((o = json_object_get (res, "unit")) && !json_is_string (o))
+        return invalid (v, "unit must be a string");
+    return 0;
+}
+
+static int check_v1_intranode (struct vctx *v, json_t *res)
+{
+    static const char *keys[] = { "type", "count", "unit", NULL };
+    const char *type;
+
+    if (check_v1_vertex (v, res, keys, "core or gpu") < 0)
+        return -1;
+    type = json_string_value (json_object_get (res, "type"));
+    if (!type || (strcmp (type, "core") && strcmp (type, "gpu")))
+        return invalid (v, "slot may contain only core and gpu resources");
+    return 0;
+}
+
+static int check_v1_slot (struct vctx *v, json_t *res)
+{
+    static const char *keys[] = {
+        "type", "count", "unit", "label", "exclusive", "with", NULL
+    };
+    json_t *with;
+    json_t *o;
+    size_t index;
+    json_t *child;
+
+    if (check_v1_vertex (v, res, keys, "slot") < 0)
+        return -1;
+    if (!json_is_string (json_object_get (res, "label")))
+        return invalid (v, "slot label must be a string");
+    if ((o = json_object_get (res, "exclusive")) && !json_is_boolean (o))
+        return invalid (v, "exclusive must be a boolean");
+    with = json_object_get (res, "with");
+    if (!json_is_array (with)
+        || json_array_size (with) < 1
+        || json_array_size (with) > 2)
+        return invalid (v, "slot must contain one or two resources");
+    json_array_foreach (with, index, child) {
+        if (check_v1_intranode (v, child) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int check_v1_node (struct vctx *v, json_t *res)
+{
+    static const char *keys[] = { "type", "count", "unit", "with", NULL };
+    json_t *with;
+    const char *type;
+
+    if (check_v1_vertex (v, res, keys, "node") < 0)
+        return -1;
+    with = json_object_get (res, "with");
+    if (!json_is_array (with) || json_array_size (with) != 1)
+        return invalid (v, "node must contain exactly one slot");
+    type = json_string_value (json_object_get (json_array_get (with, 0),
+                                               "type"));
+    if (!type || strcmp (type, "slot"))
+        return invalid (v, "node may contain only a slot");
+    return check_v1_slot (v, json_array_get (with, 0));
+}
+
+static int check_v1_schema (struct vctx *v, json_t *jobspec)
+{
+    static const char *attr_keys[] = { "system", "user", NULL };
+    json_t *resources = json_object_get (jobspec, "resources");
+    json_t *attributes = json_object_get (jobspec, "attributes");
+    json_t *tasks = json_object_get (jobspec, "tasks");
+    json_t *system;
+    json_t *o;
+    const char *type;
+
+    if (json_integer_value (json_object_get (jobspec, "version")) != 1)
+        return invalid (v, "jobspec version must be 1");
+
+    if (json_array_size (resources) != 1)
+        return invalid (v, "resources must contain exactly one resource");
+    type = json_string_value (json_object_get (json_array_get (resources, 0),
+                                               "type"));
+    if (type && !strcmp (type, "node")) {
+        if (check_v1_node (v, json_array_get (resources, 0)) < 0)
+            return -1;
+    }
+    else if (type && !strcmp (type, "slot")) {
+        if (check_v1_slot (v, json_array_get (resources, 0)) < 0)
+            return -1;
+    }
+    else
+        return invalid (v, "top level resource must be node or slot");
+
+    if (check_keys (v, attributes, attr_keys, true, false) < 0)
+        return -1;
+    system = json_object_get (attributes, "system");
+    if (json_number_value (json_object_get (system, "duration")) < 0)
+        return invalid (v, "attributes.system.duration must be >= 0");
+    if ((o = json_object_get (system, "cwd")) && !json_is_string (o))
+        return invalid (v, "attributes.system.cwd must be a string");
+    if ((o = json_object_get (system, "environment")) && !json_is_object (o))
+        return invalid (v, "attributes.system.environment must be a mapping");
+    if ((o = json_object_get (attributes, "user")) && !json_is_object (o))
+        return invalid (v, "attributes.user must be a mapping");
+
+    if (json_array_size (tasks) > 1)
+        return invalid (v, "tasks must contain at most one task");
+    if (json_array_size (tasks) == 1) {
+        static const char *task_keys[] = { "command", "slot", "count", NULL };
+        static const char *count_keys[] = { "per_slot", "total", NULL };
+        json_t *task = json_array_get (tasks, 0);
+        json_t *count = json_object_get (task, "count");
+        const char *key;
+        json_t *value;
+
+        if (check_keys (v, task, task_keys, false, false) < 0
+            || check_keys (v, count, count_keys, true, false) < 0)
+            return -1;
+        json_object_foreach (count, key, value) {
+            if (check_v1_count (v, value, key) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+int jobspec_validate (json_t *jobspec, int flags, char *errbuf, int errbufsz)
+{
+    static const char *keys[] = {
+        "resources", "tasks", "version", "attributes", NULL
+    };
+    static const char *attr_keys[] = { "system", "user", NULL };
+    struct vctx v = { .flags = flags, .errbuf = errbuf, .errbufsz = errbufsz };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    size_t index;
+    json_t *o;
+
+    if (!json_is_object (jobspec))
+        return invalid (&v, "jobspec must be a mapping");
+    if (check_keys (&v, jobspec, keys, false, false) < 0)
+        return -1;
+    resources = json_object_get (jobspec, "resources");
+    tasks = json_object_get (jobspec, "tasks");
+    version = json_object_get (jobspec, "version");
+    attributes = json_object_get (jobspec, "attributes");
+
+    if (!json_is_array (resources))
+        return invalid (&v, "resources must be a sequence");
+    if (!json_is_array (tasks))
+        return invalid (&v, "tasks must be a sequence");
+    if (!json_is_integer (version))
+        return invalid (&v, "version must be an integer");
+    if (!json_is_object (attributes))
+        return invalid (&v, "attributes must be a mapping");
+    if (json_integer_value (version) < 1)
+        return invalid (&v, "version must be >= 1");
+
+    json_array_foreach (resources, index, o) {
+        if (check_resource (&v, o) < 0)
+            return -1;
+    }
+    json_array_foreach (tasks, index, o) {
+        if (check_task (&v, o) < 0)
+            return -1;
+    }
+    if (check_keys (&v, attributes, attr_keys, true, false) < 0)
+        return -1;
+    if (json_integer_value (version) == 1
+        && check_v1_attributes (&v, attributes) < 0)
+        return -1;
+
+    if ((flags & JOBSPEC_REQUIRE_V1) && check_v1_schema (&v, jobspec) < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,44 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_JOBSPEC_H
+#define _JOB_INGEST_JOBSPEC_H
+
+#include <jansson.h>
+
+enum {
+    /* Require jobspec to conform to schemas/jobspec_v1.jsonschema.
+     */
+    JOBSPEC_REQUIRE_V1 = 1,
+};
+
+/* Validate jobspec in-process.
+ *
+ * By default, check the canonical jobspec structure of RFC 14, plus the
+ * attributes required of version 1 jobspec if version is 1.  This matches
+ * the 'jobspec' plugin of flux-job-validator(1).
+ *
+ * With JOBSPEC_REQUIRE_V1, additionally require that jobspec conform to
+ * the version 1 schema: one node or slot at the top level, slots containing
+ * only cores and gpus, at most one task, and no unknown keys.
+ *
+ * Returns 0 if valid.  On failure, returns -1 with errno set to EINVAL and
+ * a reason suitable for the submitting user in 'errbuf'.
+ */
+int jobspec_validate (json_t *jobspec,
+                      int flags,
+                      char *errbuf,
+                      int errbufsz);
+
+#endif /* !_JOB_INGEST_JOBSPEC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,246 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+
+#include "jobspec.h"
+
+/* Jobspec fragments are combined as "{version, resources, tasks,
+ * attributes}" so each test case only needs to spell out what differs.
+ */
+#define RES_SLOT \
+    "[{\"type\":\"slot\",\"count\":1,\"label\":\"foo\"," \
+    "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define RES_NODE \
+    "[{\"type\":\"node\",\"count\":4,\"with\":[{\"type\":\"slot\"," \
+    "\"count\":1,\"label\":\"foo\",\"with\":[{\"type\":\"core\"," \
+    "\"count\":2},{\"type\":\"gpu\",\"count\":1}]}]}]"
+#define TASKS \
+    "[{\"command\":[\"app\"],\"slot\":\"foo\",\"count\":{\"per_slot\":1}}]"
+#define ATTRS \
+    "{\"system\":{\"duration\":3600.0,\"cwd\":\"/home/flux\"}}"
+
+struct testcase {
+    const char *desc;
+    int version;
+    const char *resources;
+    const char *tasks;
+    const char *attributes;
+    const char *error;      // NULL if valid
+};
+
+static struct testcase tests[] = {
+    { "v1 slot>core", 1, RES_SLOT, TASKS, ATTRS, NULL },
+    { "v1 node>slot>core,gpu", 1, RES_NODE, TASKS, ATTRS, NULL },
+    { "v1 slot>node", 1,
+      "[{\"type\":\"slot\",\"count\":4,\"label\":\"foo\","
+      "\"with\":[{\"type\":\"node\",\"count\":1}]}]",
+      TASKS, ATTRS, NULL },
+    { "v999 with range count and memory", 999,
+      "[{\"type\":\"slot\",\"label\":\"foo\","
+      "\"count\":{\"min\":1,\"max\":4,\"operator\":\"+\",\"operand\":1},"
+      "\"with\":[{\"type\":\"memory\",\"count\":{\"min\":4},\"unit\":\"GB\"}]}]",
+      TASKS, "{}", NULL },
+    { "v999 with user attributes", 999, RES_SLOT, TASKS,
+      "{\"user\":{\"a\":1}}", NULL },
+    { "version 0", 0, RES_SLOT, TASKS, ATTRS, "version must be >= 1" },
+    { "resources not a sequence", 1,
+      "{\"type\":\"slot\"}", TASKS, ATTRS, "resources must be a sequence" },
+    { "tasks not a sequence", 1,
+      RES_SLOT, "{}", ATTRS, "tasks must be a sequence" },
+    { "attributes not a mapping", 1,
+      RES_SLOT, TASKS, "1", "attributes must be a mapping" },
+    { "attributes null", 1,
+      RES_SLOT, TASKS, "null", "attributes must be a mapping" },
+    { "extra attribute", 1, RES_SLOT, TASKS,
+      "{\"system\":{\"duration\":1},\"foo\":1}", "Extraneous key (foo)" },
+    { "v1 missing system", 1, RES_SLOT, TASKS,
+      "{}", "attributes.system is a required key" },
+    { "v1 missing duration", 1, RES_SLOT, TASKS,
+      "{\"system\":{}}", "attributes.system.duration is a required key" },
+    { "v1 string duration", 1, RES_SLOT, TASKS,
+      "{\"system\":{\"duration\":\"1h\"}}",
+      "attributes.system.duration must be a number" },
+    { "resource not a mapping", 1,
+      "[[{\"type\":\"slot\"}]]", TASKS, ATTRS, "resource must be a mapping" },
+    { "resource missing type", 1,
+      "[{\"count\":1}]", TASKS, ATTRS, "type is a required key for resources" },
+    { "child resource missing count", 1,
+      "[{\"type\":\"slot\",\"count\":1,\"label\":\"foo\","
+      "\"with\":[{\"type\":\"node\"}]}]",
+      TASKS, ATTRS, "count is a required key for resources" },
+    { "count is a string", 1,
+      "[{\"type\":\"node\",\"count\":\"bar\"}]", TASKS, ATTRS,
+      "count must be an int or mapping" },
+    { "count is zero", 1,
+      "[{\"type\":\"node\",\"count\":0}]", TASKS, ATTRS, "count must be > 0" },
+    { "range missing min", 1,
+      "[{\"type\":\"node\",\"count\":{\"max\":2}}]", TASKS, ATTRS,
+      "min must be in range" },
+    { "range missing operand", 1,
+      "[{\"type\":\"node\",\"count\":{\"min\":1,\"max\":2,\"operator\":\"+\"}}]",
+      TASKS, ATTRS, "Missing key (operand)" },
+    { "range bad operator", 1,
+      "[{\"type\":\"node\",\"count\":{\"min\":1,\"max\":2,\"operator\":\"-\","
+      "\"operand\":1}}]",
+      TASKS, ATTRS, "operator must be one of ['+', '*', '^']" },
+    { "label not a string", 1,
+      "[{\"type\":\"slot\",\"count\":1,\"label\":[\"a\"]}]", TASKS, ATTRS,
+      "label must be a string" },
+    { "exclusive not a boolean", 1,
+      "[{\"type\":\"node\",\"count\":1,\"exclusive\":\"blah\"}]", TASKS, ATTRS,
+      "exclusive must be a boolean" },
+    { "slot without label", 1,
+      "[{\"type\":\"slot\",\"count\":1}]", TASKS, ATTRS,
+      "slots must have labels" },
+    { "task not a mapping", 1, RES_SLOT, "[1]", ATTRS,
+      "task must be a mapping" },
+    { "task missing slot", 1, RES_SLOT,
+      "[{\"command\":[\"app\"],\"count\":{\"per_slot\":1}}]", ATTRS,
+      "Missing key (slot)" },
+    { "task count not a mapping", 1, RES_SLOT,
+      "[{\"command\":[\"app\"],\"slot\":\"foo\",\"count\":1}]", ATTRS,
+      "count must be a mapping" },
+    { "task command not an array", 1, RES_SLOT,
+      "[{\"command\":\"app\",\"slot\":\"foo\",\"count\":{\"per_slot\":1}}]",
+      ATTRS, "command must be a list of strings" },
+    { "task command empty", 1, RES_SLOT,
+      "[{\"command\":[],\"slot\":\"foo\",\"count\":{\"per_slot\":1}}]",
+      ATTRS, "command array cannot have length of zero" },
+};
+
+static struct testcase v1_tests[] = {
+    { "v1 slot>core", 1, RES_SLOT, TASKS, ATTRS, NULL },
+    { "v1 node>slot>core,gpu", 1, RES_NODE, TASKS, ATTRS, NULL },
+    { "v999", 999, RES_SLOT, TASKS, ATTRS, "jobspec version must be 1" },
+    { "slot>node", 1,
+      "[{\"type\":\"slot\",\"count\":4,\"label\":\"foo\","
+      "\"with\":[{\"type\":\"node\",\"count\":1}]}]",
+      TASKS, ATTRS, "slot may contain only core and gpu resources" },
+    { "node without slot", 1,
+      "[{\"type\":\"node\",\"count\":1}]",
+      TASKS, ATTRS, "node must contain exactly one slot" },
+    { "two top level resources", 1,
+      "[{\"type\":\"slot\",\"count\":1,\"label\":\"foo\","
+      "\"with\":[{\"type\":\"core\",\"count\":1}]},"
+      "{\"type\":\"slot\",\"count\":1,\"label\":\"bar\","
+      "\"with\":[{\"type\":\"core\",\"count\":1}]}]",
+      TASKS, ATTRS, "resources must contain exactly one resource" },
+    { "core with child", 1,
+      "[{\"type\":\"slot\",\"count\":1,\"label\":\"foo\","
+      "\"with\":[{\"type\":\"core\",\"count\":1,\"with\":[]}]}]",
+      TASKS, ATTRS, "Extraneous key (with)" },
+    { "range count", 1,
+      "[{\"type\":\"slot\",\"count\":{\"min\":1},\"label\":\"foo\","
+      "\"with\":[{\"type\":\"core\",\"count\":1}]}]",
+      TASKS, ATTRS, "count must be an integer >= 1" },
+    { "negative duration", 1, RES_SLOT, TASKS,
+      "{\"system\":{\"duration\":-1}}",
+      "attributes.system.duration must be >= 0" },
+    { "two tasks", 1, RES_SLOT,
+      "[{\"command\":[\"a\"],\"slot\":\"foo\",\"count\":{\"per_slot\":1}},"
+      "{\"command\":[\"b\"],\"slot\":\"foo\",\"count\":{\"per_slot\":1}}]",
+      ATTRS, "tasks must contain at most one task" },
+    { "task count unknown key", 1, RES_SLOT,
+      "[{\"command\":[\"a\"],\"slot\":\"foo\",\"count\":{\"per_node\":1}}]",
+      ATTRS, "Extraneous key (per_node)" },
+};
+
+static void run_tests (struct testcase *tc, int count, int flags)
+{
+    for (int i = 0; i < count; i++) {
+        char s[4096];
+        char errbuf[256] = "";
+        json_t *jobspec;
+        json_error_t error;
+        int rc;
+
+        snprintf (s, sizeof (s),
+                  "{\"version\":%d,\"resources\":%s,"
+                  "\"tasks\":%s,\"attributes\":%s}",
+                  tc[i].version,
+                  tc[i].resources,
+                  tc[i].tasks,
+                  tc[i].attributes);
+        if (!(jobspec = json_loads (s, 0, &error)))
+            BAIL_OUT ("%s: %s", tc[i].desc, error.text);
+        errno = 0;
+        rc = jobspec_validate (jobspec, flags, errbuf, sizeof (errbuf));
+        if (tc[i].error) {
+            ok (rc < 0 && errno == EINVAL && !strcmp (errbuf, tc[i].error),
+                "%s: %s", tc[i].desc, tc[i].error);
+            if (strcmp (errbuf, tc[i].error))
+                diag ("got: %s", errbuf);
+        }
+        else {
+            ok (rc == 0,
+                "%s: valid", tc[i].desc);
+            if (rc < 0)
+                diag ("got: %s", errbuf);
+        }
+        json_decref (jobspec);
+    }
+}
+
+static void test_toplevel (void)
+{
+    char errbuf[256];
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:[] s:[] s:{}}",
+                         "version", 1,
+                         "resources",
+                         "tasks",
+                         "attributes")))
+        BAIL_OUT ("json_pack failed");
+    ok (jobspec_validate (o, 0, NULL, 0) < 0 && errno == EINVAL,
+        "jobspec_validate works with NULL errbuf");
+    json_object_del (o, "tasks");
+    ok (jobspec_validate (o, 0, errbuf, sizeof (errbuf)) < 0
+        && !strcmp (errbuf, "Missing key (tasks)"),
+        "missing tasks fails with Missing key (tasks)");
+    json_object_set_new (o, "tasks", json_array ());
+    json_object_set_new (o, "foo", json_true ());
+    ok (jobspec_validate (o, 0, errbuf, sizeof (errbuf)) < 0
+        && !strcmp (errbuf, "Extraneous key (foo)"),
+        "unknown top level key fails with Extraneous key (foo)");
+    json_decref (o);
+
+    o = json_string ("foo");
+    ok (jobspec_validate (o, 0, errbuf, sizeof (errbuf)) < 0
+        && !strcmp (errbuf, "jobspec must be a mapping"),
+        "non-object jobspec fails");
+    json_decref (o);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_toplevel ();
+    run_tests (tests, sizeof (tests) / sizeof (tests[0]), 0);
+    run_tests (v1_tests,
+               sizeof (v1_tests) / sizeof (v1_tests[0]),
+               JOBSPEC_REQUIRE_V1);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -10,9 +10,15 @@
 
 /* validate - asynchronous job validation interface
  *
- * Spawn worker(s) to validate job.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * Jobspec is first checked in-process by the native validator, if enabled
+ * (see jobspec.h).  Jobs that pass are then sent to external validator
+ * workers, if any plugins or plugin arguments were configured, for
+ * site-specific checks.
+ *
+ * Spawn worker(s) to validate job.  Up to 'max_workers' (default: the
+ * number of online CPUs) workers may be active at one time.  They are
+ * started lazily, on demand, and stop after a period of inactivity (see
+ * "tunables" below).
  *
  * Jobspec is expected to be in encoded JSON form, with or without
  * whitespace or NULL termination.  The encoding is normalized before
@@ -28,6 +34,8 @@
 #include "config.h"
 #endif
 #include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
 #include <argz.h>
 #include <jansson.h>
 #include <assert.h>
@@ -38,17 +46,16 @@
 
 #include "validate.h"
 #include "worker.h"
+#include "jobspec.h"
 
 /* Tunables:
  */
 
-/* The maximum number of concurrent workers.
- */
-#define MAX_WORKER_COUNT 4
-
-/* Start a new worker if backlog reaches this level for all active workers.
+/* The default number of requests written to a busy worker at once.
+ * A new worker is started if backlog reaches this level for all active
+ * workers.
  */
-const int worker_queue_threshold = 32;
+const int default_batch_size = 32;
 
 /* Workers exit once they have been inactive for this many seconds.
  */
@@ -58,7 +65,11 @@ const double worker_inactivity_timeout = 5.0;
 
 struct validate {
     flux_t *h;
-    struct worker *worker[MAX_WORKER_COUNT];
+    bool native;
+    int native_flags;
+    int batch_size;
+    int worker_count;       // 0 if no external workers
+    struct worker **worker;
 };
 
 static void validate_killall (struct validate *v)
@@ -67,14 +78,14 @@ static void validate_killall (struct validate *v)
     flux_future_t *f;
     int i;
 
-    if (v == NULL)
+    if (v == NULL || v->worker_count == 0)
         return;
     if (!(cf = flux_future_wait_all_create ())) {
         flux_log_error (v->h, "validate_destroy: flux_future_wait_all_create");
         return;
     }
     flux_future_set_flux (cf, v->h);
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if ((f = worker_kill (v->worker[i], SIGKILL)))
             flux_future_push (cf, NULL, f);
     }
@@ -98,7 +109,7 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
         return 0;
 
     count = 0;
-    for (i = 0; i < MAX_WORKER_COUNT; i++)
+    for (i = 0; i < v->worker_count; i++)
         count += worker_stop_notify (v->worker[i], cb, arg);
     return count;
 }
@@ -109,8 +120,9 @@ void validate_destroy (struct validate *v)
         int saved_errno = errno;
         int i;
         validate_killall (v);
-        for (i = 0; i < MAX_WORKER_COUNT; i++)
+        for (i = 0; i < v->worker_count; i++)
             worker_destroy (v->worker[i]);
+        free (v->worker);
         free (v);
         errno = saved_errno;
     }
@@ -142,9 +154,36 @@ error:
     return -1;
 }
 
+static int parse_native (struct validate *v, const char *name)
+{
+    if (!strcmp (name, "jobspec"))
+        v->native = true;
+    else if (!strcmp (name, "none"))
+        v->native = false;
+    else if (!strcmp (name, "jobspec-v1")) {
+        v->native = true;
+        v->native_flags = JOBSPEC_REQUIRE_V1;
+    }
+    else {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+static int default_max_workers (void)
+{
+    long ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return ncpus > 0 ? ncpus : 1;
+}
+
 struct validate *validate_create (flux_t *h,
+                                  const char *native,
                                   const char *validator_plugins,
-                                  const char *validator_args)
+                                  const char *validator_args,
+                                  int max_workers,
+                                  int batch_size)
 {
     struct validate *v;
     int argc;
@@ -156,6 +195,21 @@ struct validate *validate_create (flux_t *h,
     if (!(v = calloc (1, sizeof (*v))))
         return NULL;
     v->h = h;
+    v->batch_size = batch_size > 0 ? batch_size : default_batch_size;
+    if (max_workers <= 0)
+        max_workers = default_max_workers ();
+
+    /* The native validator replaces the default 'jobspec' plugin, so
+     * unless requested, it only runs when no plugins are configured.
+     */
+    if (!native)
+        native = validator_plugins || validator_args ? "none" : "jobspec";
+    if (parse_native (v, native) < 0) {
+        flux_log (h, LOG_ERR, "unknown native validator: %s", native);
+        goto error;
+    }
+    if (!validator_plugins && !validator_args)
+        return v;
 
     if (validator_argz_create (&argz,
                                &argz_len,
@@ -170,14 +224,18 @@ struct validate *validate_create (flux_t *h,
     }
     argz_extract (argz, argz_len, argv);
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    if (!(v->worker = calloc (max_workers, sizeof (v->worker[0]))))
+        goto error;
+    for (i = 0; i < max_workers; i++) {
         char name[256];
         (void) snprintf (name, sizeof (name), "validator[%d]", i);
         if (!(v->worker[i] = worker_create (h,
                                             worker_inactivity_timeout,
                                             name,
+                                            v->batch_size,
                                             argc, argv)))
             goto error;
+        v->worker_count++;
     }
     free (argv);
     free (argz);
@@ -198,7 +256,7 @@ struct worker *select_best_worker (struct validate *v)
     struct worker *idle = NULL;
     int i;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if (worker_is_running (v->worker[i])) {
             if (!best || (worker_queue_depth (v->worker[i])
                         < worker_queue_depth (best)))
@@ -207,21 +265,53 @@ struct worker *select_best_worker (struct validate *v)
         else if (!idle)
             idle = v->worker[i];
     }
-    if (idle && (!best || worker_queue_depth (best) >= worker_queue_threshold))
+    if (idle && (!best || worker_queue_depth (best) >= v->batch_size))
         best = idle;
 
     return best;
 }
 
-/* Re-encode job info in compact form to eliminate any white space (esp \n),
- * then pass it to least busy validation worker, returning a future.
+/* Return a future that is already fulfilled with the result of
+ * in-process validation.
+ */
+static flux_future_t *validate_result (struct validate *v,
+                                       int errnum,
+                                       const char *errstr)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if (errnum)
+        flux_future_fulfill_error (f, errnum, errstr);
+    else
+        flux_future_fulfill (f, NULL, NULL);
+    return f;
+}
+
+/* Check jobspec with the native validator, if enabled.  If it passes and
+ * there are external workers, re-encode job info in compact form to
+ * eliminate any white space (esp \n), then pass it to least busy validation
+ * worker, returning a future.
  */
 flux_future_t *validate_job (struct validate *v, json_t *job)
 {
     flux_future_t *f;
-    char *s;
+    char *s = NULL;
     struct worker *w;
 
+    if (v->native) {
+        char errbuf[256];
+
+        if (jobspec_validate (json_object_get (job, "jobspec"),
+                              v->native_flags,
+                              errbuf,
+                              sizeof (errbuf)) < 0)
+            return validate_result (v, errno, errbuf);
+    }
+    if (v->worker_count == 0)
+        return validate_result (v, 0, NULL);
     if (!(s = json_dumps (job, JSON_COMPACT))) {
         errno = ENOMEM;
         goto error;
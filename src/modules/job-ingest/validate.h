@@ -28,9 +28,20 @@ flux_future_t *validate_job (struct validate *v, json_t *job);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Create validation context.  'native' selects the in-process validator:
+ * "jobspec", "jobspec-v1", or "none".  If NULL, it is "jobspec" when
+ * neither 'validator_plugins' nor 'validator_args' is set, and "none"
+ * otherwise.  External validator workers are only used if
+ * 'validator_plugins' or 'validator_args' is set.  Up to 'max_workers'
+ * workers are started as load increases, each receiving up to
+ * 'batch_size' jobs at a time.  Either may be 0 to select the default.
+ */
 struct validate *validate_create (flux_t *h,
+                                  const char *native,
                                   const char *validator_plugins,
-                                  const char *validator_args);
+                                  const char *validator_args,
+                                  int max_workers,
+                                  int batch_size);
 
 void validate_destroy (struct validate *v);
 
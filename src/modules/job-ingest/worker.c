@@ -29,6 +29,13 @@
  * a queue of futures, and each time a result is received, the future at
  * the head of queue is fulfilled.
  *
+ * Work submitted while earlier requests are still in flight is batched:
+ * lines are appended to a buffer that is written to the coprocess in one
+ * go once all in-flight results have been received, or once 'batch_size'
+ * lines have accumulated.  An idle worker gets new work immediately, so
+ * batching only adds latency when the worker is already busy, and under
+ * load the coprocess can read and answer many lines per system call.
+ *
  * The broker exec service is used to spawn workers on the local rank,
  * using the libsubprocess API.
  *
@@ -58,6 +65,12 @@ struct worker {
     flux_subprocess_t *p;
     flux_cmd_t *cmd;
     zlist_t *queue; // queue of futures (head is currently running)
+    int inflight;   // count of queued requests written to the coprocess
+    char *batch;    // unwritten requests, newline terminated
+    size_t batch_len;
+    size_t batch_alloc;
+    int batch_count;
+    int batch_size;
     flux_watcher_t *timer;
     double inactivity_timeout;
     zlist_t *trash;
@@ -201,11 +214,63 @@ static void worker_unexpected_exit (struct worker *w)
         worker_fulfill_future (w, f, json_err);
         flux_future_decref (f);
     }
+    w->inflight = 0;
+    w->batch_len = 0;
+    w->batch_count = 0;
+}
+
+/* Write batched requests to the coprocess.  On failure, fail the
+ * requests in the batch, which are at the tail of the queue.
+ */
+static void worker_flush (struct worker *w)
+{
+    if (w->batch_count == 0)
+        return;
+    if (flux_subprocess_write (w->p,
+                               "stdin",
+                               w->batch,
+                               w->batch_len) != w->batch_len) {
+        int errnum = errno;
+        flux_log_error (w->h, "%s: flux_subprocess_write", w->name);
+        while (w->batch_count > 0) {
+            flux_future_t *f = zlist_tail (w->queue);
+            zlist_remove (w->queue, f);
+            flux_future_fulfill_error (f, errnum, NULL);
+            flux_future_decref (f);
+            w->batch_count--;
+        }
+    }
+    w->inflight += w->batch_count;
+    w->batch_len = 0;
+    w->batch_count = 0;
+}
+
+/* Fulfill the future at the head of the queue with result 's'.
+ */
+static void worker_result (struct worker *w, const char *s)
+{
+    flux_future_t *f;
+
+    if (w->inflight == 0 || !(f = zlist_pop (w->queue))) {
+        flux_log (w->h, LOG_ERR, "%s: dropping orphan response: '%s'",
+                  w->name, s);
+        return;
+    }
+    w->inflight--;
+    worker_fulfill_future (w, f, s);
+    flux_future_decref (f);
+    if (zlist_size (w->queue) == 0)
+        worker_inactive (w);
+    else if (w->inflight == 0)
+        worker_flush (w);
 }
 
 /* Subprocess output available
  * stderr is logged
- * stdout fulfills future at the top of the worker's queue.
+ * stdout fulfills futures at the top of the worker's queue, one per line.
+ * Consume all available lines so that a batch of results is handled in
+ * one callback.  Since lines may have been consumed by an earlier
+ * callback, a zero length read means EOF only if the stream is closed.
  */
 static void worker_output_cb (flux_subprocess_t *p, const char *stream)
 {
@@ -213,11 +278,19 @@ static void worker_output_cb (flux_subprocess_t *p, const char *stream)
     const char *s;
     int len;
 
-    if (!(s = flux_subprocess_read_trimmed_line (p, stream, &len))) {
-        flux_log_error (w->h, "%s: subprocess_read_trimmed_line", w->name);
-        return;
+    for (;;) {
+        if (!(s = flux_subprocess_read_trimmed_line (p, stream, &len))) {
+            flux_log_error (w->h, "%s: subprocess_read_trimmed_line", w->name);
+            return;
+        }
+        if (len == 0)
+            break;
+        if (!strcmp (stream, "stdout"))
+            worker_result (w, s);
+        else if (!strcmp (stream, "stderr"))
+            flux_log (w->h, LOG_DEBUG, "%s: %s", w->name, s);
     }
-    if (len == 0) {
+    if (flux_subprocess_read_stream_closed (p, stream) > 0) {
         /* EOF - If p is the current worker and there are still responses
          * queued, fail them all, otherwise, just return. Other cleanup
          * handled in exit callback.
@@ -234,23 +307,6 @@ static void worker_output_cb (flux_subprocess_t *p, const char *stream)
             !strcmp (stream, "stdout") &&
             worker_queue_depth (w) > 0)
             worker_unexpected_exit (w);
-        return;
-    }
-    if (!strcmp (stream, "stdout")) {
-        flux_future_t *f;
-
-        if (!(f = zlist_pop (w->queue))) {
-            flux_log (w->h, LOG_ERR, "%s: dropping orphan response: '%s'",
-                      w->name, s);
-            return;
-        }
-        worker_fulfill_future (w, f, s);
-        flux_future_decref (f);
-        if (zlist_size (w->queue) == 0)
-            worker_inactive (w);
-    }
-    else if (!strcmp (stream, "stderr")) {
-        flux_log (w->h, LOG_DEBUG, "%s: %s", w->name, s ? s : "");
     }
 }
 
@@ -262,10 +318,27 @@ flux_subprocess_ops_t worker_ops = {
     .on_stderr          = worker_output_cb,
 };
 
+/* Ensure the batch buffer has room for 'len' more bytes.
+ */
+static int worker_batch_reserve (struct worker *w, size_t len)
+{
+    if (w->batch_len + len > w->batch_alloc) {
+        size_t size = w->batch_alloc ? w->batch_alloc : 4096;
+        char *batch;
+
+        while (size < w->batch_len + len)
+            size *= 2;
+        if (!(batch = realloc (w->batch, size)))
+            return -1;
+        w->batch = batch;
+        w->batch_alloc = size;
+    }
+    return 0;
+}
+
 flux_future_t *worker_request (struct worker *w, const char *s)
 {
-    int bufsz = strlen (s) + 1;
-    char *buf;
+    size_t len = strlen (s);
     flux_future_t *f;
     int saved_errno;
 
@@ -276,21 +349,23 @@ flux_future_t *worker_request (struct worker *w, const char *s)
     if (!(f = flux_future_create (NULL, NULL)))
         return NULL;
     flux_future_set_flux (f, w->h);
-    if (!(buf = malloc (bufsz)))
-        goto error;
-    memcpy (buf, s, bufsz - 1);
-    buf[bufsz - 1] = '\n';
     worker_active (w);
-    if (flux_subprocess_write (w->p, "stdin", buf, bufsz) != bufsz)
+    if (!w->p)
+        goto error;
+    if (worker_batch_reserve (w, len + 1) < 0)
         goto error;
     if (zlist_append (w->queue, f) < 0)
         goto error;
     flux_future_incref (f); // queue takes a reference on the future
-    free (buf);
+    memcpy (w->batch + w->batch_len, s, len);
+    w->batch[w->batch_len + len] = '\n';
+    w->batch_len += len + 1;
+    w->batch_count++;
+    if (w->inflight == 0 || w->batch_count >= w->batch_size)
+        worker_flush (w);
     return f;
 error:
     saved_errno = errno;
-    free (buf);
     flux_future_destroy (f);
     errno = saved_errno;
     return NULL;
@@ -304,6 +379,7 @@ static void worker_stop (struct worker *w)
 {
     if (w->p) {
         int saved_errno = errno;
+        worker_flush (w);
         if (flux_subprocess_close (w->p, "stdin") < 0) {
             flux_log_error (w->h, "%s: flux_subprocess_close", w->name);
             return;
@@ -383,6 +459,7 @@ void worker_destroy (struct worker *w)
             flux_subprocess_destroy (p);
         zlist_destroy (&w->trash);
         flux_watcher_destroy (w->timer);
+        free (w->batch);
         free (w->name);
         free (w);
         errno = saved_errno;
@@ -391,6 +468,7 @@ void worker_destroy (struct worker *w)
 
 struct worker *worker_create (flux_t *h, double inactivity_timeout,
                               const char *name,
+                              int batch_size,
                               int argc, char **argv)
 {
     struct worker *w;
@@ -401,6 +479,7 @@ struct worker *worker_create (flux_t *h, double inactivity_timeout,
         return NULL;
     w->h = h;
     w->inactivity_timeout = inactivity_timeout;
+    w->batch_size = batch_size > 0 ? batch_size : 1;
     if (!(w->timer = flux_timer_watcher_create (r, inactivity_timeout,
                                                 0., worker_timeout, w)))
         goto error;
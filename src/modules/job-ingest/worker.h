@@ -25,8 +25,13 @@ bool worker_is_running (struct worker *w);
 
 flux_future_t *worker_kill (struct worker *w, int signo);
 void worker_destroy (struct worker *w);
+/* Create a worker that runs the command 'argv' on demand.  Up to
+ * 'batch_size' requests submitted while the worker is busy are written
+ * to it at once.
+ */
 struct worker *worker_create (flux_t *h, double inactivity_timeout,
                               const char *worker_name,
+                              int batch_size,
                               int argc, char **argv);
 
 
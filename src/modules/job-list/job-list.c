@@ -11,9 +11,14 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
 #include <flux/core.h>
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libutil/fsd.h"
 
 #include "job-list.h"
 #include "job_state.h"
@@ -29,14 +34,26 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
     int inactive = zlistx_size (ctx->jsctx->inactive);
     int idsync_lookups = zlistx_size (ctx->idsync_lookups);
     int idsync_waits = zhashx_size (ctx->idsync_waits);
-    if (flux_respond_pack (h, msg, "{s:{s:i s:i s:i} s:{s:i s:i}}",
+    struct spill *spill = ctx->jsctx->spill;
+    if (flux_respond_pack (h, msg,
+                           "{s:{s:i s:i s:i} s:{s:i s:i} s:{s:b s:i s:i}"
+                           " s:{s:i s:f s:i s:I}}",
                            "jobs",
                            "pending", pending,
                            "running", running,
                            "inactive", inactive,
                            "idsync",
                            "lookups", idsync_lookups,
-                           "waits", idsync_waits) < 0) {
+                           "waits", idsync_waits,
+                           "restart",
+                           "complete", ctx->jsctx->restart_complete,
+                           "jobs", ctx->jsctx->restart_jobs,
+                           "lookups", ctx->jsctx->restart_lookups,
+                           "purge",
+                           "num-limit", ctx->jsctx->inactive_num_limit,
+                           "age-limit", ctx->jsctx->inactive_age_limit,
+                           "jobs", spill_count (spill),
+                           "bytes", (json_int_t)spill_size (spill)) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
@@ -100,6 +117,11 @@ static const struct flux_msg_handler_spec htab[] = {
       .cb           = job_stats_cb,
       .rolemask     = FLUX_ROLE_USER
     },
+    { .typemask     = FLUX_MSGTYPE_REQUEST,
+      .topic_glob   = "job-list.disconnect",
+      .cb           = list_disconnect_cb,
+      .rolemask     = FLUX_ROLE_USER
+    },
     { .typemask     = FLUX_MSGTYPE_REQUEST,
       .topic_glob   = "job-list.stats.get",
       .cb           = stats_cb,
@@ -113,6 +135,7 @@ static void list_ctx_destroy (struct list_ctx *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        list_stream_cleanup (ctx);
         if (ctx->jsctx)
             job_state_destroy (ctx->jsctx);
         if (ctx->idsync_lookups)
@@ -134,12 +157,83 @@ static struct list_ctx *list_ctx_create (flux_t *h)
         goto error;
     if (idsync_setup (ctx) < 0)
         goto error;
+    if (list_stream_setup (ctx) < 0)
+        goto error;
     return ctx;
 error:
     list_ctx_destroy (ctx);
     return NULL;
 }
 
+/* Configure purging of inactive jobs from [job-list] in the config
+ * file.  Module options override the config file.
+ */
+static int purge_configure (struct list_ctx *ctx, int argc, char **argv)
+{
+    flux_conf_error_t err;
+    int num_limit = 0;
+    double age_limit = 0.;
+    const char *age = NULL;
+    const char *rundir;
+    char path[PATH_MAX + 1];
+
+    if (flux_conf_unpack (flux_get_conf (ctx->h),
+                          &err,
+                          "{s?{s?i s?s}}",
+                          "job-list",
+                            "inactive-num-limit", &num_limit,
+                            "inactive-age-limit", &age) < 0) {
+        flux_log (ctx->h, LOG_ERR,
+                  "error reading job-list config: %s",
+                  err.errbuf);
+        return -1;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "inactive-num-limit=", 19)) {
+            char *endptr;
+            long l;
+
+            errno = 0;
+            l = strtol (argv[i] + 19, &endptr, 0);
+            if (errno != 0 || *endptr != '\0' || l < 0 || l > INT_MAX) {
+                flux_log (ctx->h, LOG_ERR, "Invalid %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+            num_limit = l;
+        }
+        else if (!strncmp (argv[i], "inactive-age-limit=", 19))
+            age = argv[i] + 19;
+        else {
+            flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    if (num_limit < 0) {
+        flux_log (ctx->h, LOG_ERR, "inactive-num-limit must be >= 0");
+        errno = EINVAL;
+        return -1;
+    }
+    if (age && fsd_parse_duration (age, &age_limit) < 0) {
+        flux_log (ctx->h, LOG_ERR, "Invalid inactive-age-limit: %s", age);
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(rundir = flux_attr_get (ctx->h, "rundir"))) {
+        flux_log_error (ctx->h, "rundir");
+        return -1;
+    }
+    if (snprintf (path,
+                  sizeof (path),
+                  "%s/job-list.spill",
+                  rundir) >= sizeof (path)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return job_state_purge_setup (ctx->jsctx, num_limit, age_limit, path);
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     struct list_ctx *ctx;
@@ -149,6 +243,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "initialization error");
         goto done;
     }
+    if (purge_configure (ctx, argc, argv) < 0)
+        goto done;
     if (job_state_init_from_kvs (ctx) < 0)
         goto done;
     if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
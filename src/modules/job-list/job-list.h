@@ -23,6 +23,10 @@ struct list_ctx {
     struct job_state_ctx *jsctx;
     zlistx_t *idsync_lookups;
     zhashx_t *idsync_waits;
+    zlistx_t *streams;
+    flux_watcher_t *stream_prep;
+    flux_watcher_t *stream_check;
+    flux_watcher_t *stream_idle;
 };
 
 #endif /* _FLUX_JOB_LIST_H */
@@ -15,6 +15,7 @@
 #endif
 #include <jansson.h>
 #include <assert.h>
+#include <stddef.h>
 #include <flux/core.h>
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
@@ -22,9 +23,11 @@
 #include "src/common/libutil/fluid.h"
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/grudgeset.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libjob/job_hash.h"
 #include "src/common/librlist/rlist.h"
 #include "src/common/libidset/idset.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "job_state.h"
 #include "idsync.h"
@@ -32,6 +35,10 @@
 
 #define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
 
+/* Max number of KVS lookups in flight while loading jobs at startup.
+ */
+#define RESTART_WINDOW 256
+
 /* REVERT - flag indicates state transition is a revert, avoid certain
  * checks, clear certain bitmasks on revert
  *
@@ -73,6 +80,7 @@ static int dependency_context_parse (flux_t *h,
 static void process_next_state (struct list_ctx *ctx, struct job *job);
 
 static int journal_process_events (struct job_state_ctx *jsctx, json_t *events);
+static void journal_process_backlog (struct job_state_ctx *jsctx);
 
 /* Compare items for sorting in list, priority first (higher priority
  * before lower priority), job id second N.B. zlistx_comparator_fn signature
@@ -122,6 +130,7 @@ static void job_destroy (void *data)
         free (job->ranks);
         free (job->nodelist);
         zlist_destroy (&job->next_states);
+        job_fragments_clear (job);
         free (job);
     }
 }
@@ -181,12 +190,188 @@ static bool search_direction (struct job *job)
         return false;
 }
 
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t user_hasher (const void *key)
+{
+    return *(const uint32_t *)key;
+}
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int user_cmp (const void *key1, const void *key2)
+{
+    return NUMCMP (*(const uint32_t *)key1, *(const uint32_t *)key2);
+}
+
+static void user_jobs_destroy (struct user_jobs *user)
+{
+    if (user) {
+        zlistx_destroy (&user->pending);
+        zlistx_destroy (&user->running);
+        zlistx_destroy (&user->inactive);
+        free (user);
+    }
+}
+
+/* N.B. zhashx_destructor_fn signature
+ */
+static void user_jobs_destroy_wrapper (void **data)
+{
+    if (data) {
+        user_jobs_destroy (*data);
+        *data = NULL;
+    }
+}
+
+static struct user_jobs *user_jobs_create (uint32_t userid)
+{
+    struct user_jobs *user;
+
+    if (!(user = calloc (1, sizeof (*user))))
+        return NULL;
+    user->userid = userid;
+    if (!(user->pending = zlistx_new ())
+        || !(user->running = zlistx_new ())
+        || !(user->inactive = zlistx_new ())) {
+        user_jobs_destroy (user);
+        errno = ENOMEM;
+        return NULL;
+    }
+    zlistx_set_comparator (user->pending, job_urgency_cmp);
+    zlistx_set_comparator (user->running, job_running_cmp);
+    zlistx_set_comparator (user->inactive, job_inactive_cmp);
+    return user;
+}
+
+static struct user_jobs *user_jobs_get (struct job_state_ctx *jsctx,
+                                        uint32_t userid)
+{
+    struct user_jobs *user;
+
+    if (!(user = zhashx_lookup (jsctx->users, &userid))) {
+        if (!(user = user_jobs_create (userid)))
+            return NULL;
+        if (zhashx_insert (jsctx->users, &user->userid, user) < 0) {
+            user_jobs_destroy (user);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    return user;
+}
+
+struct user_jobs *job_state_user_lookup (struct job_state_ctx *jsctx,
+                                         uint32_t userid)
+{
+    return zhashx_lookup (jsctx->users, &userid);
+}
+
+zlistx_t *job_state_result_list (struct job_state_ctx *jsctx,
+                                 flux_job_result_t result)
+{
+    switch (result) {
+        case FLUX_JOB_RESULT_COMPLETED:
+            return jsctx->results[0];
+        case FLUX_JOB_RESULT_FAILED:
+            return jsctx->results[1];
+        case FLUX_JOB_RESULT_CANCELED:
+            return jsctx->results[2];
+        case FLUX_JOB_RESULT_TIMEOUT:
+            return jsctx->results[3];
+    }
+    return NULL;
+}
+
+static zlistx_t *get_user_list (struct user_jobs *user, flux_job_state_t state)
+{
+    if (state == FLUX_JOB_STATE_NEW)
+        return NULL;
+    else if (state == FLUX_JOB_STATE_DEPEND
+             || state == FLUX_JOB_STATE_PRIORITY
+             || state == FLUX_JOB_STATE_SCHED)
+        return user->pending;
+    else if (state == FLUX_JOB_STATE_RUN
+             || state == FLUX_JOB_STATE_CLEANUP)
+        return user->running;
+    else /* state == FLUX_JOB_STATE_INACTIVE */
+        return user->inactive;
+}
+
+/* Add job to the user and result lists for 'newstate', in the same
+ * manner as job_insert_list().
+ */
+static void job_index_insert (struct job_state_ctx *jsctx,
+                              struct job *job,
+                              flux_job_state_t newstate)
+{
+    zlistx_t *list;
+
+    if (!job->user
+        && !(job->user = user_jobs_get (jsctx, job->userid))) {
+        flux_log_error (jsctx->h, "%s: user_jobs_get", __FUNCTION__);
+        return;
+    }
+    if (!(list = get_user_list (job->user, newstate)))
+        return;
+    if (list == job->user->pending)
+        job->user_list_handle = zlistx_insert (list,
+                                               job,
+                                               search_direction (job));
+    else
+        job->user_list_handle = zlistx_add_start (list, job);
+    if (!job->user_list_handle)
+        flux_log_error (jsctx->h, "%s: zlistx_insert", __FUNCTION__);
+
+    if (newstate == FLUX_JOB_STATE_INACTIVE
+        && (list = job_state_result_list (jsctx, job->result))) {
+        if (!(job->result_list_handle = zlistx_add_start (list, job)))
+            flux_log_error (jsctx->h, "%s: zlistx_add_start",
+                            __FUNCTION__);
+    }
+}
+
+/* Remove job from the user and result lists for 'oldstate'.
+ */
+static void job_index_remove (struct job_state_ctx *jsctx,
+                              struct job *job,
+                              flux_job_state_t oldstate)
+{
+    if (job->user_list_handle) {
+        zlistx_t *list = get_user_list (job->user, oldstate);
+        if (zlistx_detach (list, job->user_list_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach", __FUNCTION__);
+        job->user_list_handle = NULL;
+    }
+    if (job->result_list_handle) {
+        zlistx_t *list = job_state_result_list (jsctx, job->result);
+        if (zlistx_detach (list, job->result_list_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach", __FUNCTION__);
+        job->result_list_handle = NULL;
+    }
+}
+
+/* Reorder job on the pending lists after its priority has changed.
+ */
+static void job_pending_reorder (struct job_state_ctx *jsctx,
+                                 struct job *job)
+{
+    zlistx_reorder (jsctx->pending,
+                    job->list_handle,
+                    search_direction (job));
+    if (job->user_list_handle)
+        zlistx_reorder (job->user->pending,
+                        job->user_list_handle,
+                        search_direction (job));
+}
+
 static void update_job_state (struct list_ctx *ctx,
                               struct job *job,
                               flux_job_state_t new_state,
                               double timestamp)
 {
     job_stats_update (&ctx->jsctx->stats, job, new_state);
+    job_fragments_clear (job);
 
     job->state = new_state;
     if (job->state == FLUX_JOB_STATE_DEPEND)
@@ -210,6 +395,7 @@ static void revert_job_state (struct list_ctx *ctx,
      * may be defined.
      */
     if (job->state == FLUX_JOB_STATE_SCHED) {
+        job_fragments_clear (job);
         job->states_mask &= ~(job->state);
         update_job_state (ctx, job, FLUX_JOB_STATE_PRIORITY, timestamp);
     }
@@ -243,6 +429,7 @@ static void job_insert_list (struct job_state_ctx *jsctx,
             flux_log_error (jsctx->h, "%s: zlistx_add_start",
                             __FUNCTION__);
     }
+    job_index_insert (jsctx, job, newstate);
 }
 
 /* remove job from one list and move it to another based on the
@@ -250,12 +437,14 @@ static void job_insert_list (struct job_state_ctx *jsctx,
 static void job_change_list (struct job_state_ctx *jsctx,
                              struct job *job,
                              zlistx_t *oldlist,
+                             flux_job_state_t oldstate,
                              flux_job_state_t newstate)
 {
     if (zlistx_detach (oldlist, job->list_handle) < 0)
         flux_log_error (jsctx->h, "%s: zlistx_detach",
                         __FUNCTION__);
     job->list_handle = NULL;
+    job_index_remove (jsctx, job, oldstate);
 
     job_insert_list (jsctx, job, newstate);
 }
@@ -282,6 +471,7 @@ static void update_job_state_and_list (struct list_ctx *ctx,
 {
     zlistx_t *oldlist, *newlist;
     struct job_state_ctx *jsctx = job->ctx->jsctx;
+    flux_job_state_t oldstate = job->state;
 
     oldlist = get_list (jsctx, job->state);
     newlist = get_list (jsctx, newstate);
@@ -296,12 +486,10 @@ static void update_job_state_and_list (struct list_ctx *ctx,
      * list amongst jobs with queue priorities
      */
     if (oldlist != newlist)
-        job_change_list (jsctx, job, oldlist, newstate);
+        job_change_list (jsctx, job, oldlist, oldstate, newstate);
     else if (oldlist == jsctx->pending
              && newstate == FLUX_JOB_STATE_SCHED)
-        zlistx_reorder (jsctx->pending,
-                        job->list_handle,
-                        search_direction (job));
+        job_pending_reorder (jsctx, job);
 }
 
 static void list_id_respond (struct list_ctx *ctx,
@@ -887,28 +1075,22 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct list_ctx *ctx = arg;
-    json_t *o;
 
     ctx->jsctx->pause = false;
 
-    o = zlistx_first (ctx->jsctx->events_journal_backlog);
-    while (o) {
-        (void)journal_process_events (ctx->jsctx, o);
-        o = zlistx_next (ctx->jsctx->events_journal_backlog);
-    }
+    /* If jobs are still loading, the backlog is processed when done */
+    if (ctx->jsctx->restart_complete)
+        journal_process_backlog (ctx->jsctx);
 
     if (flux_respond (h, msg, NULL) < 0) {
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
         goto error;
     }
-
-    zlistx_purge (ctx->jsctx->events_journal_backlog);
     return;
 
  error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
-    zlistx_purge (ctx->jsctx->events_journal_backlog);
 }
 
 static struct job *eventlog_restart_parse (struct list_ctx *ctx,
@@ -1018,155 +1200,497 @@ error:
     return NULL;
 }
 
-static int depthfirst_count_depth (const char *s)
+/* A KVS lookup issued by job_state_init_from_kvs(): either a directory
+ * under "job", or the eventlog, jobspec, and R of a single job.
+ */
+struct restart_lookup {
+    struct job_state_ctx *jsctx;
+    bool isjob;
+    int level;          // directory: number of path components below "job"
+    char *key;          // directory: key
+    flux_jobid_t id;    // job: id
+    flux_future_t *f;   // directory lookup or composite of job lookups
+    void *handle;       // handle in jsctx->restart_inflight
+};
+
+static void restart_lookup_destroy (struct restart_lookup *l)
 {
-    int count = 0;
-    while (*s) {
-        if (*s++ == '.')
-            count++;
+    if (l) {
+        int saved_errno = errno;
+        flux_future_destroy (l->f);
+        free (l->key);
+        free (l);
+        errno = saved_errno;
     }
-    return count;
 }
 
-static int depthfirst_map_one (struct list_ctx *ctx, const char *key,
-                               int dirskip)
+/* zlist_free_fn footprint */
+static void restart_lookup_free (void *data)
 {
-    struct job *job = NULL;
-    flux_jobid_t id;
-    flux_future_t *f1 = NULL;
-    flux_future_t *f2 = NULL;
-    flux_future_t *f3 = NULL;
-    const char *eventlog, *jobspec, *R;
-    char path[64];
-    int rc = -1;
+    restart_lookup_destroy (data);
+}
 
-    if (strlen (key) <= dirskip) {
-        errno = EINVAL;
-        return -1;
+static void restart_lookup_destroy_wrapper (void **data)
+{
+    if (data) {
+        struct restart_lookup **l = (struct restart_lookup **)data;
+        restart_lookup_destroy (*l);
     }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
-        return -1;
-    if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
-        errno = EINVAL;
+}
+
+static int restart_push (struct job_state_ctx *jsctx,
+                         const char *key,
+                         int level,
+                         flux_jobid_t id)
+{
+    struct restart_lookup *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
         return -1;
+    l->jsctx = jsctx;
+    if (key) {
+        if (!(l->key = strdup (key)))
+            goto error;
+        l->level = level;
+    }
+    else {
+        l->isjob = true;
+        l->id = id;
     }
-    if (!(f1 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f1, &eventlog) < 0)
-        goto done;
+    if (zlist_append (jsctx->restart_queue, l) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    /* Queued lookups are freed if the module is unloaded during restart */
+    zlist_freefn (jsctx->restart_queue, l, restart_lookup_free, true);
+    return 0;
+error:
+    restart_lookup_destroy (l);
+    return -1;
+}
 
-    if (!(job = eventlog_restart_parse (ctx, eventlog, id)))
-        goto done;
+static int restart_lookup_key (struct job_state_ctx *jsctx,
+                               flux_future_t *fall,
+                               flux_jobid_t id,
+                               const char *key)
+{
+    flux_future_t *f;
+    char path[64];
 
-    if (flux_job_kvs_key (path, sizeof (path), id, "jobspec") < 0) {
+    if (flux_job_kvs_key (path, sizeof (path), id, key) < 0) {
         errno = EINVAL;
-        goto done;
+        return -1;
     }
-    if (!(f2 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f2, &jobspec) < 0)
-        goto done;
-
-    if (jobspec_parse (ctx, job, jobspec) < 0)
-        goto done;
-
-    if (job->states_mask & FLUX_JOB_STATE_RUN) {
-        if (flux_job_kvs_key (path, sizeof (path), id, "R") < 0) {
-            errno = EINVAL;
-            return -1;
-        }
-        if (!(f3 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-            goto done;
-        if (flux_kvs_lookup_get (f3, &R) < 0)
-            goto done;
-
-        if (R_lookup_parse (ctx, job, R) < 0)
-            goto done;
+    if (!(f = flux_kvs_lookup (jsctx->h, NULL, 0, path)))
+        return -1;
+    if (flux_future_push (fall, key, f) < 0) {
+        flux_future_destroy (f);
+        return -1;
     }
+    return 0;
+}
 
-    if (job->states_mask & FLUX_JOB_STATE_INACTIVE)
-        eventlog_inactive_complete (ctx, job);
-
-    if (zhashx_insert (ctx->jsctx->index, &job->id, job) < 0) {
-        flux_log_error (ctx->h, "%s: zhashx_insert", __FUNCTION__);
-        goto done;
+static int restart_send (struct job_state_ctx *jsctx, struct restart_lookup *l)
+{
+    if (!l->isjob) {
+        if (!(l->f = flux_kvs_lookup (jsctx->h,
+                                      NULL,
+                                      FLUX_KVS_READDIR,
+                                      l->key)))
+            return -1;
+        return 0;
     }
-    job_insert_list (ctx->jsctx, job, job->state);
-
-    rc = 1;
-done:
-    if (rc < 0)
-        job_destroy (job);
-    flux_future_destroy (f1);
-    flux_future_destroy (f2);
-    flux_future_destroy (f3);
-    return rc;
+    /* R is fetched unconditionally to avoid a second round trip.  It
+     * is only parsed if the eventlog shows the job reached RUN state.
+     */
+    if (!(l->f = flux_future_wait_all_create ()))
+        return -1;
+    flux_future_set_flux (l->f, jsctx->h);
+    if (restart_lookup_key (jsctx, l->f, l->id, "eventlog") < 0
+        || restart_lookup_key (jsctx, l->f, l->id, "jobspec") < 0
+        || restart_lookup_key (jsctx, l->f, l->id, "R") < 0)
+        return -1;
+    return 0;
 }
 
-static int depthfirst_map (struct list_ctx *ctx, const char *key,
-                           int dirskip)
+/* Queue a lookup for each subdirectory of directory 'l'.  At the bottom
+ * of the "job" hierarchy, subdirectories are jobs.
+ */
+static int restart_readdir (struct job_state_ctx *jsctx,
+                            struct restart_lookup *l)
 {
-    flux_future_t *f;
+    int dirskip = strlen ("job");
     const flux_kvsdir_t *dir;
     flux_kvsitr_t *itr;
     const char *name;
-    int path_level;
-    int count = 0;
     int rc = -1;
 
-    path_level = depthfirst_count_depth (key + dirskip);
-    if (!(f = flux_kvs_lookup (ctx->h, NULL, FLUX_KVS_READDIR, key)))
+    if (flux_kvs_lookup_get_dir (l->f, &dir) < 0) {
+        if (errno == ENOENT && l->level == 0)
+            return 0;
         return -1;
-    if (flux_kvs_lookup_get_dir (f, &dir) < 0) {
-        if (errno == ENOENT && path_level == 0)
-            rc = 0;
-        goto done;
     }
     if (!(itr = flux_kvsitr_create (dir)))
-        goto done;
+        return -1;
     while ((name = flux_kvsitr_next (itr))) {
         char *nkey;
+        flux_jobid_t id;
         int n;
+
         if (!flux_kvsdir_isdir (dir, name))
             continue;
         if (!(nkey = flux_kvsdir_key_at (dir, name)))
-            goto done_destroyitr;
-        if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (ctx, nkey, dirskip);
+            goto done;
+        if (l->level == 3) { // orig 'key' = .A.B.C, thus 'nkey' is complete
+            if (strlen (nkey) <= dirskip) {
+                errno = EINVAL;
+                n = -1;
+            }
+            else if ((n = fluid_decode (nkey + dirskip + 1,
+                                        &id,
+                                        FLUID_STRING_DOTHEX)) == 0)
+                n = restart_push (jsctx, NULL, 0, id);
+        }
         else
-            n = depthfirst_map (ctx, nkey, dirskip);
+            n = restart_push (jsctx, nkey, l->level + 1, 0);
         if (n < 0) {
             int saved_errno = errno;
             free (nkey);
             errno = saved_errno;
-            goto done_destroyitr;
+            goto done;
         }
-        count += n;
         free (nkey);
     }
-    rc = count;
-done_destroyitr:
-    flux_kvsitr_destroy (itr);
+    rc = 0;
 done:
-    flux_future_destroy (f);
+    flux_kvsitr_destroy (itr);
     return rc;
 }
 
-/* Read jobs present in the KVS at startup. */
+static int restart_lookup_get (flux_future_t *fall,
+                               const char *key,
+                               const char **value)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_future_get_child (fall, key))
+        || flux_kvs_lookup_get (f, value) < 0)
+        return -1;
+    return 0;
+}
+
+static int restart_job (struct job_state_ctx *jsctx, struct restart_lookup *l)
+{
+    struct list_ctx *ctx = jsctx->ctx;
+    struct job *job;
+    const char *eventlog, *jobspec, *R;
+
+    if (restart_lookup_get (l->f, "eventlog", &eventlog) < 0)
+        return -1;
+    if (!(job = eventlog_restart_parse (ctx, eventlog, l->id)))
+        return -1;
+    if (restart_lookup_get (l->f, "jobspec", &jobspec) < 0
+        || jobspec_parse (ctx, job, jobspec) < 0)
+        goto error;
+    if (job->states_mask & FLUX_JOB_STATE_RUN) {
+        if (restart_lookup_get (l->f, "R", &R) < 0
+            || R_lookup_parse (ctx, job, R) < 0)
+            goto error;
+    }
+    if (job->states_mask & FLUX_JOB_STATE_INACTIVE)
+        eventlog_inactive_complete (ctx, job);
+
+    if (zhashx_insert (jsctx->index, &job->id, job) < 0) {
+        flux_log_error (jsctx->h, "%s: zhashx_insert", __FUNCTION__);
+        goto error;
+    }
+    job_insert_list (jsctx, job, job->state);
+    if (job->state & FLUX_JOB_STATE_RUNNING
+        || job->state == FLUX_JOB_STATE_INACTIVE)
+        jsctx->restart_unsorted = true;
+    jsctx->restart_jobs++;
+
+    /* list-id requests for this job may have stalled while it loaded */
+    check_waiting_id (ctx, job);
+    return 0;
+error:
+    job_destroy (job);
+    return -1;
+}
+
+static void restart_lookup_continuation (flux_future_t *f, void *arg);
+
+/* Send queued lookups until RESTART_WINDOW are in flight.
+ */
+static int restart_fill (struct job_state_ctx *jsctx)
+{
+    struct restart_lookup *l;
+
+    while (zlistx_size (jsctx->restart_inflight) < RESTART_WINDOW
+           && (l = zlist_pop (jsctx->restart_queue))) {
+        if (restart_send (jsctx, l) < 0
+            || flux_future_then (l->f,
+                                 -1,
+                                 restart_lookup_continuation,
+                                 l) < 0
+            || !(l->handle = zlistx_add_end (jsctx->restart_inflight, l))) {
+            restart_lookup_destroy (l);
+            return -1;
+        }
+    }
+    jsctx->restart_lookups = zlistx_size (jsctx->restart_inflight);
+    return 0;
+}
+
+static void journal_process_backlog (struct job_state_ctx *jsctx)
+{
+    json_t *o;
+
+    o = zlistx_first (jsctx->events_journal_backlog);
+    while (o) {
+        (void)journal_process_events (jsctx, o);
+        o = zlistx_next (jsctx->events_journal_backlog);
+    }
+    zlistx_purge (jsctx->events_journal_backlog);
+}
+
+static void restart_finish (struct job_state_ctx *jsctx)
+{
+    flux_log (jsctx->h,
+              LOG_DEBUG,
+              "%s: read %d jobs in %.3fs",
+              __FUNCTION__,
+              jsctx->restart_jobs,
+              monotime_since (jsctx->restart_t0) / 1000.);
+
+    job_state_restart_sort (jsctx);
+    zlist_destroy (&jsctx->restart_queue);
+    zlistx_destroy (&jsctx->restart_inflight);
+    jsctx->restart_complete = true;
+
+    /* Apply job events that arrived while jobs were loading */
+    if (!jsctx->pause)
+        journal_process_backlog (jsctx);
+}
+
+static void restart_lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct restart_lookup *l = arg;
+    struct job_state_ctx *jsctx = l->jsctx;
+    int rc;
+
+    if (l->isjob)
+        rc = restart_job (jsctx, l);
+    else
+        rc = restart_readdir (jsctx, l);
+    if (rc < 0) {
+        if (l->isjob)
+            flux_log_error (jsctx->h, "restart: error loading job %ju",
+                            (uintmax_t)l->id);
+        else
+            flux_log_error (jsctx->h, "restart: error reading %s", l->key);
+        goto error;
+    }
+    /* delete will destroy struct restart_lookup and future within it */
+    zlistx_delete (jsctx->restart_inflight, l->handle);
+    if (restart_fill (jsctx) < 0) {
+        flux_log_error (jsctx->h, "restart: error sending KVS lookup");
+        goto error;
+    }
+    if (zlistx_size (jsctx->restart_inflight) == 0)
+        restart_finish (jsctx);
+    return;
+error:
+    flux_reactor_stop_error (flux_get_reactor (jsctx->h));
+}
+
+/* Read jobs present in the KVS at startup.  Lookups are issued
+ * asynchronously with up to RESTART_WINDOW in flight, so list requests
+ * can be answered for jobs loaded so far.  Job events from the journal
+ * are held in the backlog until all jobs have been loaded.
+ */
 int job_state_init_from_kvs (struct list_ctx *ctx)
 {
-    const char *dirname = "job";
-    int dirskip = strlen (dirname);
-    int count;
+    struct job_state_ctx *jsctx = ctx->jsctx;
 
-    count = depthfirst_map (ctx, dirname, dirskip);
-    if (count < 0)
+    if (!(jsctx->restart_queue = zlist_new ())
+        || !(jsctx->restart_inflight = zlistx_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    zlistx_set_destructor (jsctx->restart_inflight,
+                           restart_lookup_destroy_wrapper);
+    monotime (&jsctx->restart_t0);
+    if (restart_push (jsctx, "job", 0, 0) < 0
+        || restart_fill (jsctx) < 0)
+        return -1;
+    return 0;
+}
+
+/* zlistx_sort() swaps items between list nodes rather than moving the
+ * nodes, so reset the list handle at 'offset' in each job afterwards.
+ */
+static void sort_list (zlistx_t *list, size_t offset)
+{
+    struct job *job;
+
+    zlistx_sort (list);
+    job = zlistx_first (list);
+    while (job) {
+        *(void **)((char *)job + offset) = zlistx_cursor (list);
+        job = zlistx_next (list);
+    }
+}
+
+/* While jobs are loading, the running and inactive lists are appended
+ * to without sorting.  Sort them before they are read.
+ */
+void job_state_restart_sort (struct job_state_ctx *jsctx)
+{
+    if (jsctx->restart_unsorted) {
+        struct user_jobs *user;
+
+        sort_list (jsctx->running, offsetof (struct job, list_handle));
+        sort_list (jsctx->inactive, offsetof (struct job, list_handle));
+        user = zhashx_first (jsctx->users);
+        while (user) {
+            sort_list (user->running,
+                       offsetof (struct job, user_list_handle));
+            sort_list (user->inactive,
+                       offsetof (struct job, user_list_handle));
+            user = zhashx_next (jsctx->users);
+        }
+        for (int i = 0; i < JOB_RESULT_COUNT; i++)
+            sort_list (jsctx->results[i],
+                       offsetof (struct job, result_list_handle));
+        jsctx->restart_unsorted = false;
+    }
+}
+
+/* Append 'job' to the spill file and destroy it.
+ */
+static int purge_job (struct job_state_ctx *jsctx, struct job *job)
+{
+    flux_jobid_t id = job->id;
+    job_info_error_t err;
+    json_t *o;
+
+    if (!(o = job_to_json (job, jsctx->spill_attrs, &err)))
         return -1;
-    flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs", __FUNCTION__, count);
+    if (spill_append (jsctx->spill, o) < 0) {
+        ERRNO_SAFE_WRAP (json_decref, o);
+        return -1;
+    }
+    json_decref (o);
+    if (zlistx_detach (jsctx->inactive, job->list_handle) < 0)
+        flux_log_error (jsctx->h, "%s: zlistx_detach", __FUNCTION__);
+    job->list_handle = NULL;
+    job_index_remove (jsctx, job, job->state);
+    /* index destroys the job */
+    zhashx_delete (jsctx->index, &id);
+    return 0;
+}
+
+static bool purge_needed (struct job_state_ctx *jsctx, struct job *job)
+{
+    if (jsctx->inactive_num_limit > 0
+        && zlistx_size (jsctx->inactive) > jsctx->inactive_num_limit)
+        return true;
+    if (jsctx->inactive_age_limit > 0.
+        && flux_reactor_now (flux_get_reactor (jsctx->h)) - job->t_inactive
+           > jsctx->inactive_age_limit)
+        return true;
+    return false;
+}
 
-    zlistx_sort (ctx->jsctx->running);
-    zlistx_sort (ctx->jsctx->inactive);
+/* Purge the oldest inactive jobs until the limits are met.  This runs
+ * from the reactor rather than on the INACTIVE state transition, since
+ * jobs may be referenced further up the stack while events are
+ * processed.  It is deferred until restart is complete, so that the
+ * inactive list is sorted and jobs are appended to the spill file in
+ * order.
+ */
+static void purge_inactive (struct job_state_ctx *jsctx)
+{
+    struct job *job;
+
+    if (!jsctx->restart_complete)
+        return;
+    while ((job = zlistx_last (jsctx->inactive))
+           && purge_needed (jsctx, job)) {
+        if (purge_job (jsctx, job) < 0) {
+            flux_log_error (jsctx->h,
+                            "error purging job %ju",
+                            (uintmax_t)job->id);
+            break;
+        }
+    }
+}
+
+static void purge_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    purge_inactive (arg);
+}
+
+/* The prepare watcher only runs when the reactor wakes up, so an idle
+ * instance also needs a timer to purge jobs by age.
+ */
+static void purge_timer_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    purge_inactive (arg);
+}
+
+int job_state_purge_setup (struct job_state_ctx *jsctx,
+                           int num_limit,
+                           double age_limit,
+                           const char *path)
+{
+    flux_reactor_t *r = flux_get_reactor (jsctx->h);
+
+    if (num_limit < 0 || age_limit < 0. || !path) {
+        errno = EINVAL;
+        return -1;
+    }
+    jsctx->inactive_num_limit = num_limit;
+    jsctx->inactive_age_limit = age_limit;
+    if (num_limit == 0 && age_limit == 0.)
+        return 0;
+    if (!(jsctx->spill_attrs = json_array ()))
+        goto nomem;
+    for (int i = 0; job_attrs[i] != NULL; i++) {
+        if (json_array_append_new (jsctx->spill_attrs,
+                                   json_string (job_attrs[i])) < 0)
+            goto nomem;
+    }
+    if (!(jsctx->spill = spill_create (path))) {
+        flux_log_error (jsctx->h, "%s", path);
+        return -1;
+    }
+    if (!(jsctx->purge_prep_w = flux_prepare_watcher_create (r,
+                                                             purge_prep_cb,
+                                                             jsctx)))
+        return -1;
+    flux_watcher_start (jsctx->purge_prep_w);
+    if (age_limit > 0.) {
+        double period = age_limit < 60. ? age_limit : 60.;
+        if (!(jsctx->purge_timer_w = flux_timer_watcher_create (r,
+                                                                period,
+                                                                period,
+                                                                purge_timer_cb,
+                                                                jsctx)))
+            return -1;
+        flux_watcher_start (jsctx->purge_timer_w);
+    }
     return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
 }
 
 static int job_update_eventlog_seq (struct job_state_ctx *jsctx,
@@ -1368,9 +1892,7 @@ static int journal_priority_event (struct job_state_ctx *jsctx,
 
     if (job->state & FLUX_JOB_STATE_PENDING
         && job->priority != orig_priority)
-        zlistx_reorder (jsctx->pending,
-                        job->list_handle,
-                        search_direction (job));
+        job_pending_reorder (jsctx, job);
 
     return job_transition_state (jsctx,
                                  job,
@@ -1664,6 +2186,7 @@ static int journal_process_event (struct job_state_ctx *jsctx, json_t *event)
     double timestamp;
     const char *name;
     json_t *context = NULL;
+    struct job *job;
 
     if (json_unpack (event, "{s:I s:i s:o}",
                      "id", &id,
@@ -1763,7 +2286,6 @@ static int journal_process_event (struct job_state_ctx *jsctx, json_t *event)
             return -1;
     }
     else {
-        struct job *job;
         if (!(job = zhashx_lookup (jsctx->index, &id))) {
             flux_log_error (jsctx->h, "%s: job %ju not in hash",
                             __FUNCTION__, (uintmax_t)id);
@@ -1773,6 +2295,12 @@ static int journal_process_event (struct job_state_ctx *jsctx, json_t *event)
         (void) job_update_eventlog_seq (jsctx, job, eventlog_seq);
     }
 
+    /* Any event may have changed job attributes, so drop encoded
+     * attributes cached for list responses.
+     */
+    if ((job = zhashx_lookup (jsctx->index, &id)))
+        job_fragments_clear (job);
+
     return 0;
 }
 
@@ -1805,7 +2333,7 @@ static void job_events_journal_continuation (flux_future_t *f, void *arg)
         goto error;
     }
 
-    if (jsctx->pause) {
+    if (jsctx->pause || !jsctx->restart_complete) {
         json_t *o = json_incref (events);
         if (!zlistx_add_end (jsctx->events_journal_backlog, o)) {
             flux_log_error (jsctx->h, "%s: zlistx_add_end", __FUNCTION__);
@@ -1864,6 +2392,20 @@ struct job_state_ctx *job_state_create (struct list_ctx *ctx)
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
 
+    if (!(jsctx->users = zhashx_new ()))
+        goto error;
+    zhashx_set_key_hasher (jsctx->users, user_hasher);
+    zhashx_set_key_comparator (jsctx->users, user_cmp);
+    zhashx_set_key_duplicator (jsctx->users, NULL);
+    zhashx_set_key_destructor (jsctx->users, NULL);
+    zhashx_set_destructor (jsctx->users, user_jobs_destroy_wrapper);
+
+    for (int i = 0; i < JOB_RESULT_COUNT; i++) {
+        if (!(jsctx->results[i] = zlistx_new ()))
+            goto error;
+        zlistx_set_comparator (jsctx->results[i], job_inactive_cmp);
+    }
+
     if (!(jsctx->futures = zlistx_new ()))
         goto error;
 
@@ -1915,15 +2457,24 @@ void job_state_destroy (void *data)
             }
             zlistx_destroy (&jsctx->futures);
         }
+        zlist_destroy (&jsctx->restart_queue);
+        zlistx_destroy (&jsctx->restart_inflight);
         /* Destroy index last, as it is the one that will actually
          * destroy the job objects */
         zlistx_destroy (&jsctx->processing);
+        zhashx_destroy (&jsctx->users);
+        for (int i = 0; i < JOB_RESULT_COUNT; i++)
+            zlistx_destroy (&jsctx->results[i]);
         zlistx_destroy (&jsctx->inactive);
         zlistx_destroy (&jsctx->running);
         zlistx_destroy (&jsctx->pending);
         zhashx_destroy (&jsctx->index);
         zlistx_destroy (&jsctx->events_journal_backlog);
         flux_future_destroy (jsctx->events);
+        flux_watcher_destroy (jsctx->purge_prep_w);
+        flux_watcher_destroy (jsctx->purge_timer_w);
+        spill_destroy (jsctx->spill);
+        json_decref (jsctx->spill_attrs);
         free (jsctx);
     }
 }
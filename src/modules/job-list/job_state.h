@@ -16,6 +16,7 @@
 
 #include "job-list.h"
 #include "stats.h"
+#include "spill.h"
 #include "src/common/libutil/grudgeset.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
@@ -36,8 +37,29 @@
  * cannot yet be stored on one of the lists above.
  *
  * The list `futures` is used to store in process futures.
+ *
+ * To avoid visiting every job on queries filtered by user or result,
+ * jobs are also kept on per-user copies of the pending, running and
+ * inactive lists (`users`), and inactive jobs on per-result lists
+ * (`results`), each in the same order as the lists above.
+ *
+ * If limits are configured, the oldest inactive jobs are purged from
+ * the inactive list and index and appended to a spill file.  Requests
+ * for inactive jobs continue into the spill file once the inactive list
+ * is exhausted.
  */
 
+/* Number of job results, see flux_job_result_t.
+ */
+#define JOB_RESULT_COUNT 4
+
+struct user_jobs {
+    uint32_t userid;
+    zlistx_t *pending;
+    zlistx_t *running;
+    zlistx_t *inactive;
+};
+
 struct job_state_ctx {
     flux_t *h;
     struct list_ctx *ctx;
@@ -47,6 +69,8 @@ struct job_state_ctx {
     zlistx_t *inactive;
     zlistx_t *processing;
     zlistx_t *futures;
+    zhashx_t *users;
+    zlistx_t *results[JOB_RESULT_COUNT];
 
     /*  Job statistics: */
     struct job_stats stats;
@@ -58,6 +82,24 @@ struct job_state_ctx {
 
     /* stream of job events from the job-manager */
     flux_future_t *events;
+
+    /* loading of jobs from the KVS at startup, see
+     * job_state_init_from_kvs() */
+    zlist_t *restart_queue;
+    zlistx_t *restart_inflight;
+    struct timespec restart_t0;
+    bool restart_unsorted;
+    bool restart_complete;
+    int restart_jobs;
+    int restart_lookups;
+
+    /* purging of inactive jobs, see job_state_purge_setup() */
+    int inactive_num_limit;
+    double inactive_age_limit;
+    struct spill *spill;
+    json_t *spill_attrs;
+    flux_watcher_t *purge_prep_w;
+    flux_watcher_t *purge_timer_w;
 };
 
 struct job {
@@ -109,6 +151,12 @@ struct job {
     unsigned int states_mask;
     unsigned int states_events_mask;
     void *list_handle;
+    struct user_jobs *user;
+    void *user_list_handle;
+    void *result_list_handle;
+
+    /* cache of encoded attributes, see job_attr_fragment() */
+    char **fragments;
 
     /* timestamp of when we enter the state
      *
@@ -140,6 +188,29 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
 
 int job_state_init_from_kvs (struct list_ctx *ctx);
 
+void job_state_restart_sort (struct job_state_ctx *jsctx);
+
+/* Look up the lists of jobs belonging to 'userid'.  Returns NULL if
+ * the user has no jobs.
+ */
+struct user_jobs *job_state_user_lookup (struct job_state_ctx *jsctx,
+                                         uint32_t userid);
+
+/* Return the list of inactive jobs with 'result'.
+ */
+zlistx_t *job_state_result_list (struct job_state_ctx *jsctx,
+                                 flux_job_result_t result);
+
+/* Limit the inactive jobs held in memory to 'num_limit' jobs, and to
+ * jobs inactive for less than 'age_limit' seconds (0 = unlimited).
+ * Jobs exceeding the limits are purged oldest first and appended to a
+ * spill file at 'path'.
+ */
+int job_state_purge_setup (struct job_state_ctx *jsctx,
+                           int num_limit,
+                           double age_limit,
+                           const char *path);
+
 #endif /* ! _FLUX_JOB_LIST_JOB_STATE_H */
 
 /*
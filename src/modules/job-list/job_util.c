@@ -15,13 +15,27 @@
 #endif
 #include <jansson.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <flux/core.h>
 
+#include "src/common/libccan/ccan/build_assert/build_assert.h"
 #include "src/common/libutil/errno_safe.h"
 
 #include "job_util.h"
 #include "job_state.h"
 
+const char *job_attrs[] = { "userid", "urgency", "priority", "t_submit",
+                            "t_depend", "t_run", "t_cleanup", "t_inactive",
+                            "state", "name", "ntasks", "nnodes",
+                            "ranks", "nodelist", "success", "exception_occurred",
+                            "exception_type", "exception_severity",
+                            "exception_note", "result", "expiration",
+                            "annotations", "waitstatus", "dependencies",
+                            NULL };
+
 void seterror (job_info_error_t *errp, const char *fmt, ...)
 {
     if (errp) {
@@ -34,6 +48,153 @@ void seterror (job_info_error_t *errp, const char *fmt, ...)
     }
 }
 
+/* Return the value of attribute 'attr' of 'job'.  If the attribute has
+ * no value, e.g. t_run for a job that has not run, return NULL with
+ * 'absent' set to true.  On error, return NULL with errno set:
+ *
+ * EINVAL - invalid attribute
+ * ENOMEM - out of memory
+ */
+static json_t *job_attr_to_json (struct job *job,
+                                 const char *attr,
+                                 bool *absent)
+{
+    json_t *val = NULL;
+
+    *absent = false;
+    if (!strcmp (attr, "userid")) {
+        val = json_integer (job->userid);
+    }
+    else if (!strcmp (attr, "urgency")) {
+        val = json_integer (job->urgency);
+    }
+    else if (!strcmp (attr, "priority")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_SCHED))
+            goto absent;
+        val = json_integer (job->priority);
+    }
+    else if (!strcmp (attr, "t_submit")
+             || !strcmp (attr, "t_depend")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_DEPEND))
+            goto absent;
+        val = json_real (job->t_submit);
+    }
+    else if (!strcmp (attr, "t_run")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_RUN))
+            goto absent;
+        val = json_real (job->t_run);
+    }
+    else if (!strcmp (attr, "t_cleanup")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_CLEANUP))
+            goto absent;
+        val = json_real (job->t_cleanup);
+    }
+    else if (!strcmp (attr, "t_inactive")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
+            goto absent;
+        val = json_real (job->t_inactive);
+    }
+    else if (!strcmp (attr, "state")) {
+        val = json_integer (job->state);
+    }
+    else if (!strcmp (attr, "name")) {
+        /* potentially NULL if jobspec invalid */
+        if (job->name)
+            val = json_string (job->name);
+        else
+            val = json_string ("");
+    }
+    else if (!strcmp (attr, "ntasks")) {
+        val = json_integer (job->ntasks);
+    }
+    else if (!strcmp (attr, "nnodes")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_RUN))
+            goto absent;
+        val = json_integer (job->nnodes);
+    }
+    else if (!strcmp (attr, "ranks")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_RUN))
+            goto absent;
+        /* potentially NULL if R invalid */
+        if (job->ranks)
+            val = json_string (job->ranks);
+        else
+            val = json_string ("");
+    }
+    else if (!strcmp (attr, "nodelist")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_RUN))
+            goto absent;
+        /* potentially NULL if R invalid */
+        if (job->nodelist)
+            val = json_string (job->nodelist);
+        else
+            val = json_string ("");
+    }
+    else if (!strcmp (attr, "expiration")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_RUN))
+            goto absent;
+        val = json_real (job->expiration);
+    }
+    else if (!strcmp (attr, "waitstatus")) {
+        if (job->wait_status < 0)
+            goto absent;
+        val = json_integer (job->wait_status);
+    }
+    else if (!strcmp (attr, "success")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
+            goto absent;
+        val = json_boolean (job->success);
+    }
+    else if (!strcmp (attr, "exception_occurred")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
+            goto absent;
+        val = json_boolean (job->exception_occurred);
+    }
+    else if (!strcmp (attr, "exception_severity")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
+            || !job->exception_occurred)
+            goto absent;
+        val = json_integer (job->exception_severity);
+    }
+    else if (!strcmp (attr, "exception_type")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
+            || !job->exception_occurred)
+            goto absent;
+        val = json_string (job->exception_type);
+    }
+    else if (!strcmp (attr, "exception_note")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
+            || !job->exception_occurred)
+            goto absent;
+        val = json_string (job->exception_note);
+    }
+    else if (!strcmp (attr, "result")) {
+        if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
+            goto absent;
+        val = json_integer (job->result);
+    }
+    else if (!strcmp (attr, "annotations")) {
+        if (!job->annotations)
+            goto absent;
+        val = json_incref (job->annotations);
+    }
+    else if (!strcmp (attr, "dependencies")) {
+        if (!job->dependencies)
+            goto absent;
+        val = json_incref (grudgeset_tojson (job->dependencies));
+    }
+    else {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!val)
+        errno = ENOMEM;
+    return val;
+absent:
+    *absent = true;
+    return NULL;
+}
+
 /* For a given job, create a JSON object containing the jobid and any
  * additional requested attributes and their values.  Returns JSON
  * object which the caller must free.  On error, return NULL with
@@ -49,7 +210,8 @@ json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp)
     json_t *o;
     json_t *val = NULL;
 
-    memset (errp, 0, sizeof (*errp));
+    if (errp)
+        memset (errp, 0, sizeof (*errp));
 
     if (!(o = json_object ()))
         goto error_nomem;
@@ -61,143 +223,187 @@ json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp)
     }
     json_array_foreach (attrs, index, value) {
         const char *attr = json_string_value (value);
+        bool absent;
         if (!attr) {
             seterror (errp, "attr has no string value");
             errno = EINVAL;
             goto error;
         }
-        if (!strcmp (attr, "userid")) {
-            val = json_integer (job->userid);
-        }
-        else if (!strcmp (attr, "urgency")) {
-            val = json_integer (job->urgency);
-        }
-        else if (!strcmp (attr, "priority")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_SCHED))
-                continue;
-            val = json_integer (job->priority);
-        }
-        else if (!strcmp (attr, "t_submit")
-                 || !strcmp (attr, "t_depend")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_DEPEND))
-                continue;
-            val = json_real (job->t_submit);
-        }
-        else if (!strcmp (attr, "t_run")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_RUN))
-                continue;
-            val = json_real (job->t_run);
-        }
-        else if (!strcmp (attr, "t_cleanup")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_CLEANUP))
-                continue;
-            val = json_real (job->t_cleanup);
-        }
-        else if (!strcmp (attr, "t_inactive")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
-                continue;
-            val = json_real (job->t_inactive);
-        }
-        else if (!strcmp (attr, "state")) {
-            val = json_integer (job->state);
-        }
-        else if (!strcmp (attr, "name")) {
-            /* potentially NULL if jobspec invalid */
-            if (job->name)
-                val = json_string (job->name);
-            else
-                val = json_string ("");
-        }
-        else if (!strcmp (attr, "ntasks")) {
-            val = json_integer (job->ntasks);
-        }
-        else if (!strcmp (attr, "nnodes")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_RUN))
-                continue;
-            val = json_integer (job->nnodes);
-        }
-        else if (!strcmp (attr, "ranks")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_RUN))
-                continue;
-            /* potentially NULL if R invalid */
-            if (job->ranks)
-                val = json_string (job->ranks);
-            else
-                val = json_string ("");
-        }
-        else if (!strcmp (attr, "nodelist")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_RUN))
-                continue;
-            /* potentially NULL if R invalid */
-            if (job->nodelist)
-                val = json_string (job->nodelist);
-            else
-                val = json_string ("");
-        }
-        else if (!strcmp (attr, "expiration")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_RUN))
-                continue;
-            val = json_real (job->expiration);
-        }
-        else if (!strcmp (attr, "waitstatus")) {
-            if (job->wait_status < 0)
-                continue;
-            val = json_integer (job->wait_status);
-        }
-        else if (!strcmp (attr, "success")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
-                continue;
-            val = json_boolean (job->success);
-        }
-        else if (!strcmp (attr, "exception_occurred")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
+        if (!(val = job_attr_to_json (job, attr, &absent))) {
+            if (absent)
                 continue;
-            val = json_boolean (job->exception_occurred);
+            if (errno == EINVAL) {
+                seterror (errp, "%s is not a valid attribute", attr);
+                goto error;
+            }
+            goto error_nomem;
         }
-        else if (!strcmp (attr, "exception_severity")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
-                || !job->exception_occurred)
-                continue;
-            val = json_integer (job->exception_severity);
+        if (json_object_set_new (o, attr, val) < 0) {
+            json_decref (val);
+            goto error_nomem;
         }
-        else if (!strcmp (attr, "exception_type")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
-                || !job->exception_occurred)
-                continue;
-            val = json_string (job->exception_type);
+    }
+    return o;
+ error_nomem:
+    errno = ENOMEM;
+ error:
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return NULL;
+}
+
+int job_attr_index (const char *attr)
+{
+    BUILD_ASSERT (sizeof (job_attrs) / sizeof (job_attrs[0])
+                  == JOB_ATTR_COUNT + 1);
+    for (int i = 0; job_attrs[i] != NULL; i++) {
+        if (!strcmp (job_attrs[i], attr))
+            return i;
+    }
+    return -1;
+}
+
+static bool job_attr_valid (const char *attr)
+{
+    return job_attr_index (attr) >= 0;
+}
+
+int *job_attrs_parse (json_t *attrs, int *countp, job_info_error_t *errp)
+{
+    bool seen[JOB_ATTR_COUNT] = { false };
+    size_t index;
+    json_t *value;
+    int *indices;
+    int count = 0;
+
+    if (!(indices = calloc (json_array_size (attrs) + 1, sizeof (int)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    json_array_foreach (attrs, index, value) {
+        const char *attr = json_string_value (value);
+        int i;
+        if (!attr) {
+            seterror (errp, "attr has no string value");
+            goto inval;
         }
-        else if (!strcmp (attr, "exception_note")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE)
-                || !job->exception_occurred)
-                continue;
-            val = json_string (job->exception_note);
+        if ((i = job_attr_index (attr)) < 0) {
+            seterror (errp, "%s is not a valid attribute", attr);
+            goto inval;
         }
-        else if (!strcmp (attr, "result")) {
-            if (!(job->states_mask & FLUX_JOB_STATE_INACTIVE))
-                continue;
-            val = json_integer (job->result);
+        /* duplicates would result in duplicate object keys */
+        if (!seen[i]) {
+            seen[i] = true;
+            indices[count++] = i;
         }
-        else if (!strcmp (attr, "annotations")) {
-            if (!job->annotations)
-                continue;
-            val = json_incref (job->annotations);
+    }
+    *countp = count;
+    return indices;
+inval:
+    free (indices);
+    errno = EINVAL;
+    return NULL;
+}
+
+/* Fragment for an attribute the job has no value for.
+ */
+static char absent_fragment[] = "";
+
+const char *job_attr_fragment (struct job *job, int index)
+{
+    const char *attr;
+    json_t *val;
+    bool absent;
+    char *s;
+    char *fragment;
+
+    if (index < 0 || index >= JOB_ATTR_COUNT) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!job->fragments) {
+        if (!(job->fragments = calloc (JOB_ATTR_COUNT,
+                                       sizeof (job->fragments[0]))))
+            return NULL;
+    }
+    if (job->fragments[index])
+        return job->fragments[index];
+    attr = job_attrs[index];
+    if (!(val = job_attr_to_json (job, attr, &absent))) {
+        if (!absent)
+            return NULL;
+        return job->fragments[index] = absent_fragment;
+    }
+    s = json_dumps (val, JSON_COMPACT | JSON_ENCODE_ANY);
+    json_decref (val);
+    if (!s || asprintf (&fragment, ",\"%s\":%s", attr, s) < 0) {
+        free (s);
+        errno = ENOMEM;
+        return NULL;
+    }
+    free (s);
+    return job->fragments[index] = fragment;
+}
+
+void job_fragments_clear (struct job *job)
+{
+    if (job->fragments) {
+        int saved_errno = errno;
+        for (int i = 0; i < JOB_ATTR_COUNT; i++) {
+            if (job->fragments[i] != absent_fragment)
+                free (job->fragments[i]);
         }
-        else if (!strcmp (attr, "dependencies")) {
-            if (!job->dependencies)
-                continue;
-            val = json_incref (grudgeset_tojson (job->dependencies));
+        free (job->fragments);
+        job->fragments = NULL;
+        errno = saved_errno;
+    }
+}
+
+/* For a job previously encoded by job_to_json() with all attributes,
+ * e.g. one read back from the spill file, create a JSON object
+ * containing the jobid and any additional requested attributes.
+ * Returns JSON object which the caller must free.  On error, return
+ * NULL with errno set:
+ *
+ * EPROTO - malformed job object
+ * EINVAL - invalid attribute
+ * ENOMEM - out of memory
+ */
+json_t *job_record_to_json (json_t *record,
+                            json_t *attrs,
+                            job_info_error_t *errp)
+{
+    size_t index;
+    json_t *value;
+    json_t *o;
+    json_int_t id;
+
+    if (errp)
+        memset (errp, 0, sizeof (*errp));
+
+    if (json_unpack (record, "{s:I}", "id", &id) < 0) {
+        seterror (errp, "job record has no id");
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(o = json_pack ("{s:I}", "id", id)))
+        goto error_nomem;
+    json_array_foreach (attrs, index, value) {
+        const char *attr = json_string_value (value);
+        json_t *val;
+        if (!attr) {
+            seterror (errp, "attr has no string value");
+            errno = EINVAL;
+            goto error;
         }
-        else {
+        if (!job_attr_valid (attr)) {
             seterror (errp, "%s is not a valid attribute", attr);
             errno = EINVAL;
             goto error;
         }
-        if (val == NULL)
+        if (!(val = json_object_get (record, attr)))
+            continue;
+        if (json_object_set (o, attr, val) < 0)
             goto error_nomem;
-        if (json_object_set_new (o, attr, val) < 0) {
-            json_decref (val);
-            goto error_nomem;
-        }
     }
     return o;
  error_nomem:
@@ -22,8 +22,40 @@ typedef struct {
 void __attribute__((format (printf, 2, 3)))
 seterror (job_info_error_t *errp, const char *fmt, ...);
 
+/* NULL terminated list of all job attributes */
+extern const char *job_attrs[];
+
+/* Number of entries in job_attrs[], excluding the NULL terminator.
+ * job_util.c fails to compile if this does not match the table.
+ */
+#define JOB_ATTR_COUNT 24
+
+/* Return the index of 'attr' in job_attrs[], or -1 if not found.
+ */
+int job_attr_index (const char *attr);
+
+/* Convert a request attrs array to an array of indices into
+ * job_attrs[], which the caller must free.  On error, return NULL with
+ * errno set (EINVAL if an attribute is invalid).
+ */
+int *job_attrs_parse (json_t *attrs, int *countp, job_info_error_t *errp);
+
+/* Return the encoding of attribute job_attrs[index] of 'job' as a JSON
+ * object member with a leading comma, e.g. ',"name":"foo"', or an empty
+ * string if the job has no value for the attribute.  Fragments are
+ * cached with the job until job_fragments_clear() is called, which must
+ * happen whenever the job changes.  On error, return NULL with errno set.
+ */
+const char *job_attr_fragment (struct job *job, int index);
+
+void job_fragments_clear (struct job *job);
+
 json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp);
 
+json_t *job_record_to_json (json_t *record,
+                            json_t *attrs,
+                            job_info_error_t *errp);
+
 #endif /* ! _FLUX_JOB_LIST_JOB_UTIL_H */
 
 /*
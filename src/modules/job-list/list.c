@@ -13,6 +13,9 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <jansson.h>
 #include <flux/core.h>
 
@@ -24,6 +27,14 @@
 #include "job_util.h"
 #include "job_state.h"
 
+#define JOB_RESULT_ALL (FLUX_JOB_RESULT_COMPLETED \
+                        | FLUX_JOB_RESULT_FAILED \
+                        | FLUX_JOB_RESULT_CANCELED \
+                        | FLUX_JOB_RESULT_TIMEOUT)
+
+/* Default number of jobs per response for streaming job-list.list */
+static const int list_chunk_size = 1000;
+
 json_t *get_job_by_id (struct list_ctx *ctx,
                        job_info_error_t *errp,
                        const flux_msg_t *msg,
@@ -31,6 +42,190 @@ json_t *get_job_by_id (struct list_ctx *ctx,
                        json_t *attrs,
                        bool *stall);
 
+/* A list response payload, {"jobs":[...]}, is built as a string from
+ * the encoded attributes cached with each job (see job_attr_fragment()),
+ * rather than building and then encoding a JSON object per job.
+ *
+ * Each streaming response includes a cursor identifying the last job
+ * in it, {"jobs":[...], "cursor":{"id":I, "state":i}}, which may be
+ * passed back in a new request to resume the listing.
+ */
+struct jobs_buf {
+    char *data;
+    size_t len;
+    size_t size;
+    int count;          // number of jobs in the buffer
+    int *attrs;         // requested attributes, indices into job_attrs[]
+    int attrs_count;
+
+    bool cursor;        // add cursor to the payload (streaming)
+    flux_jobid_t last_id;
+    flux_job_state_t last_state;
+};
+
+/* Resume a listing after job 'id', which was listed in 'state'.
+ */
+struct list_cursor {
+    flux_jobid_t id;
+    flux_job_state_t state;
+};
+
+/* Where a listing left off.  'section' is the list being read,
+ * FLUX_JOB_STATE_PENDING, _RUNNING, or _INACTIVE.  'after' holds the
+ * id of the last job visited on each list read in that section, of
+ * which there is more than one if inactive lists are merged.  Once the
+ * in-memory inactive jobs are done, 'spill_offset' is the position in
+ * the spill file.
+ */
+struct list_pos {
+    int section;
+    flux_jobid_t after[JOB_RESULT_COUNT];
+    flux_jobid_t skip;          // skip merged lists up to this job, once
+    bool spill;                 // reading the spill file
+    off_t spill_offset;
+    flux_jobid_t spill_after;   // skip spill file up to this job
+};
+
+/* A streaming job-list.list request in progress.  One chunk is listed
+ * per reactor loop iteration, each resuming from the position of the
+ * last, so that the module does not block for the whole listing and only
+ * one chunk is held in memory at a time.
+ */
+struct list_stream {
+    const flux_msg_t *msg;
+    json_t *attrs;
+    int max_entries;    // 0 = unlimited
+    int total;          // number of jobs sent so far
+    uint32_t userid;
+    int states;
+    int results;
+    int chunk_size;
+    struct list_pos pos;
+};
+
+static int jobs_buf_append (struct jobs_buf *jb, const char *s, size_t len)
+{
+    if (jb->len + len >= jb->size) {
+        size_t size = jb->size ? jb->size : 4096;
+        char *data;
+
+        while (jb->len + len >= size)
+            size *= 2;
+        if (!(data = realloc (jb->data, size)))
+            return -1;
+        jb->data = data;
+        jb->size = size;
+    }
+    memcpy (jb->data + jb->len, s, len);
+    jb->len += len;
+    jb->data[jb->len] = '\0';
+    return 0;
+}
+
+static void jobs_buf_free (struct jobs_buf *jb)
+{
+    int saved_errno = errno;
+    free (jb->data);
+    free (jb->attrs);
+    errno = saved_errno;
+}
+
+static int jobs_buf_start (struct jobs_buf *jb)
+{
+    const char *s = "{\"jobs\":[";
+
+    jb->len = 0;
+    jb->count = 0;
+    return jobs_buf_append (jb, s, strlen (s));
+}
+
+/* Parse the request attrs array and start the response payload.
+ * jobs_buf_free() must be called even if this fails.  On error, return
+ * -1 with errno set:
+ *
+ * EINVAL - invalid attribute
+ * ENOMEM - out of memory
+ */
+static int jobs_buf_init (struct jobs_buf *jb,
+                          json_t *attrs,
+                          job_info_error_t *errp)
+{
+    memset (jb, 0, sizeof (*jb));
+    if (!(jb->attrs = job_attrs_parse (attrs, &jb->attrs_count, errp))
+        || jobs_buf_start (jb) < 0)
+        return -1;
+    return 0;
+}
+
+static int jobs_buf_finish (struct jobs_buf *jb)
+{
+    char s[80];
+    int n;
+
+    if (!jb->cursor)
+        return jobs_buf_append (jb, "]}", 2);
+    n = snprintf (s,
+                  sizeof (s),
+                  "],\"cursor\":{\"id\":%ju,\"state\":%d}}",
+                  (uintmax_t)jb->last_id,
+                  jb->last_state);
+    return jobs_buf_append (jb, s, n);
+}
+
+static void jobs_buf_added (struct jobs_buf *jb,
+                            flux_jobid_t id,
+                            flux_job_state_t state)
+{
+    jb->last_id = id;
+    jb->last_state = state;
+    jb->count++;
+}
+
+static int jobs_buf_add_job (struct jobs_buf *jb, struct job *job)
+{
+    char id[32];
+    int n;
+
+    n = snprintf (id,
+                  sizeof (id),
+                  "%s{\"id\":%ju",
+                  jb->count > 0 ? "," : "",
+                  (uintmax_t)job->id);
+    if (jobs_buf_append (jb, id, n) < 0)
+        return -1;
+    for (int i = 0; i < jb->attrs_count; i++) {
+        const char *fragment;
+        if (!(fragment = job_attr_fragment (job, jb->attrs[i]))
+            || jobs_buf_append (jb, fragment, strlen (fragment)) < 0)
+            return -1;
+    }
+    if (jobs_buf_append (jb, "}", 1) < 0)
+        return -1;
+    jobs_buf_added (jb, job->id, job->state);
+    return 0;
+}
+
+static int jobs_buf_add_json (struct jobs_buf *jb,
+                              json_t *o,
+                              flux_jobid_t id,
+                              flux_job_state_t state)
+{
+    char *s;
+    int rc = -1;
+
+    if (!(s = json_dumps (o, JSON_COMPACT))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((jb->count == 0 || jobs_buf_append (jb, ",", 1) == 0)
+        && jobs_buf_append (jb, s, strlen (s)) == 0) {
+        jobs_buf_added (jb, id, state);
+        rc = 0;
+    }
+    ERRNO_SAFE_WRAP (free, s);
+    return rc;
+}
+
 /* Filter test to determine if job desired by caller */
 bool job_filter (struct job *job, uint32_t userid, int states, int results)
 {
@@ -44,35 +239,203 @@ bool job_filter (struct job *job, uint32_t userid, int states, int results)
     return true;
 }
 
+/* Return the mask of states that share a list with 'state', so that
+ * jobs in these states are listed together.
+ */
+static int state_section (flux_job_state_t state)
+{
+    if ((state & FLUX_JOB_STATE_PENDING))
+        return FLUX_JOB_STATE_PENDING;
+    if ((state & FLUX_JOB_STATE_RUNNING))
+        return FLUX_JOB_STATE_RUNNING;
+    return FLUX_JOB_STATE_INACTIVE;
+}
+
+struct spill_filter {
+    struct jobs_buf *jobs;
+    job_info_error_t *errp;
+    int max_entries;
+    json_t *attrs;
+    uint32_t userid;
+    int results;
+    double since;
+    const char *name;
+    flux_jobid_t after;     // if nonzero, skip jobs up to and including
+};
+
+/* N.B. spill_f signature */
+static int spill_filter_cb (json_t *record, void *arg)
+{
+    struct spill_filter *sf = arg;
+    json_int_t id;
+    json_int_t userid;
+    int result;
+    double t_inactive;
+    const char *name;
+    json_t *o;
+
+    if (json_unpack (record, "{s:I s:I s:i s:F s:s}",
+                     "id", &id,
+                     "userid", &userid,
+                     "result", &result,
+                     "t_inactive", &t_inactive,
+                     "name", &name) < 0) {
+        seterror (sf->errp, "malformed job in spill file");
+        errno = EPROTO;
+        return -1;
+    }
+    if (sf->after) {
+        if (id == sf->after)
+            sf->after = 0;
+        return 0;
+    }
+    /* Jobs are spilled oldest first, so the rest are older still */
+    if (t_inactive <= sf->since)
+        return 1;
+    if (sf->userid != FLUX_USERID_UNKNOWN && userid != sf->userid)
+        return 0;
+    if (!(result & sf->results))
+        return 0;
+    if (sf->name && strcmp (name, sf->name) != 0)
+        return 0;
+    if (!(o = job_record_to_json (record, sf->attrs, sf->errp)))
+        return -1;
+    if (jobs_buf_add_json (sf->jobs, o, id, FLUX_JOB_STATE_INACTIVE) < 0) {
+        ERRNO_SAFE_WRAP (json_decref, o);
+        return -1;
+    }
+    json_decref (o);
+    if (sf->jobs->count == sf->max_entries)
+        return 1;
+    return 0;
+}
+
+/* Put jobs from the spill file onto jobs array, after jobs from the
+ * inactive list.  Returns 0 on success, -1 on error with errno set.
+ */
+static int get_jobs_from_spill (struct list_ctx *ctx,
+                                struct spill_filter *sf)
+{
+    if (!ctx->jsctx->spill)
+        return 0;
+    return spill_foreach (ctx->jsctx->spill, spill_filter_cb, sf);
+}
+
+/* Return the handle of 'job' on 'list', or NULL if it is not on it.
+ */
+static void *job_list_handle (struct job_state_ctx *jsctx,
+                              struct job *job,
+                              zlistx_t *list)
+{
+    zlistx_t *main_list;
+    zlistx_t *user_list;
+
+    if ((job->state & FLUX_JOB_STATE_PENDING)) {
+        main_list = jsctx->pending;
+        user_list = job->user ? job->user->pending : NULL;
+    }
+    else if ((job->state & FLUX_JOB_STATE_RUNNING)) {
+        main_list = jsctx->running;
+        user_list = job->user ? job->user->running : NULL;
+    }
+    else if (job->state == FLUX_JOB_STATE_INACTIVE) {
+        if (list == job_state_result_list (jsctx, job->result))
+            return job->result_list_handle;
+        main_list = jsctx->inactive;
+        user_list = job->user ? job->user->inactive : NULL;
+    }
+    else
+        return NULL;
+    if (list == main_list)
+        return job->list_handle;
+    if (list == user_list)
+        return job->user_list_handle;
+    return NULL;
+}
+
+/* Return the job following job 'id' on 'list', where a listing that
+ * last visited 'id' resumes, or the first job if 'id' is 0.  If the job
+ * has since moved to another list, 'list' is listed again from the
+ * start, since jobs may be listed twice but must not be skipped.  An
+ * inactive job no longer in memory has been purged to the spill file
+ * along with all older jobs, so nothing is left on an inactive list.
+ */
+static struct job *list_resume (struct job_state_ctx *jsctx,
+                                zlistx_t *list,
+                                int section,
+                                flux_jobid_t id)
+{
+    struct job *job;
+    void *handle;
+
+    if (id == 0)
+        return zlistx_first (list);
+    if (!(job = zhashx_lookup (jsctx->index, &id)))
+        return section == FLUX_JOB_STATE_INACTIVE ? NULL : zlistx_first (list);
+    if (!(handle = job_list_handle (jsctx, job, list)))
+        return zlistx_first (list);
+    zlistx_seek (list, handle);
+    return zlistx_next (list);
+}
+
+/* Start 'pos' at the beginning of 'section'.
+ */
+static void list_pos_start (struct list_pos *pos, int section)
+{
+    memset (pos, 0, sizeof (*pos));
+    pos->section = section;
+}
+
+/* Start 'pos' after the job identified by 'cursor', or at the beginning
+ * of the listing if 'cursor' is NULL.  Lists preceding the cursor's list
+ * are done.  An inactive job no longer in memory has been purged to the
+ * spill file, after all in-memory inactive jobs.
+ */
+static void list_pos_init (struct list_ctx *ctx,
+                           struct list_pos *pos,
+                           const struct list_cursor *cursor)
+{
+    list_pos_start (pos, FLUX_JOB_STATE_PENDING);
+    if (cursor) {
+        pos->section = state_section (cursor->state);
+        if (zhashx_lookup (ctx->jsctx->index, &cursor->id)) {
+            pos->after[0] = cursor->id;
+            pos->skip = cursor->id;
+        }
+        else if (pos->section == FLUX_JOB_STATE_INACTIVE) {
+            pos->spill = true;
+            pos->spill_offset = spill_size (ctx->jsctx->spill);
+            pos->spill_after = cursor->id;
+        }
+    }
+}
+
 /* Put jobs from list onto jobs array, breaking if max_entries has
- * been reached. Returns 1 if jobs array is full, 0 if continue, -1
- * one error with errno set:
+ * been reached.  Start with the job following '*after' as described in
+ * list_resume(), and set '*after' to each job as it is visited.  Returns
+ * 1 if jobs array is full, 0 if continue, -1 one error with errno set:
  *
  * ENOMEM - out of memory
  */
-int get_jobs_from_list (json_t *jobs,
-                        job_info_error_t *errp,
+int get_jobs_from_list (struct job_state_ctx *jsctx,
+                        struct jobs_buf *jobs,
                         zlistx_t *list,
+                        int section,
+                        flux_jobid_t *after,
                         int max_entries,
-                        json_t *attrs,
                         uint32_t userid,
                         int states,
                         int results)
 {
     struct job *job;
 
-    job = zlistx_first (list);
+    job = list_resume (jsctx, list, section, *after);
     while (job) {
+        *after = job->id;
         if (job_filter (job, userid, states, results)) {
-            json_t *o;
-            if (!(o = job_to_json (job, attrs, errp)))
+            if (jobs_buf_add_job (jobs, job) < 0)
                 return -1;
-            if (json_array_append_new (jobs, o) < 0) {
-                json_decref (o);
-                errno = ENOMEM;
-                return -1;
-            }
-            if (json_array_size (jobs) == max_entries)
+            if (jobs->count == max_entries)
                 return 1;
         }
         job = zlistx_next (list);
@@ -81,100 +444,372 @@ int get_jobs_from_list (json_t *jobs,
     return 0;
 }
 
-/* Create a JSON array of 'job' objects.  'max_entries' determines the
- * max number of jobs to return, 0=unlimited.  Returns JSON object
- * which the caller must free.  On error, return NULL with errno set:
+/* Put jobs from up to JOB_RESULT_COUNT lists of inactive jobs onto
+ * jobs array, merged so that the most recently inactive job comes
+ * first.  Each list resumes from its entry in 'pos->after'.  A cursor
+ * from the client identifies a job on only one of the lists, so the
+ * merged lists are walked from the start up to 'pos->skip' instead,
+ * once.  Same return values as get_jobs_from_list().
+ */
+static int get_jobs_from_inactive_lists (struct job_state_ctx *jsctx,
+                                         struct jobs_buf *jobs,
+                                         zlistx_t **lists,
+                                         int count,
+                                         struct list_pos *pos,
+                                         int max_entries,
+                                         uint32_t userid,
+                                         int states,
+                                         int results)
+{
+    struct job *head[JOB_RESULT_COUNT];
+    flux_jobid_t skip;
+    int i;
+
+    if (count == 1)
+        return get_jobs_from_list (jsctx,
+                                   jobs,
+                                   lists[0],
+                                   FLUX_JOB_STATE_INACTIVE,
+                                   &pos->after[0],
+                                   max_entries,
+                                   userid,
+                                   states,
+                                   results);
+    if ((skip = pos->skip)) {
+        pos->skip = 0;
+        memset (pos->after, 0, sizeof (pos->after));
+    }
+restart:
+    for (i = 0; i < count; i++)
+        head[i] = list_resume (jsctx,
+                               lists[i],
+                               FLUX_JOB_STATE_INACTIVE,
+                               pos->after[i]);
+    for (;;) {
+        struct job *job = NULL;
+        int next = -1;
+
+        for (i = 0; i < count; i++) {
+            if (head[i] && (!job || head[i]->t_inactive > job->t_inactive)) {
+                job = head[i];
+                next = i;
+            }
+        }
+        if (!job)
+            break;
+        pos->after[next] = job->id;
+        head[next] = zlistx_next (lists[next]);
+        if (skip) {
+            if (job->id == skip)
+                skip = 0;
+            continue;
+        }
+        if (job_filter (job, userid, states, results)) {
+            if (jobs_buf_add_job (jobs, job) < 0)
+                return -1;
+            if (jobs->count == max_entries)
+                return 1;
+        }
+    }
+    /* 'skip' was not found, list from the start */
+    if (skip) {
+        skip = 0;
+        memset (pos->after, 0, sizeof (pos->after));
+        goto restart;
+    }
+    return 0;
+}
+
+/* Fill 'jobs' with 'job' objects.  'max_entries' determines the
+ * max number of jobs to return, 0=unlimited.  The listing starts at
+ * 'pos', which is updated so that a later call resumes where this one
+ * left off without revisiting jobs.  Returns 0 on success.  On error,
+ * return -1 with errno set:
  *
- * EPROTO - malformed or empty attrs array, max_entries out of range
  * ENOMEM - out of memory
  */
-json_t *get_jobs (struct list_ctx *ctx,
-                  job_info_error_t *errp,
-                  int max_entries,
-                  json_t *attrs,
-                  uint32_t userid,
-                  int states,
-                  int results)
-{
-    json_t *jobs = NULL;
-    int saved_errno;
-    int ret = 0;
-
-    if (!(jobs = json_array ()))
-        goto error_nomem;
+int get_jobs (struct list_ctx *ctx,
+              struct jobs_buf *jobs,
+              job_info_error_t *errp,
+              int max_entries,
+              json_t *attrs,
+              uint32_t userid,
+              int states,
+              int results,
+              struct list_pos *pos)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    zlistx_t *pending = jsctx->pending;
+    zlistx_t *running = jsctx->running;
+    zlistx_t *inactive[JOB_RESULT_COUNT] = { jsctx->inactive };
+    int inactive_count = 1;
+    int ret;
+
+    /* Use the per-user or per-result lists if the query allows, so
+     * that only jobs that might match are visited.
+     */
+    if (userid != FLUX_USERID_UNKNOWN) {
+        struct user_jobs *user = job_state_user_lookup (jsctx, userid);
+        pending = user ? user->pending : NULL;
+        running = user ? user->running : NULL;
+        inactive[0] = user ? user->inactive : NULL;
+    }
+    else if ((results & JOB_RESULT_ALL) != JOB_RESULT_ALL) {
+        flux_job_result_t result;
+        inactive_count = 0;
+        for (result = 1; result & JOB_RESULT_ALL; result <<= 1) {
+            if ((results & result))
+                inactive[inactive_count++] = job_state_result_list (jsctx,
+                                                                    result);
+        }
+    }
 
     /* We return jobs in the following order, pending, running,
      * inactive */
 
-    if (states & FLUX_JOB_STATE_PENDING) {
-        if ((ret = get_jobs_from_list (jobs,
-                                       errp,
-                                       ctx->jsctx->pending,
-                                       max_entries,
-                                       attrs,
-                                       userid,
-                                       states,
-                                       results)) < 0)
-            goto error;
-    }
-
-    if (states & FLUX_JOB_STATE_RUNNING) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->running,
+    if (pos->section == FLUX_JOB_STATE_PENDING) {
+        if ((states & FLUX_JOB_STATE_PENDING) && pending) {
+            if ((ret = get_jobs_from_list (jsctx,
+                                           jobs,
+                                           pending,
+                                           pos->section,
+                                           &pos->after[0],
                                            max_entries,
-                                           attrs,
                                            userid,
                                            states,
                                            results)) < 0)
-                goto error;
+                return -1;
+            if (ret)
+                return 0;
         }
+        list_pos_start (pos, FLUX_JOB_STATE_RUNNING);
     }
 
-    if (states & FLUX_JOB_STATE_INACTIVE) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->inactive,
+    if (pos->section == FLUX_JOB_STATE_RUNNING) {
+        if ((states & FLUX_JOB_STATE_RUNNING) && running) {
+            if ((ret = get_jobs_from_list (jsctx,
+                                           jobs,
+                                           running,
+                                           pos->section,
+                                           &pos->after[0],
                                            max_entries,
-                                           attrs,
                                            userid,
                                            states,
                                            results)) < 0)
-                goto error;
+                return -1;
+            if (ret)
+                return 0;
         }
+        list_pos_start (pos, FLUX_JOB_STATE_INACTIVE);
     }
 
-    return jobs;
+    if (!(states & FLUX_JOB_STATE_INACTIVE))
+        return 0;
+
+    if (!pos->spill) {
+        if (inactive[0]) {
+            /* If the last job visited has been purged, the spill file
+             * may be skipped up to it, as newer jobs were listed already.
+             */
+            if (inactive_count == 1
+                && pos->after[0]
+                && !zhashx_lookup (jsctx->index, &pos->after[0]))
+                pos->spill_after = pos->after[0];
+            if ((ret = get_jobs_from_inactive_lists (jsctx,
+                                                     jobs,
+                                                     inactive,
+                                                     inactive_count,
+                                                     pos,
+                                                     max_entries,
+                                                     userid,
+                                                     states,
+                                                     results)) < 0)
+                return -1;
+            if (ret)
+                return 0;
+        }
+        pos->spill = true;
+        pos->spill_offset = spill_size (jsctx->spill);
+    }
+
+    if (jsctx->spill) {
+        struct spill_filter sf = {
+            .jobs = jobs,
+            .errp = errp,
+            .max_entries = max_entries,
+            .attrs = attrs,
+            .userid = userid,
+            .results = results,
+            .after = pos->spill_after,
+        };
+        if (spill_foreach_from (jsctx->spill,
+                                &pos->spill_offset,
+                                spill_filter_cb,
+                                &sf) < 0)
+            return -1;
+        pos->spill_after = sf.after;
+    }
 
-error_nomem:
-    errno = ENOMEM;
+    return 0;
+}
+
+static void list_stream_destroy (struct list_stream *ls)
+{
+    if (ls) {
+        int saved_errno = errno;
+        flux_msg_decref (ls->msg);
+        json_decref (ls->attrs);
+        free (ls);
+        errno = saved_errno;
+    }
+}
+
+/* zlistx_destructor_fn footprint */
+static void list_stream_destructor (void **item)
+{
+    if (item) {
+        list_stream_destroy (*item);
+        *item = NULL;
+    }
+}
+
+/* Send the next chunk of a streaming listing.  Returns 1 if the
+ * listing is complete (or failed), so the stream should be dropped,
+ * or 0 if there are more chunks to send.
+ */
+static int list_stream_next (struct list_ctx *ctx, struct list_stream *ls)
+{
+    flux_t *h = ctx->h;
+    job_info_error_t err = {{0}};
+    struct jobs_buf jobs;
+    int limit = ls->chunk_size;
+
+    if (ls->max_entries > 0 && ls->max_entries - ls->total < limit)
+        limit = ls->max_entries - ls->total;
+    if (jobs_buf_init (&jobs, ls->attrs, &err) < 0)
+        goto error;
+    jobs.cursor = true;
+
+    job_state_restart_sort (ctx->jsctx);
+    if (get_jobs (ctx, &jobs, &err, limit,
+                  ls->attrs, ls->userid, ls->states, ls->results,
+                  &ls->pos) < 0)
+        goto error;
+    if (jobs.count > 0) {
+        if (jobs_buf_finish (&jobs) < 0)
+            goto error;
+        if (flux_respond (h, ls->msg, jobs.data) < 0) {
+            flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+            goto error;
+        }
+        ls->total += jobs.count;
+    }
+    if (jobs.count == limit && ls->total != ls->max_entries) {
+        jobs_buf_free (&jobs);
+        return 0;
+    }
+    errno = ENODATA;
 error:
-    saved_errno = errno;
-    json_decref (jobs);
-    errno = saved_errno;
-    return NULL;
+    if (flux_respond_error (h, ls->msg, errno, err.text) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    jobs_buf_free (&jobs);
+    return 1;
+}
+
+/* prep:
+ * If streams are in progress, start idle watcher so the reactor does not
+ * block, and the next chunk is sent in the check callback.
+ */
+static void list_stream_prep_cb (flux_reactor_t *r,
+                                 flux_watcher_t *w,
+                                 int revents,
+                                 void *arg)
+{
+    struct list_ctx *ctx = arg;
+
+    if (zlistx_size (ctx->streams) > 0)
+        flux_watcher_start (ctx->stream_idle);
+}
+
+/* check:
+ * Send one chunk of the first stream, then move it to the end of the
+ * list so that concurrent streams take turns with each other, and with
+ * other requests handled between reactor loop iterations.
+ */
+static void list_stream_check_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
+{
+    struct list_ctx *ctx = arg;
+    struct list_stream *ls;
+
+    flux_watcher_stop (ctx->stream_idle);
+    if ((ls = zlistx_first (ctx->streams))) {
+        if (list_stream_next (ctx, ls) == 1)
+            zlistx_delete (ctx->streams, zlistx_cursor (ctx->streams));
+        else
+            zlistx_move_end (ctx->streams, zlistx_cursor (ctx->streams));
+    }
+    if (zlistx_size (ctx->streams) == 0) {
+        flux_watcher_stop (ctx->stream_prep);
+        flux_watcher_stop (ctx->stream_check);
+    }
+}
+
+static int list_stream_add (struct list_ctx *ctx, struct list_stream *ls)
+{
+    if (!zlistx_add_end (ctx->streams, ls)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    flux_watcher_start (ctx->stream_prep);
+    flux_watcher_start (ctx->stream_check);
+    return 0;
+}
+
+/* A cursor names the state of a listed job, so it must be exactly one
+ * of the states that are listed.
+ */
+static bool cursor_state_valid (int state)
+{
+    switch (state) {
+        case FLUX_JOB_STATE_DEPEND:
+        case FLUX_JOB_STATE_PRIORITY:
+        case FLUX_JOB_STATE_SCHED:
+        case FLUX_JOB_STATE_RUN:
+        case FLUX_JOB_STATE_CLEANUP:
+        case FLUX_JOB_STATE_INACTIVE:
+            return true;
+    }
+    return false;
 }
 
 void list_cb (flux_t *h, flux_msg_handler_t *mh,
               const flux_msg_t *msg, void *arg)
 {
     struct list_ctx *ctx = arg;
-    job_info_error_t err;
-    json_t *jobs = NULL;
+    job_info_error_t err = {{0}};
+    struct jobs_buf jobs = { 0 };
+    struct list_stream *ls = NULL;
     json_t *attrs;
     int max_entries;
     uint32_t userid;
     int states;
     int results;
+    int chunk_size = 0;
+    json_t *cursor_obj = NULL;
+    struct list_cursor cursor;
+    struct list_pos pos;
 
-    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i s?:i s?:o}",
                              "max_entries", &max_entries,
                              "attrs", &attrs,
                              "userid", &userid,
                              "states", &states,
-                             "results", &results) < 0) {
+                             "results", &results,
+                             "chunk_size", &chunk_size,
+                             "cursor", &cursor_obj) < 0) {
         seterror (&err, "invalid payload: %s", flux_msg_last_error (msg));
         errno = EPROTO;
         goto error;
@@ -189,6 +824,25 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (chunk_size < 0) {
+        seterror (&err, "invalid payload: chunk_size < 0 not allowed");
+        errno = EPROTO;
+        goto error;
+    }
+    if (cursor_obj) {
+        json_int_t id;
+        int state;
+        if (json_unpack (cursor_obj, "{s:I s:i}",
+                         "id", &id,
+                         "state", &state) < 0
+            || !cursor_state_valid (state)) {
+            seterror (&err, "invalid payload: invalid cursor");
+            errno = EPROTO;
+            goto error;
+        }
+        cursor.id = id;
+        cursor.state = state;
+    }
     /* If user sets no states, assume they want all information */
     if (!states)
         states = (FLUX_JOB_STATE_PENDING
@@ -197,78 +851,149 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
 
     /* If user sets no results, assume they want all information */
     if (!results)
-        results = (FLUX_JOB_RESULT_COMPLETED
-                   | FLUX_JOB_RESULT_FAILED
-                   | FLUX_JOB_RESULT_CANCELED
-                   | FLUX_JOB_RESULT_TIMEOUT);
+        results = JOB_RESULT_ALL;
 
-    if (!(jobs = get_jobs (ctx, &err, max_entries,
-                           attrs, userid, states, results)))
+    if (jobs_buf_init (&jobs, attrs, &err) < 0)
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0) {
-        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    /* Streaming requests are listed one chunk per reactor loop iteration.
+     * The attrs were parsed above only to validate them.
+     */
+    if (flux_msg_is_streaming (msg)) {
+        if (!(ls = calloc (1, sizeof (*ls))))
+            goto error;
+        ls->msg = flux_msg_incref (msg);
+        ls->attrs = json_incref (attrs);
+        ls->max_entries = max_entries;
+        ls->userid = userid;
+        ls->states = states;
+        ls->results = results;
+        ls->chunk_size = chunk_size ? chunk_size : list_chunk_size;
+        list_pos_init (ctx, &ls->pos, cursor_obj ? &cursor : NULL);
+        if (list_stream_add (ctx, ls) < 0)
+            goto error;
+        jobs_buf_free (&jobs);
+        return;
+    }
+
+    job_state_restart_sort (ctx->jsctx);
+    list_pos_init (ctx, &pos, cursor_obj ? &cursor : NULL);
+    if (get_jobs (ctx, &jobs, &err, max_entries,
+                  attrs, userid, states, results, &pos) < 0)
+        goto error;
+
+    if (jobs_buf_finish (&jobs) < 0)
+        goto error;
+    if (flux_respond (h, msg, jobs.data) < 0) {
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
         goto error;
     }
 
-    json_decref (jobs);
+    jobs_buf_free (&jobs);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, err.text) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
-    json_decref (jobs);
+    list_stream_destroy (ls);
+    jobs_buf_free (&jobs);
 }
 
-/* Create a JSON array of 'job' objects.  'since' limits entries
- * returned, only returning entries with 't_inactive' newer than the
- * timestamp.  Returns JSON object which the caller must free.  On
- * error, return NULL with errno set:
+/* Drop streaming requests from a client that has disconnected.
+ */
+void list_disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
+                         const flux_msg_t *msg, void *arg)
+{
+    struct list_ctx *ctx = arg;
+    struct list_stream *ls;
+
+    ls = zlistx_first (ctx->streams);
+    while (ls) {
+        if (flux_disconnect_match (msg, ls->msg))
+            zlistx_delete (ctx->streams, zlistx_cursor (ctx->streams));
+        ls = zlistx_next (ctx->streams);
+    }
+}
+
+int list_stream_setup (struct list_ctx *ctx)
+{
+    flux_reactor_t *r = flux_get_reactor (ctx->h);
+
+    if (!(ctx->streams = zlistx_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    zlistx_set_destructor (ctx->streams, list_stream_destructor);
+    ctx->stream_prep = flux_prepare_watcher_create (r,
+                                                    list_stream_prep_cb,
+                                                    ctx);
+    ctx->stream_check = flux_check_watcher_create (r,
+                                                   list_stream_check_cb,
+                                                   ctx);
+    ctx->stream_idle = flux_idle_watcher_create (r, NULL, NULL);
+    if (!ctx->stream_prep || !ctx->stream_check || !ctx->stream_idle)
+        return -1;
+    return 0;
+}
+
+void list_stream_cleanup (struct list_ctx *ctx)
+{
+    struct list_stream *ls;
+
+    if (ctx->streams) {
+        while ((ls = zlistx_first (ctx->streams))) {
+            if (flux_respond_error (ctx->h, ls->msg, ENOSYS, NULL) < 0)
+                flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+            zlistx_delete (ctx->streams, zlistx_cursor (ctx->streams));
+        }
+        zlistx_destroy (&ctx->streams);
+    }
+    flux_watcher_destroy (ctx->stream_prep);
+    flux_watcher_destroy (ctx->stream_check);
+    flux_watcher_destroy (ctx->stream_idle);
+}
+
+/* Fill 'jobs' with 'job' objects.  'since' limits entries returned,
+ * only returning entries with 't_inactive' newer than the timestamp.
+ * Returns 0 on success.  On error, return -1 with errno set:
  *
- * EPROTO - malformed or empty attrs array
  * ENOMEM - out of memory
  */
-json_t *get_inactive_jobs (struct list_ctx *ctx,
-                           job_info_error_t *errp,
-                           int max_entries,
-                           double since,
-                           json_t *attrs,
-                           const char *name)
-{
-    json_t *jobs = NULL;
+int get_inactive_jobs (struct list_ctx *ctx,
+                       struct jobs_buf *jobs,
+                       job_info_error_t *errp,
+                       int max_entries,
+                       double since,
+                       json_t *attrs,
+                       const char *name)
+{
     struct job *job;
-    int saved_errno;
-
-    if (!(jobs = json_array ()))
-        goto error_nomem;
 
     job = zlistx_first (ctx->jsctx->inactive);
     while (job && (job->t_inactive > since)) {
-        json_t *o;
         if (!name || strcmp (job->name, name) == 0) {
-            if (!(o = job_to_json (job, attrs, errp)))
-                goto error;
-            if (json_array_append_new (jobs, o) < 0) {
-                json_decref (o);
-                errno = ENOMEM;
-                goto error;
-            }
-            if (json_array_size (jobs) == max_entries)
-                goto out;
+            if (jobs_buf_add_job (jobs, job) < 0)
+                return -1;
+            if (jobs->count == max_entries)
+                return 0;
         }
         job = zlistx_next (ctx->jsctx->inactive);
     }
-
-out:
-    return jobs;
-
-error_nomem:
-    errno = ENOMEM;
-error:
-    saved_errno = errno;
-    json_decref (jobs);
-    errno = saved_errno;
-    return NULL;
+    if (!job) {
+        struct spill_filter sf = {
+            .jobs = jobs,
+            .errp = errp,
+            .max_entries = max_entries,
+            .attrs = attrs,
+            .userid = FLUX_USERID_UNKNOWN,
+            .results = ~0,
+            .since = since,
+            .name = name,
+        };
+        if (get_jobs_from_spill (ctx, &sf) < 0)
+            return -1;
+    }
+    return 0;
 }
 
 void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -276,7 +1001,7 @@ void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct list_ctx *ctx = arg;
     job_info_error_t err = {{0}};
-    json_t *jobs = NULL;
+    struct jobs_buf jobs = { 0 };
     int max_entries;
     double since;
     json_t *attrs;
@@ -300,25 +1025,53 @@ void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
-    if (!(jobs = get_inactive_jobs (ctx, &err,
-                                    max_entries,
-                                    since,
-                                    attrs,
-                                    name)))
+    if (jobs_buf_init (&jobs, attrs, &err) < 0)
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0) {
-        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    job_state_restart_sort (ctx->jsctx);
+    if (get_inactive_jobs (ctx, &jobs, &err,
+                           max_entries,
+                           since,
+                           attrs,
+                           name) < 0
+        || jobs_buf_finish (&jobs) < 0)
+        goto error;
+
+    if (flux_respond (h, msg, jobs.data) < 0) {
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
         goto error;
     }
 
-    json_decref (jobs);
+    jobs_buf_free (&jobs);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, err.text) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
-    json_decref (jobs);
+    jobs_buf_free (&jobs);
+}
+
+/* Look up a job purged to the spill file.  Returns JSON object which
+ * the caller must free.  On error, return NULL with errno set (ENOENT
+ * if the job was not purged).
+ */
+static json_t *get_spilled_job (struct list_ctx *ctx,
+                                job_info_error_t *errp,
+                                flux_jobid_t id,
+                                json_t *attrs)
+{
+    json_t *record;
+    json_t *o;
+
+    if (!ctx->jsctx->spill) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (!(record = spill_lookup (ctx->jsctx->spill, id)))
+        return NULL;
+    o = job_record_to_json (record, attrs, errp);
+    ERRNO_SAFE_WRAP (json_decref, record);
+    return o;
 }
 
 int wait_id_valid (struct list_ctx *ctx, struct idsync_data *isd)
@@ -471,6 +1224,10 @@ json_t *get_job_by_id (struct list_ctx *ctx,
     struct job *job;
 
     if (!(job = zhashx_lookup (ctx->jsctx->index, &id))) {
+        json_t *o;
+        if ((o = get_spilled_job (ctx, errp, id, attrs))
+            || errno != ENOENT)
+            return o;
         if (stall) {
             if (check_id_valid (ctx, msg, id, attrs) < 0) {
                 flux_log_error (ctx->h, "%s: check_id_valid", __FUNCTION__);
@@ -565,14 +1322,6 @@ int list_attrs_append (json_t *a, const char *attr)
 void list_attrs_cb (flux_t *h, flux_msg_handler_t *mh,
                     const flux_msg_t *msg, void *arg)
 {
-    const char *attrs[] = { "userid", "urgency", "priority", "t_submit",
-                            "t_depend", "t_run", "t_cleanup", "t_inactive",
-                            "state", "name", "ntasks", "nnodes",
-                            "ranks", "nodelist", "success", "exception_occurred",
-                            "exception_type", "exception_severity",
-                            "exception_note", "result", "expiration",
-                            "annotations", "waitstatus", "dependencies",
-                            NULL };
     json_t *a = NULL;
     int i;
 
@@ -581,8 +1330,8 @@ void list_attrs_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
 
-    for (i = 0; attrs[i] != NULL; i++) {
-        if (list_attrs_append (a, attrs[i]) < 0)
+    for (i = 0; job_attrs[i] != NULL; i++) {
+        if (list_attrs_append (a, job_attrs[i]) < 0)
             goto error;
     }
 
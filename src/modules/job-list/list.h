@@ -27,6 +27,14 @@ void list_id_cb (flux_t *h, flux_msg_handler_t *mh,
 void list_attrs_cb (flux_t *h, flux_msg_handler_t *mh,
                     const flux_msg_t *msg, void *arg);
 
+void list_disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
+                         const flux_msg_t *msg, void *arg);
+
+/* Set up and clean up state for streaming job-list.list requests.
+ */
+int list_stream_setup (struct list_ctx *ctx);
+void list_stream_cleanup (struct list_ctx *ctx);
+
 #endif /* ! _FLUX_JOB_LIST_LIST_H */
 
 /*
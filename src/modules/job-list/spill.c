@@ -0,0 +1,257 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* spill.c - append-only file of inactive jobs purged from memory
+ *
+ * Jobs are encoded as compact JSON, one per line, so the file can be
+ * read backwards (newest job first) a block at a time without an index
+ * in memory.  Since jobs are purged oldest first, readers may stop as
+ * soon as they reach a job older than they are interested in.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "spill.h"
+
+/* Read the file backwards in blocks of at least this size.
+ */
+static const size_t spill_block_size = 65536;
+
+struct spill {
+    int fd;
+    off_t size;
+    int count;
+    flux_jobid_t min_id;
+    flux_jobid_t max_id;
+};
+
+void spill_destroy (struct spill *sp)
+{
+    if (sp) {
+        int saved_errno = errno;
+        if (sp->fd >= 0)
+            close (sp->fd);
+        free (sp);
+        errno = saved_errno;
+    }
+}
+
+struct spill *spill_create (const char *path)
+{
+    struct spill *sp;
+
+    if (!(sp = calloc (1, sizeof (*sp))))
+        return NULL;
+    if ((sp->fd = open (path,
+                        O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                        0600)) < 0) {
+        free (sp);
+        return NULL;
+    }
+    return sp;
+}
+
+int spill_append (struct spill *sp, json_t *job)
+{
+    json_int_t id;
+    char *s;
+    size_t len;
+
+    if (!sp || !job || json_unpack (job, "{s:I}", "id", &id) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* N.B. compact encoding has no newlines since they are escaped
+     * within strings.
+     */
+    if (!(s = json_dumps (job, JSON_COMPACT))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    len = strlen (s);
+    s[len++] = '\n'; // replace NUL terminator
+    if (write_all (sp->fd, s, len) < 0) {
+        int saved_errno = errno;
+        free (s);
+        /* Drop any partial record, reporting failure to do so
+         * in preference to the write error.
+         */
+        if (ftruncate (sp->fd, sp->size) < 0)
+            saved_errno = errno;
+        errno = saved_errno;
+        return -1;
+    }
+    free (s);
+    if (sp->count == 0 || id < sp->min_id)
+        sp->min_id = id;
+    if (sp->count == 0 || id > sp->max_id)
+        sp->max_id = id;
+    sp->size += len;
+    sp->count++;
+    return 0;
+}
+
+static int spill_callback (spill_f cb, void *arg, const char *s, size_t len)
+{
+    json_t *job;
+    int rc;
+
+    if (!(job = json_loadb (s, len, 0, NULL))) {
+        errno = EPROTO;
+        return -1;
+    }
+    rc = cb (job, arg);
+    ERRNO_SAFE_WRAP (json_decref, job);
+    return rc;
+}
+
+/* The buffer holds the file contents from offset 'pos' to the end of
+ * the last record not yet visited, which always ends in a newline.
+ * Records are consumed from the end of the buffer, and the buffer is
+ * extended towards the start of the file when it holds no complete
+ * record.
+ */
+int spill_foreach_from (struct spill *sp,
+                        off_t *offset,
+                        spill_f cb,
+                        void *arg)
+{
+    char *buf = NULL;
+    size_t alloc = 0;
+    size_t len = 0;
+    off_t pos;
+    int rc = 0;
+
+    if (!sp || !offset || *offset < 0 || *offset > sp->size || !cb) {
+        errno = EINVAL;
+        return -1;
+    }
+    pos = *offset;
+    while (len > 0 || pos > 0) {
+        char *nl = NULL;
+        size_t start;
+
+        if (len > 0)
+            nl = memrchr (buf, '\n', len - 1);
+        if (nl || pos == 0) {
+            start = nl ? nl - buf + 1 : 0;
+            *offset = pos + start;
+            if ((rc = spill_callback (cb, arg, buf + start, len - start - 1)))
+                break;
+            len = start;
+        }
+        else {
+            size_t chunk = len > spill_block_size ? len : spill_block_size;
+            ssize_t n;
+
+            if (chunk > pos)
+                chunk = pos;
+            if (len + chunk > alloc) {
+                char *nbuf;
+                if (!(nbuf = realloc (buf, len + chunk))) {
+                    rc = -1;
+                    break;
+                }
+                buf = nbuf;
+                alloc = len + chunk;
+            }
+            memmove (buf + chunk, buf, len);
+            if ((n = pread (sp->fd, buf, chunk, pos - chunk)) < 0) {
+                rc = -1;
+                break;
+            }
+            if (n < chunk) {
+                errno = EIO;
+                rc = -1;
+                break;
+            }
+            pos -= chunk;
+            len += chunk;
+        }
+    }
+    ERRNO_SAFE_WRAP (free, buf);
+    return rc < 0 ? -1 : 0;
+}
+
+int spill_foreach (struct spill *sp, spill_f cb, void *arg)
+{
+    off_t offset = sp ? sp->size : 0;
+
+    return spill_foreach_from (sp, &offset, cb, arg);
+}
+
+struct lookup {
+    flux_jobid_t id;
+    json_t *job;
+};
+
+static int lookup_cb (json_t *job, void *arg)
+{
+    struct lookup *l = arg;
+    json_int_t id;
+
+    if (json_unpack (job, "{s:I}", "id", &id) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (id != l->id)
+        return 0;
+    l->job = json_incref (job);
+    return 1;
+}
+
+json_t *spill_lookup (struct spill *sp, flux_jobid_t id)
+{
+    struct lookup l = { .id = id, .job = NULL };
+
+    if (!sp) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (sp->count == 0 || id < sp->min_id || id > sp->max_id) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (spill_foreach (sp, lookup_cb, &l) < 0)
+        return NULL;
+    if (!l.job) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return l.job;
+}
+
+int spill_count (struct spill *sp)
+{
+    return sp ? sp->count : 0;
+}
+
+size_t spill_size (struct spill *sp)
+{
+    return sp ? sp->size : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,69 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_LIST_SPILL_H
+#define _FLUX_JOB_LIST_SPILL_H
+
+#include <sys/types.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+/* Inactive jobs purged from memory are appended to a spill file, one
+ * JSON object per line, in the order they were purged (oldest first).
+ * Each object must contain the job "id".
+ */
+struct spill;
+
+/* Callback for spill_foreach().  Return 0 to continue, 1 to stop, or
+ * -1 with errno set to stop with an error.  'job' is only valid for the
+ * duration of the callback.
+ */
+typedef int (*spill_f)(json_t *job, void *arg);
+
+/* Create (or truncate) the spill file at 'path'.
+ */
+struct spill *spill_create (const char *path);
+void spill_destroy (struct spill *sp);
+
+/* Append 'job' to the spill file.
+ */
+int spill_append (struct spill *sp, json_t *job);
+
+/* Call 'cb' for each job in the spill file, most recently appended
+ * first.  Returns 0 on success, or -1 with errno set.
+ */
+int spill_foreach (struct spill *sp, spill_f cb, void *arg);
+
+/* Like spill_foreach(), but start with the job preceding byte '*offset'
+ * of the file, and set '*offset' to the start of each job as it is passed
+ * to 'cb'.  A listing may be resumed later from '*offset', without
+ * revisiting jobs, since the file is only ever appended to.  Start with
+ * '*offset' equal to spill_size() to visit every job.
+ */
+int spill_foreach_from (struct spill *sp,
+                        off_t *offset,
+                        spill_f cb,
+                        void *arg);
+
+/* Find job 'id' in the spill file.  Returns a new reference, or NULL
+ * with errno set (ENOENT if not found).
+ */
+json_t *spill_lookup (struct spill *sp, flux_jobid_t id);
+
+/* Number of jobs and bytes in the spill file.
+ */
+int spill_count (struct spill *sp);
+size_t spill_size (struct spill *sp);
+
+#endif /* !_FLUX_JOB_LIST_SPILL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
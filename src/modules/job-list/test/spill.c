@@ -0,0 +1,287 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-list/spill.h"
+
+struct collect {
+    json_int_t expected;    // next id expected
+    int count;
+    int errors;
+    int stop_after;         // stop iteration after this many, 0=never
+};
+
+static int collect_cb (json_t *job, void *arg)
+{
+    struct collect *c = arg;
+    json_int_t id;
+
+    if (json_unpack (job, "{s:I}", "id", &id) < 0 || id != c->expected)
+        c->errors++;
+    c->expected--;
+    c->count++;
+    if (c->stop_after && c->count == c->stop_after)
+        return 1;
+    return 0;
+}
+
+static int fail_cb (json_t *job, void *arg)
+{
+    errno = EPERM;
+    return -1;
+}
+
+static char *make_path (char *tmpdir)
+{
+    char *path;
+
+    if (!mkdtemp (tmpdir))
+        BAIL_OUT ("mkdtemp failed");
+    if (asprintf (&path, "%s/spill", tmpdir) < 0)
+        BAIL_OUT ("asprintf failed");
+    return path;
+}
+
+static void append_jobs (struct spill *sp, int first, int count, int padlen)
+{
+    char *pad;
+    int errors = 0;
+
+    if (!(pad = calloc (1, padlen + 1)))
+        BAIL_OUT ("calloc failed");
+    memset (pad, 'x', padlen);
+    for (int i = first; i < first + count; i++) {
+        json_t *o;
+        if (!(o = json_pack ("{s:i s:f s:s}",
+                             "id", i,
+                             "t_inactive", (double)i,
+                             "name", pad)))
+            BAIL_OUT ("json_pack failed");
+        if (spill_append (sp, o) < 0)
+            errors++;
+        json_decref (o);
+    }
+    free (pad);
+    ok (errors == 0,
+        "spill_append %d jobs with %d byte names works", count, padlen);
+}
+
+static void test_basic (void)
+{
+    char tmpdir[] = "/tmp/spill-test.XXXXXX";
+    char *path = make_path (tmpdir);
+    struct spill *sp;
+    struct collect c;
+    json_t *o;
+    json_int_t id;
+
+    ok ((sp = spill_create (path)) != NULL,
+        "spill_create works");
+    ok (spill_count (sp) == 0 && spill_size (sp) == 0,
+        "spill is initially empty");
+
+    memset (&c, 0, sizeof (c));
+    ok (spill_foreach (sp, collect_cb, &c) == 0 && c.count == 0,
+        "spill_foreach on empty spill works");
+    errno = 0;
+    ok (spill_lookup (sp, 1) == NULL && errno == ENOENT,
+        "spill_lookup on empty spill fails with ENOENT");
+
+    append_jobs (sp, 1, 100, 8);
+    ok (spill_count (sp) == 100 && spill_size (sp) > 0,
+        "spill_count reports 100 jobs");
+
+    memset (&c, 0, sizeof (c));
+    c.expected = 100;
+    ok (spill_foreach (sp, collect_cb, &c) == 0
+        && c.count == 100
+        && c.errors == 0,
+        "spill_foreach visits jobs newest first");
+
+    memset (&c, 0, sizeof (c));
+    c.expected = 100;
+    c.stop_after = 10;
+    ok (spill_foreach (sp, collect_cb, &c) == 0
+        && c.count == 10
+        && c.errors == 0,
+        "spill_foreach stops when callback returns 1");
+
+    errno = 0;
+    ok (spill_foreach (sp, fail_cb, NULL) < 0 && errno == EPERM,
+        "spill_foreach fails with callback errno");
+
+    o = spill_lookup (sp, 42);
+    ok (o != NULL
+        && json_unpack (o, "{s:I}", "id", &id) == 0
+        && id == 42,
+        "spill_lookup finds job");
+    json_decref (o);
+    errno = 0;
+    ok (spill_lookup (sp, 101) == NULL && errno == ENOENT,
+        "spill_lookup of unknown job fails with ENOENT");
+
+    o = json_pack ("{s:s}", "name", "foo");
+    errno = 0;
+    ok (spill_append (sp, o) < 0 && errno == EINVAL,
+        "spill_append of job without id fails with EINVAL");
+    json_decref (o);
+
+    spill_destroy (sp);
+
+    ok ((sp = spill_create (path)) != NULL
+        && spill_count (sp) == 0
+        && spill_size (sp) == 0,
+        "spill_create truncates existing file");
+    spill_destroy (sp);
+
+    unlink (path);
+    rmdir (tmpdir);
+    free (path);
+}
+
+/* Records that span read blocks, and records larger than a block.
+ */
+static void test_large (void)
+{
+    char tmpdir[] = "/tmp/spill-test.XXXXXX";
+    char *path = make_path (tmpdir);
+    struct spill *sp;
+    struct collect c;
+    json_t *o;
+    json_int_t id;
+
+    if (!(sp = spill_create (path)))
+        BAIL_OUT ("spill_create failed");
+    append_jobs (sp, 1, 1000, 300);
+    append_jobs (sp, 1001, 3, 200000);
+    append_jobs (sp, 1004, 1000, 10);
+
+    memset (&c, 0, sizeof (c));
+    c.expected = 2003;
+    ok (spill_foreach (sp, collect_cb, &c) == 0
+        && c.count == 2003
+        && c.errors == 0,
+        "spill_foreach visits all jobs across blocks");
+
+    o = spill_lookup (sp, 1002);
+    ok (o != NULL
+        && json_unpack (o, "{s:I}", "id", &id) == 0
+        && id == 1002,
+        "spill_lookup finds large job");
+    json_decref (o);
+    o = spill_lookup (sp, 1);
+    ok (o != NULL
+        && json_unpack (o, "{s:I}", "id", &id) == 0
+        && id == 1,
+        "spill_lookup finds first job");
+    json_decref (o);
+
+    spill_destroy (sp);
+    unlink (path);
+    rmdir (tmpdir);
+    free (path);
+}
+
+/* Resume a listing in chunks, with jobs appended between chunks.
+ */
+static void test_resume (void)
+{
+    char tmpdir[] = "/tmp/spill-test.XXXXXX";
+    char *path = make_path (tmpdir);
+    struct spill *sp;
+    struct collect c;
+    off_t offset;
+    json_t *o;
+    int chunks = 0;
+    int errors = 0;
+
+    if (!(sp = spill_create (path)))
+        BAIL_OUT ("spill_create failed");
+    append_jobs (sp, 1, 1000, 300);
+    offset = spill_size (sp);
+
+    memset (&c, 0, sizeof (c));
+    c.expected = 1000;
+    while (c.count < 1000) {
+        c.stop_after = c.count + 7;
+        if (spill_foreach_from (sp, &offset, collect_cb, &c) < 0)
+            errors++;
+        if (++chunks > 1000)
+            break;
+        if (!(o = json_pack ("{s:i}", "id", 1000 + chunks))
+            || spill_append (sp, o) < 0)
+            errors++;
+        json_decref (o);
+    }
+    ok (errors == 0
+        && c.count == 1000
+        && c.errors == 0,
+        "spill_foreach_from resumes across blocks without revisiting jobs");
+    ok (spill_foreach_from (sp, &offset, collect_cb, &c) == 0
+        && c.count == 1000,
+        "spill_foreach_from at the start of the file visits no jobs");
+
+    spill_destroy (sp);
+    unlink (path);
+    rmdir (tmpdir);
+    free (path);
+}
+
+static void test_inval (void)
+{
+    off_t offset = 0;
+
+    errno = 0;
+    ok (spill_create ("/nonexistent/spill") == NULL && errno == ENOENT,
+        "spill_create with bad path fails with ENOENT");
+    errno = 0;
+    ok (spill_append (NULL, NULL) < 0 && errno == EINVAL,
+        "spill_append sp=NULL fails with EINVAL");
+    errno = 0;
+    ok (spill_foreach (NULL, collect_cb, NULL) < 0 && errno == EINVAL,
+        "spill_foreach sp=NULL fails with EINVAL");
+    errno = 0;
+    ok (spill_foreach_from (NULL, &offset, collect_cb, NULL) < 0
+        && errno == EINVAL,
+        "spill_foreach_from sp=NULL fails with EINVAL");
+    errno = 0;
+    ok (spill_lookup (NULL, 1) == NULL && errno == EINVAL,
+        "spill_lookup sp=NULL fails with EINVAL");
+    ok (spill_count (NULL) == 0 && spill_size (NULL) == 0,
+        "spill_count/spill_size sp=NULL return 0");
+    lives_ok ({spill_destroy (NULL);},
+        "spill_destroy sp=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_large ();
+    test_resume ();
+    test_inval ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -12,6 +12,12 @@
  *
  * Please refer to RFC27 for scheduler protocol
  *
+ * If the scheduler sets "batch" in its ready request, alloc and free
+ * requests that would otherwise be sent individually in one reactor loop
+ * iteration are instead sent as one sched.alloc-batch or sched.free-batch
+ * request, and the scheduler responds in kind.  Schedulers that don't
+ * set "batch" get one message per job as before.
+ *
  * TODO:
  * - implement flow control (credit based?) interface mode
  */
@@ -25,6 +31,7 @@
 #include <assert.h>
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "job.h"
 #include "alloc.h"
@@ -49,8 +56,14 @@ struct alloc {
     unsigned int alloc_pending_count;
     unsigned int free_pending_count;
     char *sched_sender; // for disconnect
+    bool batch;         // scheduler accepts batched requests
+    json_t *free_batch; // job ids awaiting sched.free-batch request
 };
 
+/* Maximum number of jobs in one sched.alloc-batch request.
+ */
+static const int alloc_batch_max = 1024;
+
 static void requeue_pending (struct alloc *alloc, struct job *job)
 {
     struct job_manager *ctx = alloc->ctx;
@@ -104,6 +117,8 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
             job = zhashx_next (ctx->active_jobs);
         }
         alloc->ready = false;
+        alloc->batch = false;
+        json_array_clear (alloc->free_batch);
         alloc->alloc_pending_count = 0;
         alloc->free_pending_count = 0;
         free (alloc->sched_sender);
@@ -112,47 +127,98 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
     }
 }
 
-/* Handle a sched.free response.
+/* Handle the response to a free request for job 'id'.
  */
-static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                              const flux_msg_t *msg, void *arg)
+static int free_response (struct job_manager *ctx, flux_jobid_t id)
 {
-    struct job_manager *ctx = arg;
-    flux_jobid_t id = 0;
+    flux_t *h = ctx->h;
     struct job *job;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown;
-    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
-        goto teardown;
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->has_resources) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not allocated",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     job->free_pending = 0;
     ctx->alloc->free_pending_count--;
     if (event_job_post_pack (ctx->event, job, "free", 0, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+/* Handle a sched.free response.
+ */
+static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    flux_jobid_t id = 0;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown;
+    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
+        goto teardown;
+    if (free_response (ctx, id) < 0)
         goto teardown;
     return;
 teardown:
     interface_teardown (ctx->alloc, "free response error", errno);
 }
 
-/* Send sched.free request for job.
+/* Handle a sched.free-batch response.
+ */
+static void free_batch_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *ids;
+    size_t index;
+    json_t *o;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown;
+    if (flux_msg_unpack (msg, "{s:o}", "ids", &ids) < 0)
+        goto teardown;
+    if (!json_is_array (ids)) {
+        errno = EPROTO;
+        goto teardown;
+    }
+    json_array_foreach (ids, index, o) {
+        if (!json_is_integer (o)) {
+            errno = EPROTO;
+            goto teardown;
+        }
+        if (free_response (ctx, json_integer_value (o)) < 0)
+            goto teardown;
+    }
+    return;
+teardown:
+    interface_teardown (ctx->alloc, "free response error", errno);
+}
+
+/* Send sched.free request for job, or add it to the next
+ * sched.free-batch request if the scheduler accepts batches.
  * Update flags.
  */
 int free_request (struct alloc *alloc, struct job *job)
 {
     flux_msg_t *msg;
 
+    if (alloc->batch) {
+        if (json_array_append_new (alloc->free_batch,
+                                   json_integer (job->id)) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        return 0;
+    }
     if (!(msg = flux_request_encode ("sched.free", NULL)))
         return -1;
     if (flux_msg_pack (msg, "{s:I}", "id", job->id) < 0)
@@ -187,13 +253,13 @@ int cancel_request (struct alloc *alloc, struct job *job)
     return 0;
 }
 
-/* Handle a sched.alloc response.
+/* Handle the response to an alloc request, or one entry of a
+ * sched.alloc-batch response.
  * Update flags.
  */
-static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                               const flux_msg_t *msg, void *arg)
+static int alloc_response (struct job_manager *ctx, json_t *o)
 {
-    struct job_manager *ctx = arg;
+    flux_t *h = ctx->h;
     struct alloc *alloc = ctx->alloc;
     flux_jobid_t id;
     int type;
@@ -202,25 +268,25 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
     struct job *job;
     bool cleared = false;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
-    if (flux_msg_unpack (msg, "{s:I s:i s?:s s?:o}",
-                              "id", &id,
-                              "type", &type,
-                              "note", &note,
-                              "annotations", &annotations) < 0)
-        goto teardown;
+    if (json_unpack (o, "{s:I s:i s?:s s?:o}",
+                        "id", &id,
+                        "type", &type,
+                        "note", &note,
+                        "annotations", &annotations) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->alloc_pending) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not requested",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     switch (type) {
     case FLUX_SCHED_ALLOC_SUCCESS:
@@ -237,7 +303,7 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
                       "sched.alloc-response: id=%ju already allocated",
                       (uintmax_t)id);
             errno = EEXIST;
-            goto teardown;
+            return -1;
         }
         if (annotations_update_and_publish (ctx, job, annotations) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
@@ -245,17 +311,17 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             if (event_job_post_pack (ctx->event, job, "alloc", 0,
                                      "{ s:O }",
                                      "annotations", job->annotations) < 0)
-                goto teardown;
+                return -1;
         }
         else {
             if (event_job_post_pack (ctx->event, job, "alloc", 0, NULL) < 0)
-                goto teardown;
+                return -1;
         }
         break;
     case FLUX_SCHED_ALLOC_ANNOTATE: // annotation
         if (!annotations) {
             errno = EPROTO;
-            goto teardown;
+            return -1;
         }
         if (annotations_update_and_publish (ctx, job, annotations) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
@@ -283,7 +349,7 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
                                  "severity", 0,
                                  "userid", FLUX_USERID_UNKNOWN,
                                  "note", note ? note : "") < 0)
-            goto teardown;
+            return -1;
         break;
     case FLUX_SCHED_ALLOC_CANCEL:
         alloc->alloc_pending_count--;
@@ -310,34 +376,88 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             flux_log_error (h,
                             "event_job_action id=%ju on alloc cancel",
                             (uintmax_t)id);
-            goto teardown;
+            return -1;
         }
         drain_check (alloc->ctx->drain);
         break;
     default:
         errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Handle a sched.alloc response.
+ */
+static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *o;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
+    if (flux_msg_unpack (msg, "o", &o) < 0)
         goto teardown;
+    if (alloc_response (ctx, o) < 0)
+        goto teardown;
+    return;
+teardown:
+    interface_teardown (ctx->alloc, "alloc response error", errno);
+}
+
+/* Handle a sched.alloc-batch response.
+ */
+static void alloc_batch_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *responses;
+    size_t index;
+    json_t *o;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
+    if (flux_msg_unpack (msg, "{s:o}", "responses", &responses) < 0)
+        goto teardown;
+    if (!json_is_array (responses)) {
+        errno = EPROTO;
+        goto teardown;
+    }
+    json_array_foreach (responses, index, o) {
+        if (alloc_response (ctx, o) < 0)
+            goto teardown;
     }
     return;
 teardown:
-    interface_teardown (alloc, "alloc response error", errno);
+    interface_teardown (ctx->alloc, "alloc response error", errno);
 }
 
-/* Send sched.alloc request for job.
- * Update flags.
+static json_t *alloc_request_payload (struct job *job)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:I s:I s:i s:f s:O}",
+                         "id", job->id,
+                         "priority", (json_int_t)job->priority,
+                         "userid", job->userid,
+                         "t_submit", job->t_submit,
+                         "jobspec", job->jobspec_redacted))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+/* Send request 'topic' with payload 'o'.
  */
-int alloc_request (struct alloc *alloc, struct job *job)
+static int alloc_send (struct alloc *alloc, const char *topic, json_t *o)
 {
     flux_msg_t *msg;
 
-    if (!(msg = flux_request_encode ("sched.alloc", NULL)))
+    if (!(msg = flux_request_encode (topic, NULL)))
         return -1;
-    if (flux_msg_pack (msg, "{s:I s:I s:i s:f s:O}",
-                            "id", job->id,
-                            "priority", (json_int_t)job->priority,
-                            "userid", job->userid,
-                            "t_submit", job->t_submit,
-                            "jobspec", job->jobspec_redacted) < 0)
+    if (flux_msg_pack (msg, "O", o) < 0)
         goto error;
     if (flux_send (alloc->ctx->h, msg, 0) < 0)
         goto error;
@@ -348,6 +468,40 @@ error:
     return -1;
 }
 
+/* Send sched.alloc request for job.
+ * Update flags.
+ */
+int alloc_request (struct alloc *alloc, struct job *job)
+{
+    json_t *o;
+    int rc;
+
+    if (!(o = alloc_request_payload (job)))
+        return -1;
+    rc = alloc_send (alloc, "sched.alloc", o);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return rc;
+}
+
+/* Send pending free requests as one sched.free-batch request.
+ */
+static int free_batch_flush (struct alloc *alloc)
+{
+    json_t *o;
+    int rc;
+
+    if (json_array_size (alloc->free_batch) == 0)
+        return 0;
+    if (!(o = json_pack ("{s:O}", "ids", alloc->free_batch))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    rc = alloc_send (alloc, "sched.free-batch", o);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    json_array_clear (alloc->free_batch);
+    return rc;
+}
+
 /* sched-hello:
  * Scheduler obtains jobs that have resources allocated.
  */
@@ -399,12 +553,14 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
     struct job_manager *ctx = arg;
     const char *mode;
     int limit = 0;
+    int batch = 0;
     int count;
     struct job *job;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s?:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s?:i s?:b}",
                                         "mode", &mode,
-                                        "limit", &limit) < 0)
+                                        "limit", &limit,
+                                        "batch", &batch) < 0)
         goto error;
     if (!strcmp (mode, "limited")) {
         if (limit <= 0) {
@@ -424,7 +580,9 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     ctx->alloc->ready = true;
-    flux_log (h, LOG_DEBUG, "scheduler: ready %s", mode);
+    ctx->alloc->batch = batch ? true : false;
+    flux_log (h, LOG_DEBUG, "scheduler: ready %s%s",
+              mode, batch ? " batch" : "");
     count = zlistx_size (ctx->alloc->queue);
     if (flux_respond_pack (h, msg, "{s:i}", "count", count) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
@@ -459,6 +617,10 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct alloc *alloc = ctx->alloc;
     struct job *job;
 
+    if (json_array_size (alloc->free_batch) > 0) {
+        flux_watcher_start (alloc->idle);
+        return;
+    }
     if (!alloc->ready || alloc->disable)
         return;
     if (alloc->alloc_limit
@@ -473,9 +635,89 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
         flux_watcher_start (alloc->idle);
 }
 
+/* Move job from the alloc queue to pending after its alloc request
+ * has been sent (or added to a batch).
+ */
+static void alloc_set_pending (struct alloc *alloc, struct job *job)
+{
+    struct job_manager *ctx = alloc->ctx;
+    bool fwd = job->priority > (FLUX_JOB_PRIORITY_MAX / 2);
+
+    zlistx_delete (alloc->queue, job->handle);
+    job->handle = NULL;
+    job->alloc_pending = 1;
+    job->alloc_queued = 0;
+    alloc->alloc_pending_count++;
+    if (alloc->alloc_limit) {
+        if (!(job->handle = zlistx_insert (alloc->pending_jobs, job, fwd)))
+            flux_log (ctx->h, LOG_ERR, "failed to enqueue pending job");
+    }
+    if ((job->flags & FLUX_JOB_DEBUG))
+        (void)event_job_post_pack (ctx->event, job,
+                                   "debug.alloc-request", 0, NULL);
+}
+
+/* Return the next job that may be sent an alloc request, or NULL.
+ * The queue is sorted from highest to lowest priority, so if the
+ * first job has priority=MIN, all other jobs must have the same priority,
+ * and no alloc requests can be sent.
+ */
+static struct job *alloc_next (struct alloc *alloc)
+{
+    struct job *job;
+
+    if (alloc->alloc_limit
+        && alloc->alloc_pending_count >= alloc->alloc_limit)
+        return NULL;
+    if (!(job = zlistx_first (alloc->queue))
+        || job->priority == FLUX_JOB_PRIORITY_MIN)
+        return NULL;
+    return job;
+}
+
+/* Send up to alloc_batch_max alloc requests in one sched.alloc-batch
+ * request.
+ */
+static int alloc_batch_request (struct alloc *alloc)
+{
+    struct job *job;
+    json_t *jobs;
+    json_t *o;
+    int rc = -1;
+
+    if (!(jobs = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while (json_array_size (jobs) < alloc_batch_max
+           && (job = alloc_next (alloc))) {
+        if (!(o = alloc_request_payload (job)))
+            goto out;
+        if (json_array_append_new (jobs, o) < 0) {
+            errno = ENOMEM;
+            goto out;
+        }
+        alloc_set_pending (alloc, job);
+    }
+    if (json_array_size (jobs) > 0) {
+        if (!(o = json_pack ("{s:O}", "jobs", jobs))) {
+            errno = ENOMEM;
+            goto out;
+        }
+        rc = alloc_send (alloc, "sched.alloc-batch", o);
+        ERRNO_SAFE_WRAP (json_decref, o);
+    }
+    else
+        rc = 0;
+out:
+    ERRNO_SAFE_WRAP (json_decref, jobs);
+    return rc;
+}
+
 /* check:
  * Runs right after reactor calls poll(2).
- * Stop idle watcher, and send next alloc request, if available.
+ * Stop idle watcher, send any batched free requests, and send next
+ * alloc request (or batch of requests), if available.
  */
 static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
                       int revents, void *arg)
@@ -485,36 +727,27 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct job *job;
 
     flux_watcher_stop (alloc->idle);
+    if (free_batch_flush (alloc) < 0) {
+        flux_log_error (ctx->h, "free_request fatal error");
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        return;
+    }
     if (!alloc->ready || alloc->disable)
         return;
-    if (alloc->alloc_limit
-        && alloc->alloc_pending_count >= alloc->alloc_limit)
+    if (alloc->batch) {
+        if (alloc_batch_request (alloc) < 0) {
+            flux_log_error (ctx->h, "alloc_request fatal error");
+            flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        }
         return;
-   /* The queue is sorted from highest to lowest priority, so if the
-    * first job has priority=MIN, all other jobs must have the same priority,
-    * and no alloc requests can be sent.
-    */
-    if ((job = zlistx_first (alloc->queue))
-        && job->priority != FLUX_JOB_PRIORITY_MIN) {
-        bool fwd = job->priority > (FLUX_JOB_PRIORITY_MAX / 2);
+    }
+    if ((job = alloc_next (alloc))) {
         if (alloc_request (alloc, job) < 0) {
             flux_log_error (ctx->h, "alloc_request fatal error");
             flux_reactor_stop_error (flux_get_reactor (ctx->h));
             return;
         }
-        zlistx_delete (alloc->queue, job->handle);
-        job->handle = NULL;
-        job->alloc_pending = 1;
-        job->alloc_queued = 0;
-        alloc->alloc_pending_count++;
-        if (alloc->alloc_limit) {
-            if (!(job->handle = zlistx_insert (alloc->pending_jobs, job, fwd)))
-                flux_log (ctx->h, LOG_ERR, "failed to enqueue pending job");
-        }
-        if ((job->flags & FLUX_JOB_DEBUG))
-            (void)event_job_post_pack (ctx->event, job,
-                                       "debug.alloc-request", 0, NULL);
-
+        alloc_set_pending (alloc, job);
     }
 }
 
@@ -784,6 +1017,7 @@ void alloc_ctx_destroy (struct alloc *alloc)
         flux_watcher_destroy (alloc->idle);
         zlistx_destroy (&alloc->queue);
         zlistx_destroy (&alloc->pending_jobs);
+        json_decref (alloc->free_batch);
         free (alloc->disable_reason);
         free (alloc->sched_sender);
         free (alloc);
@@ -797,6 +1031,8 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-manager.alloc-admin", alloc_admin_cb, 0},
     { FLUX_MSGTYPE_RESPONSE, "sched.alloc", alloc_response_cb, 0},
     { FLUX_MSGTYPE_RESPONSE, "sched.free", free_response_cb, 0},
+    { FLUX_MSGTYPE_RESPONSE, "sched.alloc-batch", alloc_batch_response_cb, 0},
+    { FLUX_MSGTYPE_RESPONSE, "sched.free-batch", free_batch_response_cb, 0},
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -820,6 +1056,10 @@ struct alloc *alloc_ctx_create (struct job_manager *ctx)
     zlistx_set_comparator (alloc->pending_jobs, job_comparator);
     zlistx_set_duplicator (alloc->pending_jobs, job_duplicator);
 
+    if (!(alloc->free_batch = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
     if (flux_msg_handler_addvec (ctx->h, htab, ctx, &alloc->handlers) < 0)
         goto error;
     alloc->prep = flux_prepare_watcher_create (r, prep_cb, ctx);
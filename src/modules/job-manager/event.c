@@ -50,6 +50,7 @@
 #include "wait.h"
 #include "prioritize.h"
 #include "jobtap-internal.h"
+#include "intern.h"
 
 #include "event.h"
 
@@ -369,6 +370,12 @@ int event_job_action (struct event *event, struct job *job)
             }
             break;
         case FLUX_JOB_STATE_INACTIVE:
+            /* Jobtap plugins have seen the inactive job by now, so its
+             * jobspec is no longer needed.  If a zombie's jobspec is
+             * requested, it is fetched from the KVS (see getattr.c).
+             */
+            intern_json_put (job->intern, job->jobspec_redacted);
+            job->jobspec_redacted = NULL;
             if ((job->flags & FLUX_JOB_WAITABLE))
                 wait_notify_inactive (ctx->wait, job);
             zhashx_delete (ctx->active_jobs, &job->id);
@@ -18,6 +18,9 @@
  *
  * Output:
  * - Dictionary of attributes and values.
+ *
+ * Inactive jobs that have not yet been waited on are included.  Their
+ * jobspec is not kept in memory, so it is fetched from the KVS if needed.
  */
 
 #if HAVE_CONFIG_H
@@ -29,11 +32,12 @@
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
 #include "job.h"
+#include "wait.h"
 #include "job-manager.h"
 
 #include "getattr.h"
 
-static json_t *make_dict (struct job *job,
+static json_t *make_dict (json_t *jobspec,
                           json_t *attrs,
                           char *errstr,
                           int errstrsz)
@@ -52,12 +56,12 @@ static json_t *make_dict (struct job *job,
             goto error;
         }
         if (!strcmp (key, "jobspec")) {
-            if (!job->jobspec_redacted) {
+            if (!jobspec) {
                 snprintf (errstr, errstrsz, "jobspec is NULL");
                 errno = ENOENT;
                 goto error;
             }
-            if (json_object_set (dict, key, job->jobspec_redacted) < 0)
+            if (json_object_set (dict, key, jobspec) < 0)
                 goto nomem;
         }
         else {
@@ -75,6 +79,79 @@ error:
     return NULL;
 }
 
+static bool attrs_contain (json_t *attrs, const char *name)
+{
+    size_t index;
+    json_t *val;
+
+    json_array_foreach (attrs, index, val) {
+        const char *key = json_string_value (val);
+        if (key && !strcmp (key, name))
+            return true;
+    }
+    return false;
+}
+
+static void lookup_jobspec_continuation (flux_future_t *f, void *arg)
+{
+    flux_t *h = flux_future_get_flux (f);
+    const flux_msg_t *msg = flux_future_aux_get (f, "flux::request");
+    json_t *attrs = arg;
+    const char *s;
+    json_t *jobspec = NULL;
+    json_t *dict = NULL;
+    const char *errstr = NULL;
+    char errbuf[128];
+
+    if (flux_kvs_lookup_get (f, &s) < 0
+        || !(jobspec = job_jobspec_redact (s)))
+        goto error;
+    if (!(dict = make_dict (jobspec, attrs, errbuf, sizeof (errbuf)))) {
+        errstr = errbuf;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "O", dict) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    goto done;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+done:
+    json_decref (dict);
+    json_decref (jobspec);
+    json_decref (attrs);
+    flux_future_destroy (f);
+}
+
+/* Fetch the jobspec of an inactive job from the KVS, then respond.
+ */
+static int lookup_jobspec (flux_t *h,
+                           const flux_msg_t *msg,
+                           struct job *job,
+                           json_t *attrs)
+{
+    char key[64];
+    flux_future_t *f;
+
+    if (flux_job_kvs_key (key, sizeof (key), job->id, "jobspec") < 0
+        || !(f = flux_kvs_lookup (h, NULL, 0, key)))
+        return -1;
+    if (flux_future_aux_set (f,
+                             "flux::request",
+                             (void *)flux_msg_incref (msg),
+                             (flux_free_f)flux_msg_decref) < 0) {
+        flux_msg_decref (msg);
+        goto error;
+    }
+    if (flux_future_then (f, -1, lookup_jobspec_continuation, attrs) < 0)
+        goto error;
+    json_incref (attrs);
+    return 0;
+error:
+    flux_future_destroy (f);
+    return -1;
+}
+
 void getattr_handle_request (flux_t *h,
                              flux_msg_handler_t *mh,
                              const flux_msg_t *msg,
@@ -96,7 +173,8 @@ void getattr_handle_request (flux_t *h,
                              "attrs", &attrs) < 0
                     || flux_msg_get_cred (msg, &cred) < 0)
         goto error;
-    if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
+    if (!(job = zhashx_lookup (ctx->active_jobs, &id))
+        && !(job = wait_zombie_lookup (ctx->wait, id))) {
         errstr = "unknown job";
         errno = EINVAL;
         goto error;
@@ -107,7 +185,17 @@ void getattr_handle_request (flux_t *h,
         errstr = "guests can only reprioritize their own jobs";
         goto error;
     }
-    if (!(dict = make_dict (job, attrs, errbuf, sizeof (errbuf)))) {
+    if (!job->jobspec_redacted
+        && job->state == FLUX_JOB_STATE_INACTIVE
+        && attrs_contain (attrs, "jobspec")) {
+        if (lookup_jobspec (h, msg, job, attrs) < 0)
+            goto error;
+        return;
+    }
+    if (!(dict = make_dict (job->jobspec_redacted,
+                            attrs,
+                            errbuf,
+                            sizeof (errbuf)))) {
         errstr = errbuf;
         goto error;
     }
@@ -0,0 +1,427 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* intern - share storage between equal jobspecs
+ *
+ * Many jobs share identical jobspecs, or jobspecs that differ only in a
+ * few attributes such as cwd, job name or duration.  Rather than keep a
+ * full jansson tree per job, jobspecs are interned: each JSON object down
+ * to INTERN_DEPTH levels is rebuilt from interned members, and is itself
+ * looked up in a table of values seen at that level.  Values below that
+ * depth, and any non-object values, are shared whole.  For example, with
+ * the default depth, two jobs that differ only in attributes.system.cwd
+ * share their resources, tasks, and all other attributes.system members,
+ * and only have their own top level, attributes, and attributes.system
+ * objects.
+ *
+ * Each interned value has a use count: the references handed out by
+ * intern_json() and not yet returned with intern_json_put(), plus the
+ * interned parents that contain it.  A value whose use count drops to
+ * zero is unused.  Such values are swept periodically, from the top level
+ * down so that children released by a parent in the same sweep are also
+ * found.  The values themselves are ordinary jansson objects, so they
+ * remain valid while anyone holds a reference, even after being swept.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+
+#include "intern.h"
+
+/* Objects are rebuilt from interned members at levels below this depth:
+ * jobspec > attributes > system > member.
+ */
+#define INTERN_DEPTH 4
+
+/* Sweep unused values when the number of interned jobspecs reaches
+ * twice the number that survived the last sweep, or this minimum.
+ */
+static const size_t sweep_threshold_min = 1024;
+
+struct entry {
+    size_t hash;
+    json_t *o;
+    size_t refcount;            // callers and parent entries using o
+    struct entry **children;    // interned members of o
+    size_t nchildren;
+};
+
+struct intern {
+    zhashx_t *level[INTERN_DEPTH];
+    zhashx_t *jobspecs;         // level 0 entries by e->o pointer
+    size_t sweep_threshold;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+/* FNV-1a over compact, key sorted encoding, so that equal values
+ * have equal hashes regardless of key order.
+ */
+static size_t json_hash (json_t *o)
+{
+    size_t flags = JSON_COMPACT | JSON_SORT_KEYS | JSON_ENCODE_ANY;
+    char buf[4096];
+    char *s = buf;
+    size_t len;
+    uint64_t hash = 14695981039346656037ULL;
+
+    len = json_dumpb (o, buf, sizeof (buf), flags);
+    if (len > sizeof (buf)) {
+        if (!(s = json_dumps (o, flags)))
+            return 0;
+        len = strlen (s);
+    }
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 1099511628211ULL;
+    }
+    if (s != buf)
+        free (s);
+    return hash;
+}
+
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t entry_hasher (const void *key)
+{
+    const struct entry *e = key;
+    return e->hash;
+}
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int entry_cmp (const void *key1, const void *key2)
+{
+    const struct entry *e1 = key1;
+    const struct entry *e2 = key2;
+
+    if (e1->hash != e2->hash)
+        return e1->hash < e2->hash ? -1 : 1;
+    return json_equal (e1->o, e2->o) ? 0 : 1;
+}
+
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t pointer_hasher (const void *key)
+{
+    return (uintptr_t)key >> 4;
+}
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int pointer_cmp (const void *key1, const void *key2)
+{
+    if (key1 == key2)
+        return 0;
+    return key1 < key2 ? -1 : 1;
+}
+
+/* N.B. zhashx_destructor_fn signature
+ */
+static void entry_destructor (void **item)
+{
+    if (item) {
+        struct entry *e = *item;
+        if (e) {
+            json_decref (e->o);
+            free (e->children);
+            free (e);
+        }
+        *item = NULL;
+    }
+}
+
+/* Return the entry for a value equal to 'o' at 'level', adding one if
+ * necessary.  The entry's use count is not incremented.  The use counts
+ * of an object's members are incremented only when the object is added,
+ * so that a lookup of an existing object leaves them unchanged.
+ */
+static struct entry *intern_value (struct intern *in, json_t *o, int level)
+{
+    json_t *copy = NULL;
+    struct entry **children = NULL;
+    size_t nchildren = 0;
+    struct entry key;
+    struct entry *e;
+
+    if (level < INTERN_DEPTH - 1 && json_is_object (o)) {
+        size_t size = json_object_size (o);
+        const char *name;
+        json_t *val;
+
+        if (!(copy = json_object ())
+            || (size > 0 && !(children = calloc (size, sizeof (*children)))))
+            goto error;
+        json_object_foreach (o, name, val) {
+            struct entry *child;
+            if (!(child = intern_value (in, val, level + 1))
+                || json_object_set (copy, name, child->o) < 0)
+                goto error;
+            children[nchildren++] = child;
+        }
+        o = copy;
+    }
+    key.o = o;
+    key.hash = json_hash (o);
+    if ((e = zhashx_lookup (in->level[level], &key))) {
+        if (level == 0)
+            in->hits++;
+        json_decref (copy);
+        free (children);
+        return e;
+    }
+    if (level == 0)
+        in->misses++;
+    if (!(e = calloc (1, sizeof (*e))))
+        goto error;
+    e->hash = key.hash;
+    e->o = copy ? copy : json_incref (o);
+    e->children = children;
+    e->nchildren = nchildren;
+    if (zhashx_insert (in->level[level], e, e) < 0) {
+        entry_destructor ((void **)&e);
+        errno = EEXIST;
+        return NULL;
+    }
+    if (level == 0 && zhashx_insert (in->jobspecs, e->o, e) < 0) {
+        zhashx_delete (in->level[level], e);
+        errno = EEXIST;
+        return NULL;
+    }
+    for (size_t i = 0; i < nchildren; i++)
+        children[i]->refcount++;
+    return e;
+error:
+    json_decref (copy);
+    free (children);
+    return NULL;
+}
+
+json_t *intern_json (struct intern *in, json_t *o)
+{
+    struct entry *e;
+
+    if (!in || !o)
+        return o;
+    if (zhashx_size (in->level[0]) >= in->sweep_threshold)
+        intern_sweep (in);
+    if (!(e = intern_value (in, o, 0)))
+        return o;
+    e->refcount++;
+    json_decref (o);
+    return json_incref (e->o);
+}
+
+void intern_json_put (struct intern *in, json_t *o)
+{
+    struct entry *e;
+
+    if (in && o && (e = zhashx_lookup (in->jobspecs, o)) && e->refcount > 0)
+        e->refcount--;
+    json_decref (o);
+}
+
+void intern_sweep (struct intern *in)
+{
+    if (!in)
+        return;
+    for (int i = 0; i < INTERN_DEPTH; i++) {
+        size_t size = zhashx_size (in->level[i]);
+        struct entry **unused;
+        struct entry *e;
+        size_t count = 0;
+
+        if (size == 0 || !(unused = calloc (size, sizeof (unused[0]))))
+            continue;
+        e = zhashx_first (in->level[i]);
+        while (e) {
+            if (e->refcount == 0)
+                unused[count++] = e;
+            e = zhashx_next (in->level[i]);
+        }
+        for (size_t j = 0; j < count; j++) {
+            e = unused[j];
+            for (size_t k = 0; k < e->nchildren; k++)
+                e->children[k]->refcount--;
+            if (i == 0)
+                zhashx_delete (in->jobspecs, e->o);
+            zhashx_delete (in->level[i], e);
+        }
+        free (unused);
+    }
+    in->sweep_threshold = 2 * zhashx_size (in->level[0]);
+    if (in->sweep_threshold < sweep_threshold_min)
+        in->sweep_threshold = sweep_threshold_min;
+}
+
+/* Approximate sizes of jansson internal structures on a 64-bit system,
+ * each allocation rounded up and charged 16 bytes of malloc overhead.
+ */
+#define ALLOC_SIZE(n) ((((n) + 15) & ~(size_t)15) + 16)
+
+static size_t hashtable_buckets (size_t size)
+{
+    size_t buckets = 8;
+    while (buckets <= size)
+        buckets *= 2;
+    return buckets;
+}
+
+/* Return the footprint of 'o' itself, not including object members
+ * or array elements.
+ */
+static size_t json_shallow_footprint (json_t *o)
+{
+    size_t size = 0;
+
+    switch (json_typeof (o)) {
+        case JSON_OBJECT: {
+            const char *name;
+            json_t *val;
+
+            size = ALLOC_SIZE (72)
+                + ALLOC_SIZE (16 * hashtable_buckets (json_object_size (o)));
+            json_object_foreach (o, name, val)
+                size += ALLOC_SIZE (56 + strlen (name) + 1);
+            break;
+        }
+        case JSON_ARRAY: {
+            size_t capacity = 8;
+            while (capacity < json_array_size (o))
+                capacity *= 2;
+            size = ALLOC_SIZE (40) + ALLOC_SIZE (8 * capacity);
+            break;
+        }
+        case JSON_STRING:
+            size = ALLOC_SIZE (32) + ALLOC_SIZE (json_string_length (o) + 1);
+            break;
+        case JSON_INTEGER:
+        case JSON_REAL:
+            size = ALLOC_SIZE (24);
+            break;
+        case JSON_TRUE:
+        case JSON_FALSE:
+        case JSON_NULL:
+            break; // singletons
+    }
+    return size;
+}
+
+size_t intern_json_footprint (json_t *o)
+{
+    size_t size;
+
+    if (!o)
+        return 0;
+    size = json_shallow_footprint (o);
+    if (json_is_object (o)) {
+        const char *name;
+        json_t *val;
+        json_object_foreach (o, name, val)
+            size += intern_json_footprint (val);
+    }
+    else if (json_is_array (o)) {
+        size_t index;
+        json_t *val;
+        json_array_foreach (o, index, val)
+            size += intern_json_footprint (val);
+    }
+    return size;
+}
+
+json_t *intern_stats (struct intern *in)
+{
+    size_t values = 0;
+    size_t bytes = 0;
+
+    if (!in)
+        return json_object ();
+    for (int i = 0; i < INTERN_DEPTH; i++) {
+        struct entry *e;
+
+        values += zhashx_size (in->level[i]);
+        e = zhashx_first (in->level[i]);
+        while (e) {
+            /* Members of objects above the last level are interned
+             * themselves, so are counted at the next level.
+             */
+            if (i < INTERN_DEPTH - 1 && json_is_object (e->o))
+                bytes += json_shallow_footprint (e->o);
+            else
+                bytes += intern_json_footprint (e->o);
+            bytes += ALLOC_SIZE (sizeof (*e));
+            if (e->nchildren > 0)
+                bytes += ALLOC_SIZE (e->nchildren * sizeof (e->children[0]));
+            e = zhashx_next (in->level[i]);
+        }
+    }
+    return json_pack ("{s:I s:I s:I s:I s:I}",
+                      "jobspecs", (json_int_t)zhashx_size (in->level[0]),
+                      "values", (json_int_t)values,
+                      "bytes", (json_int_t)bytes,
+                      "hits", (json_int_t)in->hits,
+                      "misses", (json_int_t)in->misses);
+}
+
+void intern_destroy (struct intern *in)
+{
+    if (in) {
+        int saved_errno = errno;
+        zhashx_destroy (&in->jobspecs);
+        for (int i = 0; i < INTERN_DEPTH; i++)
+            zhashx_destroy (&in->level[i]);
+        free (in);
+        errno = saved_errno;
+    }
+}
+
+struct intern *intern_create (void)
+{
+    struct intern *in;
+
+    if (!(in = calloc (1, sizeof (*in))))
+        return NULL;
+    for (int i = 0; i < INTERN_DEPTH; i++) {
+        if (!(in->level[i] = zhashx_new ())) {
+            errno = ENOMEM;
+            goto error;
+        }
+        zhashx_set_key_hasher (in->level[i], entry_hasher);
+        zhashx_set_key_comparator (in->level[i], entry_cmp);
+        zhashx_set_key_duplicator (in->level[i], NULL);
+        zhashx_set_key_destructor (in->level[i], NULL);
+        zhashx_set_destructor (in->level[i], entry_destructor);
+    }
+    if (!(in->jobspecs = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_key_hasher (in->jobspecs, pointer_hasher);
+    zhashx_set_key_comparator (in->jobspecs, pointer_cmp);
+    zhashx_set_key_duplicator (in->jobspecs, NULL);
+    zhashx_set_key_destructor (in->jobspecs, NULL);
+    in->sweep_threshold = sweep_threshold_min;
+    return in;
+error:
+    intern_destroy (in);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,54 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_MANAGER_INTERN_H
+#define _FLUX_JOB_MANAGER_INTERN_H
+
+#include <jansson.h>
+
+struct intern;
+
+/* Return a reference to a JSON value equal to 'o' that may share
+ * storage with other interned values, and drop the caller's reference
+ * to 'o'.  Objects are interned member by member down to a fixed depth,
+ * so jobspecs that differ only in a few attributes share the rest.
+ * The returned value must be treated as read-only.  On failure, return
+ * 'o' unchanged.
+ */
+json_t *intern_json (struct intern *in, json_t *o);
+
+/* Return a reference obtained from intern_json(), so that the value may
+ * be swept once unused.  If 'in' is NULL, this is just json_decref().
+ */
+void intern_json_put (struct intern *in, json_t *o);
+
+/* Drop interned values that have no references outstanding from
+ * intern_json().  This happens automatically as new values are interned.
+ */
+void intern_sweep (struct intern *in);
+
+/* Return interning statistics as a JSON object, including the
+ * approximate memory used by interned values.
+ */
+json_t *intern_stats (struct intern *in);
+
+/* Return the approximate memory footprint in bytes of the JSON value 'o',
+ * which need not be interned.
+ */
+size_t intern_json_footprint (json_t *o);
+
+struct intern *intern_create (void);
+void intern_destroy (struct intern *in);
+
+#endif /* !_FLUX_JOB_MANAGER_INTERN_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -32,6 +32,7 @@
 #include "journal.h"
 #include "getattr.h"
 #include "jobtap-internal.h"
+#include "intern.h"
 
 #include "job-manager.h"
 
@@ -69,14 +70,57 @@ void disconnect_rpc (flux_t *h,
     journal_listeners_disconnect_rpc (h, mh, msg, arg);
 }
 
+/* Approximate memory used by 'job', not including its interned jobspec.
+ */
+static size_t job_footprint (struct job *job)
+{
+    return sizeof (*job)
+        + intern_json_footprint (job->annotations)
+        + intern_json_footprint (job->end_event);
+}
+
 static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
                       const flux_msg_t *msg, void *arg)
 {
     struct job_manager *ctx = arg;
     int journal_listeners = journal_listeners_count (ctx->journal);
-    if (flux_respond_pack (h, msg, "{s:{s:i}}",
+    json_t *intern_stats_obj;
+    json_int_t jobspec_bytes = 0;
+    size_t bytes = 0;
+    int active = 0;
+    int inactive = 0;
+    struct job *job;
+
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        bytes += job_footprint (job);
+        active++;
+        job = zhashx_next (ctx->active_jobs);
+    }
+    job = wait_zombie_first (ctx->wait);
+    while (job) {
+        bytes += job_footprint (job);
+        inactive++;
+        job = wait_zombie_next (ctx->wait);
+    }
+    if (!(intern_stats_obj = intern_stats (ctx->intern))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    (void)json_unpack (intern_stats_obj, "{s:I}", "bytes", &jobspec_bytes);
+    bytes += jobspec_bytes;
+    if (flux_respond_pack (h, msg, "{s:{s:i} s:{s:i s:i s:I s:I} s:o}",
                            "journal",
-                             "listeners", journal_listeners) < 0) {
+                             "listeners", journal_listeners,
+                           "jobs",
+                             "active", active,
+                             "inactive", inactive,
+                             "bytes", (json_int_t)bytes,
+                             "bytes-per-job",
+                               (json_int_t)(active + inactive > 0
+                                            ? bytes / (active + inactive)
+                                            : 0),
+                           "jobspec-intern", intern_stats_obj) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
@@ -144,6 +188,11 @@ int mod_main (flux_t *h, int argc, char **argv)
     memset (&ctx, 0, sizeof (ctx));
     ctx.h = h;
 
+    if (!(ctx.intern = intern_create ())) {
+        flux_log_error (h, "error creating jobspec intern table");
+        goto done;
+    }
+
     if (!(ctx.active_jobs = job_hash_create ())) {
         flux_log_error (h, "error creating active_jobs hash");
         goto done;
@@ -225,6 +274,7 @@ done:
     event_ctx_destroy (ctx.event);
     jobtap_destroy (ctx.jobtap);
     zhashx_destroy (&ctx.active_jobs);
+    intern_destroy (ctx.intern);
     return rc;
 }
 
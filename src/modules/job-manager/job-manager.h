@@ -30,6 +30,7 @@ struct job_manager {
     struct annotate *annotate;
     struct journal *journal;
     struct jobtap *jobtap;
+    struct intern *intern;
 };
 
 #endif /* !_FLUX_JOB_MANAGER_H */
@@ -23,6 +23,7 @@
 
 #include "job.h"
 #include "event.h"
+#include "intern.h"
 
 void job_decref (struct job *job)
 {
@@ -30,7 +31,7 @@ void job_decref (struct job *job)
         int saved_errno = errno;
         json_decref (job->end_event);
         flux_msg_decref (job->waiter);
-        json_decref (job->jobspec_redacted);
+        intern_json_put (job->intern, job->jobspec_redacted);
         json_decref (job->annotations);
         grudgeset_destroy (job->dependencies);
         aux_destroy (&job->aux);
@@ -134,6 +135,19 @@ void delete_json_path (json_t *o, const char *path[])
     }
 }
 
+json_t *job_jobspec_redact (const char *jobspec)
+{
+    const char *envpath[] = { "attributes", "system", "environment", NULL };
+    json_t *o;
+
+    if (!(o = json_loads (jobspec, 0, NULL))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    delete_json_path (o, envpath);
+    return o;
+}
+
 struct job *job_create_from_eventlog (flux_jobid_t id,
                                       const char *eventlog,
                                       const char *jobspec)
@@ -142,15 +156,13 @@ struct job *job_create_from_eventlog (flux_jobid_t id,
     json_t *a = NULL;
     size_t index;
     json_t *event;
-    const char *envpath[] = { "attributes", "system", "environment", NULL };
 
     if (!(job = job_create ()))
         return NULL;
     job->id = id;
 
-    if (!(job->jobspec_redacted = json_loads (jobspec, 0, NULL)))
+    if (!(job->jobspec_redacted = job_jobspec_redact (jobspec)))
         goto inval;
-    delete_json_path (job->jobspec_redacted, envpath);
 
     if (!(a = eventlog_decode (eventlog)))
         goto error;
@@ -18,33 +18,38 @@
 #include "src/common/libjob/job.h"
 #include "src/common/libutil/grudgeset.h"
 
+/* N.B. Members are ordered to avoid padding, since there may be
+ * many of these.
+ */
 struct job {
     flux_jobid_t id;
-    uint32_t userid;
-    int urgency;
     int64_t priority;
     double t_submit;
+    uint32_t userid;
+    int urgency;
     int flags;
-    json_t *jobspec_redacted;
     int eventlog_seq;           // eventlog count / sequence number
     flux_job_state_t state;
+    int refcount;           // private to job.c
+
+    json_t *jobspec_redacted; // interned, read-only, NULL once inactive
+    struct intern *intern;  // table jobspec_redacted was interned in
     json_t *end_event;      // event that caused transition to CLEANUP state
     const flux_msg_t *waiter; // flux_job_wait() request
 
-    uint8_t alloc_queued:1; // queued for alloc, but alloc request not sent
-    uint8_t alloc_pending:1;// alloc request sent to sched
-    uint8_t free_pending:1; // free request sent to sched
-    uint8_t has_resources:1;
-    uint8_t start_pending:1;// start request sent to job-exec
-
     json_t *annotations;
 
     struct grudgeset *dependencies;
 
     void *handle;           // zlistx_t handle
-    int refcount;           // private to job.c
 
     struct aux_item *aux;
+
+    uint8_t alloc_queued:1; // queued for alloc, but alloc request not sent
+    uint8_t alloc_pending:1;// alloc request sent to sched
+    uint8_t free_pending:1; // free request sent to sched
+    uint8_t has_resources:1;
+    uint8_t start_pending:1;// start request sent to job-exec
 };
 
 void job_decref (struct job *job);
@@ -56,6 +61,11 @@ struct job *job_create_from_eventlog (flux_jobid_t id,
                                       const char *eventlog,
                                       const char *jobspec);
 
+/* Decode jobspec as stored in the KVS and remove the environment,
+ * as for job->jobspec_redacted.
+ */
+json_t *job_jobspec_redact (const char *jobspec);
+
 int job_aux_set (struct job *job,
                  const char *name,
                  void *val,
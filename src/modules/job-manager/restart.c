@@ -19,6 +19,8 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/fluid.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/errno_safe.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
 #include "job.h"
@@ -26,12 +28,18 @@
 #include "event.h"
 #include "wait.h"
 #include "jobtap-internal.h"
+#include "intern.h"
 
 /* restart_map callback should return -1 on error to stop map with error,
  * or 0 on success.  'job' is only valid for the duration of the callback.
  */
 typedef int (*restart_map_f)(struct job *job, void *arg);
 
+/* Default max number of KVS lookups in flight during restart.
+ * Configurable via job-manager.restart_window.
+ */
+#define RESTART_WINDOW_DEFAULT 256
+
 const char *checkpoint_key = "checkpoint.job-manager";
 
 int restart_count_char (const char *s, char c)
@@ -44,99 +52,251 @@ int restart_count_char (const char *s, char c)
     return count;
 }
 
-static struct job *lookup_job (flux_t *h, flux_jobid_t id)
+/* A KVS lookup in the restart pipeline: either a directory under "job",
+ * or the eventlog and jobspec of a single job.
+ */
+struct restart_lookup {
+    bool isjob;
+    int level;          // directory: number of path components below "job"
+    char *key;          // directory: key
+    flux_jobid_t id;    // job: id
+    flux_future_t *f1;  // directory or job eventlog lookup
+    flux_future_t *f2;  // job jobspec lookup
+};
+
+/* Lookups are sent in FIFO order, with at most 'window' in flight.
+ * Directory lookups append their children to the tail of the queue, so
+ * the job directories are visited in the same (sorted) order as a
+ * depth-first walk, and jobs are replayed in that order.
+ */
+struct restart_map {
+    flux_t *h;
+    int dirskip;
+    int window;
+    zlist_t *queue;     // lookups not yet sent
+    zlist_t *inflight;  // lookups sent, oldest first
+    restart_map_f cb;
+    void *arg;
+    int count;
+};
+
+static void restart_lookup_destroy (struct restart_lookup *l)
 {
-    flux_future_t *f1 = NULL;
-    flux_future_t *f2 = NULL;
-    char k1[64], k2[64];
-    const char *eventlog, *jobspec;
-    struct job *job = NULL;
+    if (l) {
+        int saved_errno = errno;
+        flux_future_destroy (l->f1);
+        flux_future_destroy (l->f2);
+        free (l->key);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static struct restart_lookup *restart_lookup_create (const char *key,
+                                                     int level,
+                                                     flux_jobid_t id)
+{
+    struct restart_lookup *l;
 
-    if (flux_job_kvs_key (k1, sizeof (k1), id, "eventlog") < 0
-        || flux_job_kvs_key (k2, sizeof (k2), id, "jobspec") < 0)
+    if (!(l = calloc (1, sizeof (*l))))
         return NULL;
-    if (!(f1 = flux_kvs_lookup (h, NULL, 0, k1))
-        || !(f2 = flux_kvs_lookup (h, NULL, 0, k2)))
-        goto done;
-    if (flux_kvs_lookup_get (f1, &eventlog) < 0
-            || flux_kvs_lookup_get (f2, &jobspec) < 0)
-        goto done;
-    job = job_create_from_eventlog (id, eventlog, jobspec);
-done:
-    flux_future_destroy (f1);
-    flux_future_destroy (f2);
-    return job;
+    if (key) {
+        if (!(l->key = strdup (key)))
+            goto error;
+        l->level = level;
+    }
+    else {
+        l->isjob = true;
+        l->id = id;
+    }
+    return l;
+error:
+    restart_lookup_destroy (l);
+    return NULL;
 }
 
-static int depthfirst_map_one (flux_t *h, const char *key, int dirskip,
-                               restart_map_f cb, void *arg)
+static int restart_lookup_send (flux_t *h, struct restart_lookup *l)
 {
-    flux_jobid_t id;
-    struct job *job = NULL;
-    int rc = -1;
+    char k1[64], k2[64];
 
-    if (strlen (key) <= dirskip) {
-        errno = EINVAL;
-        return -1;
+    if (!l->isjob) {
+        if (!(l->f1 = flux_kvs_lookup (h, NULL, FLUX_KVS_READDIR, l->key)))
+            return -1;
+        return 0;
     }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
+    if (flux_job_kvs_key (k1, sizeof (k1), l->id, "eventlog") < 0
+        || flux_job_kvs_key (k2, sizeof (k2), l->id, "jobspec") < 0)
         return -1;
-    if (!(job = lookup_job (h, id)))
+    if (!(l->f1 = flux_kvs_lookup (h, NULL, 0, k1))
+        || !(l->f2 = flux_kvs_lookup (h, NULL, 0, k2)))
         return -1;
-    if (cb (job, arg) < 0)
-        goto done;
-    rc = 1;
-done:
-    job_decref (job);
-    return rc;
+    return 0;
 }
 
-static int depthfirst_map (flux_t *h, const char *key,
-                           int dirskip, restart_map_f cb, void *arg)
+static int restart_map_push (struct restart_map *rm,
+                             const char *key,
+                             int level,
+                             flux_jobid_t id)
+{
+    struct restart_lookup *l;
+
+    if (!(l = restart_lookup_create (key, level, id)))
+        return -1;
+    if (zlist_append (rm->queue, l) < 0) {
+        restart_lookup_destroy (l);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Send queued lookups until the window is full.
+ */
+static int restart_map_fill (struct restart_map *rm)
+{
+    struct restart_lookup *l;
+
+    while (zlist_size (rm->inflight) < rm->window
+           && (l = zlist_pop (rm->queue))) {
+        if (restart_lookup_send (rm->h, l) < 0
+            || zlist_append (rm->inflight, l) < 0) {
+            restart_lookup_destroy (l);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Queue a lookup for each subdirectory of directory 'l'. At the bottom
+ * of the "job" hierarchy, subdirectories are jobs.
+ */
+static int restart_map_readdir (struct restart_map *rm,
+                                struct restart_lookup *l)
 {
-    flux_future_t *f;
     const flux_kvsdir_t *dir;
     flux_kvsitr_t *itr;
     const char *name;
-    int path_level;
-    int count = 0;
     int rc = -1;
 
-    path_level = restart_count_char (key + dirskip, '.');
-    if (!(f = flux_kvs_lookup (h, NULL, FLUX_KVS_READDIR, key)))
+    if (flux_kvs_lookup_get_dir (l->f1, &dir) < 0) {
+        if (errno == ENOENT && l->level == 0)
+            return 0;
         return -1;
-    if (flux_kvs_lookup_get_dir (f, &dir) < 0) {
-        if (errno == ENOENT && path_level == 0)
-            rc = 0;
-        goto done;
     }
     if (!(itr = flux_kvsitr_create (dir)))
-        goto done;
+        return -1;
     while ((name = flux_kvsitr_next (itr))) {
         char *nkey;
+        flux_jobid_t id;
         int n;
+
         if (!flux_kvsdir_isdir (dir, name))
             continue;
         if (!(nkey = flux_kvsdir_key_at (dir, name)))
-            goto done_destroyitr;
-        if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (h, nkey, dirskip, cb, arg);
+            goto done;
+        if (l->level == 3) { // orig 'key' = .A.B.C, thus 'nkey' is complete
+            if (strlen (nkey) <= rm->dirskip) {
+                errno = EINVAL;
+                n = -1;
+            }
+            else if ((n = fluid_decode (nkey + rm->dirskip + 1,
+                                        &id,
+                                        FLUID_STRING_DOTHEX)) == 0)
+                n = restart_map_push (rm, NULL, 0, id);
+        }
         else
-            n = depthfirst_map (h, nkey, dirskip, cb, arg);
+            n = restart_map_push (rm, nkey, l->level + 1, 0);
         if (n < 0) {
-            int saved_errno = errno;
-            free (nkey);
-            errno = saved_errno;
-            goto done_destroyitr;
+            ERRNO_SAFE_WRAP (free, nkey);
+            goto done;
         }
-        count += n;
         free (nkey);
     }
-    rc = count;
-done_destroyitr:
+    rc = 0;
+done:
     flux_kvsitr_destroy (itr);
+    return rc;
+}
+
+static int restart_map_job (struct restart_map *rm, struct restart_lookup *l)
+{
+    const char *eventlog, *jobspec;
+    struct job *job;
+    int rc;
+
+    if (flux_kvs_lookup_get (l->f1, &eventlog) < 0
+        || flux_kvs_lookup_get (l->f2, &jobspec) < 0)
+        return -1;
+    if (!(job = job_create_from_eventlog (l->id, eventlog, jobspec)))
+        return -1;
+    if ((rc = rm->cb (job, rm->arg)) >= 0)
+        rm->count++;
+    job_decref (job);
+    return rc;
+}
+
+static void restart_map_destroy (struct restart_map *rm)
+{
+    if (rm) {
+        int saved_errno = errno;
+        if (rm->queue) {
+            struct restart_lookup *l;
+            while ((l = zlist_pop (rm->queue)))
+                restart_lookup_destroy (l);
+            zlist_destroy (&rm->queue);
+        }
+        if (rm->inflight) {
+            struct restart_lookup *l;
+            while ((l = zlist_pop (rm->inflight)))
+                restart_lookup_destroy (l);
+            zlist_destroy (&rm->inflight);
+        }
+        free (rm);
+        errno = saved_errno;
+    }
+}
+
+/* Walk the job directory 'dirname' and call 'cb' for each job found,
+ * keeping up to 'window' lookups in flight.  Returns the number of jobs
+ * mapped, or -1 on error.
+ */
+static int restart_map_jobs (flux_t *h,
+                             const char *dirname,
+                             int window,
+                             restart_map_f cb,
+                             void *arg)
+{
+    struct restart_map *rm;
+    struct restart_lookup *l;
+    int rc = -1;
+
+    if (!(rm = calloc (1, sizeof (*rm))))
+        return -1;
+    rm->h = h;
+    rm->dirskip = strlen (dirname);
+    rm->window = window;
+    rm->cb = cb;
+    rm->arg = arg;
+    if (!(rm->queue = zlist_new ()) || !(rm->inflight = zlist_new ())) {
+        errno = ENOMEM;
+        goto done;
+    }
+    if (restart_map_push (rm, dirname, 0, 0) < 0
+        || restart_map_fill (rm) < 0)
+        goto done;
+    while ((l = zlist_pop (rm->inflight))) {
+        int n;
+        if (l->isjob)
+            n = restart_map_job (rm, l);
+        else
+            n = restart_map_readdir (rm, l);
+        restart_lookup_destroy (l);
+        if (n < 0 || restart_map_fill (rm) < 0)
+            goto done;
+    }
+    rc = rm->count;
 done:
-    flux_future_destroy (f);
+    restart_map_destroy (rm);
     return rc;
 }
 
@@ -148,6 +308,13 @@ static int restart_map_cb (struct job *job, void *arg)
 {
     struct job_manager *ctx = arg;
 
+    /* Inactive jobs drop their jobspec in event_job_action() below.
+     */
+    if (job->state != FLUX_JOB_STATE_INACTIVE) {
+        job->jobspec_redacted = intern_json (ctx->intern,
+                                             job->jobspec_redacted);
+        job->intern = ctx->intern;
+    }
     if (zhashx_insert (ctx->active_jobs, &job->id, job) < 0)
         return -1;
     if ((job->flags & FLUX_JOB_WAITABLE))
@@ -202,19 +369,50 @@ static int checkpoint_restore (struct job_manager *ctx)
     return 0;
 }
 
+static int restart_window (struct job_manager *ctx)
+{
+    int window = RESTART_WINDOW_DEFAULT;
+    flux_conf_error_t err;
+
+    if (flux_conf_unpack (flux_get_conf (ctx->h),
+                          &err,
+                          "{s?{s?i}}",
+                          "job-manager",
+                            "restart_window", &window) < 0) {
+        flux_log (ctx->h, LOG_ERR,
+                  "error reading job-manager config: %s",
+                  err.errbuf);
+        return RESTART_WINDOW_DEFAULT;
+    }
+    if (window < 1) {
+        flux_log (ctx->h, LOG_ERR,
+                  "job-manager.restart_window must be >= 1, using %d",
+                  RESTART_WINDOW_DEFAULT);
+        return RESTART_WINDOW_DEFAULT;
+    }
+    return window;
+}
+
 int restart_from_kvs (struct job_manager *ctx)
 {
     const char *dirname = "job";
-    int dirskip = strlen (dirname);
+    int window = restart_window (ctx);
     int count;
+    struct timespec t0;
     struct job *job;
 
     /* Load any active jobs present in the KVS at startup.
      */
-    count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
+    monotime (&t0);
+    count = restart_map_jobs (ctx->h, dirname, window, restart_map_cb, ctx);
     if (count < 0)
         return -1;
-    flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
+    flux_log (ctx->h,
+              LOG_INFO,
+              "restart: %d jobs in %.3fs (window=%d)",
+              count,
+              monotime_since (t0) / 1000.,
+              window);
     /* Post flux-restart to any jobs in SCHED state, so they may
      * transition back to PRIORITY and re-obtain the priority.
      *
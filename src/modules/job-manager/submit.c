@@ -25,6 +25,7 @@
 #include "journal.h"
 #include "wait.h"
 #include "jobtap-internal.h"
+#include "intern.h"
 
 #include "submit.h"
 
@@ -273,6 +274,15 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
         flux_log_error (h, "%s: error validating batch", __FUNCTION__);
         goto error;
     }
+    /* Share jobspec storage with earlier jobs where possible.
+     */
+    job = zlistx_first (newjobs);
+    while (job) {
+        job->jobspec_redacted = intern_json (ctx->intern,
+                                             job->jobspec_redacted);
+        job->intern = ctx->intern;
+        job = zlistx_next (newjobs);
+    }
     if (submit_hash_jobs (ctx->active_jobs, newjobs) < 0) {
         flux_log_error (h, "%s: error enqueuing batch", __FUNCTION__);
         goto error;
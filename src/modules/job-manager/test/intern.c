@@ -0,0 +1,198 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-manager/intern.h"
+
+static json_t *make_jobspec (const char *cwd)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:[{s:s s:i}] s:[{s:[s] s:s s:{s:i}}]"
+                         " s:{s:{s:f s:s s:{s:{s:i}}}}}",
+                         "version", 1,
+                         "resources",
+                           "type", "slot",
+                           "count", 1,
+                         "tasks",
+                           "command", "hostname",
+                           "slot", "task",
+                           "count", "per_slot", 1,
+                         "attributes",
+                           "system",
+                             "duration", 0.,
+                             "cwd", cwd,
+                             "shell",
+                               "options", "verbose", 1)))
+        BAIL_OUT ("json_pack failed");
+    return o;
+}
+
+static json_int_t stat_get (struct intern *in, const char *name)
+{
+    json_t *o;
+    json_int_t val = -1;
+
+    if (!(o = intern_stats (in)))
+        BAIL_OUT ("intern_stats failed");
+    if (json_unpack (o, "{s:I}", name, &val) < 0)
+        BAIL_OUT ("intern_stats has no %s", name);
+    json_decref (o);
+    return val;
+}
+
+static void test_basic (void)
+{
+    struct intern *in;
+    json_t *a, *b, *c;
+    json_t *orig;
+    json_t *shell_a, *shell_c;
+
+    if (!(in = intern_create ()))
+        BAIL_OUT ("intern_create failed");
+
+    orig = make_jobspec ("/home/a");
+    a = intern_json (in, json_incref (orig));
+    ok (a != NULL && json_equal (a, orig),
+        "intern_json returns equal value");
+    json_decref (orig);
+
+    b = intern_json (in, make_jobspec ("/home/a"));
+    ok (a == b,
+        "identical jobspecs share storage");
+    ok (stat_get (in, "jobspecs") == 1
+        && stat_get (in, "hits") == 1
+        && stat_get (in, "misses") == 1,
+        "stats report one jobspec, one hit, one miss");
+
+    orig = make_jobspec ("/home/c");
+    c = intern_json (in, json_incref (orig));
+    ok (c != a && json_equal (c, orig),
+        "jobspec with different cwd is a different value");
+    ok (json_object_get (c, "resources") == json_object_get (a, "resources")
+        && json_object_get (c, "tasks") == json_object_get (a, "tasks"),
+        "resources and tasks are shared");
+    shell_a = json_object_get (json_object_get (json_object_get (a,
+                               "attributes"), "system"), "shell");
+    shell_c = json_object_get (json_object_get (json_object_get (c,
+                               "attributes"), "system"), "shell");
+    ok (shell_a != NULL && shell_a == shell_c,
+        "attributes.system.shell is shared");
+    ok (stat_get (in, "jobspecs") == 2,
+        "stats report two jobspecs");
+    ok (stat_get (in, "bytes") > 0,
+        "stats report nonzero bytes");
+
+    intern_json_put (in, a);
+    intern_sweep (in);
+    ok (stat_get (in, "jobspecs") == 2,
+        "intern_sweep keeps jobspec with a reference outstanding");
+    json_incref (b);
+    intern_json_put (in, b);
+    intern_sweep (in);
+    ok (stat_get (in, "jobspecs") == 1,
+        "intern_sweep drops jobspec once all references are put");
+    ok (json_object_get (b, "attributes") != NULL,
+        "swept jobspec is still valid while referenced");
+    json_decref (b);
+    ok (json_equal (c, orig),
+        "remaining jobspec is intact");
+    json_decref (orig);
+    intern_json_put (in, c);
+    intern_sweep (in);
+    ok (stat_get (in, "jobspecs") == 0 && stat_get (in, "values") == 0,
+        "intern_sweep drops everything once unused");
+
+    ok (intern_json (NULL, NULL) == NULL,
+        "intern_json in=NULL o=NULL returns NULL");
+    orig = json_string ("foo");
+    ok (intern_json (NULL, orig) == orig,
+        "intern_json in=NULL returns o");
+    intern_json_put (NULL, orig);
+
+    intern_destroy (in);
+}
+
+/* Interned values outlive the table.
+ */
+static void test_destroy (void)
+{
+    struct intern *in;
+    json_t *a;
+
+    if (!(in = intern_create ()))
+        BAIL_OUT ("intern_create failed");
+    a = intern_json (in, make_jobspec ("/tmp"));
+    intern_destroy (in);
+    ok (json_object_get (a, "attributes") != NULL,
+        "interned value is valid after intern_destroy");
+    json_decref (a);
+}
+
+static void test_footprint (void)
+{
+    json_t *o = make_jobspec ("/home/a");
+    size_t size = intern_json_footprint (o);
+
+    ok (size > json_dumpb (o, NULL, 0, JSON_COMPACT),
+        "intern_json_footprint is larger than the encoded size");
+    ok (intern_json_footprint (NULL) == 0,
+        "intern_json_footprint NULL is 0");
+    json_decref (o);
+}
+
+/* Many jobs with a few distinct jobspecs: sweeping as new jobspecs
+ * are interned keeps the table bounded.
+ */
+static void test_many (void)
+{
+    struct intern *in;
+    int errors = 0;
+
+    if (!(in = intern_create ()))
+        BAIL_OUT ("intern_create failed");
+    for (int i = 0; i < 10000; i++) {
+        char cwd[32];
+        json_t *o;
+
+        snprintf (cwd, sizeof (cwd), "/home/%d", i);
+        o = intern_json (in, make_jobspec (cwd));
+        if (!json_is_object (o))
+            errors++;
+        intern_json_put (in, o);
+    }
+    ok (errors == 0,
+        "interned 10000 distinct jobspecs");
+    ok (stat_get (in, "jobspecs") <= 1024,
+        "unused jobspecs were swept");
+    intern_destroy (in);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_destroy ();
+    test_footprint ();
+    test_many ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -329,6 +329,11 @@ struct job *wait_zombie_next (struct waitjob *wait)
     return zhashx_next (wait->zombies);
 }
 
+struct job *wait_zombie_lookup (struct waitjob *wait, flux_jobid_t id)
+{
+    return zhashx_lookup (wait->zombies, &id);
+}
+
 static void respond_unloading (flux_t *h, const flux_msg_t *msg)
 {
     if (flux_respond_error (h, msg, ENOSYS, "job-manager is unloading") < 0)
@@ -29,6 +29,7 @@ void wait_disconnect_rpc (flux_t *h,
 
 struct job *wait_zombie_first (struct waitjob *wait);
 struct job *wait_zombie_next (struct waitjob *wait);
+struct job *wait_zombie_lookup (struct waitjob *wait, flux_jobid_t id);
 
 #endif /* ! _FLUX_JOB_MANAGER_WAIT_H */
 
@@ -21,6 +21,7 @@
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 
 /* State for one watcher */
 struct watcher {
@@ -36,11 +37,22 @@ struct watcher {
     int initial_rootseq;        // initial rootseq returned by initial rpc
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
-    zlist_t *lookups;           // list of futures, in commit order
+    zlist_t *lookups;           // list of struct lookup, in commit order
 
     struct ns_monitor *nsm;     // back pointer for removal
     json_t *prev;               // previous watch value for KVS_WATCH_FULL/UNIQ
     int append_offset;          // offset for KVS_WATCH_APPEND
+    int append_index;           // valref blobrefs sent for KVS_WATCH_APPEND
+    zlist_t *append_roots;      // roots to look up for KVS_WATCH_APPEND
+};
+
+/* A kvs.lookup-plus RPC, shared by watchers of the same key at the
+ * same root, see process_lookup_response().
+ */
+struct lookup {
+    flux_future_t *f;           // lookup future
+    int refcount;
+    zlist_t *watchers;          // watchers with this lookup in w->lookups
 };
 
 /* Current KVS root.
@@ -75,8 +87,56 @@ struct watch_ctx {
     flux_t *h;
     flux_msg_handler_t **handlers;
     zhash_t *namespaces;        // hash of monitored namespaces
+    unsigned long lookups;      // lookup RPCs sent
+    unsigned long coalesced;    // lookups shared with another watcher
 };
 
+static void commit_destroy (struct commit *commit);
+
+static void lookup_decref (struct lookup *l)
+{
+    if (l && --l->refcount == 0) {
+        int saved_errno = errno;
+        flux_future_destroy (l->f);
+        zlist_destroy (&l->watchers);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static struct lookup *lookup_incref (struct lookup *l)
+{
+    if (l)
+        l->refcount++;
+    return l;
+}
+
+static struct lookup *lookup_create (flux_future_t *f)
+{
+    struct lookup *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    if (!(l->watchers = zlist_new ())) {
+        free (l);
+        errno = ENOMEM;
+        return NULL;
+    }
+    l->f = f;
+    l->refcount = 1;
+    return l;
+}
+
+/* Remove watcher 'w' from lookup 'l' and drop its reference.
+ */
+static void lookup_release (struct lookup *l, struct watcher *w)
+{
+    if (l) {
+        zlist_remove (l->watchers, w);
+        lookup_decref (l);
+    }
+}
+
 static void watcher_destroy (struct watcher *w)
 {
     if (w) {
@@ -84,12 +144,18 @@ static void watcher_destroy (struct watcher *w)
         flux_msg_decref (w->request);
         free (w->key);
         if (w->lookups) {
-            flux_future_t *f;
-            while ((f = zlist_pop (w->lookups)))
-                flux_future_destroy (f);
+            struct lookup *l;
+            while ((l = zlist_pop (w->lookups)))
+                lookup_release (l, w);
             zlist_destroy (&w->lookups);
         }
         json_decref (w->prev);
+        if (w->append_roots) {
+            struct commit *commit;
+            while ((commit = zlist_pop (w->append_roots)))
+                commit_destroy (commit);
+            zlist_destroy (&w->append_roots);
+        }
         free (w);
         errno = saved_errno;
     }
@@ -109,6 +175,8 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
         goto error;
     if (!(w->lookups = zlist_new ()))
         goto error_nomem;
+    if ((flags & FLUX_KVS_WATCH_APPEND) && !(w->append_roots = zlist_new ()))
+        goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
     return w;
@@ -235,7 +303,8 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
-                                    int root_seq)
+                                    int root_seq,
+                                    int append_count)
 {
     /* this is the first response case, store the first response
      * val */
@@ -250,6 +319,8 @@ static int handle_initial_response (flux_t *h,
             flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
             return -1;
         }
+        /* a val becomes the first blobref when appended to */
+        w->append_index = append_count > 0 ? append_count : 1;
     }
 
     if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
@@ -297,40 +368,27 @@ static int handle_compare_response (flux_t *h,
     return 0;
 }
 
+/* The lookup was made with the "append_index" of blobrefs already
+ * sent, so if the value is a valref, 'val' contains only the data
+ * appended since the last response (or the full value on the first
+ * response).  If 'append_count' is 0, the value is a val and 'val'
+ * contains the full value.
+ */
 static int handle_append_response (flux_t *h,
-                                    struct watcher *w,
-                                    json_t *val)
+                                   struct watcher *w,
+                                   json_t *val,
+                                   int append_count)
 {
-    if (!w->responded) {
-        /* this is the first response case, store the first response
-         * info.  This is here b/c initial response could have been
-         * ENOENT case */
-        if (treeobj_decode_val (val,
-                                NULL,
-                                &w->append_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
-            return -1;
-        }
+    json_t *new_val = NULL;
+    void *new_data = NULL;
+    int new_len;
 
-        if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
-            return -1;
-        }
-
-        w->responded = true;
+    if (treeobj_decode_val (val, &new_data, &new_len) < 0) {
+        flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
+        return -1;
     }
-    else {
-        json_t *new_val = NULL;
-        void *new_data = NULL;
-        int new_offset;
-
-        if (treeobj_decode_val (val,
-                                &new_data,
-                                &new_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
-            return -1;
-        }
 
+    if (append_count == 0) {
         /* check length to determine if append actually happened, note
          * that zero length append is legal
          *
@@ -338,29 +396,38 @@ static int handle_append_response (flux_t *h,
          * "fake" appended to.  i.e. the key overwritten with data
          * longer than the original.
          */
-        if (new_offset < w->append_offset) {
-            free (new_data);
+        if (new_len < w->append_offset) {
             errno = EINVAL;
-            return -1;
+            goto error;
         }
-
         if (!(new_val = treeobj_create_val (new_data + w->append_offset,
-                                            new_offset - w->append_offset))) {
-            free (new_data);
-            return -1;
+                                            new_len - w->append_offset)))
+            goto error;
+        w->append_offset = new_len;
+        w->append_index = 1;
+    }
+    else {
+        /* similarly, check blobref count */
+        if (append_count < w->append_index) {
+            errno = EINVAL;
+            goto error;
         }
+        new_val = json_incref (val);
+        w->append_offset += new_len;
+        w->append_index = append_count;
+    }
+    free (new_data);
 
-        free (new_data);
-        w->append_offset = new_offset;
-
-        if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
-            json_decref (new_val);
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
-            return -1;
-        }
+    if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        return -1;
     }
 
+    w->responded = true;
     return 0;
+error:
+    ERRNO_SAFE_WRAP (free, new_data);
+    return -1;
 }
 
 static int handle_normal_response (flux_t *h,
@@ -389,6 +456,7 @@ static void handle_lookup_response (flux_future_t *f,
     flux_t *h = flux_future_get_flux (f);
     int errnum;
     int root_seq;
+    int append_count = -1;
     json_t *val;
 
     if (flux_future_aux_get (f, "initial")) {
@@ -409,9 +477,10 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
+        if (flux_rpc_get_unpack (f, "{ s:o s:i s?i }",
                                  "val", &val,
-                                 "rootseq", &root_seq) < 0) {
+                                 "rootseq", &root_seq,
+                                 "append_count", &append_count) < 0) {
             /* It is worth mentioning ENOTSUP error conditions here.
              *
              * Recall that in namespace_monitor(), an initial getroot
@@ -432,7 +501,12 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (handle_initial_response (h, w, val, root_seq) < 0)
+        if ((w->flags & FLUX_KVS_WATCH_APPEND) && append_count < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+
+        if (handle_initial_response (h, w, val, root_seq, append_count) < 0)
             goto error;
     }
     else {
@@ -445,10 +519,16 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
+        if (flux_rpc_get_unpack (f, "{ s:o s:i s?i }",
                                  "val", &val,
-                                 "rootseq", &root_seq) < 0)
+                                 "rootseq", &root_seq,
+                                 "append_count", &append_count) < 0)
+            goto error;
+
+        if ((w->flags & FLUX_KVS_WATCH_APPEND) && append_count < 0) {
+            errno = EPROTO;
             goto error;
+        }
 
         /* if we got some setroots before the initial rpc returned,
          * toss them */
@@ -462,7 +542,7 @@ static void handle_lookup_response (flux_future_t *f,
                     goto error;
             }
             else if (w->flags & FLUX_KVS_WATCH_APPEND) {
-                if (handle_append_response (h, w, val) < 0)
+                if (handle_append_response (h, w, val, append_count) < 0)
                     goto error;
             }
             else {
@@ -480,20 +560,25 @@ error:
     w->finished = true;
 }
 
-/* One lookup has completed.
- * Pop ready futures off w->lookups and send responses, until
- * the list is empty, or a non-ready future is encountered.
+static int process_lookup_response (struct ns_monitor *nsm,
+                                    struct watcher *w,
+                                    struct commit *commit,
+                                    zhash_t *shared_lookups);
+
+/* Pop ready lookups off w->lookups and send responses, until
+ * the list is empty, or a non-ready lookup is encountered.
  */
-static void lookup_continuation (flux_future_t *f, void *arg)
+static void watcher_process_lookups (struct watcher *w)
 {
-    struct watcher *w = arg;
     struct ns_monitor *nsm = w->nsm;
+    struct commit *commit;
+    struct lookup *l;
 
-    while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
-        f = zlist_pop (w->lookups);
+    while ((l = zlist_first (w->lookups)) && flux_future_is_ready (l->f)) {
+        l = zlist_pop (w->lookups);
         if (!w->finished)
-            handle_lookup_response (f, w);
-        flux_future_destroy (f);
+            handle_lookup_response (l->f, w);
+        lookup_release (l, w);
         /* if WAITCREATE and !WATCH, then we only care about sending
          * one response and being done.  We can use the responded flag
          * to indicate that condition.
@@ -503,10 +588,57 @@ static void lookup_continuation (flux_future_t *f, void *arg)
             && !(w->flags & FLUX_KVS_WATCH))
             w->finished = true;
     }
+    /* Send the next KVS_WATCH_APPEND lookup deferred by
+     * watcher_respond(), now that the append index is up to date.
+     */
+    if (!w->finished
+        && w->append_roots
+        && zlist_size (w->lookups) == 0
+        && (commit = zlist_pop (w->append_roots))) {
+        int rc = process_lookup_response (nsm, w, commit, NULL);
+        commit_destroy (commit);
+        if (rc < 0) {
+            if (!w->mute) {
+                if (flux_respond_error (nsm->ctx->h,
+                                        w->request,
+                                        errno,
+                                        NULL) < 0)
+                    flux_log_error (nsm->ctx->h,
+                                    "%s: flux_respond_error",
+                                    __FUNCTION__);
+            }
+            w->finished = true;
+        }
+    }
     if (w->finished)
         watcher_cleanup (nsm, w);
 }
 
+/* One lookup has completed.
+ * Process the lookups of each watcher sharing it.
+ * N.B. watcher_process_lookups() removes watchers from l->watchers and
+ * drops their references to 'l', so iterate over a duplicate list and
+ * hold a reference until done.
+ */
+static void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct lookup *l = lookup_incref (arg);
+    zlist_t *watchers;
+    struct watcher *w;
+
+    if ((watchers = zlist_dup (l->watchers))) {
+        w = zlist_first (watchers);
+        while (w) {
+            watcher_process_lookups (w);
+            w = zlist_next (watchers);
+        }
+        zlist_destroy (&watchers);
+    }
+    else
+        flux_log_error (flux_future_get_flux (f), "%s: zlist_dup", __FUNCTION__);
+    lookup_decref (l);
+}
+
 /* Like flux_kvs_lookupat() except:
  * - targets kvs.lookup-plus, so root_ref & root_seq are available in
  *   response
@@ -545,6 +677,13 @@ static flux_future_t *lookupat (flux_t *h,
                            "rootdir", o) < 0)
             goto error;
     }
+    /* For KVS_WATCH_APPEND, only fetch data appended since the last
+     * response, see handle_append_response().
+     */
+    if ((w->flags & FLUX_KVS_WATCH_APPEND)) {
+        if (flux_msg_pack (msg, "{s:i}", "append_index", w->append_index) < 0)
+            goto error;
+    }
     /* N.B. Since this module is authenticated to the shmem:// connector
      * with FLUX_ROLE_OWNER, we are allowed to switch the message credentials
      * in this request message, and not be overridden at the connector,
@@ -574,35 +713,97 @@ error:
     return NULL;
 }
 
-static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
+/* Build the key under which a lookup by watcher 'w' at 'commit' may be
+ * shared.  Watchers share a lookup only if the lookup request would be
+ * identical, including the credentials it is made with.  Initial lookups
+ * are made at the current root rather than a specific one, and
+ * KVS_WATCH_APPEND lookups depend on the watcher's append index, so
+ * neither is shared.
+ */
+static char *lookup_share_key (struct watcher *w, struct commit *commit)
 {
+    char *s;
+
+    if (!w->initial_rpc_sent || (w->flags & FLUX_KVS_WATCH_APPEND))
+        return NULL;
+    if (asprintf (&s,
+                  "%d:%ju:%ju:%d:%s",
+                  commit->rootseq,
+                  (uintmax_t)w->cred.userid,
+                  (uintmax_t)w->cred.rolemask,
+                  w->flags,
+                  w->key) < 0)
+        return NULL;
+    return s;
+}
+
+/* Send a lookup for watcher 'w' at 'commit', or if 'shared_lookups' is
+ * non-NULL and holds an identical lookup, add 'w' to it.
+ */
+static int process_lookup_response (struct ns_monitor *nsm,
+                                    struct watcher *w,
+                                    struct commit *commit,
+                                    zhash_t *shared_lookups)
+{
+    struct lookup *l = NULL;
+    char *share_key = NULL;
+    bool shared = false;
     flux_future_t *f;
-    if (!(f = lookupat (nsm->ctx->h,
-                        w,
-                        nsm->commit->rootref,
-                        nsm->commit->rootseq,
-                        nsm->ns_name))) {
-        flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
-        return -1;
+
+    if (shared_lookups
+        && (share_key = lookup_share_key (w, commit))
+        && (l = zhash_lookup (shared_lookups, share_key))) {
+        lookup_incref (l);
+        shared = true;
     }
-    if (zlist_append (w->lookups, f) < 0) {
-        flux_future_destroy (f);
+    else {
+        if (!(f = lookupat (nsm->ctx->h,
+                            w,
+                            commit->rootref,
+                            commit->rootseq,
+                            nsm->ns_name))) {
+            flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
+            goto error;
+        }
+        if (!(l = lookup_create (f))) {
+            flux_future_destroy (f);
+            goto error;
+        }
+        if (flux_future_then (f, -1., lookup_continuation, l) < 0)
+            goto error;
+    }
+    if (zlist_append (w->lookups, l) < 0
+        || zlist_append (l->watchers, w) < 0) {
+        zlist_remove (w->lookups, l);
         errno = ENOMEM;
-        return -1;
+        goto error;
     }
-    if (flux_future_then (f, -1., lookup_continuation, w) < 0) {
-        flux_future_destroy (f);
-        return -1;
+    if (shared)
+        nsm->ctx->coalesced++;
+    else {
+        nsm->ctx->lookups++;
+        /* N.B. shared_lookups does not own its entries.  It is destroyed
+         * before any lookup can complete, see watcher_respond_ns().
+         */
+        if (share_key)
+            (void)zhash_insert (shared_lookups, share_key, l);
     }
-    w->rootseq = nsm->commit->rootseq;
+    free (share_key);
+    w->rootseq = commit->rootseq;
     return 0;
+error:
+    lookup_decref (l);
+    ERRNO_SAFE_WRAP (free, share_key);
+    return -1;
 }
 
 /* Respond to watcher request, if appropriate.
  * De-list and destroy watcher from namespace on error.
  * De-hash and destroy namespace if watchers list becomes empty.
  */
-static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
+static void watcher_respond (struct ns_monitor *nsm,
+                             struct watcher *w,
+                             zhash_t *shared_lookups)
 {
     /* If this watcher is already done, we should ignore namespace
      * remove, setroot, cancel, etc.  that leads us here.  Just goto
@@ -657,11 +858,33 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
      *
      * Note on FLUX_KVS_WATCH_FULL: A lookup / comparison is done on every
      * change.
+     *
+     * Note on FLUX_KVS_WATCH_APPEND: Lookups request only the data past
+     * the blobrefs already sent, so only one lookup may be in flight.
+     * If one is, queue the root and look it up when the lookup in flight
+     * completes, see lookup_continuation().
      */
     if (w->rootseq == -1
         || (w->flags & FLUX_KVS_WATCH_FULL)
         || key_match (nsm->commit->keys, w->key)) {
-        if (process_lookup_response (nsm, w) < 0)
+        if ((w->flags & FLUX_KVS_WATCH_APPEND)
+            && zlist_size (w->lookups) > 0) {
+            struct commit *commit;
+            if (!(commit = commit_create (nsm->commit->rootref,
+                                          nsm->commit->rootseq,
+                                          NULL)))
+                goto error_respond;
+            if (zlist_append (w->append_roots, commit) < 0) {
+                commit_destroy (commit);
+                errno = ENOMEM;
+                goto error_respond;
+            }
+            w->rootseq = nsm->commit->rootseq;
+        }
+        else if (process_lookup_response (nsm,
+                                          w,
+                                          nsm->commit,
+                                          shared_lookups) < 0)
             goto error_respond;
     }
     return;
@@ -679,18 +902,26 @@ finished:
  * N.B. watcher_respond() may call zlist_remove() on nsm->watchers.
  * Since zlist_t is not deletion-safe for traversal, a temporary duplicate
  * must be created here.
+ *
+ * Watchers of the same key at this root share one lookup, via
+ * shared_lookups.  If the hash cannot be created, each watcher gets its
+ * own lookup.
  */
 static void watcher_respond_ns (struct ns_monitor *nsm)
 {
     zlist_t *l;
+    zhash_t *shared_lookups = NULL;
     struct watcher *w;
 
     if ((l = zlist_dup (nsm->watchers))) {
+        if (zlist_size (l) > 1)
+            shared_lookups = zhash_new ();
         w = zlist_first (l);
         while (w) {
-            watcher_respond (nsm, w);
+            watcher_respond (nsm, w, shared_lookups);
             w = zlist_next (l);
         }
+        zhash_destroy (&shared_lookups);
         zlist_destroy (&l);
     }
     else
@@ -715,7 +946,7 @@ static void watcher_cancel (struct ns_monitor *nsm,
     if (match) {
         w->canceled = true;
         w->mute = !cancel;
-        watcher_respond (nsm, w);
+        watcher_respond (nsm, w, NULL);
     }
 }
 
@@ -985,7 +1216,7 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     if (nsm->commit)
-        watcher_respond (nsm, w);
+        watcher_respond (nsm, w, NULL);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
@@ -1044,10 +1275,12 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
         watchers += zlist_size (nsm->watchers);
         nsm = zhash_next (ctx->namespaces);
     }
-    if (flux_respond_pack (h, msg, "{s:i s:i s:O}",
+    if (flux_respond_pack (h, msg, "{s:i s:i s:O s:I s:I}",
                            "watchers", watchers,
                            "namespace-count", (int)zhash_size (ctx->namespaces),
-                           "namespaces", stats) < 0)
+                           "namespaces", stats,
+                           "lookups", (json_int_t)ctx->lookups,
+                           "lookups-coalesced", (json_int_t)ctx->coalesced) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (stats);
     return;
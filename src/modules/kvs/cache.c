@@ -26,6 +26,7 @@
 #include <jansson.h>
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libccan/ccan/list/list.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/tstat.h"
@@ -50,12 +51,20 @@ struct cache_entry {
     int errnum;
     char *blobref;
     int refcount;
+    struct cache *cache;    /* set while entry is in a cache */
+    struct list_node lru;
 };
 
 struct cache {
     flux_reactor_t *r;
     double fake_time;       /* -1. for invalid */
     zhashx_t *zhx;
+    struct list_head lru;   /* most recently used first */
+    size_t acct_size;       /* sum of valid entry sizes */
+    size_t max_size;        /* 0 = unlimited */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
 };
 
 static double cache_now (struct cache *cache)
@@ -196,12 +205,16 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
     entry->data = cpy;
     entry->len = len;
     entry->valid = true;
+    if (entry->cache)
+        entry->cache->acct_size += len;
     if (entry->waitlist_valid) {
         if (wait_runqueue (entry->waitlist_valid) < 0)
             goto reset_invalid;
     }
     return 0;
 reset_invalid:
+    if (entry->cache)
+        entry->cache->acct_size -= len;
     free (entry->data);
     entry->data = NULL;
     entry->len = 0;
@@ -313,11 +326,25 @@ struct cache_entry *cache_lookup (struct cache *cache, const char *ref)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
     double current_time = cache_now (cache);
-    if (entry && current_time > entry->lastuse_time)
-        entry->lastuse_time = current_time;
+
+    if (entry) {
+        if (current_time > entry->lastuse_time)
+            entry->lastuse_time = current_time;
+        list_del (&entry->lru);
+        list_add (&cache->lru, &entry->lru);
+    }
+    if (entry && entry->valid)
+        cache->hits++;
+    else
+        cache->misses++;
     return entry;
 }
 
+struct cache_entry *cache_peek (struct cache *cache, const char *ref)
+{
+    return zhashx_lookup (cache->zhx, ref);
+}
+
 int cache_insert (struct cache *cache, struct cache_entry *entry)
 {
     int rc;
@@ -325,10 +352,25 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
     if (cache && entry) {
         rc = zhashx_insert (cache->zhx, entry->blobref, entry);
         assert (rc == 0);
+        entry->cache = cache;
+        list_add (&cache->lru, &entry->lru);
+        if (entry->valid)
+            cache->acct_size += entry->len;
     }
     return 0;
 }
 
+/* Unlink entry from cache accounting and delete it.
+ */
+static void cache_delete (struct cache *cache, struct cache_entry *entry)
+{
+    list_del (&entry->lru);
+    if (entry->valid)
+        cache->acct_size -= entry->len;
+    entry->cache = NULL;
+    zhashx_delete (cache->zhx, entry->blobref);
+}
+
 int cache_remove_entry (struct cache *cache, const char *ref)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
@@ -339,7 +381,7 @@ int cache_remove_entry (struct cache *cache, const char *ref)
             || !wait_queue_length (entry->waitlist_notdirty))
         && (!entry->waitlist_valid
             || !wait_queue_length (entry->waitlist_valid))) {
-        zhashx_delete (cache->zhx, ref);
+        cache_delete (cache, entry);
         return 1;
     }
     return 0;
@@ -381,7 +423,7 @@ int cache_expire_entries (struct cache *cache, double thresh)
             && !entry->refcount
             && (thresh == 0.
                     || cache_entry_age (entry, cache) > thresh)) {
-                zhashx_delete (cache->zhx, ref);
+                cache_delete (cache, entry);
                 count++;
         }
         ref = zlistx_next (keys);
@@ -390,6 +432,71 @@ int cache_expire_entries (struct cache *cache, double thresh)
     return count;
 }
 
+void cache_set_max_size (struct cache *cache, size_t max_size)
+{
+    if (cache)
+        cache->max_size = max_size;
+}
+
+bool cache_over_max_size (struct cache *cache)
+{
+    return (cache
+            && cache->max_size > 0
+            && cache->acct_size > cache->max_size);
+}
+
+int cache_evict_entries (struct cache *cache)
+{
+    struct cache_entry *entry;
+    struct cache_entry *prev;
+    int count = 0;
+
+    if (!cache) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* Walk from least to most recently used.  Skip pinned entries:
+     * dirty, incomplete, waited on, or referenced.
+     */
+    list_for_each_rev_safe (&cache->lru, entry, prev, lru) {
+        if (!cache_over_max_size (cache))
+            break;
+        if (!entry->valid
+            || entry->dirty
+            || entry->refcount > 0
+            || (entry->waitlist_notdirty
+                && wait_queue_length (entry->waitlist_notdirty) > 0)
+            || (entry->waitlist_valid
+                && wait_queue_length (entry->waitlist_valid) > 0))
+            continue;
+        cache_delete (cache, entry);
+        count++;
+    }
+    cache->evictions += count;
+    return count;
+}
+
+void cache_clear_counters (struct cache *cache)
+{
+    if (cache) {
+        cache->hits = 0;
+        cache->misses = 0;
+        cache->evictions = 0;
+    }
+}
+
+void cache_get_counters (struct cache *cache,
+                         struct cache_counters *counters)
+{
+    if (cache && counters) {
+        counters->size = cache->acct_size;
+        counters->max_size = cache->max_size;
+        counters->hits = cache->hits;
+        counters->misses = cache->misses;
+        counters->evictions = cache->evictions;
+    }
+}
+
 int cache_get_stats (struct cache *cache, tstat_t *ts, int *sizep,
                      int *incompletep, int *dirtyp)
 {
@@ -470,6 +577,7 @@ struct cache *cache_create (flux_reactor_t *r)
     }
     cache->r = r;
     cache->fake_time = -1.;
+    list_head_init (&cache->lru);
     /* do not duplicate hash keys, use blobrefs stored in cache entry */
     zhashx_set_key_destructor (cache->zhx, NULL);
     zhashx_set_key_duplicator (cache->zhx, NULL);
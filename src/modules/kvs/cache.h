@@ -117,10 +117,16 @@ struct cache *cache_create (flux_reactor_t *r);
 void cache_destroy (struct cache *cache);
 
 /* Look up a cache entry.
- * Update the cache entry's "last used" time.
+ * Update the cache entry's "last used" time and LRU position, and count
+ * a hit if the entry is valid or a miss otherwise.
  */
 struct cache_entry *cache_lookup (struct cache *cache, const char *ref);
 
+/* Look up a cache entry without updating its use or the hit/miss
+ * counters, e.g. when completing a load or store RPC on the entry.
+ */
+struct cache_entry *cache_peek (struct cache *cache, const char *ref);
+
 /* Insert entry in the cache.  Reference for entry created during
  * cache_entry_create() time.  Ownership of the cache entry is
  * transferred to the cache.
@@ -145,6 +151,35 @@ int cache_count_entries (struct cache *cache);
  */
 int cache_expire_entries (struct cache *cache, double max_age);
 
+/* Set a limit on the total size of valid cache entry data, in bytes.
+ * If max_size == 0 (the default), the cache size is unlimited.
+ */
+void cache_set_max_size (struct cache *cache, size_t max_size);
+
+/* Return true if the cache exceeds its size limit.
+ */
+bool cache_over_max_size (struct cache *cache);
+
+/* Expire least recently used entries until the cache is within its
+ * size limit.  Entries that are dirty, incomplete, waited on, or
+ * referenced are not expired.  Caller must not hold pointers to cache
+ * entry data that is not protected by a reference.
+ * Returns -1 on error, evicted count on success.
+ */
+int cache_evict_entries (struct cache *cache);
+
+struct cache_counters {
+    size_t size;                /* total size of valid entries */
+    size_t max_size;
+    unsigned long hits;         /* cache_lookup() found a valid entry */
+    unsigned long misses;
+    unsigned long evictions;    /* by cache_evict_entries() */
+};
+
+void cache_get_counters (struct cache *cache,
+                         struct cache_counters *counters);
+void cache_clear_counters (struct cache *cache);
+
 /* Obtain statistics on the cache.
  * Returns -1 on error, 0 on success
  */
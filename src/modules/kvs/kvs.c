@@ -31,6 +31,7 @@
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_txn_private.h"
 #include "src/common/libkvs/kvs_util_private.h"
+#include "src/common/libcontent/content-batch.h"
 
 #include "waitqueue.h"
 #include "cache.h"
@@ -56,6 +57,18 @@ const double max_lastuse_age = 10.;
  */
 const double max_namespace_age = 3600.;
 
+/* Content loads and stores issued in one reactor loop iteration are sent
+ * to the content cache as a single load-batch or store-batch request,
+ * of at most 'content_batch_max' items.
+ */
+const int content_batch_max = 256;
+
+/* Default limit on the total size of cache entries.  Least recently used
+ * entries are expired once per reactor loop iteration when it is exceeded.
+ * Override with the cache-max-size=BYTES module option (0 = unlimited).
+ */
+const size_t default_cache_max_size = 1024*1024*1024;
+
 struct kvs_ctx {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
@@ -65,6 +78,10 @@ struct kvs_ctx {
     flux_watcher_t *prep_w;
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
+    flux_watcher_t *content_prep_w;
+    struct content_batch *load_refs;    /* pending content loads */
+    struct content_batch *store_blobs;  /* pending content stores */
+    struct content_batch *store_refs;   /*   and their expected blobrefs */
     int transaction_merge;
     bool events_init;            /* flag */
     const char *hash_name;
@@ -84,6 +101,8 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                                  int revents, void *arg);
 static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
                                   int revents, void *arg);
+static void content_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg);
 static void start_root_remove (struct kvs_ctx *ctx, const char *ns);
 
 /*
@@ -98,6 +117,10 @@ static void kvs_ctx_destroy (struct kvs_ctx *ctx)
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->content_prep_w);
+        content_batch_destroy (ctx->load_refs);
+        content_batch_destroy (ctx->store_blobs);
+        content_batch_destroy (ctx->store_refs);
         free (ctx);
         errno = saved_errno;
     }
@@ -116,6 +139,7 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
     }
     if (!(ctx->cache = cache_create (r)))
         goto error;
+    cache_set_max_size (ctx->cache, default_cache_max_size);
     if (!(ctx->krm = kvsroot_mgr_create (ctx->h, ctx)))
         goto error;
     ctx->h = h;
@@ -134,6 +158,10 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
         flux_watcher_start (ctx->prep_w);
         flux_watcher_start (ctx->check_w);
     }
+    ctx->content_prep_w = flux_prepare_watcher_create (r, content_prep_cb, ctx);
+    if (!ctx->content_prep_w)
+        goto error;
+    flux_watcher_start (ctx->content_prep_w);
     ctx->transaction_merge = 1;
     list_head_init (&ctx->work_queue);
     return ctx;
@@ -441,30 +469,32 @@ static void content_load_cache_entry_error (struct kvs_ctx *ctx,
         flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
 }
 
-static void content_load_completion (flux_future_t *f, void *arg)
+/* Handle the result of loading 'blobref': either 'data' of length 'size'
+ * or an error 'errnum'.
+ */
+static void content_load_result (struct kvs_ctx *ctx,
+                                 const char *blobref,
+                                 const void *data,
+                                 int size,
+                                 int errnum)
 {
-    struct kvs_ctx *ctx = arg;
-    const void *data;
-    int size;
-    const char *blobref;
     struct cache_entry *entry;
 
-    blobref = flux_future_aux_get (f, "ref");
-
     /* should be impossible for lookup to fail, cache entry created
      * earlier, and cache_expire_entries() could not have removed it
      * b/c it is not yet valid.  But check and log incase there is
      * logic error dealng with error paths using cache_remove_entry().
      */
-    if (!(entry = cache_lookup (ctx->cache, blobref))) {
-        flux_log (ctx->h, LOG_ERR, "%s: cache_lookup", __FUNCTION__);
-        goto done;
+    if (!(entry = cache_peek (ctx->cache, blobref))) {
+        flux_log (ctx->h, LOG_ERR, "%s: cache_peek", __FUNCTION__);
+        return;
     }
 
-    if (flux_content_load_get (f, &data, &size) < 0) {
-        flux_log_error (ctx->h, "%s: flux_content_load_get", __FUNCTION__);
-        content_load_cache_entry_error (ctx, entry, errno, blobref);
-        goto done;
+    if (errnum) {
+        errno = errnum;
+        flux_log_error (ctx->h, "%s: content load %s", __FUNCTION__, blobref);
+        content_load_cache_entry_error (ctx, entry, errnum, blobref);
+        return;
     }
 
     /* If cache_entry_set_raw() fails, it's a pretty terrible error
@@ -474,42 +504,112 @@ static void content_load_completion (flux_future_t *f, void *arg)
     if (cache_entry_set_raw (entry, data, size) < 0) {
         flux_log_error (ctx->h, "%s: cache_entry_set_raw", __FUNCTION__);
         content_load_cache_entry_error (ctx, entry, errno, blobref);
+        return;
+    }
+}
+
+/* Fail all loads in 'refs' with 'errnum'.
+ */
+static void content_load_batch_error (struct kvs_ctx *ctx,
+                                      const struct content_batch *refs,
+                                      int errnum)
+{
+    int count = content_batch_count (refs);
+
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+
+        if (content_batch_get_string (refs, i, &blobref) == 0)
+            content_load_result (ctx, blobref, NULL, 0, errnum);
+    }
+}
+
+static void content_load_completion (flux_future_t *f, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    const struct content_batch *refs = flux_future_aux_get (f, "refs");
+    const struct content_batch *blobs;
+    int count = content_batch_count (refs);
+
+    if (content_batch_rpc_get (f, &blobs) < 0) {
+        flux_log_error (ctx->h, "%s: content_batch_rpc_get", __FUNCTION__);
+        content_load_batch_error (ctx, refs, errno);
         goto done;
     }
+    if (content_batch_count (blobs) != count) {
+        flux_log (ctx->h, LOG_ERR, "%s: wrong item count", __FUNCTION__);
+        content_load_batch_error (ctx, refs, EPROTO);
+        goto done;
+    }
+    for (int i = 0; i < count; i++) {
+        const char *blobref;
+        const void *data;
+        int size;
 
+        if (content_batch_get_string (refs, i, &blobref) < 0)
+            continue;
+        if (content_batch_get (blobs, i, &data, &size) < 0)
+            content_load_result (ctx, blobref, NULL, 0, errno);
+        else
+            content_load_result (ctx, blobref, data, size, 0);
+    }
 done:
     flux_future_destroy (f);
 }
 
-/* Send content load request and setup contination to handle response.
+static void content_batch_destructor (void *arg)
+{
+    content_batch_destroy (arg);
+}
+
+/* Send pending content loads as a load-batch request.
+ * On failure, waiters on the pending loads are notified of the error.
  */
-static int content_load_request_send (struct kvs_ctx *ctx, const char *ref)
+static void content_load_flush (struct kvs_ctx *ctx)
 {
+    struct content_batch *refs = ctx->load_refs;
     flux_future_t *f = NULL;
-    char *refcpy;
-    int saved_errno;
 
-    if (!(f = flux_content_load (ctx->h, ref, 0))) {
-        flux_log_error (ctx->h, "%s: flux_content_load", __FUNCTION__);
+    if (!refs)
+        return;
+    ctx->load_refs = NULL;
+    if (!(f = content_load_batch (ctx->h, refs, 0))) {
+        flux_log_error (ctx->h, "%s: content_load_batch", __FUNCTION__);
         goto error;
     }
-    if (!(refcpy = strdup (ref)))
-        goto error;
-    if (flux_future_aux_set (f, "ref", refcpy, free) < 0) {
+    if (flux_future_aux_set (f, "refs", refs, content_batch_destructor) < 0) {
         flux_log_error (ctx->h, "%s: flux_future_aux_set", __FUNCTION__);
-        free (refcpy);
         goto error;
     }
     if (flux_future_then (f, -1., content_load_completion, ctx) < 0) {
         flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
-        goto error;
+        content_load_batch_error (ctx, refs, errno);
+        flux_future_destroy (f);
+        return;
     }
-    return 0;
+    return;
 error:
-    saved_errno = errno;
+    content_load_batch_error (ctx, refs, errno);
+    content_batch_destroy (refs);
     flux_future_destroy (f);
-    errno = saved_errno;
-    return -1;
+}
+
+/* Queue content load request.  Pending loads are sent as one load-batch
+ * request from content_prep_cb(), or when the batch is full.
+ * N.B. the batch is not sent here after appending 'ref', since the caller
+ * has not yet registered its waiter on the new cache entry.
+ */
+static int content_load_request_send (struct kvs_ctx *ctx, const char *ref)
+{
+    if (content_batch_count (ctx->load_refs) >= content_batch_max)
+        content_load_flush (ctx);
+    if (!ctx->load_refs) {
+        if (!(ctx->load_refs = content_batch_create ()))
+            return -1;
+    }
+    if (content_batch_append_string (ctx->load_refs, ref) < 0)
+        return -1;
+    return 0;
 }
 
 /* Return 0 on success, -1 on error.  Set stall variable appropriately
@@ -580,18 +680,61 @@ static int load (struct kvs_ctx *ctx, const char *ref, wait_t *wait, bool *stall
  * store/write
  */
 
-static void content_store_completion (flux_future_t *f, void *arg)
+static void content_store_cache_entry_error (struct kvs_ctx *ctx,
+                                             const char *cache_blobref,
+                                             int errnum)
 {
-    struct kvs_ctx *ctx = arg;
     struct cache_entry *entry;
-    const char *cache_blobref, *blobref;
     int ret;
 
-    cache_blobref = flux_future_aux_get (f, "cache_blobref");
-    assert (cache_blobref);
+    /* failure on store, inform all waiters, must destroy entry
+     * afterwards, as future loads/stores may believe content is ok.
+     * cache_remove_entry() will not work if a waiter is still there.
+     * If assert hits, it's because we did not set up a wait error cb
+     * correctly.
+     */
+
+    /* we can't do anything if this cache_peek fails */
+    if (!(entry = cache_peek (ctx->cache, cache_blobref))) {
+        flux_log (ctx->h, LOG_ERR, "%s: cache_peek", __FUNCTION__);
+        return;
+    }
+
+    /* In the case this fails, we'll mark the cache entry not dirty,
+     * so that memory can be reclaimed at a later time.  But we can't
+     * do that with cache_entry_clear_dirty() b/c that will only clear
+     * dirty for entries without waiters.  So in this rare case, we
+     * must call cache_entry_force_clear_dirty().  flushed.
+     */
+    if (cache_entry_set_errnum_on_notdirty (entry, errnum) < 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: cache_entry_set_errnum_on_notdirty",
+                  __FUNCTION__);
+        ret = cache_entry_force_clear_dirty (entry);
+        assert (ret == 0);
+        return;
+    }
+
+    /* this can't fail, otherwise we shouldn't be in this function */
+    ret = cache_entry_force_clear_dirty (entry);
+    assert (ret == 0);
+
+    if (cache_remove_entry (ctx->cache, cache_blobref) < 0)
+        flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
+}
+
+/* Handle the result of storing the cache entry 'cache_blobref':
+ * either the 'blobref' returned by the content store or an error 'errnum'.
+ */
+static void content_store_result (struct kvs_ctx *ctx,
+                                  const char *cache_blobref,
+                                  const char *blobref,
+                                  int errnum)
+{
+    struct cache_entry *entry;
 
-    if (flux_content_store_get (f, &blobref) < 0) {
-        flux_log_error (ctx->h, "%s: flux_content_store_get", __FUNCTION__);
+    if (errnum) {
+        errno = errnum;
+        flux_log_error (ctx->h, "%s: content store", __FUNCTION__);
         goto error;
     }
 
@@ -602,7 +745,7 @@ static void content_store_completion (flux_future_t *f, void *arg)
     if (strcmp (blobref, cache_blobref)) {
         flux_log (ctx->h, LOG_ERR, "%s: inconsistent blobref returned",
                   __FUNCTION__);
-        errno = EPROTO;
+        errnum = EPROTO;
         goto error;
     }
 
@@ -612,8 +755,9 @@ static void content_store_completion (flux_future_t *f, void *arg)
      * b/c it was dirty.  But check and log incase there is logic
      * error dealng with error paths using cache_remove_entry().
      */
-    if (!(entry = cache_lookup (ctx->cache, blobref))) {
-        flux_log (ctx->h, LOG_ERR, "%s: cache_lookup", __FUNCTION__);
+    if (!(entry = cache_peek (ctx->cache, blobref))) {
+        flux_log (ctx->h, LOG_ERR, "%s: cache_peek", __FUNCTION__);
+        errnum = ENOENT;
         goto error;
     }
 
@@ -627,74 +771,130 @@ static void content_store_completion (flux_future_t *f, void *arg)
     if (cache_entry_set_dirty (entry, false) < 0) {
         flux_log_error (ctx->h, "%s: cache_entry_set_dirty",
                         __FUNCTION__);
+        errnum = errno;
         goto error;
     }
-
-    flux_future_destroy (f);
     return;
-
 error:
-    flux_future_destroy (f);
+    content_store_cache_entry_error (ctx, cache_blobref, errnum);
+}
 
-    /* failure on store, inform all waiters, must destroy entry
-     * afterwards, as future loads/stores may believe content is ok.
-     * cache_remove_entry() will not work if a waiter is still there.
-     * If assert hits, it's because we did not set up a wait error cb
-     * correctly.
-     */
+/* Fail all stores in 'refs' with 'errnum'.
+ */
+static void content_store_batch_error (struct kvs_ctx *ctx,
+                                       const struct content_batch *refs,
+                                       int errnum)
+{
+    int count = content_batch_count (refs);
 
-    /* we can't do anything if this cache_lookup fails */
-    if (!(entry = cache_lookup (ctx->cache, cache_blobref))) {
-        flux_log (ctx->h, LOG_ERR, "%s: cache_lookup", __FUNCTION__);
-        return;
-    }
+    for (int i = 0; i < count; i++) {
+        const char *cache_blobref;
 
-    /* In the case this fails, we'll mark the cache entry not dirty,
-     * so that memory can be reclaimed at a later time.  But we can't
-     * do that with cache_entry_clear_dirty() b/c that will only clear
-     * dirty for entries without waiters.  So in this rare case, we
-     * must call cache_entry_force_clear_dirty().  flushed.
-     */
-    if (cache_entry_set_errnum_on_notdirty (entry, errno) < 0) {
-        flux_log (ctx->h, LOG_ERR, "%s: cache_entry_set_errnum_on_notdirty",
-                  __FUNCTION__);
-        ret = cache_entry_force_clear_dirty (entry);
-        assert (ret == 0);
-        return;
+        if (content_batch_get_string (refs, i, &cache_blobref) == 0)
+            content_store_result (ctx, cache_blobref, NULL, errnum);
     }
+}
 
-    /* this can't fail, otherwise we shouldn't be in this function */
-    ret = cache_entry_force_clear_dirty (entry);
-    assert (ret == 0);
+static void content_store_completion (flux_future_t *f, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    const struct content_batch *refs = flux_future_aux_get (f, "refs");
+    const struct content_batch *blobrefs;
+    int count = content_batch_count (refs);
 
-    if (cache_remove_entry (ctx->cache, cache_blobref) < 0)
-        flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
+    if (content_batch_rpc_get (f, &blobrefs) < 0) {
+        flux_log_error (ctx->h, "%s: content_batch_rpc_get", __FUNCTION__);
+        content_store_batch_error (ctx, refs, errno);
+        goto done;
+    }
+    if (content_batch_count (blobrefs) != count) {
+        flux_log (ctx->h, LOG_ERR, "%s: wrong item count", __FUNCTION__);
+        content_store_batch_error (ctx, refs, EPROTO);
+        goto done;
+    }
+    for (int i = 0; i < count; i++) {
+        const char *cache_blobref, *blobref;
+
+        if (content_batch_get_string (refs, i, &cache_blobref) < 0)
+            continue;
+        if (content_batch_get_string (blobrefs, i, &blobref) < 0)
+            content_store_result (ctx, cache_blobref, NULL, errno);
+        else
+            content_store_result (ctx, cache_blobref, blobref, 0);
+    }
+done:
+    flux_future_destroy (f);
 }
 
-static int content_store_request_send (struct kvs_ctx *ctx, const char *blobref,
-                                       const void *data, int len)
+/* Send pending content stores as a store-batch request.
+ * On failure, waiters on the pending stores are notified of the error.
+ */
+static void content_store_flush (struct kvs_ctx *ctx)
 {
-    flux_future_t *f;
-    int saved_errno, rc = -1;
+    struct content_batch *blobs = ctx->store_blobs;
+    struct content_batch *refs = ctx->store_refs;
+    flux_future_t *f = NULL;
 
-    if (!(f = flux_content_store (ctx->h, data, len, 0)))
+    if (!blobs)
+        return;
+    ctx->store_blobs = NULL;
+    ctx->store_refs = NULL;
+    if (!(f = content_store_batch (ctx->h, blobs, 0))) {
+        flux_log_error (ctx->h, "%s: content_store_batch", __FUNCTION__);
         goto error;
-    if (flux_future_aux_set (f, "cache_blobref", (void *)blobref, NULL) < 0) {
-        saved_errno = errno;
-        flux_future_destroy (f);
-        errno = saved_errno;
+    }
+    content_batch_destroy (blobs);
+    blobs = NULL;
+    if (flux_future_aux_set (f, "refs", refs, content_batch_destructor) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_aux_set", __FUNCTION__);
         goto error;
     }
     if (flux_future_then (f, -1., content_store_completion, ctx) < 0) {
-        saved_errno = errno;
+        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        content_store_batch_error (ctx, refs, errno);
         flux_future_destroy (f);
-        errno = saved_errno;
-        goto error;
+        return;
     }
-
-    rc = 0;
+    return;
 error:
-    return rc;
+    content_store_batch_error (ctx, refs, errno);
+    content_batch_destroy (blobs);
+    content_batch_destroy (refs);
+    flux_future_destroy (f);
+}
+
+/* Queue content store request.  Pending stores are sent as one store-batch
+ * request from content_prep_cb(), or when the batch is full.
+ */
+static int content_store_request_send (struct kvs_ctx *ctx, const char *blobref,
+                                       const void *data, int len)
+{
+    if (content_batch_count (ctx->store_blobs) >= content_batch_max)
+        content_store_flush (ctx);
+    if (!ctx->store_blobs) {
+        if (!(ctx->store_blobs = content_batch_create ()))
+            return -1;
+        if (!(ctx->store_refs = content_batch_create ())) {
+            content_batch_destroy (ctx->store_blobs);
+            ctx->store_blobs = NULL;
+            return -1;
+        }
+    }
+    if (content_batch_append (ctx->store_blobs, data, len) < 0)
+        return -1;
+    if (content_batch_append_string (ctx->store_refs, blobref) < 0) {
+        /* store_blobs and store_refs are now out of step, so fail
+         * the stores that were already pending as well.
+         */
+        int saved_errno = errno;
+        content_store_batch_error (ctx, ctx->store_refs, saved_errno);
+        content_batch_destroy (ctx->store_blobs);
+        content_batch_destroy (ctx->store_refs);
+        ctx->store_blobs = ctx->store_refs = NULL;
+        errno = saved_errno;
+        return -1;
+    }
+    return 0;
 }
 
 static int kvstxn_load_cb (kvstxn_t *kt, const char *ref, void *data)
@@ -1046,6 +1246,24 @@ stall:
  * pre/check event callbacks
  */
 
+/* Send content loads and stores accumulated during this loop iteration,
+ * then enforce the cache size limit.  Eviction is done here rather than
+ * on cache insert since message handlers may hold unreferenced pointers
+ * to cache entry data while they run.
+ */
+static void content_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    content_load_flush (ctx);
+    content_store_flush (ctx);
+    if (cache_over_max_size (ctx->cache)) {
+        if (cache_evict_entries (ctx->cache) < 0)
+            flux_log_error (ctx->h, "%s: cache_evict_entries", __FUNCTION__);
+    }
+}
+
 static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                                  int revents, void *arg)
 {
@@ -1241,6 +1459,7 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
     if (!lh) {
         struct flux_msg_cred cred;
         int root_seq = -1;
+        int append_index = -1;
 
         if (flux_request_unpack (msg, NULL, "{ s:s s:i }",
                                  "key", &key,
@@ -1261,6 +1480,10 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
         (void)flux_request_unpack (msg, NULL, "{ s:i }",
                                    "rootseq", &root_seq);
 
+        /* append_index is optional */
+        (void)flux_request_unpack (msg, NULL, "{ s:i }",
+                                   "append_index", &append_index);
+
         /* either namespace or rootdir must be specified */
         if (!ns && !root_dirent) {
             errno = EPROTO;
@@ -1294,6 +1517,9 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
                                   flags,
                                   h)))
             goto done;
+        if (append_index >= 0
+            && lookup_set_append_index (lh, append_index) < 0)
+            goto done;
     }
     else {
         int err;
@@ -1410,6 +1636,9 @@ error:
  * kvs-watch module.  The kvs-watch module requires root information
  * on lookups (including ENOENT failed lookups) to determine what
  * lookups can be considered to be read-your-writes consistency safe.
+ * If the optional "append_index" is specified, only data from valref
+ * blobrefs at that index and above is returned, along with the total
+ * blobref count as "append_count".
  */
 static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                     const flux_msg_t *msg, void *arg)
@@ -1418,6 +1647,7 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
     json_t *val = NULL;
     const char *root_ref;
     int root_seq;
+    int append_count;
     bool stall = false;
 
     if (!(lh = lookup_common (h, mh, msg, arg, lookup_plus_request_cb,
@@ -1439,6 +1669,14 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                "rootref", root_ref) < 0)
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     }
+    else if ((append_count = lookup_get_append_count (lh)) >= 0) {
+        if (flux_respond_pack (h, msg, "{ s:O s:i s:s s:i }",
+                               "val", val,
+                               "rootseq", root_seq,
+                               "rootref", root_ref,
+                               "append_count", append_count) < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    }
     else {
         if (flux_respond_pack (h, msg, "{ s:O s:i s:s }",
                                "val", val,
@@ -2125,10 +2363,13 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
     double scale = 1E-3;
+    struct cache_counters cc;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
 
+    cache_get_counters (ctx->cache, &cc);
+
     /* if no roots are initialized, respond with all zeroes as stats */
     if (kvsroot_mgr_root_count (ctx->krm) > 0) {
         if (cache_get_stats (ctx->cache, &ts, &size, &incomplete, &dirty) < 0)
@@ -2143,12 +2384,17 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                               "max", tstat_max (&ts)*scale)))
         goto nomem;
 
-    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i }",
+    if (!(cstats = json_pack ("{ s:f s:f s:O s:i s:i s:i s:I s:I s:I }",
                               "obj size total (MiB)", (double)size/1048576,
+                              "obj size limit (MiB)",
+                              (double)cc.max_size/1048576,
                               "obj size (KiB)", tstats,
                               "#obj dirty", dirty,
                               "#obj incomplete", incomplete,
-                              "#faults", ctx->faults)))
+                              "#faults", ctx->faults,
+                              "#hits", (json_int_t)cc.hits,
+                              "#misses", (json_int_t)cc.misses,
+                              "#evictions", (json_int_t)cc.evictions)))
         goto nomem;
 
     if (!(nsstats = json_object ()))
@@ -2205,6 +2451,7 @@ static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 static void stats_clear (struct kvs_ctx *ctx)
 {
     ctx->faults = 0;
+    cache_clear_counters (ctx->cache);
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
@@ -2721,6 +2968,8 @@ static void process_args (struct kvs_ctx *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "cache-max-size=", 15) == 0)
+            cache_set_max_size (ctx->cache, strtoull (av[i]+15, NULL, 10));
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
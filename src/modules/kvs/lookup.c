@@ -70,15 +70,21 @@ struct lookup {
 
     int flags;
 
+    /* if append_index >= 0, only return data from valref blobrefs
+     * starting at append_index (see lookup_set_append_index()) */
+    int append_index;
+    int append_count;
+
     void *aux;
 
     /* potential return values from lookup */
     json_t *val;           /* value of lookup */
 
-    /* if valref_missing_refs is true, iterate on refs, else
-     * return missing_ref string.
+    /* if valref_missing_refs is true, iterate on refs starting at
+     * valref_missing_start, else return missing_ref string.
      */
     const json_t *valref_missing_refs;
+    int valref_missing_start;
     const char *missing_ref;
 
     /* for namespace callback */
@@ -569,6 +575,7 @@ lookup_t *lookup_create (struct cache *cache,
 
     lh->cred = cred;
     lh->flags = flags;
+    lh->append_index = -1;
 
     lh->val = NULL;
     lh->valref_missing_refs = NULL;
@@ -643,6 +650,27 @@ json_t *lookup_get_value (lookup_t *lh)
     return NULL;
 }
 
+int lookup_set_append_index (lookup_t *lh, int index)
+{
+    if (!lh || index < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    lh->append_index = index;
+    return 0;
+}
+
+int lookup_get_append_count (lookup_t *lh)
+{
+    if (lh
+        && lh->state == LOOKUP_STATE_FINISHED
+        && lh->errnum == 0
+        && lh->append_index >= 0)
+        return lh->append_count;
+    errno = EINVAL;
+    return -1;
+}
+
 int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
 {
     if (lh
@@ -660,7 +688,7 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
             refcount = treeobj_get_count (lh->valref_missing_refs);
             assert (refcount > 0);
 
-            for (i = 0; i < refcount; i++) {
+            for (i = lh->valref_missing_start; i < refcount; i++) {
                 struct cache_entry *entry;
                 const char *ref;
 
@@ -759,6 +787,7 @@ static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
     if (!(entry = cache_lookup (lh->cache, reftmp))
         || !cache_entry_get_valid (entry)) {
         lh->valref_missing_refs = lh->wdirent;
+        lh->valref_missing_start = 0;
         (*stall) = true;
         return 0;
     }
@@ -775,8 +804,9 @@ static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
     return 0;
 }
 
-static int get_multi_blobref_valref_length (lookup_t *lh, int refcount,
-                                            int *total_len, bool *stall)
+static int get_multi_blobref_valref_length (lookup_t *lh, int start,
+                                            int refcount, int *total_len,
+                                            bool *stall)
 {
     struct cache_entry *entry;
     const char *reftmp;
@@ -784,7 +814,7 @@ static int get_multi_blobref_valref_length (lookup_t *lh, int refcount,
     int len;
     int i;
 
-    for (i = 0; i < refcount; i++) {
+    for (i = start; i < refcount; i++) {
         if (!(reftmp = treeobj_get_blobref (lh->wdirent, i))) {
             lh->errnum = errno;
             return -1;
@@ -792,6 +822,7 @@ static int get_multi_blobref_valref_length (lookup_t *lh, int refcount,
         if (!(entry = cache_lookup (lh->cache, reftmp))
             || !cache_entry_get_valid (entry)) {
             lh->valref_missing_refs = lh->wdirent;
+            lh->valref_missing_start = start;
             (*stall) = true;
             return 0;
         }
@@ -815,8 +846,8 @@ static int get_multi_blobref_valref_length (lookup_t *lh, int refcount,
     return 0;
 }
 
-static char *get_multi_blobref_valref_data (lookup_t *lh, int refcount,
-                                            int total_len)
+static char *get_multi_blobref_valref_data (lookup_t *lh, int start,
+                                            int refcount, int total_len)
 {
     struct cache_entry *entry;
     const char *reftmp;
@@ -826,12 +857,12 @@ static char *get_multi_blobref_valref_data (lookup_t *lh, int refcount,
     int pos = 0;
     int i;
 
-    if (!(valbuf = malloc (total_len))) {
+    if (!(valbuf = malloc (total_len > 0 ? total_len : 1))) {
         lh->errnum = errno;
         return NULL;
     }
 
-    for (i = 0; i < refcount; i++) {
+    for (i = start; i < refcount; i++) {
         int ret;
 
         /* this function should only be called if all cache entries
@@ -857,14 +888,18 @@ static char *get_multi_blobref_valref_data (lookup_t *lh, int refcount,
 
 /* return 0 on success, -1 on failure.  On success, stall should be
  * check */
-static int get_multi_blobref_valref_value (lookup_t *lh, int refcount,
-                                           bool *stall)
+static int get_multi_blobref_valref_value (lookup_t *lh, int start,
+                                           int refcount, bool *stall)
 {
     char *valbuf = NULL;
     int total_len = 0;
     int rc = -1;
 
-    if (get_multi_blobref_valref_length (lh, refcount, &total_len, stall) < 0)
+    if (get_multi_blobref_valref_length (lh,
+                                         start,
+                                         refcount,
+                                         &total_len,
+                                         stall) < 0)
         goto done;
 
     if ((*stall) == true) {
@@ -872,7 +907,10 @@ static int get_multi_blobref_valref_value (lookup_t *lh, int refcount,
         goto done;
     }
 
-    if (!(valbuf = get_multi_blobref_valref_data (lh, refcount, total_len)))
+    if (!(valbuf = get_multi_blobref_valref_data (lh,
+                                                  start,
+                                                  refcount,
+                                                  total_len)))
         goto done;
 
     if (!(lh->val = treeobj_create_val (valbuf, total_len))) {
@@ -1103,7 +1141,20 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
-                if (refcount == 1) {
+                if (lh->append_index >= 0) {
+                    int start = lh->append_index;
+                    if (start > refcount)
+                        start = refcount;
+                    if (get_multi_blobref_valref_value (lh,
+                                                        start,
+                                                        refcount,
+                                                        &stall) < 0)
+                        goto error;
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                    lh->append_count = refcount;
+                }
+                else if (refcount == 1) {
                     if (get_single_blobref_valref_value (lh, &stall) < 0)
                         goto error;
                     if (stall)
@@ -1111,6 +1162,7 @@ lookup_process_t lookup (lookup_t *lh)
                 }
                 else {
                     if (get_multi_blobref_valref_value (lh,
+                                                        0,
                                                         refcount,
                                                         &stall) < 0)
                         goto error;
@@ -1143,6 +1195,9 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = errno;
                     goto error;
                 }
+                /* a val has no blobrefs, always return it in full */
+                if (lh->append_index >= 0)
+                    lh->append_count = 0;
             } else if (treeobj_is_symlink (lh->wdirent)) {
                 /* this should be "impossible" */
                 if (!(lh->flags & FLUX_KVS_READLINK)) {
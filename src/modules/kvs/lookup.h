@@ -67,6 +67,19 @@ int lookup_set_aux_errnum (lookup_t *lh, int errnum);
  * memory. */
 json_t *lookup_get_value (lookup_t *lh);
 
+/* For watchers of appended values: only return the data of valref
+ * blobrefs starting at 'index', i.e. the data appended since a prior
+ * lookup returned a blobref count of 'index'.  A val is always returned
+ * in full.  Must be called before lookup().
+ */
+int lookup_set_append_index (lookup_t *lh, int index);
+
+/* Get the blobref count of the value found by a lookup with an append
+ * index set, after lookup() returns LOOKUP_PROCESS_FINISHED.  The count
+ * is 0 if the value is a val.
+ */
+int lookup_get_append_count (lookup_t *lh);
+
 /* On lookup stall b/c of missing reference(s), get missing reference
  * that should be loaded into the KVS cache via callback function.
  *
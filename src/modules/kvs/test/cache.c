@@ -714,6 +714,97 @@ void cache_expiration_tests (void)
     cache_destroy (cache);
 }
 
+void cache_eviction_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e[4];
+    struct cache_counters cc;
+    char ref[16];
+    char data[100];
+    wait_t *w;
+    int count = 0;
+
+    memset (data, 'x', sizeof (data));
+    ok ((cache = cache_create (NULL)) != NULL,
+        "cache_create works");
+    ok (cache_over_max_size (cache) == false,
+        "cache_over_max_size returns false with no limit");
+
+    for (int i = 0; i < 4; i++) {
+        snprintf (ref, sizeof (ref), "evict%d", i);
+        if (!(e[i] = cache_entry_create (ref))
+            || cache_entry_set_raw (e[i], data, sizeof (data)) < 0
+            || cache_insert (cache, e[i]) < 0)
+            BAIL_OUT ("error creating cache entry");
+    }
+    cache_get_counters (cache, &cc);
+    ok (cc.size == 400,
+        "cache size is 400 bytes after inserting 4 100 byte entries");
+    ok (cache_evict_entries (cache) == 0,
+        "cache_evict_entries evicts nothing with no limit");
+
+    /* Pin entries: 0 dirty, 1 referenced, 2 waited on.
+     * Then make 1 the most recently used, leaving 3 as LRU after 0.
+     */
+    ok (cache_entry_set_dirty (e[0], true) == 0,
+        "cache_entry_set_dirty e0 works");
+    cache_entry_incref (e[1]);
+    ok ((w = wait_create (wait_cb, &count)) != NULL,
+        "wait_create works");
+    ok (cache_entry_wait_notdirty (e[2], w) == 0,
+        "cache_entry_wait_notdirty e2 works");
+    ok (cache_lookup (cache, "evict1") == e[1],
+        "cache_lookup evict1 works");
+
+    cache_set_max_size (cache, 150);
+    ok (cache_over_max_size (cache) == true,
+        "cache_over_max_size returns true with 150 byte limit");
+    ok (cache_evict_entries (cache) == 1,
+        "cache_evict_entries evicted 1 entry");
+    ok (cache_lookup (cache, "evict3") == NULL,
+        "unpinned entry was evicted");
+    ok (cache_count_entries (cache) == 3,
+        "pinned entries were not evicted");
+    ok (cache_over_max_size (cache) == true,
+        "cache is still over its limit");
+
+    cache_entry_decref (e[1]);
+    ok (cache_evict_entries (cache) == 1
+        && cache_lookup (cache, "evict1") == NULL,
+        "cache_evict_entries evicts entry after reference is dropped");
+
+    cache_get_counters (cache, &cc);
+    ok (cc.size == 200 && cc.max_size == 150,
+        "cache size is 200 bytes with 150 byte limit");
+    ok (cc.evictions == 2,
+        "evictions counter is 2");
+    ok (cc.hits == 1,
+        "hits counter is 1");
+    ok (cc.misses == 2,
+        "misses counter is 2");
+    ok (cache_peek (cache, "evict0") == e[0],
+        "cache_peek finds entry");
+    cache_get_counters (cache, &cc);
+    ok (cc.hits == 1 && cc.misses == 2,
+        "cache_peek does not update counters");
+
+    ok (cache_remove_entry (cache, "evict0") == 0,
+        "cache_remove_entry of dirty entry fails");
+    ok (cache_entry_set_dirty (e[2], true) == 0
+        && cache_entry_set_dirty (e[2], false) == 0
+        && count == 1,
+        "waiter on e2 was run");
+    ok (cache_entry_set_dirty (e[0], false) == 0,
+        "cache_entry_set_dirty e0 false works");
+    ok (cache_evict_entries (cache) == 1,
+        "cache_evict_entries evicts 1 entry once entries are unpinned");
+    cache_get_counters (cache, &cc);
+    ok (cc.size == 100,
+        "cache size is 100 bytes");
+
+    cache_destroy (cache);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -726,6 +817,7 @@ int main (int argc, char *argv[])
     cache_expiration_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
+    cache_eviction_tests ();
 
     done_testing ();
     return (0);
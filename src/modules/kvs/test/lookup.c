@@ -3321,6 +3321,222 @@ void lookup_stall_ref_expire_cache_entries (void) {
     json_decref (root);
 }
 
+/* lookup with append index, only data from later blobrefs returned */
+void lookup_append_index (void) {
+    json_t *root;
+    json_t *dirref;
+    json_t *valref_tmp;
+    json_t *test;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    char valref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref3_ref[BLOBREF_MAX_STRING_SIZE];
+    char dirref_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ltest_init (&cache, &krm);
+
+    /* This cache is
+     *
+     * valref1_ref
+     * "abcd"
+     *
+     * valref2_ref
+     * "efgh"
+     *
+     * valref3_ref
+     * "ijkl"
+     *
+     * dirref_ref
+     * "val" : val to "foo"
+     * "valref_multi" : valref to [ valref1_ref, valref2_ref, valref3_ref ]
+     *
+     * root_ref
+     * "dirref" : dirref to dirref_ref
+     *
+     * valref2_ref and valref3_ref are not inserted until later.
+     */
+
+    blobref_hash ("sha1", "abcd", 4, valref1_ref, sizeof (valref1_ref));
+    (void)cache_insert (cache, create_cache_entry_raw (valref1_ref, "abcd", 4));
+    blobref_hash ("sha1", "efgh", 4, valref2_ref, sizeof (valref2_ref));
+    blobref_hash ("sha1", "ijkl", 4, valref3_ref, sizeof (valref3_ref));
+
+    dirref = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref, "val", "foo", 3);
+    valref_tmp = treeobj_create_valref (valref1_ref);
+    treeobj_append_blobref (valref_tmp, valref2_ref);
+    treeobj_append_blobref (valref_tmp, valref3_ref);
+    treeobj_insert_entry (dirref, "valref_multi", valref_tmp);
+    json_decref (valref_tmp);
+
+    treeobj_hash ("sha1", dirref, dirref_ref, sizeof (dirref_ref));
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref_ref, dirref));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (root, "dirref", dirref_ref);
+
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.valref_multi",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on dirref.valref_multi");
+    ok (lookup_set_append_index (NULL, 0) < 0 && errno == EINVAL,
+        "lookup_set_append_index fails with EINVAL on NULL lookup");
+    ok (lookup_set_append_index (lh, -1) < 0 && errno == EINVAL,
+        "lookup_set_append_index fails with EINVAL on negative index");
+    ok (lookup_get_append_count (lh) < 0 && errno == EINVAL,
+        "lookup_get_append_count fails with EINVAL before lookup");
+    ok (lookup_set_append_index (lh, 1) == 0,
+        "lookup_set_append_index works");
+
+    /* only the missing refs at index 1 and above are requested */
+    check_stall (lh, EAGAIN, 2, NULL, "dirref.valref_multi append stall");
+
+    (void)cache_insert (cache, create_cache_entry_raw (valref2_ref, "efgh", 4));
+    (void)cache_insert (cache, create_cache_entry_raw (valref3_ref, "ijkl", 4));
+
+    test = treeobj_create_val ("efghijkl", 8);
+    check_common (lh,
+                  LOOKUP_PROCESS_FINISHED,
+                  0,
+                  false,
+                  test,
+                  1,
+                  NULL,
+                  "dirref.valref_multi append index 1",
+                  false);
+    ok (lookup_get_append_count (lh) == 3,
+        "lookup_get_append_count returns 3");
+    lookup_destroy (lh);
+    json_decref (test);
+
+    /* index equal to and beyond blobref count returns empty val */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.valref_multi",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on dirref.valref_multi");
+    ok (lookup_set_append_index (lh, 5) == 0,
+        "lookup_set_append_index works");
+    test = treeobj_create_val (NULL, 0);
+    check_common (lh,
+                  LOOKUP_PROCESS_FINISHED,
+                  0,
+                  false,
+                  test,
+                  1,
+                  NULL,
+                  "dirref.valref_multi append index 5",
+                  false);
+    ok (lookup_get_append_count (lh) == 3,
+        "lookup_get_append_count returns 3");
+    lookup_destroy (lh);
+    json_decref (test);
+
+    /* val is always returned in full, with a blobref count of 0 */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on dirref.val");
+    ok (lookup_set_append_index (lh, 0) == 0,
+        "lookup_set_append_index works");
+    test = treeobj_create_val ("foo", 3);
+    check_common (lh,
+                  LOOKUP_PROCESS_FINISHED,
+                  0,
+                  false,
+                  test,
+                  1,
+                  NULL,
+                  "dirref.val append index 0",
+                  false);
+    ok (lookup_get_append_count (lh) == 0,
+        "lookup_get_append_count returns 0");
+    lookup_destroy (lh);
+    json_decref (test);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on dirref.val");
+    ok (lookup_set_append_index (lh, 1) == 0,
+        "lookup_set_append_index works");
+    test = treeobj_create_val ("foo", 3);
+    check_common (lh,
+                  LOOKUP_PROCESS_FINISHED,
+                  0,
+                  false,
+                  test,
+                  1,
+                  NULL,
+                  "dirref.val append index 1",
+                  false);
+    ok (lookup_get_append_count (lh) == 0,
+        "lookup_get_append_count returns 0");
+    lookup_destroy (lh);
+    json_decref (test);
+
+    /* append count not available without append index */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.valref_multi",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on dirref.valref_multi");
+    test = treeobj_create_val ("abcdefghijkl", 12);
+    check_common (lh,
+                  LOOKUP_PROCESS_FINISHED,
+                  0,
+                  false,
+                  test,
+                  1,
+                  NULL,
+                  "dirref.valref_multi no append index",
+                  false);
+    ok (lookup_get_append_count (lh) < 0 && errno == EINVAL,
+        "lookup_get_append_count fails with EINVAL without append index");
+    lookup_destroy (lh);
+    json_decref (test);
+
+    ltest_finalize (cache, krm);
+    json_decref (dirref);
+    json_decref (root);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3343,6 +3559,7 @@ int main (int argc, char *argv[])
     lookup_stall_ref ();
     lookup_stall_namespace_removed ();
     lookup_stall_ref_expire_cache_entries ();
+    lookup_append_index ();
 
     done_testing ();
     return (0);
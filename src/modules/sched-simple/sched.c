@@ -18,6 +18,7 @@
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libjob/job.h"
+#include "src/common/libjob/job_hash.h"
 #include "src/common/librlist/rlist.h"
 #include "libjj.h"
 
@@ -39,6 +40,15 @@ struct jobreq {
     int errnum;
 };
 
+/* Resources allocated to a job, kept until the job's resources are
+ * freed so the free path need not parse R or regenerate the summary.
+ */
+struct jobrsrc {
+    flux_jobid_t id;
+    struct rlist *rl;
+    char *summary;
+};
+
 struct simple_sched {
     flux_t *h;
     flux_future_t *acquire_f; /* resource.acquire future */
@@ -49,6 +59,7 @@ struct simple_sched {
     int schedutil_flags;
     struct rlist *rlist;    /* list of resources */
     zlistx_t *queue;        /* job queue */
+    zhashx_t *allocs;       /* jobid => struct jobrsrc */
     schedutil_t *util_ctx;
 
     flux_watcher_t *prep;
@@ -56,6 +67,44 @@ struct simple_sched {
     flux_watcher_t *idle;
 };
 
+static void jobrsrc_destroy (struct jobrsrc *jr)
+{
+    if (jr) {
+        int saved_errno = errno;
+        rlist_destroy (jr->rl);
+        free (jr->summary);
+        free (jr);
+        errno = saved_errno;
+    }
+}
+
+static void jobrsrc_destructor (void **item)
+{
+    if (item) {
+        jobrsrc_destroy (*item);
+        *item = NULL;
+    }
+}
+
+/* Keep allocation 'rl' and its summary string 's' for job 'id'.
+ * On success, ownership of 'rl' and 's' passes to ss->allocs.
+ */
+static int jobrsrc_save (struct simple_sched *ss,
+                         flux_jobid_t id,
+                         struct rlist *rl,
+                         char *s)
+{
+    struct jobrsrc *jr;
+
+    if (!(jr = calloc (1, sizeof (*jr))))
+        return -1;
+    jr->id = id;
+    jr->rl = rl;
+    jr->summary = s;
+    zhashx_update (ss->allocs, &jr->id, jr);
+    return 0;
+}
+
 static void jobreq_destroy (struct jobreq *job)
 {
     if (job) {
@@ -130,6 +179,7 @@ static void simple_sched_destroy (flux_t *h, struct simple_sched *ss)
     }
     flux_future_destroy (ss->acquire_f);
     zlistx_destroy (&ss->queue);
+    zhashx_destroy (&ss->allocs);
     flux_watcher_destroy (ss->prep);
     flux_watcher_destroy (ss->check);
     flux_watcher_destroy (ss->idle);
@@ -150,6 +200,7 @@ static struct simple_sched * simple_sched_create (void)
      * concurrency being excessively large.
      */
     ss->alloc_limit = 8;
+    ss->schedutil_flags = SCHEDUTIL_BATCH;
     return ss;
 }
 
@@ -168,9 +219,13 @@ static char *Rstring_create (struct rlist *l, double now, double timelimit)
     return s;
 }
 
+/* Try to allocate resources to the job at the head of the queue.
+ * Returns 0 if the job was allocated resources or denied, and removed
+ * from the queue.  Returns -1 with errno set to ENOSPC if resources are
+ * not currently available, or to ENOENT if the queue is empty.
+ */
 static int try_alloc (flux_t *h, struct simple_sched *ss)
 {
-    int rc = -1;
     char *s = NULL;
     struct rlist *alloc = NULL;
     struct jj_counts *jj = NULL;
@@ -179,12 +234,14 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
     double now = flux_reactor_now (flux_get_reactor (h));
     bool fail_alloc = flux_module_debug_test (h, DEBUG_FAIL_ALLOC, false);
 
-    if (!job)
+    if (!job) {
+        errno = ENOENT;
         return -1;
+    }
 
     jj = &job->jj;
+    errno = 0;
     if (!fail_alloc) {
-        errno = 0;
         alloc = rlist_alloc (ss->rlist, ss->alloc_mode,
                              jj->nnodes, jj->nslots, jj->slot_size);
     }
@@ -199,7 +256,7 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
             rlist_destroy (alloc);
             alloc = NULL;
         } else if (errno == ENOSPC)
-            return rc;
+            return -1;
         else if (errno == EOVERFLOW)
             note = "unsatisfiable request";
         else if (fail_alloc)
@@ -223,14 +280,38 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
         flux_log_error (h, "schedutil_alloc_respond_success_pack");
 
     flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
-    rc = 0;
 
+    if (jobrsrc_save (ss, job->id, alloc, s) < 0)
+        flux_log_error (h, "alloc: %ju: error saving allocation",
+                        (uintmax_t) job->id);
+    else {
+        alloc = NULL;
+        s = NULL;
+    }
 out:
     zlistx_delete (ss->queue, job->handle);
     rlist_destroy (alloc);
     free (R);
     free (s);
-    return rc;
+    return 0;
+}
+
+/* Allocate resources to as many jobs from the head of the queue as
+ * possible in one pass.  The pass stops at the first job that cannot
+ * be allocated resources, so jobs are still allocated in queue order.
+ * Returns the number of jobs removed from the queue.  If the pass was
+ * stopped by a job that doesn't fit, set *blocked to true.
+ */
+static int try_alloc_queue (flux_t *h, struct simple_sched *ss, bool *blocked)
+{
+    int count = 0;
+
+    *blocked = false;
+    while (try_alloc (h, ss) == 0)
+        count++;
+    if (errno == ENOSPC)
+        *blocked = true;
+    return count;
 }
 
 static void annotate_reason_pending (struct simple_sched *ss)
@@ -271,29 +352,52 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
                       int revents, void *arg)
 {
     struct simple_sched *ss = arg;
+    bool blocked;
+    int count;
+
     flux_watcher_stop (ss->idle);
 
-    /* See if we can fulfill alloc for a pending job
-     * If current head of queue can't be allocated, stop the prep
-     *  watcher, i.e. block. O/w, retry on next loop.
+    /* Fulfill alloc for as many pending jobs as possible.
+     * If the head of queue can't be allocated, stop the prep
+     *  watcher, i.e. block until resources are freed.
      */
-    if (try_alloc (ss->h, ss) < 0 && errno == ENOSPC) {
+    count = try_alloc_queue (ss->h, ss, &blocked);
+    if (count > 1)
+        flux_log (ss->h, LOG_DEBUG, "alloc: %d jobs in one pass", count);
+    if (blocked) {
         annotate_reason_pending (ss);
         flux_watcher_stop (ss->prep);
         flux_watcher_stop (ss->check);
     }
 }
 
-static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
+/* Free the resources of job 'id'.  The allocation saved by try_alloc()
+ * or hello_cb() is used if available, otherwise it is parsed from 'R'.
+ */
+static int try_free (flux_t *h,
+                     struct simple_sched *ss,
+                     flux_jobid_t id,
+                     const char *R)
 {
     int rc = -1;
     char *r = NULL;
-    struct rlist *alloc = rlist_from_R (R);
-    if (!alloc) {
-        flux_log_error (h, "free: unable to parse R=%s", R);
-        return -1;
+    struct rlist *alloc = NULL;
+    struct jobrsrc *jr;
+
+    if ((jr = zhashx_lookup (ss->allocs, &id))) {
+        alloc = jr->rl;
+        r = jr->summary;
+        jr->rl = NULL;
+        jr->summary = NULL;
+        zhashx_delete (ss->allocs, &id);
+    }
+    else {
+        if (!(alloc = rlist_from_R (R))) {
+            flux_log_error (h, "free: unable to parse R=%s", R);
+            return -1;
+        }
+        r = rlist_dumps (alloc);
     }
-    r = rlist_dumps (alloc);
     if ((rc = rlist_free (ss->rlist, alloc)) < 0)
         flux_log_error (h, "free: %s", r);
     else
@@ -306,6 +410,7 @@ static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
 void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
 {
     struct simple_sched *ss = arg;
+    flux_jobid_t id;
 
     if (!R) {
         flux_log (h, LOG_ERR, "free: R is NULL");
@@ -314,7 +419,8 @@ void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
         return;
     }
 
-    if (try_free (h, ss, R) < 0) {
+    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0
+        || try_free (h, ss, id, R) < 0) {
         if (flux_respond_error (h, msg, errno, NULL) < 0)
             flux_log_error (h, "free_cb: flux_respond_error");
         return;
@@ -485,8 +591,11 @@ static int hello_cb (flux_t *h,
     s = rlist_dumps (alloc);
     if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0)
         flux_log_error (h, "hello: rlist_remove (%s)", s);
-    else
+    else {
         flux_log (h, LOG_DEBUG, "hello: alloc %s", s);
+        if (jobrsrc_save (ss, id, alloc, s) == 0)
+            return 0;
+    }
     free (s);
     rlist_destroy (alloc);
     return 0;
@@ -647,8 +756,9 @@ static void acquire_continuation (flux_future_t *f, void *arg)
         flux_reactor_stop (flux_get_reactor (ss->h));
         return;
     }
+    /* Resources may have come up, see if pending jobs can be allocated */
     if (ss_resource_update (ss, f) == 0)
-        try_alloc (ss->h, ss);
+        flux_watcher_start (ss->prep);
 }
 
 /*  Synchronously acquire resources from resource module.
@@ -791,6 +901,9 @@ static int process_args (flux_t *h, struct simple_sched *ss,
         else if (strcmp ("test-free-nolookup", argv[i]) == 0) {
             ss->schedutil_flags |= SCHEDUTIL_FREE_NOLOOKUP;
         }
+        else if (strcmp ("test-no-batch", argv[i]) == 0) {
+            ss->schedutil_flags &= ~SCHEDUTIL_BATCH;
+        }
         else {
             flux_log_error (h, "Unknown module option: '%s'", argv[i]);
             return -1;
@@ -839,6 +952,9 @@ int mod_main (flux_t *h, int argc, char **argv)
         goto done;
     zlistx_set_comparator (ss->queue, jobreq_cmp);
     zlistx_set_destructor (ss->queue, jobreq_destructor);
+    if (!(ss->allocs = job_hash_create ()))
+        goto done;
+    zhashx_set_destructor (ss->allocs, jobrsrc_destructor);
 
     /* Let `flux module load simple-sched` return before synchronous
      * initialization with resource and job-manager modules.
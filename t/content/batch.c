@@ -0,0 +1,164 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* batch - exercise content load-batch and store-batch methods
+ *
+ * Usage: batch [--bypass-cache] store FILE...
+ *        batch [--bypass-cache] load BLOBREF...
+ *
+ * store sends the contents of each FILE in one store-batch request and
+ * prints the returned blobrefs, one per line.  load sends the BLOBREFs in
+ * one load-batch request and writes the returned blobs to stdout.
+ * A failed item is reported on stderr and causes a nonzero exit code.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/read_all.h"
+#include "src/common/libcontent/content-batch.h"
+
+static struct optparse_option opts[] = {
+    { .name = "bypass-cache", .key = 'b', .has_arg = 0,
+      .usage = "Send request directly to the backing store",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static struct content_batch *batch_from_files (int argc, char **argv)
+{
+    struct content_batch *b;
+
+    if (!(b = content_batch_create ()))
+        log_err_exit ("content_batch_create");
+    for (int i = 0; i < argc; i++) {
+        void *data;
+        ssize_t size;
+        int fd;
+
+        if ((fd = open (argv[i], O_RDONLY)) < 0)
+            log_err_exit ("%s", argv[i]);
+        if ((size = read_all (fd, &data)) < 0)
+            log_err_exit ("%s", argv[i]);
+        if (content_batch_append (b, data, size) < 0)
+            log_err_exit ("content_batch_append");
+        free (data);
+        close (fd);
+    }
+    return b;
+}
+
+static struct content_batch *batch_from_strings (int argc, char **argv)
+{
+    struct content_batch *b;
+
+    if (!(b = content_batch_create ()))
+        log_err_exit ("content_batch_create");
+    for (int i = 0; i < argc; i++) {
+        if (content_batch_append_string (b, argv[i]) < 0)
+            log_err_exit ("content_batch_append_string");
+    }
+    return b;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int optindex;
+    int flags = 0;
+    const char *cmd;
+    flux_t *h;
+    flux_future_t *f;
+    struct content_batch *req;
+    const struct content_batch *rep;
+    int count;
+    int errors = 0;
+
+    log_init ("batch");
+
+    if (!(p = optparse_create ("batch"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS
+        || optparse_set (p,
+                         OPTPARSE_USAGE,
+                         "[--bypass-cache] store FILE... | load BLOBREF...")
+            != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if ((optindex = optparse_parse_args (p, argc, argv)) < 0)
+        exit (1);
+    if (optindex == argc) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (optparse_hasopt (p, "bypass-cache"))
+        flags |= CONTENT_FLAG_CACHE_BYPASS;
+    cmd = argv[optindex++];
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    if (!strcmp (cmd, "store")) {
+        req = batch_from_files (argc - optindex, argv + optindex);
+        if (!(f = content_store_batch (h, req, flags)))
+            log_err_exit ("content_store_batch");
+    }
+    else if (!strcmp (cmd, "load")) {
+        req = batch_from_strings (argc - optindex, argv + optindex);
+        if (!(f = content_load_batch (h, req, flags)))
+            log_err_exit ("content_load_batch");
+    }
+    else
+        log_msg_exit ("unknown command: %s", cmd);
+
+    if (content_batch_rpc_get (f, &rep) < 0)
+        log_err_exit ("%s", cmd);
+    count = content_batch_count (rep);
+    if (count != content_batch_count (req))
+        log_msg_exit ("expected %d items, got %d",
+                      content_batch_count (req),
+                      count);
+    for (int i = 0; i < count; i++) {
+        const void *data;
+        int len;
+
+        if (content_batch_get (rep, i, &data, &len) < 0) {
+            log_err ("%s", argv[optindex + i]);
+            errors++;
+            continue;
+        }
+        if (!strcmp (cmd, "store")) {
+            const char *blobref;
+            if (content_batch_get_string (rep, i, &blobref) < 0)
+                log_err_exit ("%s", argv[optindex + i]);
+            printf ("%s\n", blobref);
+        }
+        else if (len > 0 && fwrite (data, len, 1, stdout) != 1)
+            log_err_exit ("write");
+    }
+
+    flux_future_destroy (f);
+    content_batch_destroy (req);
+    flux_close (h);
+    optparse_destroy (p);
+    log_fini ();
+    return errors > 0 ? 1 : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
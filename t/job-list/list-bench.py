@@ -0,0 +1,63 @@
+###############################################################
+# Copyright 2024 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+
+# Usage: flux python list-bench.py [OPTIONS]
+#
+#  Send job-list.list requests one at a time and report the number of
+#  jobs returned and the request latency
+#
+
+import argparse
+import sys
+import time
+
+import flux
+from flux.constants import FLUX_USERID_UNKNOWN
+
+parser = argparse.ArgumentParser(description="benchmark job-list.list")
+parser.add_argument("-n", "--count", type=int, default=100, help="requests")
+parser.add_argument("-u", "--userid", type=int, default=FLUX_USERID_UNKNOWN)
+parser.add_argument("-s", "--states", type=int, default=0, help="states mask")
+parser.add_argument("-r", "--results", type=int, default=0, help="results mask")
+parser.add_argument("-m", "--max-entries", type=int, default=0)
+parser.add_argument("-a", "--attrs", default="", help="comma separated attrs")
+args = parser.parse_args()
+
+h = flux.Flux()
+payload = {
+    "max_entries": args.max_entries,
+    "attrs": [x for x in args.attrs.split(",") if x],
+    "userid": args.userid,
+    "states": args.states,
+    "results": args.results,
+}
+
+times = []
+njobs = 0
+for i in range(args.count):
+    t0 = time.perf_counter()
+    njobs = len(h.rpc("job-list.list", payload).get()["jobs"])
+    times.append(time.perf_counter() - t0)
+
+times.sort()
+fmt = "list-bench: {} jobs, {} requests: mean {:.3f}ms p50 {:.3f}ms p99 {:.3f}ms"
+print(
+    fmt.format(
+        njobs,
+        args.count,
+        1000 * sum(times) / len(times),
+        1000 * times[len(times) // 2],
+        1000 * times[min(len(times) - 1, (99 * len(times)) // 100)],
+    ),
+    file=sys.stderr,
+)
+print(njobs)
+
+# vim: tabstop=4 shiftwidth=4 expandtab
@@ -0,0 +1,218 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* watch_append.c - time a FLUX_KVS_WATCH_APPEND watcher on a key
+ * that is appended to many times
+ *
+ * Appends are committed with up to --window commits in flight.  The
+ * test completes when the watcher has received every appended byte.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <getopt.h>
+#include <string.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/xzmalloc.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/log.h"
+
+#define OPTIONS "hqc:s:w:k:"
+static const struct option longopts[] = {
+    {"help",            no_argument,        0, 'h'},
+    {"quiet",           no_argument,        0, 'q'},
+    {"count",           required_argument,  0, 'c'},
+    {"size",            required_argument,  0, 's'},
+    {"window",          required_argument,  0, 'w'},
+    {"key",             required_argument,  0, 'k'},
+    { 0, 0, 0, 0 },
+};
+
+struct bench {
+    flux_t *h;
+    const char *key;
+    char *data;
+    int size;
+    int count;
+    int window;
+    int sent;
+    int committed;
+    int inflight;
+    long long expected;
+    long long received;
+    int responses;
+};
+
+static void send_appends (struct bench *b);
+
+void usage (void)
+{
+    fprintf (stderr,
+"Usage: watch_append [--quiet] [--key NAME] [--count N] [--size BYTES]\n"
+"                    [--window N]\n"
+);
+    exit (1);
+}
+
+static void commit_continuation (flux_future_t *f, void *arg)
+{
+    struct bench *b = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_future_destroy (f);
+    b->inflight--;
+    b->committed++;
+    send_appends (b);
+}
+
+static void send_appends (struct bench *b)
+{
+    while (b->sent < b->count && b->inflight < b->window) {
+        flux_kvs_txn_t *txn;
+        flux_future_t *f;
+
+        if (!(txn = flux_kvs_txn_create ()))
+            log_err_exit ("flux_kvs_txn_create");
+        if (flux_kvs_txn_put_raw (txn,
+                                  FLUX_KVS_APPEND,
+                                  b->key,
+                                  b->data,
+                                  b->size) < 0)
+            log_err_exit ("flux_kvs_txn_put_raw");
+        if (!(f = flux_kvs_commit (b->h, NULL, 0, txn))
+            || flux_future_then (f, -1., commit_continuation, b) < 0)
+            log_err_exit ("flux_kvs_commit");
+        flux_kvs_txn_destroy (txn);
+        b->inflight++;
+        b->sent++;
+    }
+}
+
+static void watch_continuation (flux_future_t *f, void *arg)
+{
+    struct bench *b = arg;
+    const void *data;
+    int len;
+
+    if (flux_kvs_lookup_get_raw (f, &data, &len) < 0)
+        log_err_exit ("flux_kvs_lookup_get_raw");
+    b->received += len;
+    b->responses++;
+    if (b->received > b->expected)
+        log_msg_exit ("received %lld bytes, expected %lld",
+                      b->received,
+                      b->expected);
+    if (b->received == b->expected) {
+        if (flux_kvs_lookup_cancel (f) < 0)
+            log_err_exit ("flux_kvs_lookup_cancel");
+        flux_reactor_stop (flux_get_reactor (b->h));
+    }
+    flux_future_reset (f);
+}
+
+int main (int argc, char *argv[])
+{
+    struct bench b = { .key = "watch_append", .count = 100000,
+                       .size = 8, .window = 64 };
+    flux_future_t *f;
+    flux_kvs_txn_t *txn;
+    bool quiet = false;
+    struct timespec t0;
+    double elapsed;
+    int ch;
+
+    log_init ("watch_append");
+
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'h': /* --help */
+                usage ();
+                break;
+            case 'q': /* --quiet */
+                quiet = true;
+                break;
+            case 'c': /* --count N */
+                b.count = strtoul (optarg, NULL, 10);
+                break;
+            case 's': /* --size BYTES */
+                b.size = strtoul (optarg, NULL, 10);
+                break;
+            case 'w': /* --window N */
+                b.window = strtoul (optarg, NULL, 10);
+                break;
+            case 'k': /* --key NAME */
+                b.key = optarg;
+                break;
+            default:
+                usage ();
+                break;
+        }
+    }
+    if (optind != argc)
+        usage ();
+    if (b.count < 1 || b.size < 1 || b.window < 1)
+        usage ();
+
+    if (!(b.h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    /* Start from an empty key so that the initial response is empty.
+     */
+    if (!(txn = flux_kvs_txn_create ()))
+        log_err_exit ("flux_kvs_txn_create");
+    if (flux_kvs_txn_put_raw (txn, 0, b.key, NULL, 0) < 0)
+        log_err_exit ("flux_kvs_txn_put_raw");
+    if (!(f = flux_kvs_commit (b.h, NULL, 0, txn))
+        || flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_future_destroy (f);
+    flux_kvs_txn_destroy (txn);
+
+    b.data = xzmalloc (b.size);
+    memset (b.data, 'x', b.size);
+    b.expected = (long long)b.count * b.size;
+
+    monotime (&t0);
+    if (!(f = flux_kvs_lookup (b.h,
+                               NULL,
+                               FLUX_KVS_WATCH | FLUX_KVS_WATCH_APPEND,
+                               b.key))
+        || flux_future_then (f, -1., watch_continuation, &b) < 0)
+        log_err_exit ("flux_kvs_lookup");
+    send_appends (&b);
+    if (flux_reactor_run (flux_get_reactor (b.h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    elapsed = monotime_since (t0) / 1000;
+
+    if (b.received != b.expected)
+        log_msg_exit ("received %lld bytes, expected %lld",
+                      b.received,
+                      b.expected);
+    if (!quiet) {
+        log_msg ("watch_append: time=%0.3f s (%d appends of size %d)",
+                 elapsed, b.count, b.size);
+        log_msg ("watch_append: %.0f appends/s, %d responses",
+                 elapsed > 0 ? b.count / elapsed : 0.,
+                 b.responses);
+    }
+
+    flux_future_destroy (f);
+    free (b.data);
+    flux_close (b.h);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
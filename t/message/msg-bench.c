@@ -0,0 +1,139 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* msg-bench - time basic flux_msg_t operations
+ *
+ * Build a request with a --size byte payload and --hops routes, then
+ * time --count iterations each of encode, decode, copy, and a route
+ * push/pop pair, as a message crossing a broker would undergo.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of iterations of each operation (default 1000000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Payload size (default 1024)",
+    },
+    { .name = "hops", .key = 'H', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of routes on the message (default 3)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void report (const char *name, int count, double ms)
+{
+    printf ("%s: %d in %.3fs (%.1f ns/op)\n",
+            name,
+            count,
+            ms / 1000.,
+            ms * 1E6 / count);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    flux_msg_t *msg;
+    char *payload;
+    void *buf;
+    size_t bufsize;
+    int count, size, hops;
+    struct timespec t0;
+
+    log_init ("msg-bench");
+
+    if (!(p = optparse_create ("msg-bench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_create");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    count = optparse_get_int (p, "count", 1000000);
+    size = optparse_get_int (p, "size", 1024);
+    hops = optparse_get_int (p, "hops", 3);
+    if (count <= 0 || size < 0 || hops < 0)
+        log_msg_exit ("invalid argument");
+
+    if (!(payload = malloc (size + 1)))
+        log_err_exit ("malloc");
+    memset (payload, 'x', size);
+    if (!(msg = flux_request_encode_raw ("bench.msg", payload, size))
+        || flux_msg_enable_route (msg) < 0)
+        log_err_exit ("error encoding test message");
+    for (int i = 0; i < hops; i++) {
+        char id[64];
+        snprintf (id, sizeof (id), "%08x-bench-hop-%d", i, i);
+        if (flux_msg_push_route (msg, id) < 0)
+            log_err_exit ("flux_msg_push_route");
+    }
+    bufsize = flux_msg_encode_size (msg);
+    if (!(buf = malloc (bufsize)))
+        log_err_exit ("malloc");
+
+    printf ("size=%d hops=%d encoded=%zu\n", size, hops, bufsize);
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        if (flux_msg_encode_size (msg) != bufsize
+            || flux_msg_encode (msg, buf, bufsize) < 0)
+            log_err_exit ("flux_msg_encode");
+    }
+    report ("encode", count, monotime_since (t0));
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        flux_msg_t *cpy;
+        if (!(cpy = flux_msg_decode (buf, bufsize)))
+            log_err_exit ("flux_msg_decode");
+        flux_msg_destroy (cpy);
+    }
+    report ("decode", count, monotime_since (t0));
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        flux_msg_t *cpy;
+        if (!(cpy = flux_msg_copy (msg, true)))
+            log_err_exit ("flux_msg_copy");
+        flux_msg_destroy (cpy);
+    }
+    report ("copy", count, monotime_since (t0));
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        char *id;
+        if (flux_msg_push_route (msg, "bench-route") < 0
+            || flux_msg_pop_route (msg, &id) < 0)
+            log_err_exit ("flux_msg_push_route/pop_route");
+        free (id);
+    }
+    report ("route push/pop", count, monotime_since (t0));
+
+    free (buf);
+    free (payload);
+    flux_msg_destroy (msg);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,303 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* overlay-bench - time message throughput on the broker overlay
+ *
+ * Create a rank 0 overlay bound to tcp://127.0.0.1 and --children
+ * overlays connected directly to it, all in one process on one reactor.
+ * Then time --count requests routed downstream from rank 0 to the
+ * children, responses routed upstream from the children to rank 0, and
+ * events multicast from rank 0 to all children.  At most --window
+ * messages are in flight at once so that zeromq high water marks are
+ * not reached.  Use --batch-size to enable overlay message batching.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <czmq.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libtestutil/util.h"
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/stdlog.h"
+
+#include "src/broker/overlay.h"
+#include "src/broker/attr.h"
+
+struct bench {
+    flux_t *h;
+    struct overlay **ov;
+    attr_t **attrs;
+    int size;
+    int received;
+    int expected;
+};
+
+static struct optparse_option opts[] = {
+    { .name = "children", .key = 'N', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of children of rank 0 (default 4)",
+    },
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of messages of each type (default 100000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Payload size (default 1024)",
+    },
+    { .name = "window", .key = 'w', .has_arg = 1, .arginfo = "N",
+      .usage = "Maximum messages in flight (default 100)",
+    },
+    { .name = "batch-size", .key = 'b', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Set tbon.batch-size on all overlays (default 0)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void report (const char *name, int count, double ms)
+{
+    printf ("%s: %d in %.3fs (%.0f msgs/s)\n",
+            name,
+            count,
+            ms / 1000.,
+            count * 1000. / ms);
+}
+
+static void log_cb (const char *buf, int len, void *arg)
+{
+    struct stdlog_header hdr;
+    const char *msg;
+    int msglen;
+
+    if (stdlog_decode (buf, len, &hdr, NULL, NULL, &msg, &msglen) == 0)
+        fprintf (stderr, "overlay-bench: %.*s\n", msglen, msg);
+}
+
+static void recv_cb (const flux_msg_t *msg, overlay_where_t from, void *arg)
+{
+    struct bench *b = arg;
+
+    if (++b->received == b->expected)
+        flux_reactor_stop (flux_get_reactor (b->h));
+}
+
+static void monitor_cb (struct overlay *ov, void *arg)
+{
+    struct bench *b = arg;
+
+    if (overlay_get_child_peer_count (ov) == b->size - 1)
+        flux_reactor_stop (flux_get_reactor (b->h));
+}
+
+/* Run the reactor until 'count' more messages have been received.
+ */
+static void wait_received (struct bench *b, int count)
+{
+    b->expected = b->received + count;
+    if (b->received < b->expected) {
+        if (flux_reactor_run (flux_get_reactor (b->h), 0) < 0)
+            log_err_exit ("flux_reactor_run");
+    }
+}
+
+static void bench_create (struct bench *b,
+                          flux_t *h,
+                          int size,
+                          const char *batch_size)
+{
+    const char *uri = NULL;
+
+    b->h = h;
+    b->size = size;
+    if (!(b->ov = calloc (size, sizeof (b->ov[0])))
+        || !(b->attrs = calloc (size, sizeof (b->attrs[0]))))
+        log_err_exit ("calloc");
+    for (int rank = 0; rank < size; rank++) {
+        char name[32];
+
+        snprintf (name, sizeof (name), "bench-%d", rank);
+        if (!(b->ov[rank] = overlay_create (h, recv_cb, b))
+            || overlay_set_geometry (b->ov[rank], size, rank, size - 1) < 0
+            || !(b->attrs[rank] = attr_create ())
+            || overlay_register_attrs (b->ov[rank], b->attrs[rank]) < 0
+            || attr_set (b->attrs[rank],
+                         "tbon.batch-size",
+                         batch_size,
+                         false) < 0)
+            log_err_exit ("%s: error creating overlay", name);
+        if (rank == 0) {
+            if (overlay_bind (b->ov[0], "tcp://127.0.0.1:*") < 0
+                || !(uri = overlay_get_bind_uri (b->ov[0])))
+                log_err_exit ("%s: overlay_bind", name);
+            overlay_set_monitor_cb (b->ov[0], monitor_cb, b);
+        }
+        else {
+            if (overlay_authorize (b->ov[0],
+                                   name,
+                                   overlay_cert_pubkey (b->ov[rank])) < 0
+                || overlay_set_parent_pubkey (b->ov[rank],
+                                   overlay_cert_pubkey (b->ov[0])) < 0
+                || overlay_set_parent_uri (b->ov[rank], uri) < 0
+                || overlay_connect (b->ov[rank]) < 0)
+                log_err_exit ("%s: error connecting overlay", name);
+        }
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    overlay_set_monitor_cb (b->ov[0], NULL, NULL);
+}
+
+static void bench_destroy (struct bench *b)
+{
+    for (int rank = b->size - 1; rank >= 0; rank--) {
+        attr_destroy (b->attrs[rank]);
+        overlay_destroy (b->ov[rank]);
+    }
+    free (b->attrs);
+    free (b->ov);
+}
+
+static void bench_requests (struct bench *b, const char *payload, int size,
+                            int count, int window)
+{
+    flux_msg_t *msg;
+    struct timespec t0;
+    int n = 0;
+
+    if (!(msg = flux_request_encode_raw ("bench.request", payload, size)))
+        log_err_exit ("flux_request_encode_raw");
+    monotime (&t0);
+    while (n < count) {
+        int batch = count - n < window ? count - n : window;
+        for (int i = 0; i < batch; i++, n++) {
+            if (flux_msg_set_nodeid (msg, 1 + n % (b->size - 1)) < 0
+                || overlay_sendmsg (b->ov[0], msg, OVERLAY_ANY) < 0)
+                log_err_exit ("error sending request");
+        }
+        wait_received (b, batch);
+    }
+    report ("request downstream", count, monotime_since (t0));
+    flux_msg_decref (msg);
+}
+
+static void bench_responses (struct bench *b, const char *payload, int size,
+                             int count, int window)
+{
+    flux_msg_t *msg;
+    struct timespec t0;
+    int n = 0;
+
+    if (!(msg = flux_response_encode_raw ("bench.response", payload, size))
+        || flux_msg_push_route (msg, overlay_get_uuid (b->ov[0])) < 0)
+        log_err_exit ("flux_response_encode_raw");
+    monotime (&t0);
+    while (n < count) {
+        int batch = count - n < window ? count - n : window;
+        for (int i = 0; i < batch; i++, n++) {
+            if (overlay_sendmsg (b->ov[1 + n % (b->size - 1)],
+                                 msg,
+                                 OVERLAY_ANY) < 0)
+                log_err_exit ("error sending response");
+        }
+        wait_received (b, batch);
+    }
+    report ("response upstream", count, monotime_since (t0));
+    flux_msg_decref (msg);
+}
+
+static void bench_events (struct bench *b, const char *payload, int size,
+                          int count, int window)
+{
+    flux_msg_t *msg;
+    struct timespec t0;
+    int n = 0;
+
+    if (window < b->size - 1)
+        window = b->size - 1;
+    if (!(msg = flux_event_encode_raw ("bench.event", payload, size)))
+        log_err_exit ("flux_event_encode_raw");
+    monotime (&t0);
+    while (n < count) {
+        int batch = (count - n) * (b->size - 1) < window
+                    ? count - n : window / (b->size - 1);
+        for (int i = 0; i < batch; i++, n++) {
+            if (overlay_sendmsg (b->ov[0], msg, OVERLAY_DOWNSTREAM) < 0)
+                log_err_exit ("error sending event");
+        }
+        wait_received (b, batch * (b->size - 1));
+    }
+    report ("event multicast", count * (b->size - 1), monotime_since (t0));
+    flux_msg_decref (msg);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    flux_t *h;
+    struct bench b = { 0 };
+    char *payload;
+    int children, count, size, window;
+    const char *batch_size;
+
+    log_init ("overlay-bench");
+
+    if (!(p = optparse_create ("overlay-bench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_create");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    children = optparse_get_int (p, "children", 4);
+    count = optparse_get_int (p, "count", 100000);
+    size = optparse_get_int (p, "size", 1024);
+    window = optparse_get_int (p, "window", 100);
+    batch_size = optparse_get_str (p, "batch-size", "0");
+    if (children <= 0 || count <= 0 || size < 0 || window <= 0)
+        log_msg_exit ("invalid argument");
+
+    if (!(payload = malloc (size + 1)))
+        log_err_exit ("malloc");
+    memset (payload, 'x', size);
+
+    if (!zsys_init ())
+        log_msg_exit ("zsys_init failed");
+    zsys_set_linger (5);
+    if (!(h = loopback_create (0))
+        || flux_attr_set_cacheonly (h, "rank", "0") < 0)
+        log_err_exit ("error creating loopback handle");
+    flux_log_set_redirect (h, log_cb, NULL);
+
+    bench_create (&b, h, children + 1, batch_size);
+
+    printf ("children=%d size=%d window=%d batch-size=%s uri=%s\n",
+            children,
+            size,
+            window,
+            batch_size,
+            overlay_get_bind_uri (b.ov[0]));
+
+    bench_requests (&b, payload, size, count, window);
+    bench_responses (&b, payload, size, count, window);
+    bench_events (&b, payload, size, count, window);
+
+    bench_destroy (&b);
+    flux_close (h);
+    free (payload);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,166 @@
+/************************************************************\
+ * Copyright 2024 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* event-bench - time router event distribution to many clients
+ *
+ * Add --clients router entries, each subscribed to --subs topics of
+ * its own, then publish --events events round-robin so that each event
+ * is delivered to exactly one client, as when many flux job wait-event
+ * clients are connected to connector-local.  Events are looped back to
+ * the router over a loop:// handle.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/librouter/router.h"
+
+static struct optparse_option opts[] = {
+    { .name = "clients", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of router clients (default 10000)",
+    },
+    { .name = "subs", .key = 's', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of subscriptions per client (default 4)",
+    },
+    { .name = "events", .key = 'e', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of events to publish (default 100000)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+struct bench {
+    flux_t *h;
+    int events;
+    int received;
+};
+
+static int client_send (const flux_msg_t *msg, void *arg)
+{
+    struct bench *b = arg;
+    int type;
+
+    if (flux_msg_get_type (msg, &type) < 0)
+        return -1;
+    if (type == FLUX_MSGTYPE_EVENT) {
+        if (++b->received == b->events)
+            flux_reactor_stop (flux_get_reactor (b->h));
+    }
+    else if (type == FLUX_MSGTYPE_RESPONSE) {
+        if (flux_response_decode (msg, NULL, NULL) < 0)
+            log_err_exit ("local.sub");
+    }
+    return 0;
+}
+
+static void client_subscribe (struct router_entry *entry, const char *topic)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode ("local.sub", NULL))
+        || flux_msg_pack (msg, "{s:s}", "topic", topic) < 0)
+        log_err_exit ("error encoding local.sub request");
+    router_entry_recv (entry, msg);
+    flux_msg_destroy (msg);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct bench b = { 0 };
+    struct router *rtr;
+    struct router_entry **entries;
+    int nclients, nsubs;
+    struct timespec t0;
+    double t_sub;
+    double t_run;
+    char topic[128];
+
+    log_init ("event-bench");
+
+    if (!(p = optparse_create ("event-bench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_create");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    nclients = optparse_get_int (p, "clients", 10000);
+    nsubs = optparse_get_int (p, "subs", 4);
+    b.events = optparse_get_int (p, "events", 100000);
+    if (nclients <= 0 || nsubs <= 0 || b.events <= 0)
+        log_msg_exit ("invalid argument");
+
+    if (!(b.h = flux_open ("loop://", 0)))
+        log_err_exit ("flux_open loop://");
+    if (!(rtr = router_create (b.h)))
+        log_err_exit ("router_create");
+    if (!(entries = calloc (nclients, sizeof (entries[0]))))
+        log_err_exit ("calloc");
+
+    monotime (&t0);
+    for (int i = 0; i < nclients; i++) {
+        char uuid[64];
+        snprintf (uuid, sizeof (uuid), "client%d", i);
+        if (!(entries[i] = router_entry_add (rtr, uuid, client_send, &b)))
+            log_err_exit ("router_entry_add");
+        for (int j = 0; j < nsubs; j++) {
+            snprintf (topic, sizeof (topic), "bench.client%d.sub%d", i, j);
+            client_subscribe (entries[i], topic);
+        }
+    }
+    t_sub = monotime_since (t0);
+
+    monotime (&t0);
+    for (int i = 0; i < b.events; i++) {
+        flux_msg_t *msg;
+        snprintf (topic,
+                  sizeof (topic),
+                  "bench.client%d.sub%d.event",
+                  i % nclients,
+                  (i / nclients) % nsubs);
+        if (!(msg = flux_event_encode (topic, NULL))
+            || flux_send (b.h, msg, 0) < 0)
+            log_err_exit ("error sending event");
+        flux_msg_destroy (msg);
+    }
+    if (flux_reactor_run (flux_get_reactor (b.h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    t_run = monotime_since (t0);
+
+    if (b.received != b.events)
+        log_msg_exit ("received %d of %d events", b.received, b.events);
+
+    printf ("clients=%d subs=%d\n", nclients, nsubs);
+    printf ("subscribe: %d subscriptions in %.3fs\n",
+            nclients * nsubs,
+            t_sub / 1000.);
+    printf ("events: %d events in %.3fs (%.1f events/s)\n",
+            b.events,
+            t_run / 1000.,
+            b.events / (t_run / 1000.));
+
+    for (int i = 0; i < nclients; i++)
+        router_entry_delete (entries[i]);
+    free (entries);
+    router_destroy (rtr);
+    flux_close (b.h);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
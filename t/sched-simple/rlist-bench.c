@@ -0,0 +1,189 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rlist-bench - time rlist_alloc()/rlist_free() against a synthetic rlist
+ *
+ * Fill a synthetic resource list of --nodes nodes with jobs, then run
+ * --jobs iterations of free-random-job/allocate-new-job, which is the
+ * steady state of a scheduler with a deep queue.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/librlist/rlist.h"
+
+static struct optparse_option opts[] = {
+    { .name = "nodes", .key = 'N', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of nodes in synthetic rlist (default 10000)",
+    },
+    { .name = "cores", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of cores per node (default 32)",
+    },
+    { .name = "jobs", .key = 'j', .has_arg = 1, .arginfo = "N",
+      .usage = "Number of free/alloc iterations (default 10000)",
+    },
+    { .name = "mode", .key = 'm', .has_arg = 1, .arginfo = "MODE",
+      .usage = "Allocation mode: worst-fit, best-fit, first-fit",
+    },
+    { .name = "max-slots", .key = 's', .has_arg = 1, .arginfo = "N",
+      .usage = "Max slots per job (default 16)",
+    },
+    { .name = "max-slot-size", .key = 'S', .has_arg = 1, .arginfo = "N",
+      .usage = "Max cores per slot (default 4)",
+    },
+    { .name = "seed", .has_arg = 1, .arginfo = "N",
+      .usage = "Random number seed",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static struct rlist *rlist_synthetic (int nnodes, int ncores)
+{
+    struct rlist *rl;
+    char cores[64];
+
+    if (!(rl = rlist_create ()))
+        log_err_exit ("rlist_create");
+    snprintf (cores, sizeof (cores), "0-%d", ncores - 1);
+    for (int i = 0; i < nnodes; i++) {
+        char host[64];
+        snprintf (host, sizeof (host), "node%d", i);
+        if (rlist_append_rank_cores (rl, host, i, cores) < 0)
+            log_err_exit ("rlist_append_rank_cores");
+    }
+    return rl;
+}
+
+static struct rlist *alloc_random (struct rlist *rl,
+                                   const char *mode,
+                                   int max_slots,
+                                   int max_slot_size)
+{
+    int nslots = 1 + rand () % max_slots;
+    int slot_size = 1 + rand () % max_slot_size;
+    struct rlist *alloc;
+
+    if (!(alloc = rlist_alloc (rl, mode, 0, nslots, slot_size))
+        && errno != ENOSPC)
+        log_err_exit ("rlist_alloc");
+    return alloc;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct rlist *rl;
+    struct rlist **jobs;
+    int nnodes, ncores, njobs, max_slots, max_slot_size;
+    const char *mode;
+    int njobs_running = 0;
+    int nfill;
+    int allocs = 0;
+    int frees = 0;
+    struct timespec t0;
+    double t_fill;
+    double t_run;
+
+    log_init ("rlist-bench");
+
+    if (!(p = optparse_create ("rlist-bench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_create");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    nnodes = optparse_get_int (p, "nodes", 10000);
+    ncores = optparse_get_int (p, "cores", 32);
+    njobs = optparse_get_int (p, "jobs", 10000);
+    max_slots = optparse_get_int (p, "max-slots", 16);
+    max_slot_size = optparse_get_int (p, "max-slot-size", 4);
+    mode = optparse_get_str (p, "mode", NULL);
+    srand (optparse_get_int (p, "seed", 0));
+
+    if (nnodes <= 0 || ncores <= 0 || njobs <= 0
+        || max_slots <= 0 || max_slot_size <= 0)
+        log_msg_exit ("invalid argument");
+
+    rl = rlist_synthetic (nnodes, ncores);
+    if (!(jobs = calloc (rl->total + 1, sizeof (*jobs))))
+        log_err_exit ("calloc");
+
+    /*  Fill the instance until the first allocation failure
+     */
+    monotime (&t0);
+    while (njobs_running < rl->total
+           && (jobs[njobs_running] = alloc_random (rl,
+                                                   mode,
+                                                   max_slots,
+                                                   max_slot_size)))
+        njobs_running++;
+    t_fill = monotime_since (t0);
+    nfill = njobs_running;
+
+    /*  Steady state: free a random job, then allocate until ENOSPC
+     */
+    monotime (&t0);
+    for (int i = 0; i < njobs && njobs_running > 0; i++) {
+        int n = rand () % njobs_running;
+        if (rlist_free (rl, jobs[n]) < 0)
+            log_err_exit ("rlist_free");
+        rlist_destroy (jobs[n]);
+        jobs[n] = jobs[--njobs_running];
+        frees++;
+        while ((jobs[njobs_running] = alloc_random (rl,
+                                                   mode,
+                                                   max_slots,
+                                                   max_slot_size))) {
+            njobs_running++;
+            allocs++;
+        }
+    }
+    t_run = monotime_since (t0);
+
+    printf ("nodes=%d cores=%d mode=%s\n",
+            nnodes,
+            ncores,
+            mode ? mode : "worst-fit");
+    printf ("fill: %d jobs in %.3fs (%.1f jobs/s)\n",
+            nfill,
+            t_fill / 1000.,
+            nfill / (t_fill / 1000.));
+    printf ("steady state: %d frees, %d allocs in %.3fs (%.1f ops/s)\n",
+            frees,
+            allocs,
+            t_run / 1000.,
+            (frees + allocs) / (t_run / 1000.));
+
+    for (int i = 0; i < njobs_running; i++) {
+        if (rlist_free (rl, jobs[i]) < 0)
+            log_err_exit ("rlist_free");
+        rlist_destroy (jobs[i]);
+    }
+    if (rl->avail != rl->total)
+        log_msg_exit ("avail=%d != total=%d after freeing all jobs",
+                      rl->avail,
+                      rl->total);
+    free (jobs);
+    rlist_destroy (rl);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
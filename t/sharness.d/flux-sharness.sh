@@ -33,6 +33,23 @@ test_size_large() {
 }
 
 
+#
+#  job-list loads jobs from the KVS asynchronously after it is loaded.
+#   Wait (up to 10s) until all jobs have been loaded, so that list
+#   results are complete.
+#
+job_list_wait_restart() {
+    local i=0
+    while test "$(flux module stats --parse restart.complete job-list)" \
+               != "true" \
+          && test $i -lt 100
+    do
+        sleep 0.1
+        i=$((i + 1))
+    done
+    test $i -lt 100
+}
+
 #
 #  Tests using test_under_flux() and which load their own modules should
 #   ensure those modules are unloaded at the end of the test for proper
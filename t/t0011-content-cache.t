@@ -11,6 +11,7 @@ echo "# $0: flux session size will be ${SIZE}"
 
 BLOBREF=${FLUX_BUILD_DIR}/t/kvs/blobref
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
+BATCH=${FLUX_BUILD_DIR}/t/content/batch
 
 MAXBLOB=`flux getattr content.blob-size-limit`
 HASHFUN=`flux getattr content.hash`
@@ -181,6 +182,69 @@ test_expect_success 'store 1K blobs from all ranks using async RPC' '
 	flux exec -n flux content spam 1024 256 >/dev/null
 '
 
+# Backing store is not loaded so rank 0 entries are dirty and never purged
+test_expect_success 'storing new blobs adds one entry each to rank 0 cache' '
+	COUNT=$(flux module stats --type int --parse count content) &&
+	BYTES=$(flux module stats --type int --parse size content) &&
+	for i in 1 2 3; do echo digestkey.$i | flux content store; done \
+		>digestkey.hash &&
+	test $(flux module stats --type int --parse count content) \
+		-eq $(($COUNT+3)) &&
+	test $(flux module stats --type int --parse size content) \
+		-eq $(($BYTES+36))
+'
+test_expect_success 'storing the same blobs again adds no entries' '
+	COUNT=$(flux module stats --type int --parse count content) &&
+	for i in 1 2 3; do echo digestkey.$i | flux content store; done \
+		>digestkey2.hash &&
+	test_cmp digestkey.hash digestkey2.hash &&
+	test $(flux module stats --type int --parse count content) -eq $COUNT
+'
+test_expect_success 'content stats reports a nonzero entry-size' '
+	test $(flux module stats --type int --parse entry-size content) -gt 0
+'
+test_expect_success 'load of blobref with foreign hash type fails' '
+	if test "$HASHFUN" = sha1; then FOREIGN=sha256; else FOREIGN=sha1; fi &&
+	test_must_fail flux content load \
+		$(echo foreign | $BLOBREF $FOREIGN) 2>foreign.err &&
+	grep "No such file or directory" foreign.err
+'
+
+test_expect_success 'store-batch on rank 3 returns blobrefs in order' '
+	flux content store <64.0.store >b1.hash &&
+	flux content store <4k.0.store >b2.hash &&
+	cat b1.hash b2.hash >batch.expect &&
+	flux exec -r 3 $BATCH store 64.0.store 4k.0.store >batch.out &&
+	test_cmp batch.expect batch.out
+'
+test_expect_success 'store-batch of new blobs on rank 3 works' '
+	echo batchfoo >foo.store &&
+	echo batchbar >bar.store &&
+	flux exec -r 3 $BATCH store foo.store bar.store >batch2.out &&
+	test $(wc -l <batch2.out) -eq 2
+'
+test_expect_success 'load-batch on all ranks returns blobs in order' '
+	cat foo.store bar.store 64.0.store >batch3.expect &&
+	flux exec -n sh -c "$BATCH load $(cat batch2.out) $(cat b1.hash) \
+		>batch3.out.\$(flux getattr rank)" &&
+	for i in $(seq 0 $((${SIZE}-1))); do \
+		test_cmp batch3.expect batch3.out.$i || return 1; \
+	done
+'
+test_expect_success 'load-batch of unknown blobref reports per-item error' '
+	HASHSTR=$(echo batchnoexist | $BLOBREF $HASHFUN) &&
+	test_must_fail flux exec -r 1 $BATCH load $(cat b1.hash) $HASHSTR \
+		>batch4.out 2>batch4.err &&
+	grep "No such file or directory" batch4.err &&
+	test_cmp 64.0.store batch4.out
+'
+test_expect_success 'empty load-batch and store-batch work' '
+	$BATCH load &&
+	$BATCH store
+'
+test_expect_success 'load-batch request with malformed payload fails with EPROTO(71)' '
+	echo -n x | ${RPC} content.load-batch 71
+'
 test_expect_success 'load request with empty payload fails with EPROTO(71)' '
 	${RPC} content.load 71 </dev/null
 '
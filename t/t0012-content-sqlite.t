@@ -11,6 +11,7 @@ echo "# $0: flux session size will be ${SIZE}"
 
 BLOBREF=${FLUX_BUILD_DIR}/t/kvs/blobref
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
+BATCH=${FLUX_BUILD_DIR}/t/content/batch
 
 HASHFUN=`flux getattr content.hash`
 
@@ -102,6 +103,23 @@ test_expect_success 'load and verify 1m blob on all ranks' '
 	test_cmp 1m.0.all.expect 1m.0.all.output
 '
 
+test_expect_success 'store-batch bypassing cache works' '
+	$BATCH --bypass-cache store 64.0.store 4k.0.store >batch.out &&
+	cat 64.0.hash 4k.0.hash >batch.expect &&
+	test_cmp batch.expect batch.out
+'
+test_expect_success 'load-batch bypassing cache works' '
+	$BATCH --bypass-cache load $(cat 4k.0.hash 0.0.hash 64.0.hash) \
+		>batch2.out &&
+	cat 4k.0.store 0.0.store 64.0.store >batch2.expect &&
+	test_cmp batch2.expect batch2.out
+'
+test_expect_success 'load-batch bypassing cache reports per-item error' '
+	test_must_fail $BATCH --bypass-cache load sha1-nosuchblob \
+		$(cat 64.0.hash) >batch3.out &&
+	test_cmp 64.0.store batch3.out
+'
+
 test_expect_success 'exercise batching of synchronous flush to backing store' '
 	flux setattr content.flush-batch-limit 5 &&
 	flux content spam 200 200 >/dev/null &&
@@ -0,0 +1,259 @@
+#!/bin/sh
+
+test_description='Test content-mmap backing store service'
+
+. `dirname $0`/sharness.sh
+
+if test "$TEST_LONG" = "t"; then
+    test_set_prereq LONGTEST
+fi
+
+test_under_flux 1 minimal
+
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+TORTURE=${FLUX_BUILD_DIR}/t/kvs/torture
+
+SIZES="0 1 64 100 1000 1024 1025 8192 65536 262144 1048576 4194304"
+LARGE_SIZES="8388608 10000000 16777216 33554432 67108864"
+
+##
+# Functions used by tests
+##
+
+# Usage: backing_load blobref
+backing_load() {
+        echo -n $1 | $RPC content-backing.load
+}
+# Usage: backing_store <blob >blobref
+backing_store() {
+        $RPC -r content-backing.store
+}
+# Usage: make_blob size >blob
+make_blob() {
+	if test $1 -eq 0; then
+		dd if=/dev/null 2>/dev/null
+	else
+		dd if=/dev/urandom count=1 bs=$1 2>/dev/null
+	fi
+}
+# Usage: check_blob size
+# Leaves behind blob.<size> and blobref.<size>
+check_blob() {
+	make_blob $1 >blob.$1 &&
+	backing_store <blob.$1 >blobref.$1 &&
+	backing_load $(cat blobref.$1) >blob.$1.check &&
+	test_cmp blob.$1 blob.$1.check
+}
+# Usage: check_blob size
+# Relies on existence of blob.<size> and blobref.<size>
+recheck_blob() {
+	backing_load $(cat blobref.$1) >blob.$1.recheck &&
+	test_cmp blob.$1 blob.$1.recheck
+}
+# Usage: recheck_cache_blob size
+# Relies on existence of blob.<size> and blobref.<size>
+recheck_cache_blob() {
+	flux content load $(cat blobref.$1) >blob.$1.cachecheck &&
+	test_cmp blob.$1 blob.$1.cachecheck
+}
+# Usage: kvs_checkpoint_put key value
+kvs_checkpoint_put() {
+        jq -j -c -n  "{key:\"$1\",value:\"$2\"}" | $RPC kvs-checkpoint.put
+}
+# Usage: kvs_checkpoint_get key >value
+kvs_checkpoint_get() {
+        jq -j -c -n  "{key:\"$1\"}" | $RPC kvs-checkpoint.get
+}
+# Usage: content_bench module
+# Run kvs torture in a new instance using the specified backing module,
+# and report the time needed to flush the content cache to it.
+content_bench() {
+	flux start \
+	    -o,-Scontent.backing-module=$1 \
+	    -o,-Scontent.backing-path=$(pwd)/bench.$1 \
+	    sh -c "$TORTURE --prefix bench --count 20000 --size 1024 && \
+	           t0=\$(date +%s%N) && \
+	           flux content flush && \
+	           t1=\$(date +%s%N) && \
+	           echo $1: flush time=\$(((\$t1-\$t0)/1000000)) ms"
+}
+
+##
+# Tests of the module by itself (no content cache)
+##
+
+test_expect_success 'load content-mmap module' '
+	flux module load content-mmap testing
+'
+
+test_expect_success 'content.backing-path attribute is set' '
+	MMAPDB=$(flux getattr content.backing-path) &&
+	test -d ${MMAPDB}
+'
+
+test_expect_success 'store/load/verify various size small blobs' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success LONGTEST 'store/load/verify various size large blobs' '
+	err=0 &&
+	for size in $LARGE_SIZES; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'storing the same blob again works' '
+	backing_store <blob.1024 >blobref.1024.again &&
+	test_cmp blobref.1024 blobref.1024.again
+'
+
+test_expect_success 'flux module stats reports objects stored' '
+	count=$(flux module stats --parse=objects content-mmap) &&
+	test $count -ge $(echo $SIZES | wc -w)
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.put foo=bar' '
+        kvs_checkpoint_put foo bar
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returned bar' '
+        echo bar >value.exp &&
+        kvs_checkpoint_get foo | jq -r .value >value.out &&
+        test_cmp value.exp value.out
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.put updates foo=baz' '
+        kvs_checkpoint_put foo baz
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returned baz' '
+        echo baz >value2.exp &&
+        kvs_checkpoint_get foo | jq -r .value >value2.out &&
+        test_cmp value2.exp value2.out
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get noexist fails' '
+        test_must_fail kvs_checkpoint_get noexist
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.put with invalid key fails' '
+        test_must_fail kvs_checkpoint_put a/b baz 2>badkey.err &&
+        grep "invalid key" badkey.err
+'
+
+test_expect_success 'reload content-mmap module with sync option' '
+	flux module reload content-mmap testing sync
+'
+
+test_expect_success 'reload/verify various size small blobs' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success LONGTEST 'reload/verify various size large blobs' '
+	err=0 &&
+	for size in $LARGE_SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returns same value' '
+        kvs_checkpoint_get foo | jq -r .value >value2.out &&
+        test_cmp value2.exp value2.out
+'
+
+test_expect_success 'store/load/verify blobs with sync option' '
+	check_blob 8192 &&
+	check_blob 100
+'
+
+test_expect_success 'reload content-mmap module after removing index' '
+	flux module remove content-mmap &&
+	rm -f ${MMAPDB}/index &&
+	flux module load content-mmap testing
+'
+
+test_expect_success 'reload/verify various size small blobs' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'load with invalid blobref fails' '
+	test_must_fail backing_load notblobref
+'
+test_expect_success 'kvs-checkpoint.get bad request fails with EPROTO' '
+	test_must_fail $RPC kvs-checkpoint.get </dev/null 2>badget.err &&
+	grep "Protocol error" badget.err
+'
+test_expect_success 'kvs-checkpoint.put bad request fails with EPROTO' '
+	test_must_fail $RPC kvs-checkpoint.put </dev/null 2>badput.err &&
+	grep "Protocol error" badput.err
+'
+test_expect_success 'module load fails with unknown option' '
+	flux module remove content-mmap &&
+	test_must_fail flux module load content-mmap badopt &&
+	flux module load content-mmap testing
+'
+
+##
+# Tests of the module acting as backing store for content cache
+##
+
+test_expect_success 'reload content-mmap module without testing option' '
+	flux module reload content-mmap
+'
+
+test_expect_success 'verify content.backing-module=content-mmap' '
+        test "$(flux getattr content.backing-module)" = "content-mmap"
+'
+
+test_expect_success 'reload/verify various size small blobs through cache' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_cache_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'remove content-mmap module' '
+	flux module remove content-mmap
+'
+
+##
+# Instance restart and benchmark against content-sqlite
+##
+
+test_expect_success 'kvs content persists across instance restart' '
+	flux start \
+	    -o,-Scontent.backing-module=content-mmap \
+	    -o,-Scontent.backing-path=$(pwd)/restart.mmap \
+	    flux kvs put test.a=42 &&
+	flux start \
+	    -o,-Scontent.backing-module=content-mmap \
+	    -o,-Scontent.backing-path=$(pwd)/restart.mmap \
+	    flux kvs get test.a >restart.out &&
+	echo 42 >restart.exp &&
+	test_cmp restart.exp restart.out
+'
+
+test_expect_success LONGTEST 'benchmark kvs torture with content-sqlite' '
+	content_bench content-sqlite
+'
+
+test_expect_success LONGTEST 'benchmark kvs torture with content-mmap' '
+	content_bench content-mmap
+'
+
+test_done
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+
+test_description='Test overlay message batching'
+
+# Append --logfile option if FLUX_TESTS_LOGFILE is set in environment:
+test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
+. `dirname $0`/sharness.sh
+
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+ARGS="-o,-Sbroker.rc1_path=,-Sbroker.rc3_path="
+
+test_expect_success 'tbon.batch-size is 0 (disabled) by default' '
+	flux start ${ARGS} flux getattr tbon.batch-size >size.out &&
+	echo 0 >size.exp &&
+	test_cmp size.exp size.out
+'
+test_expect_success 'tbon.batch-timeout is 1ms by default' '
+	flux start ${ARGS} flux getattr tbon.batch-timeout >timeout.out &&
+	echo 0.001s >timeout.exp &&
+	test_cmp timeout.exp timeout.out
+'
+test_expect_success 'tbon.batch-timeout can be set on the command line' '
+	flux start ${ARGS} -o,-Stbon.batch-timeout=10ms \
+		flux getattr tbon.batch-timeout >timeout2.out &&
+	echo 0.01s >timeout2.exp &&
+	test_cmp timeout2.exp timeout2.out
+'
+test_expect_success 'tbon.batch-timeout can be changed at runtime' '
+	flux start ${ARGS} sh -c "flux setattr tbon.batch-timeout 2ms \
+		&& flux getattr tbon.batch-timeout" >timeout3.out &&
+	echo 0.002s >timeout3.exp &&
+	test_cmp timeout3.exp timeout3.out
+'
+test_expect_success 'invalid tbon.batch-timeout is rejected' '
+	test_must_fail flux start ${ARGS} -o,-Stbon.batch-timeout=foo /bin/true
+'
+test_expect_success 'invalid tbon.batch-size is rejected' '
+	test_must_fail flux start ${ARGS} -o,-Stbon.batch-size=foo /bin/true
+'
+test_expect_success 'create script to send messages over the overlay' '
+	cat >batch.sh <<-EOT &&
+	#!/bin/sh -e
+	for i in \$(seq 1 8); do
+	    flux exec -r 1 flux getattr rank
+	done >ranks.out
+	flux event pub test.batch
+	flux exec -r 1 /bin/true
+	$RPC overlay.stats.get </dev/null >stats.0
+	flux exec -r 1 $RPC overlay.stats.get </dev/null >stats.1
+	EOT
+	chmod +x batch.sh
+'
+test_expect_success 'messages are delivered with batching enabled' '
+	flux start ${ARGS} -o,-Stbon.batch-size=65536 --test-size=2 \
+		./batch.sh &&
+	test $(grep -c "^1$" ranks.out) -eq 8
+'
+test_expect_success HAVE_JQ 'overlay.stats.get reports batches sent by rank 0' '
+	$jq -e ".batch.count > 0" <stats.0 &&
+	$jq -e ".batch.messages >= .batch.count" <stats.0 &&
+	$jq -e "(.batch.size | add) == .batch.count" <stats.0 &&
+	$jq -e "(.batch.latency | add) == .batch.count" <stats.0
+'
+test_expect_success HAVE_JQ 'overlay.stats.get reports batches sent by rank 1' '
+	$jq -e ".batch.count > 0" <stats.1 &&
+	$jq -e "(.batch.size | length) == 16" <stats.1
+'
+test_expect_success HAVE_JQ 'overlay.stats.get reports no batches when disabled' '
+	flux start ${ARGS} --test-size=2 \
+		$RPC overlay.stats.get </dev/null >stats.none &&
+	$jq -e ".batch.count == 0" <stats.none
+'
+
+test_done
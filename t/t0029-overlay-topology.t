@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+
+test_description='Test TBON topology selection'
+
+# Append --logfile option if FLUX_TESTS_LOGFILE is set in environment:
+test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
+. `dirname $0`/sharness.sh
+
+ARGS="-o,-Sbroker.rc1_path=,-Sbroker.rc3_path="
+
+# Usage: getattr_rank TOPO SIZE RANK ATTR
+getattr_rank() {
+	flux start ${ARGS} -s$2 -o,-Stbon.topo=$1 \
+		flux exec -r $3 flux getattr $4
+}
+
+test_expect_success 'tbon.topo is kary:2 by default' '
+	flux start ${ARGS} flux getattr tbon.topo >topo.out &&
+	echo kary:2 >topo.exp &&
+	test_cmp topo.exp topo.out
+'
+test_expect_success 'tbon.topo reflects the --k-ary option' '
+	flux start ${ARGS} -s2 -o,--k-ary=3 flux getattr tbon.topo >topo2.out &&
+	echo kary:3 >topo2.exp &&
+	test_cmp topo2.exp topo2.out
+'
+test_expect_success 'tbon.topo cannot be changed at runtime' '
+	test_must_fail flux start ${ARGS} flux setattr tbon.topo binomial
+'
+test_expect_success 'invalid tbon.topo is rejected' '
+	test_must_fail flux start ${ARGS} -o,-Stbon.topo=foo /bin/true &&
+	test_must_fail flux start ${ARGS} -o,-Stbon.topo=kary:0 /bin/true &&
+	test_must_fail flux start ${ARGS} -o,-Stbon.topo=flatroot /bin/true
+'
+test_expect_success 'binomial topology has the expected shape' '
+	test $(getattr_rank binomial 8 0 tbon.descendants) -eq 7 &&
+	test $(getattr_rank binomial 8 0 tbon.maxlevel) -eq 3 &&
+	test $(getattr_rank binomial 8 4 tbon.descendants) -eq 3 &&
+	test $(getattr_rank binomial 8 7 tbon.level) -eq 3
+'
+test_expect_success 'flatroot topology has the expected shape' '
+	test $(getattr_rank flatroot:7 8 0 tbon.maxlevel) -eq 1 &&
+	test $(getattr_rank flatroot:2:3 8 0 tbon.maxlevel) -eq 2 &&
+	test $(getattr_rank flatroot:2:3 8 1 tbon.descendants) -eq 3 &&
+	test $(getattr_rank flatroot:2:3 8 2 tbon.descendants) -eq 2 &&
+	test $(getattr_rank flatroot:2:3 8 0 tbon.arity) -eq 2 &&
+	test $(getattr_rank flatroot:100 8 0 tbon.arity) -eq 7
+'
+for topo in kary:1 kary:3 binomial flatroot:3 flatroot:2:1; do
+	test_expect_success "RPCs reach every rank with tbon.topo=$topo" '
+		flux start ${ARGS} -s8 -o,-Stbon.topo=$topo \
+			sh -c "for r in \$(seq 0 7); do \
+				flux ping --count 2 --interval 0 \$r || exit 1; \
+			done"
+	'
+done
+test_expect_success 'ping latency can be compared by rank distance' '
+	flux start ${ARGS} -s8 -o,-Stbon.topo=binomial \
+		sh -c "for r in 1 3 7; do \
+			echo level=\$(flux exec -r \$r flux getattr tbon.level); \
+			flux ping --count 10 --interval 0 \$r | tail -1; \
+		done" >latency.out &&
+	test_debug "cat latency.out" &&
+	grep -q level=3 latency.out
+'
+
+test_done
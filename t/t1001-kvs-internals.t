@@ -517,4 +517,36 @@ test_expect_success 'kvs: test invalid lookup rpc' '
         grep "flux_future_get: Protocol error" lookup_invalid_output
 '
 
+#
+# test cache size limit
+# N.B. reloads the rank 0 kvs module so keep these tests last
+#
+
+test_expect_success 'kvs: reload kvs with small cache-max-size' '
+        flux kvs put $DIR.cachelimit.a=$largeval &&
+        flux module reload kvs cache-max-size=1024 &&
+        flux module stats --parse "cache.obj size limit (MiB)" kvs >limit.out &&
+        test "$(cat limit.out)" != "0.0"
+'
+
+test_expect_success 'kvs: lookups on cache with small limit work' '
+        flux module stats -c kvs &&
+        for i in $(seq 1 8); do
+            flux kvs put $DIR.cachelimit.$i=$largeval$i || return 1
+        done &&
+        for i in $(seq 1 8); do
+            test_kvs_key $DIR.cachelimit.$i "$largeval$i" || return 1
+        done &&
+        test_kvs_key $DIR.cachelimit.a "$largeval"
+'
+
+test_expect_success 'kvs: cache entries were evicted' '
+        flux module stats --parse "cache.#evictions" kvs >evictions.out &&
+        test $(cat evictions.out) -gt 0 &&
+        flux module stats --parse "cache.#hits" kvs >hits.out &&
+        test $(cat hits.out) -gt 0 &&
+        flux module stats --parse "cache.#misses" kvs >misses.out &&
+        test $(cat misses.out) -gt 0
+'
+
 test_done
@@ -46,6 +46,28 @@ test_expect_success NO_CHAIN_LINT 'kvs-watch stats reports active watcher' '
        wait $pid
 '
 
+test_expect_success NO_CHAIN_LINT 'kvs-watch shares lookups of the same key' '
+       flux kvs put test.shared=0 &&
+       flux kvs get --watch --count=2 test.shared >shared1.out &
+       pid1=$! &&
+       flux kvs get --watch --count=2 test.shared >shared2.out &
+       pid2=$! &&
+       flux kvs get --watch --count=2 test.shared >shared3.out &
+       pid3=$! &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" shared1.out &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" shared2.out &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" shared3.out &&
+       before=$(flux module stats --parse=lookups-coalesced kvs-watch) &&
+       flux kvs put --no-merge test.shared=1 &&
+       wait $pid1 && wait $pid2 && wait $pid3 &&
+       after=$(flux module stats --parse=lookups-coalesced kvs-watch) &&
+       test $after -eq $(($before+2)) &&
+       printf "0\n1\n" >shared.exp &&
+       test_cmp shared.exp shared1.out &&
+       test_cmp shared.exp shared2.out &&
+       test_cmp shared.exp shared3.out
+'
+
 # Check that stdin contains an integer on each line that
 # is one more than the integer on the previous line.
 test_monotonicity() {
@@ -457,6 +479,11 @@ flux-kvs: test.append.test: Invalid argument
         test_cmp expected append10.out
 '
 
+test_expect_success 'flux kvs get: --append receives every byte of many appends' '
+        ${FLUX_BUILD_DIR}/t/kvs/watch_append \
+            --key=test.append.many --count=1000 --window=16
+'
+
 # full checks
 
 # in full checks, we create a directory that we will use to
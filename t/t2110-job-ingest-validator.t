@@ -3,6 +3,7 @@ test_description='Test job validator'
 
 . $(dirname $0)/sharness.sh
 
+export FLUX_CONF_DIR=$(pwd)
 test_under_flux 4 job
 
 flux setattr log-stderr-level 1
@@ -94,6 +95,33 @@ test_expect_success 'job-ingest: test jobspec validator with version 1' '
 test_expect_success 'job-ingest: v1 jobspecs accepted with v1 requirement' '
 	test_valid ${JOBSPEC}/valid_v1/*
 '
+test_expect_success 'job-ingest: test native validator with version 1' '
+	ingest_module reload validator-native=jobspec-v1
+'
+test_expect_success 'job-ingest: v1 jobspecs accepted by native v1 validator' '
+	test_valid ${JOBSPEC}/valid_v1/*
+'
+test_expect_success 'job-ingest: non-v1 jobspec rejected by native v1 validator' '
+	$Y2J <${JOBSPEC}/valid/example2.yaml >example2.json &&
+	test_must_fail flux job submit example2.json 2>example2.err &&
+	grep "slot may contain only core and gpu resources" example2.err
+'
+test_expect_success 'job-ingest: invalid validator-native is rejected' '
+	test_must_fail flux module reload job-ingest validator-native=foo &&
+	flux module load job-ingest
+'
+test_expect_success NO_ASAN 'job-ingest: report submit rate with each validator' '
+	flux mini run --dry-run hostname >bench.json &&
+	for args in "validator-native=none" \
+	            "validator-native=jobspec" \
+	            "validator-native=jobspec validator-plugins=jobspec" \
+	            "disable-validator"; do \
+		ingest_module reload $args &&
+		echo "$args:" &&
+		$SUBMITBENCH --stats --urgency=0 -r 100 bench.json \
+			|| return 1; \
+	done
+'
 test_expect_success 'job-ingest: test python jsonschema validator' '
 	ingest_module reload \
 		validator-plugins=schema \
@@ -128,6 +156,16 @@ test_expect_success 'job-ingest: infeasible jobs are now rejected' '
 	test_must_fail flux mini submit -N 12 -n12 hostname 2>infeasible3.err &&
 	grep "request is not satisfiable" infeasible3.err
 '
+test_expect_success 'job-ingest: native validator is off when plugins are set' '
+	jobid=$(flux mini submit --setattr=foo=bar hostname) &&
+	flux job cancel $jobid
+'
+test_expect_success 'job-ingest: native validator can be combined with plugins' '
+	ingest_module reload validator-native=jobspec \
+		validator-plugins=feasibility &&
+	test_must_fail flux mini submit --setattr=foo=bar hostname &&
+	ingest_module reload validator-plugins=feasibility
+'
 test_expect_success 'job-ingest: feasibility validator works with jobs running' '
 	ncores=$(flux resource list -s up -no {ncores}) &&
 	flux queue start &&
@@ -147,6 +185,48 @@ test_expect_success 'job-ingest: jobs that fail either validator are rejected' '
 	test_must_fail flux mini submit --setattr=foo=bar hostname &&
 	test_must_fail flux mini submit -n 4568 hostname
 '
+test_expect_success 'job-ingest: validator pool can be configured' '
+	cat >ingest.toml <<-EOT &&
+	[ingest.validator]
+	max-workers = 1
+	batch-size = 8
+	EOT
+	flux config reload &&
+	ingest_module reload validator-plugins=jobspec
+'
+test_expect_success 'job-ingest: batched requests to single worker work' '
+	flux mini run --dry-run hostname >batch.json &&
+	$SUBMITBENCH --urgency=0 -r 100 batch.json &&
+	test_must_fail flux mini submit --setattr=foo=bar hostname
+'
+test_expect_success 'job-ingest: module args override config' '
+	ingest_module reload validator-plugins=jobspec \
+		validator-max-workers=2 validator-batch-size=1 &&
+	$SUBMITBENCH --urgency=0 -r 100 batch.json
+'
+test_expect_success 'job-ingest: invalid validator pool args are rejected' '
+	test_must_fail flux module reload job-ingest \
+		validator-max-workers=0 &&
+	test_must_fail flux module load job-ingest \
+		validator-batch-size=foo
+'
+test_expect_success 'job-ingest: invalid validator pool config is rejected' '
+	cat >ingest.toml <<-EOT &&
+	[ingest.validator]
+	max-workers = "many"
+	EOT
+	flux config reload &&
+	test_must_fail flux module load job-ingest &&
+	cat >ingest.toml <<-EOT &&
+	[ingest.validator]
+	batch-size = 0
+	EOT
+	flux config reload &&
+	test_must_fail flux module load job-ingest &&
+	rm ingest.toml &&
+	flux config reload &&
+	flux module load job-ingest
+'
 test_expect_success 'job-ingest: validator unexpected exit is handled' '
 	ingest_module reload \
 		validator-plugins=${BAD_VALIDATOR} &&
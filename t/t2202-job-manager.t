@@ -6,6 +6,7 @@ test_description='Test flux job manager service'
 
 . $(dirname $0)/sharness.sh
 
+export FLUX_CONF_DIR=$(pwd)
 test_under_flux 4 kvs
 
 flux setattr log-stderr-level 1
@@ -209,6 +210,30 @@ test_expect_success 'job-manager: queue was successfully reconstructed' '
 	test_cmp list10_reordered.out list_reload.out
 '
 
+test_expect_success 'job-manager: restart reported job count and window' '
+	flux dmesg | grep "restart: 10 jobs in .*(window=256)"
+'
+
+test_expect_success 'job-manager: reload with restart_window = 1' '
+	cat >job-manager.toml <<-EOT &&
+	[job-manager]
+	restart_window = 1
+	EOT
+	flux config reload &&
+	flux module reload job-manager &&
+	flux dmesg | grep "restart: 10 jobs in .*(window=1)"
+'
+
+test_expect_success 'job-manager: queue was reconstructed in the same order' '
+	${LIST_JOBS} >list_reload_w1.out &&
+	test_cmp list10_reordered.out list_reload_w1.out
+'
+
+test_expect_success 'job-manager: restore default restart_window' '
+	rm -f job-manager.toml &&
+	flux config reload
+'
+
 check_eventlog_restart_events() {
 	for jobid in $($jq .id <list_reload.out); do
 		if ! flux job wait-event -t 20 -c 1 ${jobid} flux-restart \
@@ -381,6 +406,25 @@ test_expect_success HAVE_JQ 'job-manager stats works' '
         cat stats.out | $jq -e .journal.listeners
 '
 
+test_expect_success HAVE_JQ 'job-manager stats reports bytes per job' '
+	flux job submit basic.json &&
+	flux job submit basic.json &&
+	flux module stats job-manager >stats2.out &&
+	$jq -e ".jobs.active >= 2" <stats2.out &&
+	$jq -e ".jobs[\"bytes-per-job\"] > 0" <stats2.out &&
+	$jq -e ".[\"jobspec-intern\"].hits >= 1" <stats2.out
+'
+
+test_expect_success HAVE_JQ 'job-manager: getattr jobspec works on zombie' '
+	jobid=$(flux job submit --flags=waitable basic.json | flux job id) &&
+	flux job cancel $jobid &&
+	flux job wait-event $jobid clean &&
+	echo "{\"id\":$jobid,\"attrs\":[\"jobspec\"]}" \
+		| ${RPC} job-manager.getattr >getattr.out &&
+	$jq -e ".jobspec.tasks" <getattr.out &&
+	$jq -e ".jobspec.attributes.system.environment == null" <getattr.out
+'
+
 test_expect_success 'job-manager: remove job-info, job-manager, job-ingest' '
 	flux module remove job-info &&
 	flux module remove job-manager &&
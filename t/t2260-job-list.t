@@ -4,6 +4,7 @@ test_description='Test flux job list services'
 
 . $(dirname $0)/sharness.sh
 
+export FLUX_CONF_DIR=$(pwd)
 test_under_flux 4 job
 
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
@@ -408,6 +409,7 @@ wait_inactive() {
 test_expect_success 'reload the job-list module' '
         flux job list -a > before_reload.out &&
         flux module reload job-list &&
+        job_list_wait_restart &&
         wait_inactive
 '
 
@@ -416,6 +418,13 @@ test_expect_success HAVE_JQ 'job-list: list successfully reconstructed' '
         test_cmp before_reload.out after_reload.out
 '
 
+test_expect_success HAVE_JQ 'job-list: stats report restart progress' '
+        flux module stats job-list >restart_stats.out &&
+        jq -e ".restart.complete == true" <restart_stats.out &&
+        jq -e ".restart.jobs == $(wc -l <before_reload.out)" <restart_stats.out &&
+        jq -e ".restart.lookups == 0" <restart_stats.out
+'
+
 test_expect_success HAVE_JQ 'job stats lists jobs in correct state (all inactive)' '
         flux job stats | jq -e ".job_states.depend == 0" &&
         flux job stats | jq -e ".job_states.priority == 0" &&
@@ -664,7 +673,8 @@ test_expect_success HAVE_JQ 'flux job lists full path for job name if basename f
 '
 
 test_expect_success 'reload the job-list module' '
-        flux module reload job-list
+        flux module reload job-list &&
+        job_list_wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify job names preserved across restart' '
@@ -701,7 +711,8 @@ test_expect_success HAVE_JQ 'flux job list outputs ntasks correctly (4 tasks)' '
 '
 
 test_expect_success 'reload the job-list module' '
-        flux module reload job-list
+        flux module reload job-list &&
+        job_list_wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify task count preserved across restart' '
@@ -821,7 +832,8 @@ test_expect_success HAVE_JQ 'flux job list outputs expiration time when set' '
 '
 
 test_expect_success 'reload the job-list module' '
-        flux module reload job-list
+        flux module reload job-list &&
+        job_list_wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify nnodes/ranks/nodelist preserved across restart' '
@@ -886,6 +898,7 @@ test_expect_success 'job-list parses flux-restart events' '
         flux module unload job-list &&
         flux module reload job-manager &&
         flux module load job-list &&
+        job_list_wait_restart &&
         wait_jobid $jobid &&
         flux module reload job-exec &&
         flux module reload sched-simple
@@ -996,6 +1009,57 @@ test_expect_success HAVE_JQ 'list request with invalid input fails with EINVAL(2
 	EOF
 	test_cmp ${name}.expected ${name}.out
 '
+test_expect_success 'list request with duplicate attrs returns each attr once' '
+	cat <<-EOF >list-dup-attrs.py &&
+	import flux
+	payload = {
+	    "max_entries": 1,
+	    "attrs": ["name", "state", "name"],
+	    "userid": flux.constants.FLUX_USERID_UNKNOWN,
+	    "states": 0,
+	    "results": 0,
+	}
+	s = flux.Flux().rpc("job-list.list", payload).get_str()
+	print(s.count("\"name\":"), s.count("\"state\":"))
+	EOF
+	echo "1 1" >list-dup-attrs.expected &&
+	flux python list-dup-attrs.py >list-dup-attrs.out &&
+	test_cmp list-dup-attrs.expected list-dup-attrs.out
+'
+test_expect_success 'streaming list request returns jobs in chunks' '
+	cat <<-EOF >list-stream.py &&
+	import sys
+	import flux
+	from flux.job import job_list, job_list_stream
+	h = flux.Flux()
+	uid = flux.constants.FLUX_USERID_UNKNOWN
+	attrs = ["state"]
+	full = job_list(h, max_entries=0, attrs=attrs, userid=uid).get_jobs()
+	jobs = list(job_list_stream(h, attrs=attrs, userid=uid, chunk_size=2))
+	assert [j["id"] for j in jobs] == [j["id"] for j in full]
+	jobs = list(job_list_stream(h, max_entries=3, attrs=attrs, userid=uid))
+	assert [j["id"] for j in jobs] == [j["id"] for j in full[:3]]
+	cursor = {"id": jobs[-1]["id"], "state": jobs[-1]["state"]}
+	rest = list(job_list_stream(h, userid=uid, chunk_size=2, cursor=cursor))
+	assert [j["id"] for j in rest] == [j["id"] for j in full[3:]]
+	print(len(full))
+	EOF
+	flux python list-stream.py >list-stream.out &&
+	test $(cat list-stream.out) -gt 3
+'
+test_expect_success HAVE_JQ 'list request with invalid cursor fails with EPROTO(71)' '
+	$jq -j -c -n "{max_entries:5, userid:0, states:0, results:0, attrs:[], cursor:{id:1, state:1}}" \
+	  | $listRPC >list-bad-cursor.out &&
+	cat <<-EOF >list-bad-cursor.expected &&
+	errno 71: invalid payload: invalid cursor
+	EOF
+	test_cmp list-bad-cursor.expected list-bad-cursor.out
+'
+test_expect_success HAVE_JQ 'list request with multi-state cursor fails with EPROTO(71)' '
+	$jq -j -c -n "{max_entries:5, userid:0, states:0, results:0, attrs:[], cursor:{id:1, state:96}}" \
+	  | $listRPC >list-bad-cursor2.out &&
+	test_cmp list-bad-cursor.expected list-bad-cursor2.out
+'
 test_expect_success 'list-id request with empty payload fails with EPROTO(71)' '
 	${RPC} job-list.list-id 71 </dev/null
 '
@@ -1220,4 +1284,173 @@ test_expect_success HAVE_JQ 'flux job list works on racy annotations' '
         cat list_racy_annotation.out | $jq -e ".annotations"
 '
 
+#
+# queries filtered by user and result
+#
+
+LIST_BENCH="flux python ${FLUX_SOURCE_DIR}/t/job-list/list-bench.py"
+
+test_expect_success HAVE_JQ 'list of my jobs matches list of all users jobs' '
+        flux job list -A -c 0 | $jq -S -c . > filter_all.out &&
+        flux job list -a -c 0 | $jq -S -c . > filter_user.out &&
+        test $(wc -l < filter_user.out) -gt 5 &&
+        test_cmp filter_all.out filter_user.out
+'
+test_expect_success 'list of unknown user jobs is empty' '
+        test $(flux job list -a -u 12345 -c 0 | wc -l) -eq 0
+'
+test_expect_success HAVE_JQ 'list by result returns expected jobs' '
+        flux job list -s inactive -u all -c 0 > filter_inactive.out &&
+        for result in 1 2 4 8 5 14; do
+            $jq -c "select(.result as \$r | ($result / \$r | floor) % 2 == 1)" \
+                < filter_inactive.out | wc -l > filter_expected.$result &&
+            $LIST_BENCH -n 1 -s 64 -r $result > filter_result.$result &&
+            test_cmp filter_expected.$result filter_result.$result || return 1
+        done
+'
+test_expect_success 'list by result honors max_entries' '
+        test $($LIST_BENCH -n 1 -s 64 -r 6 -m 1) -eq 1
+'
+test_expect_success 'benchmark filtered job-list queries' '
+        for opts in "" "-u $(id -u)" "-u 12345" "-s 64" "-s 64 -r 1" \
+                    "-s 64 -r 4"; do
+            echo "query: $opts" &&
+            $LIST_BENCH -n 100 -a state,userid $opts || return 1
+        done
+'
+
+#
+# purging inactive jobs to the spill file
+#
+
+wait_purged() {
+        local count=$1
+        local i=0
+        while test "$(flux module stats --parse purge.jobs job-list)" \
+                   != "$count" \
+              && test $i -lt 100
+        do
+                sleep 0.1
+                i=$((i + 1))
+        done
+        test $i -lt 100
+}
+
+test_expect_success HAVE_JQ 'save inactive job listings before purge' '
+        flux job list -s inactive -c 0 | $jq -S -c . > purge_list.exp &&
+        flux job list-inactive | $jq -S -c . > purge_inactive.exp &&
+        test $(wc -l < purge_list.exp) -gt 5 &&
+        test_cmp purge_list.exp purge_inactive.exp
+'
+test_expect_success 'reload job-list with inactive-num-limit=3' '
+        flux module reload job-list inactive-num-limit=3 &&
+        job_list_wait_restart &&
+        wait_purged $(($(wc -l < purge_list.exp) - 3)) &&
+        test $(flux module stats --parse jobs.inactive job-list) -eq 3 &&
+        test $(flux module stats --parse purge.num-limit job-list) -eq 3 &&
+        test $(flux module stats --parse purge.bytes job-list) -gt 0
+'
+test_expect_success HAVE_JQ 'flux job list includes purged jobs' '
+        flux job list -s inactive -c 0 | $jq -S -c . > purge_list.out &&
+        test_cmp purge_list.exp purge_list.out
+'
+test_expect_success HAVE_JQ 'flux job list -c works across purged jobs' '
+        flux job list -s inactive -c 5 | $jq -S -c . > purge_list5.out &&
+        head -5 purge_list.exp > purge_list5.exp &&
+        test_cmp purge_list5.exp purge_list5.out
+'
+test_expect_success HAVE_JQ 'streaming list works in chunks across purged jobs' '
+	cat <<-EOF >purge-stream.py &&
+	import json
+	import os
+	import flux
+	from flux.job import job_list_stream
+	h = flux.Flux()
+	exp = [json.loads(line) for line in open("purge_list.exp")]
+	inactive = 64
+	for userid in [flux.constants.FLUX_USERID_UNKNOWN, os.getuid()]:
+	    for results in [0, 1 | 2 | 4]:
+	        ids = [j["id"] for j in exp if not results or j["result"] & results]
+	        jobs = job_list_stream(
+	            h, userid=userid, states=inactive, results=results, chunk_size=2
+	        )
+	        assert [j["id"] for j in jobs] == ids
+	uid = flux.constants.FLUX_USERID_UNKNOWN
+	jobs = list(job_list_stream(h, max_entries=2, userid=uid, states=inactive))
+	cursor = {"id": jobs[-1]["id"], "state": jobs[-1]["state"]}
+	rest = job_list_stream(
+	    h, userid=uid, states=inactive, chunk_size=2, cursor=cursor
+	)
+	assert [j["id"] for j in rest] == [j["id"] for j in exp[2:]]
+	EOF
+        flux python purge-stream.py
+'
+test_expect_success HAVE_JQ 'flux job list-inactive includes purged jobs' '
+        flux job list-inactive | $jq -S -c . > purge_inactive.out &&
+        test_cmp purge_inactive.exp purge_inactive.out
+'
+test_expect_success HAVE_JQ 'flux job list-inactive --since works on purged jobs' '
+        since=$(sed -n 5p purge_inactive.exp | $jq .t_inactive) &&
+        flux job list-inactive --since=$since | $jq -S -c . \
+            > purge_since.out &&
+        head -4 purge_inactive.exp > purge_since.exp &&
+        test_cmp purge_since.exp purge_since.out
+'
+test_expect_success HAVE_JQ 'flux job list-ids works on purged job' '
+        id=$(tail -1 purge_list.exp | $jq .id) &&
+        flux job list-ids $id | $jq -S -c . > purge_id.out &&
+        tail -1 purge_list.exp > purge_id.exp &&
+        test_cmp purge_id.exp purge_id.out
+'
+test_expect_success HAVE_JQ 'new inactive jobs are purged as they complete' '
+        jobid=$(flux mini submit hostname | flux job id) &&
+        fj_wait_event $jobid clean &&
+        wait_purged $(wc -l < purge_list.exp) &&
+        test $(flux module stats --parse jobs.inactive job-list) -eq 3 &&
+        flux job list -s inactive -c 1 | $jq -e ".id == $jobid" &&
+        test $(flux job list -s inactive -c 0 | wc -l) \
+            -eq $(($(wc -l < purge_list.exp) + 1))
+'
+test_expect_success 'reload job-list with inactive-age-limit=1ms' '
+        count=$(flux job list -s inactive -c 0 | wc -l) &&
+        flux module reload job-list inactive-age-limit=1ms &&
+        job_list_wait_restart &&
+        wait_purged $count &&
+        test $(flux module stats --parse jobs.inactive job-list) -eq 0 &&
+        test $(flux job list -s inactive -c 0 | wc -l) -eq $count
+'
+test_expect_success 'job-list fails to load with invalid purge options' '
+        flux module remove job-list &&
+        test_must_fail flux module load job-list inactive-num-limit=-1 &&
+        test_must_fail flux module load job-list inactive-num-limit=foo &&
+        test_must_fail flux module load job-list inactive-age-limit=foo &&
+        test_must_fail flux module load job-list foo=bar
+'
+test_expect_success 'job-list can be configured with [job-list]' '
+        cat >job-list.toml <<-EOF &&
+	[job-list]
+	inactive-num-limit = 2
+	EOF
+        flux config reload &&
+        flux module load job-list &&
+        job_list_wait_restart &&
+        test $(flux module stats --parse purge.num-limit job-list) -eq 2
+'
+test_expect_success 'job-list fails to load with invalid [job-list] config' '
+        flux module remove job-list &&
+        cat >job-list.toml <<-EOF &&
+	[job-list]
+	inactive-num-limit = "foo"
+	EOF
+        flux config reload &&
+        test_must_fail flux module load job-list
+'
+test_expect_success 'reload job-list with defaults' '
+        rm -f job-list.toml &&
+        flux config reload &&
+        flux module load job-list &&
+        job_list_wait_restart &&
+        test $(flux module stats --parse purge.jobs job-list) -eq 0
+'
+
 test_done
@@ -149,6 +149,7 @@ test_expect_success 'dependencies are re-established after restart' '
 	flux module reload job-manager &&
 	flux jobtap load ${PLUGINPATH}/dependency-test.so &&
 	flux module load job-list &&
+	job_list_wait_restart &&
 	flux module reload -f sched-simple &&
 	flux module reload -f job-exec &&
 	flux job eventlog ${jobid} &&
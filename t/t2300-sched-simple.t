@@ -252,6 +252,18 @@ test_expect_success 'sched-simple: submit job and cancel it' '
 	flux job cancel $(cat job19.id) &&
 	$dmesg_grep -t 10 "free: R is NULL"
 '
+test_expect_success 'sched-simple: scheduler requested batched alloc/free' '
+	$dmesg_grep -t 10 "scheduler: ready .* batch"
+'
+test_expect_success 'sched-simple: reload sched-simple without batching' '
+	flux module reload sched-simple test-no-batch
+'
+test_expect_success 'sched-simple: job runs without batching' '
+	flux job submit basic.json >job20.id &&
+	flux job wait-event --timeout=5.0 $(cat job20.id) alloc &&
+	flux job cancel $(cat job20.id) &&
+	flux job wait-event --timeout=5.0 $(cat job20.id) free
+'
 test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
 	flux module remove sched-simple &&
 	flux job cancelall -f
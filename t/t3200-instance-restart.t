@@ -7,6 +7,24 @@ test_description='Test instance restart'
 test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
 . `dirname $0`/sharness.sh
 
+# job-list loads jobs from the KVS asynchronously, so wait for it to
+# finish before listing inactive jobs
+cat >list-inactive.sh <<-'EOT'
+#!/bin/sh
+i=0
+while test "$(flux module stats --parse restart.complete job-list)" != "true"
+do
+    if test $i -ge 100; then
+        echo "job-list restart did not complete" >&2
+        exit 1
+    fi
+    sleep 0.1
+    i=$((i + 1))
+done
+flux jobs --suppress-header --format={id} --filter=INACTIVE
+EOT
+chmod +x list-inactive.sh
+
 if test -n "$S3_ACCESS_KEY_ID"; then
     test_set_prereq S3
     export FLUX_CONF_DIR=$(pwd)
@@ -29,8 +47,7 @@ test_expect_success 'restart instance and run another job' '
 
 test_expect_success 'restart instance and list inactive jobs' '
 	flux start -o,--setattr=content.backing-path=$(pwd)/content.sqlite \
-	           flux jobs --suppress-header --format={id} \
-		   	--filter=INACTIVE >list.out
+	           $(pwd)/list-inactive.sh >list.out
 '
 
 test_expect_success 'inactive job list contains all jobs run before' '
@@ -54,8 +71,7 @@ test_expect_success 'restart instance and list inactive jobs' '
 	flux start \
 	    -o,-Scontent.backing-module=content-files \
 	    -o,-Scontent.backing-path=$(pwd)/content.files \
-	    flux jobs --suppress-header --format={id} \
-	        --filter=INACTIVE >files_list.out
+	    $(pwd)/list-inactive.sh >files_list.out
 '
 
 test_expect_success 'inactive job list contains job from before restart' '
@@ -88,8 +104,7 @@ test_expect_success S3 'run a job in persistent instance (content-s3)' '
 test_expect_success S3 'restart instance and list inactive jobs' '
 	flux start \
 	    -o,-Scontent.backing-module=content-s3 \
-	    flux jobs --suppress-header --format={id} \
-	        --filter=INACTIVE >files_list2.out
+	    $(pwd)/list-inactive.sh >files_list2.out
 '
 
 test_expect_success S3 'inactive job list contains job from before restart' '